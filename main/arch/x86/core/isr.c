@@ -7,6 +7,7 @@
 #include <asm/apic.h>
 #include <asm/irq.h>
 #include <asm/irq_defs.h>
+#include <asm/smp_defs.h>
 #include <xnix/debug.h>
 #include <xnix/irq.h>
 #include <xnix/stdio.h>
@@ -74,7 +75,7 @@ void irq_handler(struct irq_frame *frame) {
  *
  * 处理核间中断:
  * - RESCHED: 触发重新调度
- * - TLB: TLB shootdown (待实现)
+ * - TLB: TLB shootdown, 刷新本核 TLB 并确认
  * - PANIC: 停止当前核
  */
 void ipi_handler(struct irq_frame *frame) {
@@ -88,7 +89,7 @@ void ipi_handler(struct irq_frame *frame) {
         break;
 
     case IPI_VECTOR_TLB:
-        /* TLB shootdown: 待实现 */
+        smp_tlb_ipi();
         break;
 
     case IPI_VECTOR_PANIC:
@@ -2,6 +2,7 @@
 
 #include <asm/gdt.h>
 #include <asm/tss.h>
+#include <xnix/cap.h>
 #include <xnix/mm_ops.h>
 #include <xnix/process_def.h>
 #include <xnix/stdio.h> /* pr_info */
@@ -42,4 +43,19 @@ void arch_thread_switch(struct thread *next) {
         uint32_t esp0 = (uint32_t)next->stack + next->stack_size;
         tss_set_stack(KERNEL_DS, esp0);
     }
+
+    /* 加载 I/O 权限位图, 让有端口权限的驱动直接执行 in/out */
+    struct process *owner = next->state == THREAD_EXITED ? NULL : next->owner;
+    if (owner && (owner->cap_mask & CAP_IO_PORT)) {
+        /* 持锁拷贝, 防止其他 CPU 上的 cap_grant_ioport 同时换掉并释放位图 */
+        spin_lock(&owner->cap_lock);
+        if (owner->ioport_bitmap) {
+            tss_load_iomap(owner->ioport_bitmap->id, owner->ioport_bitmap->bits);
+        } else {
+            tss_load_iomap(0, NULL);
+        }
+        spin_unlock(&owner->cap_lock);
+    } else {
+        tss_load_iomap(0, NULL);
+    }
 }
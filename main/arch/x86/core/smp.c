@@ -6,10 +6,13 @@
  * 阶段 2: AP 启动
  */
 
+#include <arch/cpu.h>
+#include <arch/mmu.h>
 #include <arch/smp.h>
 
 #include <asm/apic.h>
 #include <asm/smp_defs.h>
+#include <xnix/sync.h>
 
 /* SMP 信息 (由 lapic.c 定义) */
 extern struct smp_info g_smp_info;
@@ -74,3 +77,57 @@ void smp_send_ipi_all(uint8_t vector) {
 
     lapic_send_ipi_all(vector);
 }
+
+/*
+ * TLB shootdown
+ *
+ * 发起方给每个目标核置 tlb_pending 再发 IPI, 目标核刷新后清位, 发起方等全部清零.
+ * 同一时刻只有一个发起方 (tlb_lock). 系统调用在关中断的中断门里执行, IPI 进不来,
+ * 所以等锁和等确认时都顺带处理发给自己的请求, 两个核同时发起也不会互等.
+ */
+static spinlock_t    tlb_lock = SPINLOCK_INIT;
+static volatile bool tlb_pending[CFG_MAX_CPUS];
+
+static void tlb_poll(cpu_id_t self) {
+    if (tlb_pending[self]) {
+        arch_tlb_flush_all();
+        barrier_full();
+        tlb_pending[self] = false;
+    }
+}
+
+void smp_tlb_ipi(void) {
+    tlb_poll(cpu_current_id());
+}
+
+void arch_tlb_shootdown(void) {
+    arch_tlb_flush_all();
+
+    uint32_t n = cpu_count();
+    if (n <= 1 || !g_smp_info.apic_available) {
+        return;
+    }
+    cpu_id_t self = cpu_current_id();
+
+    while (!spin_trylock(&tlb_lock)) {
+        tlb_poll(self);
+        cpu_pause();
+    }
+
+    for (cpu_id_t i = 0; i < n; i++) {
+        tlb_pending[i] = i != self && cpu_online[i];
+    }
+    barrier_full();
+    for (cpu_id_t i = 0; i < n; i++) {
+        if (tlb_pending[i]) {
+            smp_send_ipi(i, IPI_VECTOR_TLB);
+        }
+    }
+    for (cpu_id_t i = 0; i < n; i++) {
+        while (tlb_pending[i]) {
+            cpu_pause();
+        }
+    }
+
+    spin_unlock(&tlb_lock);
+}
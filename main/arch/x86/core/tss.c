@@ -5,6 +5,10 @@
  * @see https://ysos.gzti.me/
  *
  * 支持 Per-CPU TSS 用于 SMP
+ *
+ * TSS 后紧跟 I/O 权限位图, 用户态驱动的 in/out/rep ins 由 CPU 按位图
+ * 直接放行, 不再经过系统调用. 位图语义与进程端口表相反 (bit=1 禁止),
+ * 末尾需要一个全 1 字节作为终止.
  */
 
 #include <arch/smp.h>
@@ -14,20 +18,39 @@
 #include <xnix/percpu.h>
 #include <xnix/string.h>
 
+#define TSS_IOMAP_BYTES 8192 /* 65536 ports / 8 */
+
+struct tss_iomap {
+    struct tss_entry tss;
+    uint8_t          iomap[TSS_IOMAP_BYTES];
+    uint8_t          iomap_end; /* 必须为 0xFF */
+} __attribute__((packed));
+
+/* iomap_base 指向段界限之外: 没有位图, CPL3 的所有端口访问都会 #GP */
+#define TSS_IOMAP_NONE  ((uint16_t)sizeof(struct tss_iomap))
+#define TSS_IOMAP_VALID ((uint16_t)sizeof(struct tss_entry))
+
 /* Per-CPU TSS */
-static DEFINE_PER_CPU(struct tss_entry, tss);
+static DEFINE_PER_CPU(struct tss_iomap, tss);
+
+/* 当前 CPU 位图中已加载的端口表 id, 0 表示未加载 */
+static DEFINE_PER_CPU(uint32_t, tss_iomap_id);
+
+static void tss_reset(struct tss_iomap *t) {
+    memset(t, 0, sizeof(struct tss_iomap));
+    t->tss.ss0        = 0x10; /* KERNEL_DS */
+    t->tss.esp0       = 0;    /* 初始为 0, 调度时会更新 */
+    t->tss.iomap_base = TSS_IOMAP_NONE;
+    t->iomap_end      = 0xFF;
+}
 
 /**
  * 初始化所有 TSS (BSP 调用)
  */
 void tss_init(void) {
     for (uint32_t i = 0; i < CFG_MAX_CPUS; i++) {
-        struct tss_entry *t = per_cpu_ptr(tss, i);
-        memset(t, 0, sizeof(struct tss_entry));
-        t->ss0  = 0x10; /* KERNEL_DS */
-        t->esp0 = 0;    /* 初始为 0, 调度时会更新 */
-        /* I/O Map Base = sizeof(tss) 表示没有 I/O Bitmap */
-        t->iomap_base = sizeof(struct tss_entry);
+        tss_reset(per_cpu_ptr(tss, i));
+        *per_cpu_ptr(tss_iomap_id, i) = 0;
     }
 }
 
@@ -38,20 +61,17 @@ void tss_init_cpu(uint32_t cpu_id) {
     if (cpu_id >= CFG_MAX_CPUS) {
         return;
     }
-    struct tss_entry *t = per_cpu_ptr(tss, cpu_id);
-    memset(t, 0, sizeof(struct tss_entry));
-    t->ss0        = 0x10; /* KERNEL_DS */
-    t->esp0       = 0;
-    t->iomap_base = sizeof(struct tss_entry);
+    tss_reset(per_cpu_ptr(tss, cpu_id));
+    *per_cpu_ptr(tss_iomap_id, cpu_id) = 0;
 }
 
 /**
  * 设置当前 CPU 的 TSS 栈指针
  */
 void tss_set_stack(uint32_t ss0, uint32_t esp0) {
-    struct tss_entry *t = this_cpu_ptr(tss);
-    t->ss0              = ss0;
-    t->esp0             = esp0;
+    struct tss_iomap *t = this_cpu_ptr(tss);
+    t->tss.ss0          = ss0;
+    t->tss.esp0         = esp0;
 }
 
 /**
@@ -61,9 +81,33 @@ void tss_set_stack_cpu(uint32_t cpu_id, uint32_t ss0, uint32_t esp0) {
     if (cpu_id >= CFG_MAX_CPUS) {
         return;
     }
-    struct tss_entry *t = per_cpu_ptr(tss, cpu_id);
-    t->ss0              = ss0;
-    t->esp0             = esp0;
+    struct tss_iomap *t = per_cpu_ptr(tss, cpu_id);
+    t->tss.ss0          = ss0;
+    t->tss.esp0         = esp0;
+}
+
+/**
+ * 加载当前 CPU 的 I/O 权限位图
+ */
+void tss_load_iomap(uint32_t id, const uint8_t *allow) {
+    struct tss_iomap *t = this_cpu_ptr(tss);
+
+    if (!allow) {
+        /* 保留位图内容和 id, 切回同一张表时不必重新拷贝 */
+        t->tss.iomap_base = TSS_IOMAP_NONE;
+        return;
+    }
+
+    uint32_t *cached = this_cpu_ptr(tss_iomap_id);
+    if (*cached != id) {
+        const uint32_t *src = (const uint32_t *)allow;
+        uint32_t       *dst = (uint32_t *)t->iomap;
+        for (uint32_t i = 0; i < TSS_IOMAP_BYTES / 4; i++) {
+            dst[i] = ~src[i];
+        }
+        *cached = id;
+    }
+    t->tss.iomap_base = TSS_IOMAP_VALID;
 }
 
 /**
@@ -74,5 +118,5 @@ void tss_get_desc(uint32_t cpu_id, uint32_t *base, uint32_t *limit) {
         cpu_id = 0;
     }
     *base  = (uint32_t)per_cpu_ptr(tss, cpu_id);
-    *limit = sizeof(struct tss_entry) - 1;
+    *limit = sizeof(struct tss_iomap) - 1;
 }
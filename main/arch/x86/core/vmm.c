@@ -7,6 +7,7 @@
 #include <xnix/config.h>
 #include <xnix/debug.h>
 #include <xnix/errno.h>
+#include <xnix/filemap.h>
 #include <xnix/mm.h>
 #include <xnix/mm_ops.h>
 #include <xnix/stdio.h>
@@ -628,12 +629,18 @@ extern const char *process_get_name(void *proc);
 extern void       *process_get_page_dir(void *proc);
 
 void vmm_page_fault(struct irq_regs *frame, vaddr_t vaddr) {
-    /* 进入紧急模式,确保同步输出 */
-    early_console_emergency();
-
     uint32_t err_code  = frame->err_code;
     bool     from_user = (frame->cs & 0x03) == 3;
 
+    /* 文件映射缺页: 取页后返回用户态重试 */
+    if (from_user && !(err_code & 0x08) &&
+        filemap_fault(process_get_current(), vaddr, err_code & 0x01, err_code & 0x02) == 0) {
+        return;
+    }
+
+    /* 进入紧急模式,确保同步输出 */
+    early_console_emergency();
+
     uint32_t cr3;
     asm volatile("mov %%cr3, %0" : "=r"(cr3));
 
@@ -72,6 +72,22 @@ static inline uint16_t inw(uint16_t port) {
     return ret;
 }
 
+static inline void insb(uint16_t port, void *buf, uint32_t count) {
+    __asm__ volatile("cld; rep insb" : "+D"(buf), "+c"(count) : "d"(port) : "memory");
+}
+
+static inline void outsb(uint16_t port, const void *buf, uint32_t count) {
+    __asm__ volatile("cld; rep outsb" : "+S"(buf), "+c"(count) : "d"(port) : "memory");
+}
+
+static inline void insw(uint16_t port, void *buf, uint32_t count) {
+    __asm__ volatile("cld; rep insw" : "+D"(buf), "+c"(count) : "d"(port) : "memory");
+}
+
+static inline void outsw(uint16_t port, const void *buf, uint32_t count) {
+    __asm__ volatile("cld; rep outsw" : "+S"(buf), "+c"(count) : "d"(port) : "memory");
+}
+
 static inline void io_wait(void) {
     outb(0x80, 0);
 }
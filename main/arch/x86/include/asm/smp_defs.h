@@ -133,6 +133,29 @@ struct mp_lint {
     uint8_t  dst_lintin; /* LINTIN# */
 } __attribute__((packed));
 
+/* MP 中断类型 / 标志 */
+#define MP_INT_TYPE_INT    0 /* 向量化中断 */
+#define MP_INT_POL_MASK    0x03
+#define MP_INT_POL_HIGH    0x01
+#define MP_INT_POL_LOW     0x03
+#define MP_INT_TRIG_MASK   0x0C
+#define MP_INT_TRIG_EDGE   0x04
+#define MP_INT_TRIG_LEVEL  0x0C
+#define MP_PCI_ROUTES_MAX  32
+
+/**
+ * PCI INTx 路由 (由 PCI 总线上的 I/O 中断条目整理而来)
+ *
+ * MP 规范中 PCI 源 IRQ 编码为 (设备号 << 2) | 引脚.
+ */
+struct mp_pci_route {
+    uint8_t  bus;   /* PCI 总线号 */
+    uint8_t  dev;   /* 设备号 */
+    uint8_t  pin;   /* 0=INTA# ... 3=INTD# */
+    uint8_t  gsi;   /* I/O APIC 输入脚 */
+    uint16_t flags; /* 极性/触发模式 (MP_INT_*) */
+};
+
 /**
  * Per-CPU 数据结构
  */
@@ -159,6 +182,10 @@ struct smp_info {
     paddr_t  ioapic_base;             /* I/O APIC 基地址 */
     uint8_t  ioapic_id;               /* I/O APIC ID */
     bool     apic_available;          /* APIC 是否可用 */
+
+    uint32_t            pci_bus_mask[8]; /* 类型为 PCI 的总线 ID 位图 */
+    struct mp_pci_route pci_routes[MP_PCI_ROUTES_MAX];
+    uint32_t            pci_route_count;
 };
 
 /* 全局 SMP 信息 */
@@ -170,6 +197,9 @@ void mp_table_dump(const struct smp_info *info);
 
 int acpi_madt_parse(struct smp_info *info);
 
+/* IPI_VECTOR_TLB 处理: 刷新本核 TLB 并确认 (smp.c) */
+void smp_tlb_ipi(void);
+
 /* Per-CPU 数据访问 */
 extern struct per_cpu_data g_per_cpu[CFG_MAX_CPUS];
 
@@ -46,6 +46,14 @@ void tss_set_stack(uint32_t ss0, uint32_t esp0);
 /* 更新指定 CPU 的内核栈指针 */
 void tss_set_stack_cpu(uint32_t cpu_id, uint32_t ss0, uint32_t esp0);
 
+/*
+ * 加载当前 CPU 的 I/O 权限位图
+ *
+ * allow 为进程端口表 (bit=1 允许), NULL 表示禁止用户态直接访问任何端口.
+ * id 与上次加载的相同时跳过 8KB 拷贝, 只恢复 iomap_base.
+ */
+void tss_load_iomap(uint32_t id, const uint8_t *allow);
+
 /* 获取指定 CPU 的 TSS 结构的地址和大小 (供 GDT 初始化使用) */
 void tss_get_desc(uint32_t cpu_id, uint32_t *base, uint32_t *limit);
 
@@ -9,6 +9,13 @@
 #include <plat/platform.h>
 
 #include <asm/smp_defs.h>
+#include <xnix/physmem.h>
+
+/*
+ * 0xFEC00000 以上是 IOAPIC, HPET, LAPIC 和固件 ROM 所在的平台保留区,
+ * PCI BAR 不会分配在这里, 不允许用户态当作 MMIO 映射
+ */
+#define X86_PLATFORM_MMIO_BASE 0xFEC00000u
 
 /* GDT/IDT 初始化 (在 core 层) */
 extern void gdt_init(void);
@@ -36,6 +43,8 @@ void arch_init(void) {
     gdt_init();
     idt_init();
 
+    mmio_reserve(X86_PLATFORM_MMIO_BASE, 0u - X86_PLATFORM_MMIO_BASE);
+
     /*
      * 外部 IRQ 先使用 8259 PIC (PIT/键盘等 ISA IRQ 更稳定)
      * LAPIC 初始化在 smp_init 中进行,用于 IPI 拉起 AP
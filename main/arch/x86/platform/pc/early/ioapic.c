@@ -9,9 +9,11 @@
 #include <arch/cpu.h>
 
 #include <asm/apic.h>
+#include <asm/irq.h>
 #include <asm/smp_defs.h>
 #include <xnix/driver.h>
 #include <xnix/irq.h>
+#include <xnix/physmem.h>
 #include <xnix/stdio.h>
 #include <xnix/vmm.h>
 
@@ -21,6 +23,9 @@ static volatile uint32_t *ioapic_base = NULL;
 /* 最大中断输入数量 */
 static uint8_t ioapic_max_redir = 0;
 
+/* 每个输入脚的触发模式 (IRQ_MODE_*), 默认 ISA: 边沿触发, 高电平有效 */
+static uint8_t ioapic_irq_mode[ARCH_NR_IRQS];
+
 uint32_t ioapic_read(uint8_t reg) {
     if (!ioapic_base) {
         return 0;
@@ -80,6 +85,9 @@ void ioapic_init(void) {
 
     ioapic_base = (volatile uint32_t *)ioapic_phys;
 
+    /* MADT 可能把 IOAPIC 放在平台保留区之外, 单独登记 */
+    mmio_reserve(ioapic_phys, PAGE_SIZE);
+
     /* 读取 I/O APIC 版本和最大重定向条目 */
     uint32_t ver     = ioapic_read(IOAPIC_VER);
     ioapic_max_redir = ((ver >> 16) & 0xFF) + 1;
@@ -113,8 +121,15 @@ void ioapic_enable_irq(uint8_t irq, uint8_t vector, uint8_t dest) {
     uint64_t redir = vector;
     redir |= ((uint64_t)dest << 56); /* 目标 LAPIC ID */
 
-    /* ISA 中断默认配置: 边沿触发, 高电平有效 */
-    /* 某些 IRQ (如 PCI) 可能需要电平触发 */
+    /* ISA 中断默认边沿触发, 高电平有效; PCI 中断由 irq_route_pci 设为电平 */
+    if (irq < ARCH_NR_IRQS) {
+        if (ioapic_irq_mode[irq] & IRQ_MODE_ACTIVE_LOW) {
+            redir |= (1ULL << 13);
+        }
+        if (ioapic_irq_mode[irq] & IRQ_MODE_LEVEL) {
+            redir |= (1ULL << 15);
+        }
+    }
 
     ioapic_write_redir(irq, redir);
 }
@@ -195,12 +210,46 @@ static void apic_chip_eoi(uint8_t irq) {
     lapic_eoi();
 }
 
+/**
+ * 在 MP Table 的 PCI 中断条目里查找 (bus, dev, pin) 对应的 IOAPIC 输入脚
+ */
+static int apic_chip_route_pci(uint8_t bus, uint8_t dev, uint8_t pin, uint32_t *mode) {
+    extern struct smp_info g_smp_info;
+
+    for (uint32_t i = 0; i < g_smp_info.pci_route_count; i++) {
+        const struct mp_pci_route *r = &g_smp_info.pci_routes[i];
+        if (r->bus != bus || r->dev != dev || r->pin != pin) {
+            continue;
+        }
+
+        /* "符合总线规范" 对 PCI 来说就是低电平有效 + 电平触发 */
+        uint32_t m = 0;
+        if ((r->flags & MP_INT_POL_MASK) != MP_INT_POL_HIGH) {
+            m |= IRQ_MODE_ACTIVE_LOW;
+        }
+        if ((r->flags & MP_INT_TRIG_MASK) != MP_INT_TRIG_EDGE) {
+            m |= IRQ_MODE_LEVEL;
+        }
+        *mode = m;
+        return r->gsi;
+    }
+    return -1;
+}
+
+static void apic_chip_set_mode(uint8_t irq, uint32_t mode) {
+    if (irq < ARCH_NR_IRQS) {
+        ioapic_irq_mode[irq] = (uint8_t)mode;
+    }
+}
+
 static const struct irqchip_ops apic_chip = {
-    .name    = "apic",
-    .init    = apic_chip_init,
-    .enable  = apic_chip_enable,
-    .disable = apic_chip_disable,
-    .eoi     = apic_chip_eoi,
+    .name      = "apic",
+    .init      = apic_chip_init,
+    .enable    = apic_chip_enable,
+    .disable   = apic_chip_disable,
+    .eoi       = apic_chip_eoi,
+    .route_pci = apic_chip_route_pci,
+    .set_mode  = apic_chip_set_mode,
 };
 
 /**
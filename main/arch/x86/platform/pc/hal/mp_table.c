@@ -139,6 +139,10 @@ static int mp_parse_config(const struct mp_config *cfg, struct smp_info *info) {
         }
 
         case MP_ENTRY_BUS: {
+            const struct mp_bus *bus = (const struct mp_bus *)entry;
+            if (memcmp(bus->bus_type, "PCI", 3) == 0) {
+                info->pci_bus_mask[bus->bus_id / 32] |= 1u << (bus->bus_id % 32);
+            }
             entry += sizeof(struct mp_bus);
             break;
         }
@@ -154,6 +158,19 @@ static int mp_parse_config(const struct mp_config *cfg, struct smp_info *info) {
         }
 
         case MP_ENTRY_IOINT: {
+            const struct mp_ioint *ioint = (const struct mp_ioint *)entry;
+
+            /* 总线条目总是排在中断条目之前, 这里已能判断源总线类型 */
+            bool pci = info->pci_bus_mask[ioint->src_bus / 32] & (1u << (ioint->src_bus % 32));
+            if (pci && ioint->int_type == MP_INT_TYPE_INT &&
+                info->pci_route_count < MP_PCI_ROUTES_MAX) {
+                struct mp_pci_route *r = &info->pci_routes[info->pci_route_count++];
+                r->bus                 = ioint->src_bus;
+                r->dev                 = ioint->src_irq >> 2;
+                r->pin                 = ioint->src_irq & 3;
+                r->gsi                 = ioint->dst_intin;
+                r->flags               = ioint->flags;
+            }
             entry += sizeof(struct mp_ioint);
             break;
         }
@@ -58,6 +58,15 @@ void arch_mmu_init(void);
 void arch_tlb_flush_all(void);
 void arch_tlb_flush_page(vaddr_t addr);
 
+/**
+ * 刷新所有在线 CPU 的 TLB
+ *
+ * 撤销或降级用户映射后调用: 同一进程的线程可能正跑在其他核上, 还缓存着旧表项.
+ * 本核直接刷新, 其他核发 IPI 并等它们刷完才返回.
+ * 调用者不能持有自旋锁.
+ */
+void arch_tlb_shootdown(void);
+
 /**
  * 获取内核可用的物理内存范围
  *   BIOS/bootloader 会告诉内核哪些内存是可用的
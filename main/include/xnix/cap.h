@@ -8,11 +8,37 @@
 #ifndef XNIX_CAP_H
 #define XNIX_CAP_H
 
+#include <arch/atomic.h>
+
 #include <xnix/abi/cap.h>
 #include <xnix/types.h>
 
 struct process;
 
+#define IOPORT_BITMAP_BYTES 8192 /* 65536 ports / 8 */
+
+/**
+ * IO 端口访问表
+ *
+ * bit=1 表示允许访问. 通过 caps=NULL spawn 的子进程与父进程共享同一张表,
+ * 只增加引用计数. id 全局唯一, 上下文切换时据此判断 TSS 中的 I/O 位图
+ * 是否需要重新加载.
+ */
+struct ioport_bitmap {
+    atomic_t refcount;
+    uint32_t id;
+    uint8_t  bits[IOPORT_BITMAP_BYTES];
+};
+
+/** 分配一张 IO 端口表, 所有位初始化为 fill (0x00 或 0xFF) */
+struct ioport_bitmap *ioport_bitmap_create(uint8_t fill);
+
+/** 增加引用, 返回 bm 本身(bm 可为 NULL) */
+struct ioport_bitmap *ioport_bitmap_get(struct ioport_bitmap *bm);
+
+/** 释放引用, 最后一个引用释放时回收 */
+void ioport_bitmap_put(struct ioport_bitmap *bm);
+
 /** 检查进程是否拥有指定能力 */
 bool cap_check(struct process *proc, uint32_t cap);
 
@@ -25,8 +51,11 @@ bool cap_check_irq(struct process *proc, uint8_t irq);
 /** 检查 child_caps 是否为 parent_caps 的子集 */
 bool cap_is_subset(uint32_t child_caps, uint32_t parent_caps);
 
-/** 从 spawn_caps 构建 ioport_bitmap, 返回分配的位图指针(调用者负责释放) */
-uint8_t *cap_build_ioport_bitmap(const struct spawn_caps *caps);
+/** 把端口区间 [start, end] 加入进程的 IO 位图(写时复制), 并赋予 CAP_IO_PORT */
+int cap_grant_ioport(struct process *proc, uint16_t start, uint16_t end);
+
+/** 从 spawn_caps 构建 ioport_bitmap, 返回持有一个引用的位图(调用者负责 put) */
+struct ioport_bitmap *cap_build_ioport_bitmap(const struct spawn_caps *caps);
 
 /** 从 spawn_caps 构建 irq_mask */
 uint32_t cap_build_irq_mask(const struct spawn_caps *caps);
@@ -0,0 +1,103 @@
+/**
+ * @file filemap.h
+ * @brief 文件映射与文件页缓存
+ *
+ * 文件系统在用户态服务端, 内核不认识文件. 映射时内核向服务端申请一个
+ * 缓页会话 (IO_MAP), 之后缺页由内核代缺页线程发 IO_PAGE_IN 取页,
+ * 写回发 IO_PAGE_OUT. 取到的页按 (缓页 endpoint, 文件标识) 缓存,
+ * 同一文件的所有映射共享, 没有映射后仍保留一段时间供下次映射直接命中.
+ *
+ * 这份缓存同时是普通读的页缓存: 服务端填充, 客户端 SYS_FCACHE_READ
+ * 命中时不经过服务端 (见 abi/fcache.h). 服务端处理 write 后就地更新缓存页,
+ * 映射与 write 看到同一份内容.
+ *
+ * 目前只有 exec 读 ELF 时用映射代替逐块读 (仍复制进新进程, 段页不共享);
+ * 字体编译在 libfont 里, 其余数据文件都是一次读完的小配置, 没有改用映射.
+ */
+
+#ifndef XNIX_FILEMAP_H
+#define XNIX_FILEMAP_H
+
+#include <xnix/abi/handle.h>
+#include <xnix/types.h>
+
+struct process;
+struct abi_fcache_args;
+
+/**
+ * 建立文件映射
+ *
+ * @param proc     目标进程 (当前进程, 期间会发 IPC)
+ * @param handle   文件所在服务端的 endpoint handle
+ * @param session  已打开文件的会话
+ * @param offset   文件内偏移(页对齐)
+ * @param size     映射大小
+ * @param prot     ABI_PROT_*
+ * @param flags    ABI_MAP_SHARED 或 ABI_MAP_PRIVATE
+ * @param out_addr 输出映射起始地址
+ * @return 0 成功, 负数错误码
+ */
+int filemap_map(struct process *proc, handle_t handle, uint32_t session, uint32_t offset,
+                uint32_t size, uint32_t prot, uint32_t flags, uint32_t *out_addr);
+
+/**
+ * 取消 [addr, addr + size) 内的文件映射, 共享可写映射先写回脏页
+ *
+ * 区间可以只覆盖映射的一部分, 剩下的部分仍然有效.
+ *
+ * @return 0 成功, -ENOENT 区间不是文件映射, 其他负数错误码
+ */
+int filemap_unmap(struct process *proc, uint32_t addr, uint32_t size);
+
+/**
+ * 写回 [addr, addr + size) 内共享可写映射的脏页
+ * @return 0 成功, 负数错误码
+ */
+int filemap_sync(struct process *proc, uint32_t addr, uint32_t size);
+
+/**
+ * 用户态缺页处理 (在缺页线程上下文中调用, 可能阻塞等服务端取页)
+ *
+ * @param proc    当前进程
+ * @param vaddr   缺页地址
+ * @param present 页存在 (写保护错误)
+ * @param write   写访问
+ * @return 0 已建立映射可重试, 负数表示不是文件映射或无法满足
+ */
+int filemap_fault(struct process *proc, uint32_t vaddr, bool present, bool write);
+
+/**
+ * 预先调入用户缓冲区中的文件映射页
+ *
+ * copy_from_user/copy_to_user 不处理缺页, 以用户缓冲区为参数的
+ * 系统调用在访问前调用此函数. 不在文件映射内的部分忽略.
+ */
+void filemap_prefault(struct process *proc, uint32_t addr, uint32_t size, bool write);
+
+/**
+ * 进程销毁时释放全部文件映射 (不发 IPC, 未写回的脏页留在缓存里,
+ * 文件页淘汰时再写回)
+ */
+void filemap_release_process(struct process *proc);
+
+/**
+ * 服务端操作读缓存 (ABI_FCACHE_BIND/UNBIND/FILL/INVAL/UPDATE)
+ *
+ * 调用者须持有 cache_ep 的接收和 SERVE 权限. 不向服务端发 IPC.
+ *
+ * @return 0 成功, 负数错误码
+ */
+int filemap_cache_ctl(struct process *proc, const struct abi_fcache_args *args);
+
+/**
+ * 从读缓存拷贝文件内容到用户缓冲区
+ *
+ * @param handle  客户端发请求用的 endpoint
+ * @param session 客户端会话
+ * @return 从 offset 起连续命中的字节数, 0 表示未命中,
+ *         -ENOENT 表示会话未登记 (服务端不填缓存)
+ */
+int filemap_cache_read(struct process *proc, handle_t handle, uint32_t session, uint32_t offset,
+                       void *ubuf, uint32_t size);
+
+#endif /* XNIX_FILEMAP_H */
@@ -42,6 +42,10 @@ struct ipc_message {
 #define IPC_FLAG_NO_BLOCK ABI_IPC_FLAG_NONBLOCK
 #define IPC_FLAG_TIMEOUT  ABI_IPC_FLAG_TIMEOUT
 #define IPC_FLAG_NOREPLY  ABI_IPC_FLAG_NOREPLY /* 内核设置: 接收端无需 reply */
+#define IPC_FLAG_IOV      ABI_IPC_FLAG_IOV     /* buffer 为分散/聚集段(内核中指向 ipc_iov_desc) */
+#define IPC_FLAG_KERNEL   ABI_IPC_FLAG_KERNEL  /* 内核发出, 接收端据此信任请求来源 */
+
+#define IPC_IOV_MAX ABI_IPC_IOV_MAX
 
 /*
  * 错误处理
@@ -116,6 +120,16 @@ int ipc_reply(struct ipc_message *reply);
  */
 int ipc_reply_to(tid_t sender_tid, struct ipc_message *reply);
 
+/**
+ * 接管对 sender_tid 的延迟回复
+ *
+ * 把请求交给工作线程处理的服务调用此函数, 发送方捐出的优先级随之
+ * 转到当前线程. 只能接管本进程线程收下的请求.
+ *
+ * @return 0 成功, -EINVAL 发送方不在等待回复或不属于本进程
+ */
+int ipc_reply_adopt(tid_t sender_tid);
+
 /**
  * 等待多个对象(Endpoint 或 Event)
  */
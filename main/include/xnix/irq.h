@@ -29,10 +29,15 @@ typedef struct irq_regs irq_frame_t;
  */
 typedef void (*irq_handler_t)(irq_frame_t *frame);
 
+/* IRQ 触发模式 (irqchip_ops.set_mode) */
+#define IRQ_MODE_LEVEL      (1u << 0) /* 电平触发, 否则边沿 */
+#define IRQ_MODE_ACTIVE_LOW (1u << 1) /* 低电平有效, 否则高电平 */
+
 /**
  * @brief 中断控制器硬件抽象接口
  *
- * 具体的中断控制器驱动(PIC,APIC 等)需实现这些操作
+ * 具体的中断控制器驱动(PIC,APIC 等)需实现这些操作.
+ * route_pci/set_mode 可选, PIC 下 PCI 中断直接走 BIOS 分配的 legacy 线.
  */
 struct irqchip_ops {
     const char *name;
@@ -40,6 +45,10 @@ struct irqchip_ops {
     void (*enable)(uint8_t irq);
     void (*disable)(uint8_t irq);
     void (*eoi)(uint8_t irq);
+
+    /* 查询 PCI INTx 路由, 返回 IRQ 号并填充触发模式, 未知返回负数 */
+    int (*route_pci)(uint8_t bus, uint8_t dev, uint8_t pin, uint32_t *mode);
+    void (*set_mode)(uint8_t irq, uint32_t mode);
 };
 
 /**
@@ -89,6 +98,26 @@ void irq_set_handler(uint8_t irq, irq_handler_t handler);
  */
 void irq_dispatch(uint8_t irq, irq_frame_t *frame);
 
+/**
+ * @brief 解析 PCI 设备的中断路由
+ *
+ * 优先使用中断控制器提供的路由表(MP Table), 查不到时退回配置空间里
+ * BIOS 填写的 Interrupt Line. 电平触发的 IRQ 会被记录, 用户态驱动
+ * 收到中断后需要 irq_user_ack() 重新打开.
+ *
+ * @param bus    PCI 总线号
+ * @param dev    设备号
+ * @param pin    中断引脚 (0=INTA# ... 3=INTD#)
+ * @param legacy 配置空间 Interrupt Line (0xFF 表示未分配)
+ * @return IRQ 号,负数失败
+ */
+int irq_route_pci(uint8_t bus, uint8_t dev, uint8_t pin, uint8_t legacy);
+
+/**
+ * @brief IRQ 是否为电平触发
+ */
+bool irq_is_level(uint8_t irq);
+
 /*
  * IRQ 用户态绑定
  *
@@ -129,6 +158,15 @@ int irq_unbind_event(uint8_t irq, struct process *owner);
 void irq_user_push(uint8_t irq, uint8_t data);
 void irq_user_signal(uint8_t irq);
 
+/**
+ * @brief 用户态驱动处理完电平触发中断后重新使能
+ *
+ * @param irq   IRQ 编号
+ * @param owner 调用进程, 必须已绑定该 IRQ
+ * @return 0 成功,负数失败
+ */
+int irq_user_ack(uint8_t irq, struct process *owner);
+
 /**
  * @brief 从 IRQ 缓冲区读取数据
  *
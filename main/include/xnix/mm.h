@@ -62,6 +62,13 @@ void free_page(void *page);
  */
 void free_pages(void *page, uint32_t count);
 
+/**
+ * 判断物理区间是否与内核管理的内存重叠
+ *
+ * 用于拒绝把普通 RAM 当作设备 MMIO 暴露给用户态.
+ */
+bool page_alloc_overlaps(paddr_t addr, uint32_t size);
+
 /*
  * 内核堆分配器 (Kernel Heap)
  *
@@ -23,6 +23,9 @@ typedef enum {
     PHYSMEM_TYPE_GENERIC = 0, /* 通用物理内存 */
     PHYSMEM_TYPE_FB      = 1, /* Framebuffer */
     PHYSMEM_TYPE_SHM     = 2, /* 匿名共享内存 */
+    PHYSMEM_TYPE_DMA     = 3, /* 物理连续的 DMA 缓冲区 */
+    PHYSMEM_TYPE_MMIO    = 4, /* 设备寄存器窗口 (PCI BAR) */
+    PHYSMEM_TYPE_MODULE  = 5, /* 引导模块 (普通 RAM, 可缓存) */
 } physmem_type_t;
 
 /**
@@ -88,6 +91,15 @@ void physmem_put(struct physmem_region *region);
 handle_t physmem_create_handle_for_proc(struct process *proc, paddr_t phys_addr, uint32_t size,
                                         const char *name);
 
+/**
+ * 为引导模块创建 physmem handle
+ *
+ * 与 physmem_create_handle_for_proc 相同, 但区域是普通 RAM:
+ * 映射到 mmap 区域并启用缓存, 可以用 munmap 取消.
+ */
+handle_t physmem_create_module_handle_for_proc(struct process *proc, paddr_t phys_addr,
+                                               uint32_t size, const char *name);
+
 /**
  * 创建 framebuffer physmem handle
  *
@@ -112,6 +124,45 @@ handle_t physmem_create_fb_handle_for_proc(struct process *proc, const char *nam
 uint32_t physmem_map_to_user(struct process *proc, struct physmem_region *region, uint32_t offset,
                              uint32_t size, uint32_t prot);
 
+/**
+ * 取消 physmem_map_to_user 建立的动态映射 (SHM/DMA/MMIO/MODULE)
+ *
+ * 区间必须正好是一次映射的范围. 只清页表项, 物理页仍归 region 所有;
+ * 各核 TLB 刷新之后虚拟地址才留给之后的映射复用.
+ *
+ * @param proc 目标进程
+ * @param addr 映射起始地址 (向下对齐到页)
+ * @param size 映射大小
+ * @return 0 成功, -EINVAL 不是一段完整的 physmem 映射
+ */
+int physmem_unmap_from_user(struct process *proc, uint32_t addr, uint32_t size);
+
+/**
+ * 在进程的 mmap 区域分配一段虚拟地址 (不建立映射), 在 proc->mmaps 上登记
+ *
+ * @param proc 目标进程
+ * @param size 大小(页对齐)
+ * @param phys 是否为 physmem 映射
+ * @return 起始地址, 地址空间不足或内存不足返回 0
+ */
+uint32_t mmap_va_alloc(struct process *proc, uint32_t size, bool phys);
+
+/**
+ * 标记一段 physmem 映射正在取消, 之后的 claim 不会再选中它
+ *
+ * @return 0 成功, -EINVAL 不是一段完整的 physmem 映射或已在取消中
+ */
+int mmap_va_claim(struct process *proc, uint32_t base, uint32_t size);
+
+/**
+ * 归还 mmap_va_alloc 分配的虚拟地址 (整段或其中一部分),
+ * 调用者已清除其中的映射并刷新了 TLB
+ */
+void mmap_va_free(struct process *proc, uint32_t base, uint32_t size);
+
+/** 释放进程的全部 mmap 登记 (进程销毁时调用) */
+void mmap_va_release_process(struct process *proc);
+
 /**
  * 创建匿名共享内存区域
  *
@@ -123,4 +174,34 @@ uint32_t physmem_map_to_user(struct process *proc, struct physmem_region *region
  */
 struct physmem_region *shm_create(uint32_t size);
 
+/**
+ * 创建 DMA 缓冲区
+ *
+ * 分配物理连续的低端页并清零, 供用户态驱动填写 PRD/描述符表.
+ * 用户态通过 physmem 信息查询物理地址, 映射方式与 SHM 相同(可缓存).
+ *
+ * @param size 缓冲区大小(字节,向上对齐到页)
+ * @return physmem 对象指针,失败返回 NULL
+ */
+struct physmem_region *dma_create(uint32_t size);
+
+/**
+ * 创建设备 MMIO 区域
+ *
+ * 包装一段设备物理地址(如 PCI 内存 BAR), 不分配内存, 释放时也不归还.
+ * 映射到 mmap 区域, 禁用缓存.
+ *
+ * @param phys_addr 物理起始地址(向下对齐到页)
+ * @param size      区域大小(向上对齐到页)
+ * @return physmem 对象指针,与受管 RAM 或内核保留窗口重叠, 或失败返回 NULL
+ */
+struct physmem_region *mmio_create(paddr_t phys_addr, uint32_t size);
+
+/**
+ * 登记内核自用的设备寄存器窗口 (LAPIC, IOAPIC 等)
+ *
+ * mmio_create 拒绝与登记过的窗口重叠的请求. 只在启动阶段调用.
+ */
+void mmio_reserve(paddr_t base, uint32_t size);
+
 #endif /* XNIX_PHYSMEM_H */
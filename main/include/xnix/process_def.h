@@ -19,9 +19,12 @@
 #include <xnix/sync.h>
 #include <xnix/types.h>
 
-struct handle_table; /* 前向声明 */
-struct thread;       /* 前向声明 */
-struct page_table;   /* 前向声明 */
+struct handle_table;  /* 前向声明 */
+struct thread;        /* 前向声明 */
+struct page_table;    /* 前向声明 */
+struct ioport_bitmap; /* 前向声明 */
+struct vm_area;       /* 前向声明 */
+struct pipe_quota;    /* 前向声明 */
 
 /**
  * 同步对象表
@@ -38,6 +41,20 @@ struct sync_table {
     spinlock_t lock;                             /* 保护表操作 */
 };
 
+/**
+ * mmap 区域里一段已占用的虚拟地址
+ *
+ * physmem 动态映射和文件映射都登记在这里, 按地址升序链接.
+ * 分配时在相邻两段之间首次适配, 释放即摘下节点, 不会有回收不了的空洞.
+ */
+struct mmap_range {
+    uint32_t           base;
+    uint32_t           size;
+    bool               phys;  /* physmem 映射, 只有这类能经 physmem_unmap_from_user 取消 */
+    bool               dying; /* 正在取消: 页表项和各核 TLB 清完之前地址仍然占着 */
+    struct mmap_range *next;
+};
+
 /**
  * 进程控制块 (PCB)
  */
@@ -55,9 +72,10 @@ struct process {
     struct handle_table *handles;
 
     /* 能力 (Capability) */
-    uint32_t  cap_mask;       /* 能力位图 (CAP_*) */
-    uint8_t  *ioport_bitmap;  /* IO 端口访问表 (8KB, 按需分配, NULL=无) */
-    uint32_t  irq_mask;       /* IRQ 访问位图 (bit N = IRQ N) */
+    uint32_t              cap_mask;      /* 能力位图 (CAP_*) */
+    struct ioport_bitmap *ioport_bitmap; /* IO 端口访问表 (共享, 引用计数, NULL=无) */
+    uint32_t              irq_mask;      /* IRQ 访问位图 (bit N = IRQ N) */
+    spinlock_t            cap_lock;      /* 保护以上三项的修改和 ioport_bitmap 的读取 */
 
     /* 线程列表 */
     struct thread *threads;      /* 属于此进程的线程链表 */
@@ -73,7 +91,10 @@ struct process {
     uint32_t heap_max;     /* 堆上限(栈底之前) */
 
     /* 用户态 mmap 区域 */
-    uint32_t mmap_next;    /* 下一个可用 mmap 虚拟地址(SHM 等) */
+    uint32_t           mmap_base; /* mmap 区域起始地址 */
+    struct mmap_range *mmaps;     /* 已占用的 mmap 虚拟地址, 按地址升序 */
+    spinlock_t         mmap_lock; /* 保护 mmaps */
+    struct vm_area    *vmas;      /* 文件映射区间链表 (filemap.c) */
 
     /* 父子关系 */
     struct process *parent;
@@ -97,6 +118,8 @@ struct process {
     /* 资源统计 */
     uint32_t page_count;  /* 已分配的页数(用户空间) */
     uint32_t stack_pages; /* 栈页数 */
+
+    struct pipe_quota *pipe_quota; /* 管道扩容配额 (与管道共享, 引用计数, NULL=未扩容过) */
 };
 
 /**
@@ -83,4 +83,16 @@ void sched_tick(void);
 void sched_block(void *wait_chan);
 void sched_wakeup(void *wait_chan);
 
+/**
+ * Mutex 优先级继承
+ *
+ * sched_pi_mutex_wait     等锁线程把自己的优先级借给持锁者, 并记下所等的锁
+ * sched_pi_mutex_acquired 拿到锁后清除等待记录
+ * sched_pi_mutex_release  释放锁后按仍在等持锁者其他锁的线程重新计算继承值
+ */
+struct mutex;
+void sched_pi_mutex_wait(struct mutex *m, thread_t waiter);
+void sched_pi_mutex_acquired(thread_t t);
+void sched_pi_mutex_release(thread_t t);
+
 #endif
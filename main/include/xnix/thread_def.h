@@ -42,8 +42,17 @@ struct thread {
     const char *name;
 
     thread_state_t state;
-    int            priority;   /* 小 = 高优先级 */
-    uint32_t       time_slice; /* 剩余时间片(tick 数) */
+    int            priority;      /* 有效优先级(含继承), 小 = 高优先级 */
+    int            base_priority; /* 自身优先级 */
+    int            pi_ipc_prio;   /* IPC 调用方捐赠的优先级, THREAD_PRIO_NONE 表示无 */
+    int            pi_mutex_prio; /* 等锁线程继承来的优先级, THREAD_PRIO_NONE 表示无 */
+    uint32_t       time_slice;    /* 剩余时间片(tick 数) */
+
+    /* 优先级继承记录 (pi.c, sched_lock 保护) */
+    struct thread *pi_donee;      /* call 等 reply 期间, 优先级捐给了谁 */
+    struct thread *pi_donors;     /* 捐给本线程且尚未回复的调用方 */
+    struct thread *pi_donor_next; /* pi_donors 链接 */
+    struct mutex  *pi_wait_lock;  /* 正在等待的 mutex */
 
     struct thread_context ctx;
     void                 *stack; /* 栈底 */
@@ -78,6 +87,7 @@ struct thread {
     uint32_t            notified_bits;  /* Notification 接收到的位图 */
     bool                pending_wakeup; /* 是否有挂起的唤醒信号 */
     tid_t               ipc_peer;       /* 通信对端 TID */
+    int                 ipc_result;     /* 对端唤醒时附带的错误码 (消息未能送达), 0 表示成功 */
 
     /* 用户线程支持(仅用户态线程使用) */
     uint32_t ustack_top;      /* 用户态栈顶地址 */
@@ -94,6 +104,12 @@ struct thread {
     uint64_t cpu_ticks; /* 累计运行的 tick 数 */
 };
 
+/* 未继承任何优先级 */
+#define THREAD_PRIO_NONE 0x7FFFFFFF
+
+/* 用户线程可设置的最低优先级 (idle 线程为 255) */
+#define THREAD_PRIO_USER_MAX 254
+
 /* CPU 位图操作 */
 #define CPUS_ALL              0xFFFFFFFF /* 任意核 */
 #define CPUS_SET(mask, cpu)   ((mask) | (1U << (cpu)))
@@ -127,6 +143,12 @@ struct sched_policy {
 
     /* 选择最适合的 CPU(负载均衡) */
     cpu_id_t (*select_cpu)(struct thread *t);
+
+    /* 加入运行队列同优先级段的最前面, 保留 time_slice(时间片捐赠, 可选) */
+    void (*enqueue_front)(struct thread *t, cpu_id_t cpu);
+
+    /* 就绪线程的有效优先级变化后调整其队列位置(可选) */
+    void (*reprio)(struct thread *t);
 };
 
 /*
@@ -201,6 +223,36 @@ struct thread **sched_get_blocked_list(void);
  */
 void sched_wakeup_thread(struct thread *t);
 
+/**
+ * 唤醒线程并把 donor 的剩余时间片捐赠给它
+ *
+ * 线程被放到 donor 所在 CPU 同优先级段的队首, 用于 IPC call/reply
+ * 这类 donor 马上就要阻塞或刚完成服务的场景, 避免对端排到队尾.
+ */
+void sched_wakeup_donate(struct thread *t, struct thread *donor);
+
+/*
+ * 优先级继承 (pi.c)
+ *
+ * 有效优先级 = min(base_priority, pi_ipc_prio, pi_mutex_prio).
+ */
+
+/**
+ * IPC 调用期间把调用方优先级捐赠给服务线程, reply 时收回
+ *
+ * sched_pi_ipc_donate 调用方 donor 把优先级捐给服务线程 t (记在 donor 的 reply token 上)
+ * sched_pi_ipc_return 回复 donor 时, 从当前受赠线程 (不一定是回复者) 身上收回
+ * sched_pi_ipc_adopt  同进程的线程 t 接管对 donor 的延迟回复, 捐赠随之转移
+ */
+void sched_pi_ipc_donate(struct thread *t, struct thread *donor);
+void sched_pi_ipc_return(struct thread *donor);
+int  sched_pi_ipc_adopt(struct thread *donor, struct thread *t);
+
+/**
+ * 设置线程自身优先级, 有效优先级按继承关系重新计算
+ */
+void sched_set_base_priority(struct thread *t, int prio);
+
 /**
  * 查找阻塞的线程(用于 IPC reply)
  */
@@ -3,6 +3,8 @@
 
 #include <xnix/types.h>
 
+struct process;
+
 /**
  * 从用户地址空间复制到内核缓冲区
  *
@@ -23,4 +25,17 @@ int copy_from_user(void *dst, const void *user_src, size_t n);
  */
 int copy_to_user(void *user_dst, const void *src, size_t n);
 
+/**
+ * 从指定进程的地址空间复制到内核缓冲区
+ *
+ * 与 copy_from_user 相同, 但按 proc 的页目录解析地址,
+ * 不要求 proc 是当前进程(用于 IPC 跨地址空间搬运).
+ */
+int copy_from_proc(struct process *proc, void *dst, const void *user_src, size_t n);
+
+/**
+ * 从内核缓冲区复制到指定进程的地址空间
+ */
+int copy_to_proc(struct process *proc, void *user_dst, const void *src, size_t n);
+
 #endif /* XNIX_UACCESS_H */
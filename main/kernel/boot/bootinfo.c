@@ -95,7 +95,8 @@ void boot_handles_collect(void) {
         char                  handle_name[32];
         snprintf(handle_name, sizeof(handle_name), "boot.%s", res->name);
 
-        handle_t h = physmem_create_handle_for_proc(kproc, res->phys_addr, res->size, handle_name);
+        handle_t h = physmem_create_module_handle_for_proc(kproc, res->phys_addr, res->size,
+                                                           handle_name);
         if (h != HANDLE_INVALID) {
             pr_info("boot_handles: created %s handle %u (%u bytes)", handle_name, h, res->size);
         }
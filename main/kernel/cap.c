@@ -6,9 +6,11 @@
  */
 
 #include <xnix/cap.h>
+#include <xnix/errno.h>
 #include <xnix/mm.h>
 #include <xnix/process_def.h>
 #include <xnix/string.h>
+#include <xnix/sync.h>
 
 bool cap_check(struct process *proc, uint32_t cap) {
     if (!proc) {
@@ -24,10 +26,13 @@ bool cap_check_ioport(struct process *proc, uint16_t port) {
     if (!(proc->cap_mask & CAP_IO_PORT)) {
         return false;
     }
-    if (!proc->ioport_bitmap) {
-        return false;
-    }
-    return (proc->ioport_bitmap[port / 8] >> (port % 8)) & 1;
+
+    /* 位图可能被 cap_grant_ioport 换掉并释放, 读取要持锁 */
+    uint32_t flags = spin_lock_irqsave(&proc->cap_lock);
+    bool     ok    = proc->ioport_bitmap &&
+              ((proc->ioport_bitmap->bits[port / 8] >> (port % 8)) & 1);
+    spin_unlock_irqrestore(&proc->cap_lock, flags);
+    return ok;
 }
 
 bool cap_check_irq(struct process *proc, uint8_t irq) {
@@ -44,16 +49,75 @@ bool cap_is_subset(uint32_t child_caps, uint32_t parent_caps) {
     return (child_caps & parent_caps) == child_caps;
 }
 
-uint8_t *cap_build_ioport_bitmap(const struct spawn_caps *caps) {
+/* 0 保留给 "TSS 中尚未加载任何位图" */
+static atomic_t ioport_bitmap_next_id = ATOMIC_INIT(0);
+
+struct ioport_bitmap *ioport_bitmap_create(uint8_t fill) {
+    struct ioport_bitmap *bm = kmalloc(sizeof(struct ioport_bitmap));
+    if (!bm) {
+        return NULL;
+    }
+    atomic_set(&bm->refcount, 1);
+    bm->id = (uint32_t)atomic_inc(&ioport_bitmap_next_id);
+    memset(bm->bits, fill, sizeof(bm->bits));
+    return bm;
+}
+
+struct ioport_bitmap *ioport_bitmap_get(struct ioport_bitmap *bm) {
+    if (bm) {
+        atomic_inc(&bm->refcount);
+    }
+    return bm;
+}
+
+void ioport_bitmap_put(struct ioport_bitmap *bm) {
+    if (bm && atomic_dec(&bm->refcount) == 0) {
+        kfree(bm);
+    }
+}
+
+int cap_grant_ioport(struct process *proc, uint16_t start, uint16_t end) {
+    if (!proc || start > end) {
+        return -EINVAL;
+    }
+
+    /*
+     * 位图可能被多个进程共享(spawn 继承), 不能原地修改.
+     * 复制一份再替换, 新 id 会让 TSS 缓存在下次切换时失效.
+     * 复制和替换在 cap_lock 内完成, 并发授予不会丢失端口;
+     * 读者都持锁访问, 放锁后旧位图不再有人引用.
+     */
+    struct ioport_bitmap *bm = ioport_bitmap_create(0);
+    if (!bm) {
+        return -ENOMEM;
+    }
+
+    uint32_t              flags = spin_lock_irqsave(&proc->cap_lock);
+    struct ioport_bitmap *old   = proc->ioport_bitmap;
+    if (old) {
+        memcpy(bm->bits, old->bits, sizeof(bm->bits));
+    }
+    for (uint32_t port = start; port <= end; port++) {
+        bm->bits[port / 8] |= (1u << (port % 8));
+    }
+    proc->ioport_bitmap = bm;
+    proc->cap_mask |= CAP_IO_PORT;
+    spin_unlock_irqrestore(&proc->cap_lock, flags);
+
+    ioport_bitmap_put(old);
+    return 0;
+}
+
+struct ioport_bitmap *cap_build_ioport_bitmap(const struct spawn_caps *caps) {
     if (!caps || caps->ioport_count == 0) {
         return NULL;
     }
 
-    /* 65536 ports / 8 = 8192 bytes */
-    uint8_t *bitmap = kzalloc(8192);
-    if (!bitmap) {
+    struct ioport_bitmap *bm = ioport_bitmap_create(0);
+    if (!bm) {
         return NULL;
     }
+    uint8_t *bitmap = bm->bits;
 
     for (uint8_t i = 0; i < caps->ioport_count && i < SPAWN_IOPORT_RANGES_MAX; i++) {
         uint32_t start = caps->ioports[i].start;
@@ -63,7 +127,7 @@ uint8_t *cap_build_ioport_bitmap(const struct spawn_caps *caps) {
         }
     }
 
-    return bitmap;
+    return bm;
 }
 
 uint32_t cap_build_irq_mask(const struct spawn_caps *caps) {
@@ -6,6 +6,7 @@
 #include <arch/cpu.h>
 
 #include <ipc/endpoint.h>
+#include <ipc/iov.h>
 #include <xnix/errno.h>
 #include <xnix/handle.h>
 #include <xnix/ipc.h>
@@ -99,20 +100,34 @@ handle_t endpoint_create(const char *name) {
 /**
  * 从 Sender 拷贝消息到 Receiver
  *
- * 注意:buffer.data 在此处已经是内核缓冲区(由 sys_ipc.c 的
+ * 注意:普通 buffer.data 在此处已经是内核缓冲区(由 sys_ipc.c 的
  * copy_from_user/copy_to_user 处理),所以直接 memcpy 是安全的.
+ * IPC_FLAG_IOV 的 buffer.data 指向 ipc_iov_desc, 段仍在用户空间.
+ *
+ * @return 0 成功, 负数表示 IOV 段搬运失败 (消息作废, 不传 handle)
  */
-static void ipc_copy_msg(struct thread *src, struct thread *dst, struct ipc_message *src_msg,
-                         struct ipc_message *dst_msg) {
+static int ipc_copy_msg(struct thread *src, struct thread *dst, struct ipc_message *src_msg,
+                        struct ipc_message *dst_msg) {
     if (!src_msg || !dst_msg) {
-        return;
+        return 0;
     }
 
     /* 拷贝寄存器 */
     memcpy(&dst_msg->regs, &src_msg->regs, sizeof(struct ipc_msg_regs));
 
-    /* 拷贝 Buffer(内核缓冲区之间) */
-    if (src_msg->buffer.data && src_msg->buffer.size > 0 && dst_msg->buffer.data &&
+    /* 来源标志: 接收端据此区分内核代发的请求 */
+    dst_msg->flags = (dst_msg->flags & ~IPC_FLAG_KERNEL) | (src_msg->flags & IPC_FLAG_KERNEL);
+
+    /* 拷贝 Buffer: 任一端为 IOV 时按段直接在两个地址空间之间搬运 */
+    if ((src_msg->flags | dst_msg->flags) & IPC_FLAG_IOV) {
+        int n = ipc_iov_transfer(dst->owner, dst_msg, src->owner, src_msg);
+        if (n < 0) {
+            dst_msg->buffer.size   = 0;
+            dst_msg->handles.count = 0;
+            return n;
+        }
+        dst_msg->buffer.size = (uint32_t)n;
+    } else if (src_msg->buffer.data && src_msg->buffer.size > 0 && dst_msg->buffer.data &&
         dst_msg->buffer.size >= src_msg->buffer.size) {
         memcpy((void *)(uintptr_t)dst_msg->buffer.data, (void *)(uintptr_t)src_msg->buffer.data,
                src_msg->buffer.size);
@@ -133,14 +148,15 @@ static void ipc_copy_msg(struct thread *src, struct thread *dst, struct ipc_mess
                         "CAP_HANDLE_GRANT capability, %u handle(s) dropped\n",
                         src_proc->name ? src_proc->name : "?", src_proc->pid,
                         src_msg->handles.count);
-                return;
+                return 0;
             }
             for (uint32_t i = 0; i < src_msg->handles.count; i++) {
                 handle_t src_handle = src_msg->handles.handles[i];
 
-                /* 传递 Handle 到接收者进程 */
+                /* 传递 Handle 到接收者进程, SERVE 不随消息转移 */
                 handle_t dst_handle =
-                    handle_transfer(src_proc, src_handle, dst_proc, NULL, HANDLE_INVALID, 0);
+                    handle_transfer(src_proc, src_handle, dst_proc, NULL, HANDLE_INVALID,
+                                    HANDLE_RIGHT_ALL & ~HANDLE_RIGHT_SERVE);
 
                 if (dst_handle != HANDLE_INVALID) {
                     dst_msg->handles.handles[dst_msg->handles.count++] = dst_handle;
@@ -148,6 +164,22 @@ static void ipc_copy_msg(struct thread *src, struct thread *dst, struct ipc_mess
             }
         }
     }
+    return 0;
+}
+
+/* 消息没能送达: 带着错误码唤醒阻塞中的对端 */
+static void ipc_fail_peer(struct thread *t, int err) {
+    t->ipc_result    = err;
+    t->ipc_req_msg   = NULL;
+    t->ipc_reply_msg = NULL;
+    sched_wakeup_thread(t);
+}
+
+/* 取出被唤醒时对端附带的结果 */
+static int ipc_take_result(struct thread *t) {
+    int ret       = t->ipc_result;
+    t->ipc_result = 0;
+    return ret;
 }
 
 static bool ipc_msg_is_one_way(const struct ipc_message *msg) {
@@ -170,6 +202,7 @@ static int ipc_send_to_ep(struct ipc_endpoint *ep, struct ipc_message *msg,
     if (!current) {
         return -EINVAL;
     }
+    current->ipc_result = 0;
 
     spin_lock(&ep->lock);
 
@@ -181,12 +214,23 @@ static int ipc_send_to_ep(struct ipc_endpoint *ep, struct ipc_message *msg,
         spin_unlock(&ep->lock);
         endpoint_unref(ep);
 
-        /* 拷贝消息到接收者 */
-        ipc_copy_msg(current, receiver, msg, receiver->ipc_reply_msg);
+        /* 拷贝消息到接收者; 失败时接收方这次 receive 返回 -EAGAIN, 错误交给发送方 */
+        int err = ipc_copy_msg(current, receiver, msg, receiver->ipc_reply_msg);
+        if (err < 0) {
+            ipc_fail_peer(receiver, -EAGAIN);
+            return err;
+        }
         receiver->ipc_peer                  = current->tid;
         receiver->ipc_reply_msg->sender_tid = current->tid;
         receiver->ipc_reply_msg->sender_pid = current->owner ? current->owner->pid : 0;
-        sched_wakeup_thread(receiver);
+
+        if (one_way) {
+            sched_wakeup_thread(receiver);
+        } else {
+            /* call: 调用方马上阻塞, 把优先级和剩余时间片捐给服务线程, reply 时收回 */
+            sched_pi_ipc_donate(receiver, current);
+            sched_wakeup_donate(receiver, current);
+        }
 
         pr_debug("[IPC] send -> recv: sender=%d receiver=%d\n", current->tid, receiver->tid);
 
@@ -204,11 +248,12 @@ static int ipc_send_to_ep(struct ipc_endpoint *ep, struct ipc_message *msg,
             pr_debug("[IPC] send reply timeout: sender=%d\n", current->tid);
             current->ipc_req_msg   = NULL;
             current->ipc_reply_msg = NULL;
+            sched_pi_ipc_return(current);
             return -ETIMEDOUT;
         }
         current->ipc_req_msg   = NULL;
         current->ipc_reply_msg = NULL;
-        return 0;
+        return ipc_take_result(current);
     }
 
     /* 没有接收者,加入发送队列 */
@@ -249,7 +294,7 @@ static int ipc_send_to_ep(struct ipc_endpoint *ep, struct ipc_message *msg,
         }
         current->ipc_req_msg   = NULL;
         current->ipc_reply_msg = NULL;
-        return 0;
+        return ipc_take_result(current);
     }
 
     /* 阻塞等待接收者 */
@@ -270,12 +315,14 @@ static int ipc_send_to_ep(struct ipc_endpoint *ep, struct ipc_message *msg,
         endpoint_unref(ep);
         current->ipc_req_msg   = NULL;
         current->ipc_reply_msg = NULL;
+        /* 可能已被服务线程取走并捐出了优先级 */
+        sched_pi_ipc_return(current);
         return -ETIMEDOUT;
     }
 
     current->ipc_req_msg   = NULL;
     current->ipc_reply_msg = NULL;
-    return 0;
+    return ipc_take_result(current);
 }
 
 int ipc_send(handle_t ep_handle, struct ipc_message *msg, uint32_t timeout_ms) {
@@ -355,8 +402,10 @@ int ipc_receive(handle_t ep_handle, struct ipc_message *msg, uint32_t timeout_ms
         return -EPERM;
     }
 
-    current = sched_current();
+    current             = sched_current();
+    current->ipc_result = 0;
 
+again:
     spin_lock(&ep->lock);
 
     /* 检查发送队列(同步发送者) */
@@ -367,8 +416,12 @@ int ipc_receive(handle_t ep_handle, struct ipc_message *msg, uint32_t timeout_ms
         spin_unlock(&ep->lock);
         endpoint_unref(ep);
 
-        /* 拷贝消息: Sender -> Current(Receiver) */
-        ipc_copy_msg(sender, current, sender->ipc_req_msg, msg);
+        /* 拷贝消息: Sender -> Current(Receiver); 送不到就把错误还给发送方, 接着收下一条 */
+        int err = ipc_copy_msg(sender, current, sender->ipc_req_msg, msg);
+        if (err < 0) {
+            ipc_fail_peer(sender, err);
+            goto again;
+        }
 
         /* 记录发送者 */
         current->ipc_peer = sender->tid;
@@ -387,7 +440,8 @@ int ipc_receive(handle_t ep_handle, struct ipc_message *msg, uint32_t timeout_ms
             return 0;
         }
 
-        /* call: 发送方继续阻塞等待 reply */
+        /* call: 发送方继续阻塞等待 reply, 期间服务线程以发送方优先级运行 */
+        sched_pi_ipc_donate(current, sender);
         handle_object_put(entry.type, entry.object);
         return 0;
     }
@@ -423,9 +477,9 @@ int ipc_receive(handle_t ep_handle, struct ipc_message *msg, uint32_t timeout_ms
         return -ETIMEDOUT;
     }
 
-    /* 被唤醒,说明收到消息了 */
+    /* 被唤醒,说明收到消息了 (或发送方的消息没能送达) */
     handle_object_put(entry.type, entry.object);
-    return 0;
+    return ipc_take_result(current);
 }
 
 /**
@@ -458,21 +512,24 @@ int ipc_reply(struct ipc_message *reply) {
         return -EINVAL;
     }
 
-    /* 拷贝 Reply: Current(Receiver) -> Sender */
+    /* 拷贝 Reply: Current(Receiver) -> Sender, 失败时发送方的 call 返回同一错误 */
+    int err = 0;
     if (reply && sender->ipc_reply_msg) {
-        ipc_copy_msg(current, sender, reply, sender->ipc_reply_msg);
+        err = ipc_copy_msg(current, sender, reply, sender->ipc_reply_msg);
     }
 
     current->ipc_peer = TID_INVALID;
     sender->ipc_req_msg = NULL;
     sender->ipc_reply_msg = NULL;
+    sender->ipc_result    = err;
 
-    /* 唤醒发送者 */
-    sched_wakeup_thread(sender);
+    /* 收回发送者捐出的优先级, 剩余时间片还给发送者 */
+    sched_pi_ipc_return(sender);
+    sched_wakeup_donate(sender, current);
 
     pr_debug("[IPC] reply: sender=%d receiver=%d\n", current->tid, sender->tid);
 
-    return 0;
+    return err;
 }
 
 /**
@@ -498,20 +555,41 @@ int ipc_reply_to(tid_t sender_tid, struct ipc_message *reply) {
         return -EINVAL;
     }
 
-    /* 拷贝 Reply: Current -> Sender */
+    /* 拷贝 Reply: Current -> Sender, 失败时发送方的 call 返回同一错误 */
+    int err = 0;
     if (reply && sender->ipc_reply_msg) {
-        ipc_copy_msg(current, sender, reply, sender->ipc_reply_msg);
+        err = ipc_copy_msg(current, sender, reply, sender->ipc_reply_msg);
     }
 
     sender->ipc_req_msg = NULL;
     sender->ipc_reply_msg = NULL;
+    sender->ipc_result    = err;
 
-    /* 唤醒发送者 */
-    sched_wakeup_thread(sender);
+    /* 从当前持有这次捐赠的线程身上收回 (不一定是回复者), 剩余时间片还给发送者 */
+    sched_pi_ipc_return(sender);
+    sched_wakeup_donate(sender, current);
 
     pr_debug("[IPC] reply_to: sender=%d receiver=%d\n", current->tid, sender->tid);
 
-    return 0;
+    return err;
+}
+
+/**
+ * 接管延迟回复: 当前线程将负责回复 sender_tid
+ * 发送方捐出的优先级从原受赠线程转到当前线程.
+ */
+int ipc_reply_adopt(tid_t sender_tid) {
+    struct thread *current = sched_current();
+
+    if (!current || sender_tid == TID_INVALID) {
+        return -EINVAL;
+    }
+
+    struct thread *sender = sched_lookup_blocked(sender_tid);
+    if (!sender || !sender->ipc_reply_msg) {
+        return -EINVAL;
+    }
+    return sched_pi_ipc_adopt(sender, current);
 }
 
 void ipc_init(void) {
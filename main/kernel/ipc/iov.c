@@ -0,0 +1,165 @@
+/**
+ * @file iov.c
+ * @brief IPC 分散/聚集传输
+ *
+ * 把两端的 buffer 都看成段序列(普通内核缓冲区是 1 段, proc=NULL),
+ * 逐段推进游标搬运. 用户 -> 用户时经一页中转缓冲区, 因为每个 CPU
+ * 只有一个 kmap 窗口, 不能同时映射两边的物理页.
+ */
+
+#include <arch/mmu.h>
+
+#include <ipc/iov.h>
+#include <xnix/errno.h>
+#include <xnix/mm.h>
+#include <xnix/string.h>
+#include <xnix/usraccess.h>
+
+/* 段游标 */
+struct iov_cursor {
+    struct process             *proc; /* NULL 表示内核地址 */
+    const struct abi_ipc_iovec *seg;
+    uint32_t                    count;
+    uint32_t                    idx;
+    uint32_t                    off;
+    struct abi_ipc_iovec        single; /* 普通 buffer 包装成 1 段 */
+};
+
+int ipc_iov_desc_create(const void *user_iov, uint32_t count, struct ipc_iov_desc **out) {
+    if (!out || !user_iov || count == 0 || count > IPC_IOV_MAX) {
+        return -EINVAL;
+    }
+
+    struct ipc_iov_desc *desc = kzalloc(sizeof(*desc));
+    if (!desc) {
+        return -ENOMEM;
+    }
+
+    int ret = copy_from_user(desc->seg, user_iov, count * sizeof(struct abi_ipc_iovec));
+    if (ret < 0) {
+        kfree(desc);
+        return ret;
+    }
+
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t size = desc->seg[i].size;
+        if (size && !desc->seg[i].data) {
+            kfree(desc);
+            return -EINVAL;
+        }
+        if (total + size < total) {
+            kfree(desc);
+            return -EOVERFLOW;
+        }
+        total += size;
+    }
+
+    desc->count = count;
+    desc->total = total;
+    *out        = desc;
+    return 0;
+}
+
+static void iov_cursor_init(struct iov_cursor *c, struct process *proc,
+                            const struct ipc_message *msg) {
+    memset(c, 0, sizeof(*c));
+
+    if (msg->flags & IPC_FLAG_IOV) {
+        const struct ipc_iov_desc *desc = (const void *)(uintptr_t)msg->buffer.data;
+        c->proc  = proc;
+        c->seg   = desc ? desc->seg : NULL;
+        c->count = desc ? desc->count : 0;
+        return;
+    }
+
+    /* 普通 buffer 已被 sys_ipc.c 拷进内核 */
+    c->single.data = msg->buffer.data;
+    c->single.size = msg->buffer.data ? msg->buffer.size : 0;
+    c->seg         = &c->single;
+    c->count       = 1;
+}
+
+/* 跳过空段, 返回当前段剩余字节数(0 表示耗尽) */
+static uint32_t iov_cursor_avail(struct iov_cursor *c) {
+    while (c->idx < c->count) {
+        uint32_t left = c->seg[c->idx].size - c->off;
+        if (left) {
+            return left;
+        }
+        c->idx++;
+        c->off = 0;
+    }
+    return 0;
+}
+
+static uintptr_t iov_cursor_addr(const struct iov_cursor *c) {
+    return (uintptr_t)c->seg[c->idx].data + c->off;
+}
+
+static void iov_cursor_advance(struct iov_cursor *c, uint32_t n) {
+    c->off += n;
+}
+
+int ipc_iov_transfer(struct process *dst_proc, const struct ipc_message *dst_msg,
+                     struct process *src_proc, const struct ipc_message *src_msg) {
+    struct iov_cursor src, dst;
+    uint8_t          *bounce = NULL;
+    uint32_t          copied = 0;
+    int               ret    = 0;
+
+    if (!dst_msg || !src_msg) {
+        return -EINVAL;
+    }
+
+    iov_cursor_init(&src, src_proc, src_msg);
+    iov_cursor_init(&dst, dst_proc, dst_msg);
+
+    if (src.proc && dst.proc) {
+        bounce = kmalloc(PAGE_SIZE);
+        if (!bounce) {
+            return -ENOMEM;
+        }
+    }
+
+    for (;;) {
+        uint32_t s = iov_cursor_avail(&src);
+        uint32_t d = iov_cursor_avail(&dst);
+        if (!s || !d) {
+            break;
+        }
+
+        uint32_t n = s < d ? s : d;
+        if (bounce && n > PAGE_SIZE) {
+            n = PAGE_SIZE;
+        }
+
+        void *sp = (void *)iov_cursor_addr(&src);
+        void *dp = (void *)iov_cursor_addr(&dst);
+
+        if (!src.proc && !dst.proc) {
+            memcpy(dp, sp, n);
+        } else if (!src.proc) {
+            ret = copy_to_proc(dst.proc, dp, sp, n);
+        } else if (!dst.proc) {
+            ret = copy_from_proc(src.proc, dp, sp, n);
+        } else {
+            ret = copy_from_proc(src.proc, bounce, sp, n);
+            if (ret == 0) {
+                ret = copy_to_proc(dst.proc, dp, bounce, n);
+            }
+        }
+        if (ret < 0) {
+            break;
+        }
+
+        iov_cursor_advance(&src, n);
+        iov_cursor_advance(&dst, n);
+        copied += n;
+    }
+
+    if (bounce) {
+        kfree(bounce);
+    }
+    return ret < 0 ? ret : (int)copied;
+}
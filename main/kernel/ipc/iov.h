@@ -0,0 +1,42 @@
+#ifndef KERNEL_IPC_IOV_H
+#define KERNEL_IPC_IOV_H
+
+#include <xnix/ipc.h>
+#include <xnix/types.h>
+
+struct process;
+
+/**
+ * 内核侧分散/聚集描述
+ *
+ * IPC_FLAG_IOV 消息在内核中 buffer.data 指向本结构(由 sys_ipc.c 分配),
+ * 段地址仍是所属进程的用户虚拟地址, 会合时才真正搬运数据.
+ */
+struct ipc_iov_desc {
+    uint32_t             count;
+    uint32_t             total; /* 各段长度之和 */
+    struct abi_ipc_iovec seg[IPC_IOV_MAX];
+};
+
+/**
+ * 从用户态 iovec 数组构建描述
+ *
+ * @param user_iov 用户空间 abi_ipc_iovec 数组
+ * @param count    段数
+ * @param out      输出描述(kmalloc 分配, 调用者 kfree)
+ * @return 0 成功, 负数失败
+ */
+int ipc_iov_desc_create(const void *user_iov, uint32_t count, struct ipc_iov_desc **out);
+
+/**
+ * 在两条消息之间搬运 buffer 数据
+ *
+ * 任一端可以是普通内核缓冲区或 IOV 描述. 用户段按各自进程的页目录解析,
+ * 不要求其中任何一方是当前进程.
+ *
+ * @return 实际拷贝的字节数, 负数失败
+ */
+int ipc_iov_transfer(struct process *dst_proc, const struct ipc_message *dst_msg,
+                     struct process *src_proc, const struct ipc_message *src_msg);
+
+#endif /* KERNEL_IPC_IOV_H */
@@ -7,23 +7,112 @@
  */
 
 #include <arch/cpu.h>
+#include <arch/mmu.h>
 
 #include <ipc/pipe.h>
+#include <xnix/cap.h>
 #include <xnix/errno.h>
 #include <xnix/handle.h>
 #include <xnix/mm.h>
 #include <xnix/process.h>
+#include <xnix/process_def.h>
+#include <xnix/string.h>
 #include <xnix/thread_def.h>
 #include <xnix/usraccess.h>
 
 /* ---- 环形缓冲区 ---- */
 
-static uint32_t ring_used(struct ipc_pipe *p) {
-    return (p->tail - p->head + PIPE_BUF_SIZE) % PIPE_BUF_SIZE;
+static uint32_t ring_free(struct ipc_pipe *p) {
+    return p->capacity - p->used;
 }
 
-static uint32_t ring_free(struct ipc_pipe *p) {
-    return PIPE_BUF_SIZE - 1 - ring_used(p);
+/*
+ * 写者唤醒水位: 读者腾出的空间达到容量一半(或读空)才唤醒阻塞写者,
+ * 避免每读几个字节就来回切换一次.
+ */
+static bool ring_writer_wake_ok(struct ipc_pipe *p) {
+    return p->used == 0 || ring_free(p) >= p->capacity / 2;
+}
+
+/**
+ * 从环形缓冲区拷出到用户空间, 最多两段连续区间
+ * 调用者已占住 p->reading 且不持 p->lock; 不推进 head, 由调用者回到锁内提交.
+ */
+static int ring_copy_out(struct ipc_pipe *p, uint8_t *ubuf, uint32_t n) {
+    uint32_t first = p->capacity - p->head;
+    if (first > n) {
+        first = n;
+    }
+
+    int ret = copy_to_user(ubuf, p->buf + p->head, first);
+    if (ret == 0 && n > first) {
+        ret = copy_to_user(ubuf + first, p->buf, n - first);
+    }
+    return ret;
+}
+
+/**
+ * 从用户空间拷入环形缓冲区 tail 处, 最多两段连续区间
+ * 调用者已占住 p->writing 且不持 p->lock; tail 须在锁内取得 (读者会并发推进 head).
+ */
+static int ring_copy_in(struct ipc_pipe *p, uint32_t tail, const uint8_t *ubuf, uint32_t n) {
+    uint32_t first = p->capacity - tail;
+    if (first > n) {
+        first = n;
+    }
+
+    int ret = copy_from_user(p->buf + tail, ubuf, first);
+    if (ret == 0 && n > first) {
+        ret = copy_from_user(p->buf, ubuf + first, n - first);
+    }
+    return ret;
+}
+
+/* ---- 扩容配额 ---- */
+
+static spinlock_t g_pipe_quota_lock = SPINLOCK_INIT;
+
+void pipe_quota_put(struct pipe_quota *quota) {
+    if (!quota) return;
+
+    spin_lock(&g_pipe_quota_lock);
+    bool last = --quota->refcount == 0;
+    spin_unlock(&g_pipe_quota_lock);
+
+    if (last) {
+        kfree(quota);
+    }
+}
+
+/**
+ * 把管道的扩容字节从原配额转到 quota 上, 超限返回 -ENOMEM
+ * 调用者持有 p->lock. 原配额的引用转交给调用者释放.
+ */
+static int pipe_quota_charge(struct ipc_pipe *p, struct pipe_quota *quota, uint32_t charge,
+                             bool unlimited, struct pipe_quota **old) {
+    spin_lock(&g_pipe_quota_lock);
+
+    uint32_t have = quota->bytes;
+    if (p->quota == quota) {
+        have -= p->charge;
+    }
+    if (!unlimited && have + charge > CFG_PIPE_PROC_LIMIT) {
+        spin_unlock(&g_pipe_quota_lock);
+        return -ENOMEM;
+    }
+
+    if (p->quota) {
+        p->quota->bytes -= p->charge;
+    }
+    *old = p->quota;
+
+    quota->bytes += charge;
+    quota->refcount++;
+    p->quota  = quota;
+    p->charge = charge;
+
+    spin_unlock(&g_pipe_quota_lock);
+    return 0;
 }
 
 /* ---- 引用计数 ---- */
@@ -46,6 +135,13 @@ void pipe_unref(void *ptr) {
     p->refcount--;
     if (p->refcount == 0) {
         cpu_irq_restore(flags);
+        if (p->quota) {
+            spin_lock(&g_pipe_quota_lock);
+            p->quota->bytes -= p->charge;
+            spin_unlock(&g_pipe_quota_lock);
+            pipe_quota_put(p->quota);
+        }
+        kfree(p->buf);
         kfree(p);
         return;
     }
@@ -152,13 +248,21 @@ int pipe_create(handle_t *read_h, handle_t *write_h) {
     p = kzalloc(sizeof(*p));
     if (!p) return -ENOMEM;
 
+    p->buf = kmalloc(PIPE_BUF_DEFAULT);
+    if (!p->buf) {
+        kfree(p);
+        return -ENOMEM;
+    }
+
     spin_init(&p->lock);
+    p->capacity     = PIPE_BUF_DEFAULT;
     p->refcount     = 2; /* 读端 + 写端 各持有一个引用 */
     p->reader_count = 1;
     p->writer_count = 1;
 
     rh = handle_alloc(proc, HANDLE_PIPE_READ, p, NULL);
     if (rh == HANDLE_INVALID) {
+        kfree(p->buf);
         kfree(p);
         return -ENOMEM;
     }
@@ -177,63 +281,62 @@ int pipe_create(handle_t *read_h, handle_t *write_h) {
 
 /* ---- 读 ---- */
 
-int pipe_read(struct ipc_pipe *p, void *ubuf, uint32_t size) {
+int pipe_read(struct ipc_pipe *p, void *ubuf, uint32_t size, uint32_t flags) {
     struct thread *current = sched_current();
-    uint32_t       total   = 0;
 
     if (!p || !ubuf || size == 0) return -EINVAL;
 
     spin_lock(&p->lock);
 
     for (;;) {
-        uint32_t avail = ring_used(p);
-
-        if (avail > 0) {
-            /* 有数据, 尽可能多读 */
-            uint32_t n = avail;
-            if (n > size - total) n = size - total;
+        if (p->used > 0 && !p->reading) {
+            /* 有数据, 占住读端后放锁分段拷走尽可能多的字节 */
+            uint32_t total = 0;
+            int      ret   = 0;
 
-            /* 从环形缓冲区拷贝到用户空间 */
-            for (uint32_t i = 0; i < n; i++) {
-                uint8_t byte = p->buf[p->head];
-                p->head = (p->head + 1) % PIPE_BUF_SIZE;
+            p->reading = true;
+            while (ret == 0 && total < size && p->used > 0) {
+                uint32_t n = size - total;
+                if (n > p->used) n = p->used;
+                if (n > PIPE_COPY_CHUNK) n = PIPE_COPY_CHUNK;
 
                 spin_unlock(&p->lock);
-                int ret = copy_to_user((uint8_t *)ubuf + total + i, &byte, 1);
+                ret = ring_copy_out(p, (uint8_t *)ubuf + total, n);
                 spin_lock(&p->lock);
 
-                if (ret < 0) {
-                    /* 唤醒写者(已腾出空间) */
-                    wakeup_all(&p->write_queue);
-                    spin_unlock(&p->lock);
-                    return total > 0 ? (int)total : ret;
+                if (ret == 0) {
+                    p->head = (p->head + n) % p->capacity;
+                    p->used -= n;
+                    total += n;
+
+                    /* 阻塞写者只在越过水位后唤醒 */
+                    if (p->write_queue && ring_writer_wake_ok(p)) {
+                        wakeup_all(&p->write_queue);
+                    }
                 }
             }
+            p->reading = false;
 
-            total += n;
-
-            /* 唤醒阻塞写者(已腾出空间) */
-            wakeup_all(&p->write_queue);
-
-            /* 已读够请求的量, 返回 */
+            /* 等 reading 的其他读者重新竞争 */
+            if (p->read_queue && p->used > 0) {
+                wakeup_all(&p->read_queue);
+            }
             spin_unlock(&p->lock);
-            return (int)total;
+            return total > 0 ? (int)total : ret;
         }
 
-        /* 缓冲区空 */
-        if (total > 0) {
-            /* 已经读到一些数据, 返回 */
+        if (p->used == 0 && p->writer_count == 0) {
+            /* 写端全部关闭 → EOF */
             spin_unlock(&p->lock);
-            return (int)total;
+            return 0;
         }
 
-        if (p->writer_count == 0) {
-            /* 写端全部关闭 → EOF */
+        if (flags & PIPE_NONBLOCK) {
             spin_unlock(&p->lock);
-            return 0;
+            return -EAGAIN;
         }
 
-        /* 阻塞等待数据 */
+        /* 阻塞等待数据 (或等其他读者拷完) */
         enqueue_thread(&p->read_queue, current);
         spin_unlock(&p->lock);
 
@@ -251,7 +354,7 @@ int pipe_read(struct ipc_pipe *p, void *ubuf, uint32_t size) {
 
 /* ---- 写 ---- */
 
-int pipe_write(struct ipc_pipe *p, const void *ubuf, uint32_t size) {
+int pipe_write(struct ipc_pipe *p, const void *ubuf, uint32_t size, uint32_t flags) {
     struct thread *current = sched_current();
     uint32_t       total   = 0;
 
@@ -263,48 +366,57 @@ int pipe_write(struct ipc_pipe *p, const void *ubuf, uint32_t size) {
         if (p->reader_count == 0) {
             /* 读端全部关闭 → EPIPE */
             spin_unlock(&p->lock);
-            return -EPIPE;
+            return total > 0 ? (int)total : -EPIPE;
         }
 
-        uint32_t space = ring_free(p);
-        if (space > 0) {
-            uint32_t n = size - total;
-            if (n > space) n = space;
+        if (ring_free(p) > 0 && !p->writing) {
+            /* 占住写端, 放锁分段填满空闲区间 */
+            uint32_t start = total;
+            int      ret   = 0;
+
+            p->writing = true;
+            while (ret == 0 && total < size && p->reader_count > 0 && ring_free(p) > 0) {
+                uint32_t n = size - total;
+                if (n > ring_free(p)) n = ring_free(p);
+                if (n > PIPE_COPY_CHUNK) n = PIPE_COPY_CHUNK;
+                uint32_t tail = (p->head + p->used) % p->capacity;
 
-            /* 从用户空间拷贝到环形缓冲区 */
-            for (uint32_t i = 0; i < n; i++) {
-                uint8_t byte;
                 spin_unlock(&p->lock);
-                int ret = copy_from_user(&byte, (const uint8_t *)ubuf + total + i, 1);
+                ret = ring_copy_in(p, tail, (const uint8_t *)ubuf + total, n);
                 spin_lock(&p->lock);
 
-                if (ret < 0) {
-                    wakeup_all(&p->read_queue);
-                    poll_wakeup(p->poll_queue);
-                    spin_unlock(&p->lock);
-                    return total > 0 ? (int)total : ret;
+                if (ret == 0) {
+                    p->used += n;
+                    total += n;
                 }
-
-                p->buf[p->tail] = byte;
-                p->tail = (p->tail + 1) % PIPE_BUF_SIZE;
             }
+            p->writing = false;
 
-            total += n;
-
-            /* 唤醒阻塞读者(有数据了) */
-            wakeup_all(&p->read_queue);
-            poll_wakeup(p->poll_queue);
+            /* 等 writing 的其他写者重新竞争 */
+            if (p->write_queue && ring_free(p) > 0) {
+                wakeup_all(&p->write_queue);
+            }
+            if (total > start) {
+                wakeup_all(&p->read_queue);
+                poll_wakeup(p->poll_queue);
+            }
 
-            if (total >= size) {
+            if (ret < 0 || total >= size) {
                 spin_unlock(&p->lock);
-                return (int)total;
+                return total > 0 ? (int)total : ret;
             }
-
-            /* 还有更多数据要写, 继续循环 */
             continue;
         }
 
-        /* 缓冲区满, 阻塞等待空间 */
+        /* 缓冲区满: 先让读者消费, 再阻塞等待空间 (或等其他写者拷完) */
+        wakeup_all(&p->read_queue);
+        poll_wakeup(p->poll_queue);
+
+        if (flags & PIPE_NONBLOCK) {
+            spin_unlock(&p->lock);
+            return total > 0 ? (int)total : -EAGAIN;
+        }
+
         enqueue_thread(&p->write_queue, current);
         spin_unlock(&p->lock);
 
@@ -318,3 +430,90 @@ int pipe_write(struct ipc_pipe *p, const void *ubuf, uint32_t size) {
         spin_lock(&p->lock);
     }
 }
+
+/* ---- 容量调整 ---- */
+
+int pipe_set_size(struct ipc_pipe *p, uint32_t size) {
+    struct process *proc = process_current();
+
+    if (!p || !proc) return -EINVAL;
+
+    if (size == 0) {
+        return (int)p->capacity;
+    }
+
+    if (size < PIPE_BUF_MIN) size = PIPE_BUF_MIN;
+    if (size > PIPE_BUF_MAX) size = PIPE_BUF_MAX;
+    size = PAGE_ALIGN_UP(size);
+
+    /* 首次扩容时为进程建立配额 */
+    struct pipe_quota *quota = NULL;
+    uint32_t charge = size > PIPE_BUF_DEFAULT ? size - PIPE_BUF_DEFAULT : 0;
+    if (charge > 0) {
+        if (!proc->pipe_quota) {
+            struct pipe_quota *q = kzalloc(sizeof(*q));
+            if (!q) return -ENOMEM;
+            q->refcount = 1;
+
+            spin_lock(&g_pipe_quota_lock);
+            if (!proc->pipe_quota) {
+                proc->pipe_quota = q;
+                q = NULL;
+            }
+            spin_unlock(&g_pipe_quota_lock);
+            kfree(q);
+        }
+        quota = proc->pipe_quota;
+    }
+
+    uint8_t *nbuf = kmalloc(size);
+    if (!nbuf) return -ENOMEM;
+
+    spin_lock(&p->lock);
+
+    /* 有人在锁外拷贝时不能换缓冲区 */
+    if (p->used > size || p->reading || p->writing) {
+        spin_unlock(&p->lock);
+        kfree(nbuf);
+        return -EBUSY;
+    }
+
+    struct pipe_quota *old = NULL;
+    if (quota) {
+        int ret = pipe_quota_charge(p, quota, charge, cap_check(proc, CAP_MM_MMAP), &old);
+        if (ret < 0) {
+            spin_unlock(&p->lock);
+            kfree(nbuf);
+            return ret;
+        }
+    } else if (p->quota) {
+        /* 缩回默认容量, 归还原配额 */
+        spin_lock(&g_pipe_quota_lock);
+        p->quota->bytes -= p->charge;
+        spin_unlock(&g_pipe_quota_lock);
+        old       = p->quota;
+        p->quota  = NULL;
+        p->charge = 0;
+    }
+
+    /* 把现有数据线性化搬到新缓冲区头部 */
+    uint32_t first = p->capacity - p->head;
+    if (first > p->used) first = p->used;
+    memcpy(nbuf, p->buf + p->head, first);
+    memcpy(nbuf + first, p->buf, p->used - first);
+
+    uint8_t *obuf = p->buf;
+    p->buf        = nbuf;
+    p->capacity   = size;
+    p->head       = 0;
+
+    /* 扩容后可能腾出空间 */
+    if (p->write_queue && ring_writer_wake_ok(p)) {
+        wakeup_all(&p->write_queue);
+    }
+    spin_unlock(&p->lock);
+
+    pipe_quota_put(old);
+    kfree(obuf);
+    return (int)size;
+}
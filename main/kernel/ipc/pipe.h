@@ -3,12 +3,22 @@
 
 #include <ipc/wait.h>
 #include <xnix/abi/handle.h>
+#include <xnix/abi/pipe.h>
+#include <xnix/config.h>
 #include <xnix/sync.h>
 #include <xnix/types.h>
 
 struct thread;
+struct process;
 
-#define PIPE_BUF_SIZE 4096
+#define PIPE_BUF_MIN     4096
+#define PIPE_BUF_DEFAULT CFG_PIPE_DEFAULT_SIZE
+#define PIPE_BUF_MAX     CFG_PIPE_MAX_SIZE
+
+/* 单次不持锁拷贝的最大字节数, 拷完一段回到锁内提交再继续 */
+#define PIPE_COPY_CHUNK 4096
+
+#define PIPE_NONBLOCK ABI_PIPE_NONBLOCK
 
 /**
  * 内核管道对象
@@ -16,20 +26,43 @@ struct thread;
  * 字节流通道: 有内核缓冲区, 支持阻塞读写, EOF/EPIPE 语义.
  * 关闭写端 → 读者收到 EOF (read 返回 0).
  * 关闭读端 → 写者收到 EPIPE (write 返回 -EPIPE).
+ *
+ * 环形缓冲区容量可通过 pipe_set_size 调整.
+ * 用户拷贝不持 lock: 读者/写者先在锁内占住 reading/writing, 放锁分段拷贝,
+ * 再回到锁内推进 head/used. 读者只碰已用区间, 写者只碰空闲区间, 互不重叠.
  */
 struct ipc_pipe {
     spinlock_t     lock;
-    uint8_t        buf[PIPE_BUF_SIZE];
-    uint32_t       head;
-    uint32_t       tail;
+    uint8_t       *buf;
+    uint32_t       capacity; /* 缓冲区字节数 */
+    uint32_t       head;     /* 读位置 */
+    uint32_t       used;     /* 已缓存字节数 */
     uint32_t       refcount;
     uint32_t       reader_count;
     uint32_t       writer_count;
+    bool           reading;  /* 有读者正在锁外拷贝 */
+    bool           writing;  /* 有写者正在锁外拷贝 */
+    struct pipe_quota *quota; /* 扩容字节记在谁的配额上 (持有引用) */
+    uint32_t       charge;   /* 超出 PIPE_BUF_DEFAULT 的字节数 */
     struct thread *read_queue;
     struct thread *write_queue;
     struct poll_entry *poll_queue;
 };
 
+/**
+ * 进程的管道扩容配额
+ *
+ * 进程和它扩容过的管道各持一份引用, 进程先退出时配额随最后一个管道释放,
+ * 管道不反过来持有进程, 避免 handle 表与进程互相引用.
+ */
+struct pipe_quota {
+    uint32_t refcount;
+    uint32_t bytes; /* 已记账的额外缓冲区字节数 */
+};
+
+/** 释放进程持有的配额引用 (进程销毁时调用) */
+void pipe_quota_put(struct pipe_quota *quota);
+
 /**
  * 创建管道, 返回读写两端 handle
  */
@@ -37,15 +70,30 @@ int pipe_create(handle_t *read_h, handle_t *write_h);
 
 /**
  * 从管道读取数据
+ * @param flags PIPE_NONBLOCK: 无数据时返回 -EAGAIN
  * @return 读取字节数, 0=EOF, 负数=错误
  */
-int pipe_read(struct ipc_pipe *pipe, void *ubuf, uint32_t size);
+int pipe_read(struct ipc_pipe *pipe, void *ubuf, uint32_t size, uint32_t flags);
 
 /**
  * 向管道写入数据
+ * @param flags PIPE_NONBLOCK: 缓冲区满时返回已写字节数, 一字节也没写则 -EAGAIN
  * @return 写入字节数, 负数=错误 (-EPIPE)
  */
-int pipe_write(struct ipc_pipe *pipe, const void *ubuf, uint32_t size);
+int pipe_write(struct ipc_pipe *pipe, const void *ubuf, uint32_t size, uint32_t flags);
+
+/**
+ * 调整管道缓冲区容量
+ *
+ * 容量会被对齐到页并限制在 [PIPE_BUF_MIN, PIPE_BUF_MAX].
+ * 超出 PIPE_BUF_DEFAULT 的部分记在调用进程名下, 总量受 CFG_PIPE_PROC_LIMIT
+ * 限制; 持有 CAP_MM_MMAP 的进程不受此限.
+ *
+ * @param size 新容量, 0 表示只查询
+ * @return 调整后的容量, 负数=错误 (-EBUSY: 已缓存数据超过新容量或正在拷贝,
+ *         -ENOMEM: 超出进程配额)
+ */
+int pipe_set_size(struct ipc_pipe *pipe, uint32_t size);
 
 void pipe_ref(void *ptr);
 void pipe_unref(void *ptr);
@@ -0,0 +1,86 @@
+/**
+ * @file ring.c
+ * @brief 共享内存环形通道
+ *
+ * 内核只负责一次性搭建: SHM + 初始化好的头部 + 两个门铃 event.
+ * 之后的入队/出队完全在用户态完成(见 libsys ring helper),
+ * 内核只在门铃 event_signal/event_wait 时介入.
+ */
+
+#include <ipc/ring.h>
+#include <xnix/errno.h>
+#include <xnix/handle.h>
+#include <xnix/ipc.h>
+#include <xnix/physmem.h>
+#include <xnix/process.h>
+#include <xnix/string.h>
+
+_Static_assert(sizeof(struct abi_ring_header) <= ABI_RING_HDR_SIZE, "ring header too large");
+
+extern void *vmm_kmap(paddr_t paddr);
+extern void  vmm_kunmap(void *vaddr);
+
+int ring_create(struct abi_ring_create_args *args) {
+    struct process *proc = process_current();
+
+    if (!proc || !args) {
+        return -EINVAL;
+    }
+
+    uint32_t entries    = args->entries;
+    uint32_t entry_size = args->entry_size;
+
+    if (entries == 0 || entries > ABI_RING_ENTRIES_MAX || (entries & (entries - 1)) != 0) {
+        return -EINVAL;
+    }
+    if (entry_size == 0 || entry_size > ABI_RING_ENTRY_MAX || (entry_size & 3) != 0) {
+        return -EINVAL;
+    }
+
+    uint32_t ring_bytes = entries * entry_size;
+    uint32_t total      = ABI_RING_HDR_SIZE + 2 * ring_bytes;
+
+    struct physmem_region *region = shm_create(total);
+    if (!region) {
+        return -ENOMEM;
+    }
+
+    /* 头部一定落在第 0 页(shm_create 已清零) */
+    struct abi_ring_header *hdr = vmm_kmap(region->shm_info.pages[0]);
+    if (!hdr) {
+        physmem_put(region);
+        return -ENOMEM;
+    }
+    hdr->magic      = ABI_RING_MAGIC;
+    hdr->entry_size = entry_size;
+    hdr->entries    = entries;
+    hdr->mask       = entries - 1;
+    hdr->sq.offset  = ABI_RING_HDR_SIZE;
+    hdr->cq.offset  = ABI_RING_HDR_SIZE + ring_bytes;
+    vmm_kunmap(hdr);
+
+    handle_t shm_h = handle_alloc(proc, HANDLE_PHYSMEM, region, NULL);
+    if (shm_h == HANDLE_INVALID) {
+        physmem_put(region);
+        return -ENOMEM;
+    }
+
+    handle_t sq_h = event_create();
+    if (sq_h == HANDLE_INVALID) {
+        handle_free(proc, shm_h);
+        return -ENOMEM;
+    }
+
+    handle_t cq_h = event_create();
+    if (cq_h == HANDLE_INVALID) {
+        handle_free(proc, sq_h);
+        handle_free(proc, shm_h);
+        return -ENOMEM;
+    }
+
+    args->shm      = shm_h;
+    args->sq_event = sq_h;
+    args->cq_event = cq_h;
+    args->size     = region->size;
+    return 0;
+}
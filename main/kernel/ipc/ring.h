@@ -0,0 +1,18 @@
+#ifndef KERNEL_IPC_RING_H
+#define KERNEL_IPC_RING_H
+
+#include <xnix/abi/ring.h>
+#include <xnix/types.h>
+
+/**
+ * 创建共享内存环形通道
+ *
+ * 分配一块 SHM(头部 + SQ + CQ)并初始化头部, 同时创建 SQ/CQ 两个门铃 event.
+ * 三个 handle 都分配在当前进程中, 通过 args 的 out 字段返回.
+ *
+ * @param args entries/entry_size 为输入, 其余为输出
+ * @return 0 成功, 负数失败
+ */
+int ring_create(struct abi_ring_create_args *args);
+
+#endif /* KERNEL_IPC_RING_H */
@@ -6,10 +6,12 @@
  */
 
 #include <asm/irq.h>
+#include <xnix/errno.h>
 #include <xnix/irq.h>
 
 static const struct irqchip_ops *current_chip               = NULL;
 static irq_handler_t             irq_handlers[ARCH_NR_IRQS] = {0};
+static uint32_t                  irq_level_mask             = 0; /* 电平触发的 IRQ */
 
 void irq_set_chip(const struct irqchip_ops *ops) {
     current_chip = ops;
@@ -45,6 +47,45 @@ void irq_set_handler(uint8_t irq, irq_handler_t handler) {
     }
 }
 
+int irq_route_pci(uint8_t bus, uint8_t dev, uint8_t pin, uint8_t legacy) {
+    if (pin > 3) {
+        return -EINVAL;
+    }
+
+    /* PCI INTx 是低电平有效的电平触发共享线, 路由表未给出时按 PCI 默认值 */
+    uint32_t mode = IRQ_MODE_LEVEL | IRQ_MODE_ACTIVE_LOW;
+    int      irq  = -1;
+
+    if (current_chip && current_chip->route_pci) {
+        irq = current_chip->route_pci(bus, dev, pin, &mode);
+    }
+    if (irq < 0) {
+        /* legacy 线经过 PIC/IOAPIC 的 ISA 输入, 南桥已把极性翻转为高电平 */
+        if (legacy >= 16) {
+            return -ENOENT;
+        }
+        irq  = legacy;
+        mode = IRQ_MODE_LEVEL;
+    }
+    if (irq >= ARCH_NR_IRQS) {
+        return -ENOENT;
+    }
+
+    if (current_chip && current_chip->set_mode) {
+        current_chip->set_mode((uint8_t)irq, mode);
+    }
+    if (mode & IRQ_MODE_LEVEL) {
+        irq_level_mask |= 1u << irq;
+    } else {
+        irq_level_mask &= ~(1u << irq);
+    }
+    return irq;
+}
+
+bool irq_is_level(uint8_t irq) {
+    return irq < ARCH_NR_IRQS && (irq_level_mask & (1u << irq));
+}
+
 void irq_dispatch(uint8_t irq, irq_frame_t *frame) {
     if (irq < ARCH_NR_IRQS && irq_handlers[irq]) {
         irq_handlers[irq](frame);
@@ -53,7 +94,14 @@ void irq_dispatch(uint8_t irq, irq_frame_t *frame) {
             irq_eoi(irq);
         }
     } else {
-        /* 无 handler 时直接发送 EOI,避免中断被阻塞 */
+        /*
+         * 无内核 handler: 转给绑定该 IRQ 的用户态驱动(如 IDE), 并直接 EOI.
+         * 电平触发的线在设备清除中断源前会一直有效, 先屏蔽, 由驱动 ack 后再打开.
+         */
+        if (irq_is_level(irq)) {
+            irq_disable(irq);
+        }
+        irq_user_signal(irq);
         irq_eoi(irq);
     }
 }
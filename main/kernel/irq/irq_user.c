@@ -198,6 +198,23 @@ void irq_user_signal(uint8_t irq) {
     }
 }
 
+int irq_user_ack(uint8_t irq, struct process *owner) {
+    if (irq >= ARCH_NR_IRQS) {
+        return -EINVAL;
+    }
+
+    for (int i = 0; i < IRQ_USER_MAX_BINDINGS; i++) {
+        if (irq_bindings[irq][i].bound && irq_bindings[irq][i].owner == owner) {
+            /* 边沿触发的线从未被屏蔽, ack 是空操作 */
+            if (irq_is_level(irq)) {
+                irq_enable(irq);
+            }
+            return 0;
+        }
+    }
+    return -ENOENT;
+}
+
 int irq_user_read(uint8_t irq, uint8_t *buf, size_t size, bool block) {
     if (irq >= ARCH_NR_IRQS || !buf || size == 0) {
         return -EINVAL;
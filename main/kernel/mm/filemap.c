@@ -0,0 +1,1258 @@
+/**
+ * @file filemap.c
+ * @brief 文件映射与文件页缓存
+ *
+ * 每个被映射的文件对应一个 vm_file, 记录缓页会话和已读入的页;
+ * 进程的每段文件映射是一个 vm_area, 挂在 proc->vmas 上并引用 vm_file.
+ *
+ * 缺页时按映射方式装页:
+ *   - 读访问: 直接映射缓存页, 只读
+ *   - 共享映射的写访问: 把缓存页改为可写并记脏
+ *   - 私有映射的写访问: 复制缓存页到新页 (写时复制)
+ * 共享可写映射先以只读装入, 第一次写才记脏, 写回时只发真正改过的页.
+ *
+ * 全局锁只保护链表, 页数组和脏位, 与服务端的 IPC 都在锁外进行,
+ * 期间持有 vm_file 的临时引用, 保证它不会被淘汰.
+ *
+ * 同一份 vm_file 也是普通读的页缓存: 服务端读文件时把整页填进来 (FILL),
+ * 并把客户端会话登记到文件上 (BIND), 客户端 SYS_FCACHE_READ 直接从缓存页
+ * 拷贝. 这类文件没有缓页会话, 淘汰时不发 IPC.
+ *
+ * 服务端处理 write 后把写入的数据交给内核 (UPDATE), 已缓存的页就地改写,
+ * 映射者不用重新缺页就能看到, 与 write 保持一致. 截断等无法就地更新的改动
+ * 作废整份缓存 (INVAL), 作废的文件不再被查到, 仍在映射的等映射取消后淘汰.
+ */
+
+#include <ipc/endpoint.h>
+
+#include <xnix/abi/fcache.h>
+#include <xnix/abi/io.h>
+#include <xnix/abi/mman.h>
+#include <xnix/cap.h>
+#include <xnix/errno.h>
+#include <xnix/filemap.h>
+#include <xnix/handle.h>
+#include <xnix/ipc.h>
+#include <xnix/mm.h>
+#include <xnix/mm_ops.h>
+#include <xnix/physmem.h>
+#include <xnix/process_def.h>
+#include <xnix/stdio.h>
+#include <xnix/string.h>
+#include <xnix/sync.h>
+#include <xnix/usraccess.h>
+#include <xnix/vm_layout.h>
+#include <xnix/vmm.h>
+
+#define FILEMAP_IDLE_MAX    64   /* 无人映射时仍保留缓存页的文件数 */
+#define FILEMAP_CACHE_PAGES 4096 /* 缓存页总数超过该值时淘汰空闲文件 (16MB) */
+#define FILEMAP_BIND_MAX    128  /* 登记的客户端会话数, 超出时丢弃最早的 */
+#define FILEMAP_IO_TIMEOUT  5000 /* 取页/写回超时 (ms) */
+
+extern void *vmm_kmap(paddr_t paddr);
+extern void  vmm_kunmap(void *vaddr);
+
+/* 被映射的文件 */
+struct vm_file {
+    struct ipc_endpoint *ep;       /* 缓页 endpoint (持有引用) */
+    uint32_t             session;  /* 缓页会话 */
+    uint32_t             key;      /* 服务端给出的文件标识 */
+    uint32_t             size;     /* 建立缓存时的文件大小 */
+    uint32_t             version;  /* 缓存页对应的内容版本 */
+    uint32_t             npages;   /* 文件页数 */
+    paddr_t             *pages;    /* 缓存页, 0 = 未读入 */
+    uint32_t            *dirty;    /* 脏页位图 */
+    uint32_t             refcount; /* 映射数 + 进行中的缺页/写回 */
+    uint32_t             writers;  /* 共享可写映射数 */
+    uint32_t             gen;      /* 服务端每次就地更新加一, 更新前发出的取页结果作废 */
+    bool                 pager;    /* session 有效 (经 IO_MAP 建立), 淘汰时要写回并关闭 */
+    bool                 stale;    /* 已作废: 不再被查到, 空闲后淘汰 */
+    struct vm_file      *next;     /* 全局链表, 最近使用的在前 */
+};
+
+/* 进程内的一段文件映射 */
+struct vm_area {
+    uint32_t        start; /* [start, end) 页对齐 */
+    uint32_t        end;
+    uint32_t        pgoff; /* start 对应的文件页号 */
+    uint32_t        prot;  /* ABI_PROT_* */
+    uint32_t        flags; /* ABI_MAP_* */
+    struct vm_file *file;
+    struct vm_area *next;
+};
+
+/* 客户端会话到缓存文件的登记, 供 SYS_FCACHE_READ 查找 */
+struct fcache_bind {
+    struct ipc_endpoint *ep;       /* 客户端发请求用的 endpoint (持有引用) */
+    uint32_t             session;
+    struct ipc_endpoint *cache_ep; /* 缓存所属 endpoint (持有引用) */
+    uint32_t             key;
+    uint32_t             version;  /* 登记时的内容版本, 缓存版本不同不算命中 */
+    struct fcache_bind  *next;     /* 最近登记的在前 */
+};
+
+static struct vm_file     *g_files;
+static struct fcache_bind *g_binds;
+static uint32_t            g_nbinds;
+static uint32_t            g_cache_pages; /* 所有文件的缓存页数 */
+static spinlock_t          g_filemap_lock = SPINLOCK_INIT;
+
+static inline bool file_dirty(const struct vm_file *f, uint32_t idx) {
+    return f->dirty[idx >> 5] & (1u << (idx & 31));
+}
+
+static inline void file_set_dirty(struct vm_file *f, uint32_t idx) {
+    f->dirty[idx >> 5] |= 1u << (idx & 31);
+}
+
+static inline void file_clear_dirty(struct vm_file *f, uint32_t idx) {
+    f->dirty[idx >> 5] &= ~(1u << (idx & 31));
+}
+
+static inline bool vma_shared_write(const struct vm_area *vma) {
+    return (vma->flags & ABI_MAP_SHARED) && (vma->prot & ABI_PROT_WRITE);
+}
+
+/* 以下链表操作要求持有 g_filemap_lock */
+
+static struct vm_area *vma_find(struct process *proc, uint32_t addr) {
+    for (struct vm_area *vma = proc->vmas; vma; vma = vma->next) {
+        if (addr >= vma->start && addr < vma->end) {
+            return vma;
+        }
+    }
+    return NULL;
+}
+
+static void file_unlink(struct vm_file *f) {
+    struct vm_file **pp = &g_files;
+    while (*pp) {
+        if (*pp == f) {
+            *pp = f->next;
+            break;
+        }
+        pp = &(*pp)->next;
+    }
+    f->next = NULL;
+}
+
+static struct vm_file *file_find(struct ipc_endpoint *ep, uint32_t key) {
+    for (struct vm_file *f = g_files; f; f = f->next) {
+        if (f->ep == ep && f->key == key && !f->stale) {
+            return f;
+        }
+    }
+    return NULL;
+}
+
+/* 以内核身份向服务端发请求, 返回回复的 data[0] */
+static int filemap_call(struct ipc_endpoint *ep, struct ipc_message *req,
+                        struct ipc_message *reply) {
+    req->flags = IPC_FLAG_KERNEL;
+    int ret    = ipc_call_direct(ep, req, reply, FILEMAP_IO_TIMEOUT);
+    if (ret < 0) {
+        return ret;
+    }
+    return (int32_t)reply->regs.data[0];
+}
+
+static void pager_close(struct ipc_endpoint *ep, uint32_t session) {
+    struct ipc_message req   = {0};
+    struct ipc_message reply = {0};
+
+    req.regs.data[0] = IO_CLOSE;
+    req.regs.data[1] = session;
+    filemap_call(ep, &req, &reply);
+}
+
+/* 从服务端读入第 idx 页, 返回新分配的物理页, 失败返回 0 */
+static paddr_t file_page_in(struct vm_file *f, uint32_t idx) {
+    void *buf = kmalloc(PAGE_SIZE);
+    if (!buf) {
+        return 0;
+    }
+
+    struct ipc_message req   = {0};
+    struct ipc_message reply = {0};
+    req.regs.data[0]  = IO_PAGE_IN;
+    req.regs.data[1]  = f->session;
+    req.regs.data[2]  = idx * PAGE_SIZE;
+    req.regs.data[3]  = PAGE_SIZE;
+    reply.buffer.data = (uint64_t)(uintptr_t)buf;
+    reply.buffer.size = PAGE_SIZE;
+
+    paddr_t page = 0;
+    int     n    = filemap_call(f->ep, &req, &reply);
+    if (n >= 0) {
+        if ((uint32_t)n > reply.buffer.size) {
+            n = (int)reply.buffer.size;
+        }
+        page = (paddr_t)alloc_page_high();
+        if (page) {
+            uint8_t *k = vmm_kmap(page);
+            memcpy(k, buf, (uint32_t)n);
+            memset(k + n, 0, PAGE_SIZE - (uint32_t)n);
+            vmm_kunmap(k);
+        }
+    } else {
+        pr_warn("filemap: page-in failed (key=%u page=%u): %d", f->key, idx, n);
+    }
+
+    kfree(buf);
+    return page;
+}
+
+/* 把缓存页写回文件, 文件末页只写到文件末尾 */
+static int file_page_out(struct vm_file *f, uint32_t idx, paddr_t page) {
+    uint32_t off = idx * PAGE_SIZE;
+    uint32_t n   = f->size - off < PAGE_SIZE ? f->size - off : PAGE_SIZE;
+
+    void *buf = kmalloc(PAGE_SIZE);
+    if (!buf) {
+        return -ENOMEM;
+    }
+    void *k = vmm_kmap(page);
+    memcpy(buf, k, n);
+    vmm_kunmap(k);
+
+    struct ipc_message req   = {0};
+    struct ipc_message reply = {0};
+    req.regs.data[0] = IO_PAGE_OUT;
+    req.regs.data[1] = f->session;
+    req.regs.data[2] = off;
+    req.regs.data[3] = n;
+    req.buffer.data  = (uint64_t)(uintptr_t)buf;
+    req.buffer.size  = n;
+
+    int ret = filemap_call(f->ep, &req, &reply);
+    kfree(buf);
+    if (ret < 0) {
+        pr_warn("filemap: write-back failed (key=%u page=%u): %d", f->key, idx, ret);
+        return ret;
+    }
+    return 0;
+}
+
+/*
+ * 写回 [first, last) 中的脏页
+ * clear: 已没有可写映射能再改这些页 (或已降为只读), 写回后清脏位
+ */
+static int file_writeback(struct vm_file *f, uint32_t first, uint32_t last, bool clear) {
+    int err = 0;
+
+    for (uint32_t idx = first; idx < last && idx < f->npages; idx++) {
+        uint32_t flags = spin_lock_irqsave(&g_filemap_lock);
+        paddr_t  page  = file_dirty(f, idx) ? f->pages[idx] : 0;
+        if (page && clear) {
+            file_clear_dirty(f, idx);
+        }
+        spin_unlock_irqrestore(&g_filemap_lock, flags);
+
+        if (!page) {
+            continue;
+        }
+        int ret = file_page_out(f, idx, page);
+        if (ret < 0) {
+            err   = ret;
+            flags = spin_lock_irqsave(&g_filemap_lock);
+            file_set_dirty(f, idx);
+            spin_unlock_irqrestore(&g_filemap_lock, flags);
+        }
+    }
+    return err;
+}
+
+static struct vm_file *file_create(struct ipc_endpoint *ep, uint32_t session, uint32_t key,
+                                   uint32_t size, uint32_t version) {
+    struct vm_file *f = kzalloc(sizeof(*f));
+    if (!f) {
+        return NULL;
+    }
+
+    f->ep      = ep;
+    f->session = session;
+    f->key     = key;
+    f->size    = size;
+    f->version = version;
+    f->pager   = true;
+    f->npages  = (size >> PAGE_SHIFT) + ((size & (PAGE_SIZE - 1)) ? 1 : 0);
+
+    uint32_t n = f->npages ? f->npages : 1;
+    f->pages   = kzalloc(n * sizeof(paddr_t));
+    f->dirty   = kzalloc(((n + 31) / 32) * sizeof(uint32_t));
+    if (!f->pages || !f->dirty) {
+        kfree(f->pages);
+        kfree(f->dirty);
+        kfree(f);
+        return NULL;
+    }
+    return f;
+}
+
+/* 淘汰已摘下链表的文件: 写回脏页, 关闭缓页会话, 释放缓存页 */
+static void file_destroy(struct vm_file *f) {
+    if (f->pager) {
+        file_writeback(f, 0, f->npages, true);
+        pager_close(f->ep, f->session);
+    }
+
+    uint32_t freed = 0;
+    for (uint32_t i = 0; i < f->npages; i++) {
+        if (f->pages[i]) {
+            free_page((void *)f->pages[i]);
+            freed++;
+        }
+    }
+    uint32_t flags = spin_lock_irqsave(&g_filemap_lock);
+    g_cache_pages -= freed;
+    spin_unlock_irqrestore(&g_filemap_lock, flags);
+
+    handle_object_put(HANDLE_ENDPOINT, f->ep);
+    kfree(f->pages);
+    kfree(f->dirty);
+    kfree(f);
+}
+
+/*
+ * 淘汰空闲文件: 已作废的总是淘汰, 其余在空闲文件数或缓存页数超限时
+ * 从最久未用的开始. 只在系统调用上下文中调用.
+ * 有缓页会话的文件淘汰时要向服务端发 IPC, 调用者就是服务端 (may_ipc = false) 时跳过.
+ */
+static void filemap_trim(bool may_ipc) {
+    while (1) {
+        uint32_t        flags  = spin_lock_irqsave(&g_filemap_lock);
+        struct vm_file *victim = NULL;
+        uint32_t        idle   = 0;
+        for (struct vm_file *f = g_files; f; f = f->next) {
+            if (f->refcount != 0) {
+                continue;
+            }
+            idle++;
+            if ((f->pager && !may_ipc) || (victim && victim->stale)) {
+                continue;
+            }
+            victim = f;
+        }
+        bool over = idle > FILEMAP_IDLE_MAX || g_cache_pages > FILEMAP_CACHE_PAGES;
+        if (!victim || (!victim->stale && !over)) {
+            spin_unlock_irqrestore(&g_filemap_lock, flags);
+            return;
+        }
+        file_unlink(victim);
+        spin_unlock_irqrestore(&g_filemap_lock, flags);
+
+        file_destroy(victim);
+    }
+}
+
+static void file_put(struct vm_file *f) {
+    uint32_t flags = spin_lock_irqsave(&g_filemap_lock);
+    f->refcount--;
+    spin_unlock_irqrestore(&g_filemap_lock, flags);
+}
+
+/* 复制一页到新分配的页 */
+static paddr_t page_dup(paddr_t src) {
+    void *buf = kmalloc(PAGE_SIZE);
+    if (!buf) {
+        return 0;
+    }
+    paddr_t dst = (paddr_t)alloc_page_high();
+    if (dst) {
+        void *k = vmm_kmap(src);
+        memcpy(buf, k, PAGE_SIZE);
+        vmm_kunmap(k);
+        k = vmm_kmap(dst);
+        memcpy(k, buf, PAGE_SIZE);
+        vmm_kunmap(k);
+    }
+    kfree(buf);
+    return dst;
+}
+
+/*
+ * 清除一段映射的页表项并释放其中的私有副本
+ * 缓存页只在文件淘汰时释放, 页数组在文件存活期间只会由 0 变为有效页, 不加锁读取.
+ */
+#define VMA_FREE_BATCH 32
+
+/*
+ * 清除 vma 的页表项, 释放私有副本页.
+ * flush 时先刷新各核 TLB 再释放页, 否则其他核上的线程还能经旧表项写进已释放的页;
+ * 进程销毁时没有线程在跑, 不需要.
+ */
+static void vma_unmap_pages(struct process *proc, struct vm_area *vma, bool flush) {
+    const struct mm_operations *mm = mm_get_ops();
+    struct vm_file             *f  = vma->file;
+    paddr_t                     priv[VMA_FREE_BATCH];
+    uint32_t                    npriv = 0;
+
+    for (uint32_t va = vma->start; va < vma->end; va += PAGE_SIZE) {
+        uintptr_t paddr = 0;
+        uint32_t  qf    = 0;
+        if (mm->query_flags(proc->page_dir_phys, va, &paddr, &qf) < 0 ||
+            !(qf & MM_QUERY_PRESENT)) {
+            continue;
+        }
+        mm->unmap(proc->page_dir_phys, va);
+
+        uint32_t idx = vma->pgoff + (va - vma->start) / PAGE_SIZE;
+        paddr &= PAGE_MASK;
+        if (!(vma->flags & ABI_MAP_SHARED) && (idx >= f->npages || paddr != f->pages[idx])) {
+            if (npriv == VMA_FREE_BATCH) {
+                if (flush) {
+                    arch_tlb_shootdown();
+                }
+                while (npriv) {
+                    free_page((void *)priv[--npriv]);
+                }
+            }
+            priv[npriv++] = paddr;
+        }
+    }
+
+    if (flush) {
+        arch_tlb_shootdown();
+    }
+    while (npriv) {
+        free_page((void *)priv[--npriv]);
+    }
+}
+
+int filemap_map(struct process *proc, handle_t handle, uint32_t session, uint32_t offset,
+                uint32_t size, uint32_t prot, uint32_t flags, uint32_t *out_addr) {
+    if (!proc || !out_addr || size == 0 || (offset & (PAGE_SIZE - 1))) {
+        return -EINVAL;
+    }
+    if (!(prot & ABI_PROT_READ) || (prot & ~(ABI_PROT_READ | ABI_PROT_WRITE))) {
+        return -EINVAL;
+    }
+    if (flags != ABI_MAP_SHARED && flags != ABI_MAP_PRIVATE) {
+        return -EINVAL;
+    }
+    uint32_t len = PAGE_ALIGN_UP(size);
+    if (len < size) {
+        return -EINVAL;
+    }
+
+    const struct mm_operations *mm = mm_get_ops();
+    if (!mm || !mm->map || !mm->unmap || !mm->query_flags) {
+        return -ENOSYS;
+    }
+
+    struct handle_entry entry;
+    if (handle_acquire(proc, handle, HANDLE_ENDPOINT, &entry) < 0) {
+        return -EBADF;
+    }
+    if (!(entry.rights & HANDLE_RIGHT_WRITE) || !cap_check(proc, CAP_IPC_SEND)) {
+        handle_object_put(entry.type, entry.object);
+        return -EPERM;
+    }
+
+    /* 申请缓页会话 */
+    struct ipc_message req   = {0};
+    struct ipc_message reply = {0};
+    req.regs.data[0] = IO_MAP;
+    req.regs.data[1] = session;
+
+    struct ipc_endpoint *pager = entry.object;
+    int                  ret   = filemap_call(pager, &req, &reply);
+
+    /* 服务端另给了取页 endpoint: 只留对象引用, 传来的 handle 不留在进程里 */
+    if (reply.handles.count > 0) {
+        struct handle_entry pe;
+        if (ret >= 0) {
+            if (handle_acquire(proc, reply.handles.handles[0], HANDLE_ENDPOINT, &pe) < 0) {
+                ret = -EPROTO;
+            } else {
+                handle_object_put(entry.type, entry.object);
+                pager = pe.object;
+            }
+        }
+        for (uint32_t i = 0; i < reply.handles.count && i < IPC_MSG_HANDLES_MAX; i++) {
+            handle_free(proc, reply.handles.handles[i]);
+        }
+    }
+    if (ret < 0) {
+        handle_object_put(HANDLE_ENDPOINT, pager);
+        return ret == -ENOSYS ? -ENODEV : ret;
+    }
+
+    uint32_t psession = reply.regs.data[1];
+    uint32_t key      = reply.regs.data[2];
+    uint32_t fsize    = reply.regs.data[3];
+    uint32_t version  = reply.regs.data[4];
+
+    struct vm_file *fresh = NULL;
+    if (offset < fsize && len <= PAGE_ALIGN_UP(fsize) - offset) {
+        fresh = file_create(pager, psession, key, fsize, version);
+    }
+    if (!fresh) {
+        pager_close(pager, psession);
+        handle_object_put(HANDLE_ENDPOINT, pager);
+        return offset < fsize ? -ENOMEM : -ENXIO;
+    }
+
+    struct vm_area *vma  = kzalloc(sizeof(*vma));
+    uint32_t        base = vma ? mmap_va_alloc(proc, len, false) : 0;
+    if (!base) {
+        kfree(vma);
+        file_destroy(fresh);
+        return -ENOMEM;
+    }
+
+    /*
+     * 同一文件已有缓存则共用, 内容已变的旧缓存作废.
+     * 只经读填充的缓存还没有缓页会话, 接过这次申请到的.
+     */
+    uint32_t        irq = spin_lock_irqsave(&g_filemap_lock);
+    struct vm_file *f   = file_find(pager, key);
+    if (f && (f->version != version || f->size != fsize)) {
+        f->stale = true;
+        f        = NULL;
+    }
+    if (f) {
+        file_unlink(f);
+        if (!f->pager) {
+            f->session   = psession;
+            f->pager     = true;
+            fresh->pager = false;
+        }
+    } else {
+        f     = fresh;
+        fresh = NULL;
+    }
+    f->next = g_files;
+    g_files = f;
+    f->refcount++;
+    if (flags == ABI_MAP_SHARED && (prot & ABI_PROT_WRITE)) {
+        f->writers++;
+    }
+
+    vma->start = base;
+    vma->end   = base + len;
+    vma->pgoff = offset / PAGE_SIZE;
+    vma->prot  = prot;
+    vma->flags = flags;
+    vma->file  = f;
+    vma->next  = proc->vmas;
+    proc->vmas = vma;
+    spin_unlock_irqrestore(&g_filemap_lock, irq);
+
+    if (fresh) {
+        file_destroy(fresh);
+    }
+    filemap_trim(true);
+
+    *out_addr = base;
+    return 0;
+}
+
+int filemap_fault(struct process *proc, uint32_t vaddr, bool present, bool write) {
+    const struct mm_operations *mm = mm_get_ops();
+    if (!proc || !proc->vmas || !mm || !mm->map || !mm->query_flags) {
+        return -EFAULT;
+    }
+    if (present && !write) {
+        return -EFAULT; /* 文件映射页只会因写保护而在存在时缺页 */
+    }
+    uint32_t va = vaddr & PAGE_MASK;
+
+    uint32_t        irq = spin_lock_irqsave(&g_filemap_lock);
+    struct vm_area *vma = vma_find(proc, va);
+    if (!vma || (write && !(vma->prot & ABI_PROT_WRITE))) {
+        spin_unlock_irqrestore(&g_filemap_lock, irq);
+        return -EFAULT;
+    }
+    struct vm_file *f   = vma->file;
+    uint32_t        idx = vma->pgoff + (va - vma->start) / PAGE_SIZE;
+    if (idx >= f->npages) {
+        spin_unlock_irqrestore(&g_filemap_lock, irq);
+        return -EFAULT; /* 越过文件末尾 */
+    }
+    bool     shared = vma->flags & ABI_MAP_SHARED;
+    paddr_t  page   = f->pages[idx];
+    uint32_t gen    = f->gen;
+    f->refcount++; /* 取页/复制期间不被淘汰 */
+    spin_unlock_irqrestore(&g_filemap_lock, irq);
+
+    int ret = 0;
+    if (!page) {
+        paddr_t fresh = file_page_in(f, idx);
+        if (!fresh) {
+            file_put(f);
+            return -EIO;
+        }
+        irq = spin_lock_irqsave(&g_filemap_lock);
+        if (!f->pages[idx] && f->gen == gen) {
+            f->pages[idx] = fresh;
+            fresh         = 0;
+            g_cache_pages++;
+        }
+        page = f->pages[idx];
+        spin_unlock_irqrestore(&g_filemap_lock, irq);
+        if (fresh) {
+            free_page((void *)fresh); /* 其他线程已先读入, 或取页期间文件被改写 */
+        }
+        if (!page) {
+            file_put(f);
+            return 0; /* 重新缺页再取 */
+        }
+    }
+
+    paddr_t  map  = page;
+    uint32_t prot = VMM_PROT_USER | VMM_PROT_READ;
+    if (write) {
+        prot |= VMM_PROT_WRITE;
+        if (!shared) {
+            map = page_dup(page);
+            if (!map) {
+                file_put(f);
+                return -ENOMEM;
+            }
+        }
+    }
+
+    irq = spin_lock_irqsave(&g_filemap_lock);
+    uintptr_t cur = 0;
+    uint32_t  qf  = 0;
+    mm->query_flags(proc->page_dir_phys, va, &cur, &qf);
+    bool done = (qf & MM_QUERY_PRESENT) && (!write || (qf & MM_QUERY_WRITE));
+
+    /* 等待期间映射可能已被取消, 或其他线程已装好这一页 */
+    if (vma_find(proc, va) != vma || done) {
+        spin_unlock_irqrestore(&g_filemap_lock, irq);
+        if (map != page) {
+            free_page((void *)map);
+        }
+        file_put(f);
+        return 0;
+    }
+    if (write && shared) {
+        file_set_dirty(f, idx);
+    }
+    if (mm->map(proc->page_dir_phys, va, map, prot) != 0) {
+        ret = -ENOMEM;
+    }
+    f->refcount--;
+    spin_unlock_irqrestore(&g_filemap_lock, irq);
+
+    if (ret < 0 && map != page) {
+        free_page((void *)map);
+    }
+    return ret;
+}
+
+void filemap_prefault(struct process *proc, uint32_t addr, uint32_t size, bool write) {
+    const struct mm_operations *mm = mm_get_ops();
+    if (!proc || !proc->vmas || !size || !mm || !mm->query_flags) {
+        return;
+    }
+
+    uint32_t end = addr + size;
+    if (end < addr || end > KERNEL_VIRT_BASE) {
+        return; /* 非法缓冲区交给之后的拷贝报错 */
+    }
+
+    for (uint32_t va = addr & PAGE_MASK; va < end; va += PAGE_SIZE) {
+        uintptr_t paddr = 0;
+        uint32_t  qf    = 0;
+        mm->query_flags(proc->page_dir_phys, va, &paddr, &qf);
+        bool present = qf & MM_QUERY_PRESENT;
+        if (present && (!write || (qf & MM_QUERY_WRITE))) {
+            continue;
+        }
+        if (filemap_fault(proc, va, present, write) < 0) {
+            return;
+        }
+    }
+}
+
+int filemap_unmap(struct process *proc, uint32_t addr, uint32_t size) {
+    if (!proc || size == 0) {
+        return -EINVAL;
+    }
+    uint32_t start = addr & PAGE_MASK;
+    uint32_t end   = PAGE_ALIGN_UP(addr + size);
+    if (end <= start) {
+        return -EINVAL;
+    }
+
+    /*
+     * 每轮从一个相交的映射上切下 [lo, hi): 整段相交直接摘下,
+     * 否则切下的部分单独成一个 vma 处理, 原映射收缩, 从中间切时拆出尾段.
+     */
+    bool found = false;
+    int  err   = 0;
+    while (1) {
+        struct vm_area *piece = kzalloc(sizeof(*piece));
+        struct vm_area *tail  = kzalloc(sizeof(*tail));
+        if (!piece || !tail) {
+            kfree(piece);
+            kfree(tail);
+            return -ENOMEM;
+        }
+
+        uint32_t         irq = spin_lock_irqsave(&g_filemap_lock);
+        struct vm_area **pp  = &proc->vmas;
+        while (*pp && ((*pp)->end <= start || end <= (*pp)->start)) {
+            pp = &(*pp)->next;
+        }
+        struct vm_area *vma = *pp;
+        if (!vma) {
+            spin_unlock_irqrestore(&g_filemap_lock, irq);
+            kfree(piece);
+            kfree(tail);
+            break;
+        }
+        found = true;
+
+        uint32_t        lo = vma->start > start ? vma->start : start;
+        uint32_t        hi = vma->end < end ? vma->end : end;
+        struct vm_file *f  = vma->file;
+        if (lo == vma->start && hi == vma->end) {
+            *pp = vma->next;
+            kfree(piece);
+            piece = vma;
+        } else {
+            *piece       = *vma;
+            piece->start = lo;
+            piece->end   = hi;
+            piece->pgoff = vma->pgoff + (lo - vma->start) / PAGE_SIZE;
+            piece->next  = NULL;
+            f->refcount++;
+            if (vma_shared_write(vma)) {
+                f->writers++;
+            }
+
+            if (lo > vma->start && hi < vma->end) {
+                *tail       = *vma;
+                tail->start = hi;
+                tail->pgoff = vma->pgoff + (hi - vma->start) / PAGE_SIZE;
+                vma->next   = tail;
+                tail        = NULL;
+                f->refcount++;
+                if (vma_shared_write(vma)) {
+                    f->writers++;
+                }
+                vma->end = lo;
+            } else if (lo == vma->start) {
+                vma->pgoff += (hi - vma->start) / PAGE_SIZE;
+                vma->start = hi;
+            } else {
+                vma->end = lo;
+            }
+        }
+        bool clear = vma_shared_write(piece) && f->writers == 1;
+        spin_unlock_irqrestore(&g_filemap_lock, irq);
+        kfree(tail);
+
+        vma_unmap_pages(proc, piece, true);
+
+        /* 最后一个可写映射消失后, 写回的页不会再变脏 */
+        if (vma_shared_write(piece)) {
+            uint32_t first = piece->pgoff;
+            int      ret   = file_writeback(f, first, first + (hi - lo) / PAGE_SIZE, clear);
+            if (ret < 0) {
+                err = ret;
+            }
+        }
+
+        irq = spin_lock_irqsave(&g_filemap_lock);
+        if (vma_shared_write(piece)) {
+            f->writers--;
+        }
+        f->refcount--;
+        spin_unlock_irqrestore(&g_filemap_lock, irq);
+
+        mmap_va_free(proc, lo, hi - lo);
+        kfree(piece);
+    }
+
+    if (!found) {
+        return -ENOENT;
+    }
+    filemap_trim(true);
+    return err;
+}
+
+int filemap_sync(struct process *proc, uint32_t addr, uint32_t size) {
+    const struct mm_operations *mm = mm_get_ops();
+    if (!proc || !mm || !mm->map || !mm->query_flags) {
+        return -EINVAL;
+    }
+    uint32_t start = addr & PAGE_MASK;
+    uint32_t end   = PAGE_ALIGN_UP(addr + size);
+    int      err   = 0;
+
+    /* 按地址顺序处理与区间相交的共享可写映射 */
+    uint32_t cursor = start;
+    while (cursor < end) {
+        uint32_t        irq = spin_lock_irqsave(&g_filemap_lock);
+        struct vm_area *vma = NULL;
+        for (struct vm_area *v = proc->vmas; v; v = v->next) {
+            if (vma_shared_write(v) && v->end > cursor && v->start < end &&
+                (!vma || v->start < vma->start)) {
+                vma = v;
+            }
+        }
+        if (!vma) {
+            spin_unlock_irqrestore(&g_filemap_lock, irq);
+            break;
+        }
+
+        uint32_t        lo    = vma->start > cursor ? vma->start : cursor;
+        uint32_t        hi    = vma->end < end ? vma->end : end;
+        uint32_t        first = vma->pgoff + (lo - vma->start) / PAGE_SIZE;
+        struct vm_file *f     = vma->file;
+
+        /* 唯一的写者: 先降为只读, 之后再写会重新缺页记脏, 写回后可以清脏位 */
+        bool clear = f->writers == 1;
+        if (clear) {
+            for (uint32_t va = lo; va < hi; va += PAGE_SIZE) {
+                uintptr_t paddr = 0;
+                uint32_t  qf    = 0;
+                mm->query_flags(proc->page_dir_phys, va, &paddr, &qf);
+                if ((qf & MM_QUERY_PRESENT) && (qf & MM_QUERY_WRITE)) {
+                    mm->map(proc->page_dir_phys, va, paddr & PAGE_MASK,
+                            VMM_PROT_USER | VMM_PROT_READ);
+                }
+            }
+        }
+        f->refcount++;
+        spin_unlock_irqrestore(&g_filemap_lock, irq);
+
+        /* 其他核还缓存着可写表项的话, 写回之后的写入不会再缺页记脏 */
+        if (clear) {
+            arch_tlb_shootdown();
+        }
+
+        int ret = file_writeback(f, first, first + (hi - lo) / PAGE_SIZE, clear);
+        if (ret < 0) {
+            err = ret;
+        }
+        file_put(f);
+        cursor = hi;
+    }
+    return err;
+}
+
+void filemap_release_process(struct process *proc) {
+    if (!proc || !proc->vmas) {
+        return;
+    }
+
+    uint32_t        irq  = spin_lock_irqsave(&g_filemap_lock);
+    struct vm_area *list = proc->vmas;
+    proc->vmas           = NULL;
+    spin_unlock_irqrestore(&g_filemap_lock, irq);
+
+    while (list) {
+        struct vm_area *vma = list;
+        list                = vma->next;
+
+        if (proc->page_dir_phys) {
+            vma_unmap_pages(proc, vma, false);
+        }
+
+        irq = spin_lock_irqsave(&g_filemap_lock);
+        if (vma_shared_write(vma)) {
+            vma->file->writers--;
+        }
+        vma->file->refcount--;
+        spin_unlock_irqrestore(&g_filemap_lock, irq);
+        kfree(vma);
+    }
+}
+
+/* 以下为读缓存: 服务端填充/登记/作废, 客户端直接读 */
+
+static void bind_release(struct fcache_bind *b) {
+    handle_object_put(HANDLE_ENDPOINT, b->ep);
+    handle_object_put(HANDLE_ENDPOINT, b->cache_ep);
+    kfree(b);
+}
+
+/* 摘下 (ep, session) 的登记, 要求持有 g_filemap_lock */
+static struct fcache_bind *bind_take(struct ipc_endpoint *ep, uint32_t session) {
+    for (struct fcache_bind **pp = &g_binds; *pp; pp = &(*pp)->next) {
+        struct fcache_bind *b = *pp;
+        if (b->ep == ep && b->session == session) {
+            *pp = b->next;
+            g_nbinds--;
+            return b;
+        }
+    }
+    return NULL;
+}
+
+/* 登记客户端会话, 接管 cache_ep 和 ep 的引用 */
+static int cache_bind(struct ipc_endpoint *cache_ep, struct ipc_endpoint *ep, uint32_t session,
+                      uint32_t key, uint32_t version) {
+    struct fcache_bind *b = kzalloc(sizeof(*b));
+    if (!b) {
+        handle_object_put(HANDLE_ENDPOINT, ep);
+        handle_object_put(HANDLE_ENDPOINT, cache_ep);
+        return -ENOMEM;
+    }
+    b->ep       = ep;
+    b->session  = session;
+    b->cache_ep = cache_ep;
+    b->key      = key;
+    b->version  = version;
+
+    struct fcache_bind *drop = NULL;
+    uint32_t            irq  = spin_lock_irqsave(&g_filemap_lock);
+    struct fcache_bind *old  = bind_take(ep, session);
+    b->next                  = g_binds;
+    g_binds                  = b;
+    g_nbinds++;
+    if (g_nbinds > FILEMAP_BIND_MAX) {
+        struct fcache_bind **pp = &g_binds;
+        while ((*pp)->next) {
+            pp = &(*pp)->next;
+        }
+        drop = *pp;
+        *pp  = NULL;
+        g_nbinds--;
+    }
+    spin_unlock_irqrestore(&g_filemap_lock, irq);
+
+    if (old) {
+        bind_release(old);
+    }
+    if (drop) {
+        bind_release(drop);
+    }
+    return 0;
+}
+
+/*
+ * 取得 (cache_ep, key) 的当前缓存并加临时引用, 没有或版本不符时新建.
+ * 新建的文件接管 cache_ep 的引用, 否则释放它.
+ */
+static struct vm_file *cache_get(struct ipc_endpoint *cache_ep, uint32_t key, uint32_t version,
+                                 uint32_t size) {
+    struct vm_file *fresh = NULL;
+
+    for (int pass = 0; pass < 2; pass++) {
+        uint32_t        irq = spin_lock_irqsave(&g_filemap_lock);
+        struct vm_file *f   = file_find(cache_ep, key);
+        if (f && (f->version != version || f->size != size)) {
+            f->stale = true;
+            f        = NULL;
+        }
+        if (!f && fresh) {
+            f     = fresh;
+            fresh = NULL;
+        } else if (f) {
+            file_unlink(f);
+        }
+        if (f) {
+            f->next = g_files;
+            g_files = f;
+            f->refcount++;
+            spin_unlock_irqrestore(&g_filemap_lock, irq);
+
+            if (fresh) {
+                file_destroy(fresh); /* 其他线程已先建好, 没有缓页会话, 不发 IPC */
+            } else if (pass == 0) {
+                handle_object_put(HANDLE_ENDPOINT, cache_ep); /* 沿用已有文件的引用 */
+            }
+            return f;
+        }
+        spin_unlock_irqrestore(&g_filemap_lock, irq);
+
+        fresh = file_create(cache_ep, 0, key, size, version);
+        if (!fresh) {
+            handle_object_put(HANDLE_ENDPOINT, cache_ep);
+            return NULL;
+        }
+        fresh->pager = false;
+    }
+    return NULL; /* 第二轮总能取到 fresh */
+}
+
+/* 填入 [offset, offset + len) 覆盖的整页, 文件末页不足一页时补零 */
+static int cache_fill(struct ipc_endpoint *cache_ep, const struct abi_fcache_args *args) {
+    uint32_t end = args->offset + args->len;
+    if (args->len == 0 || end < args->offset || end > args->file_size) {
+        handle_object_put(HANDLE_ENDPOINT, cache_ep);
+        return -EINVAL;
+    }
+
+    struct vm_file *f = cache_get(cache_ep, args->key, args->version, args->file_size);
+    if (!f) {
+        return -ENOMEM;
+    }
+    void *buf = kmalloc(PAGE_SIZE);
+    if (!buf) {
+        file_put(f);
+        return -ENOMEM;
+    }
+
+    int ret = 0;
+    for (uint32_t pos = PAGE_ALIGN_UP(args->offset); pos < end; pos += PAGE_SIZE) {
+        uint32_t idx = pos >> PAGE_SHIFT;
+        uint32_t n   = end - pos < PAGE_SIZE ? end - pos : PAGE_SIZE;
+        if (n < PAGE_SIZE && end != f->size) {
+            break; /* 只收整页或文件末页 */
+        }
+        if (f->pages[idx]) {
+            continue;
+        }
+
+        ret = copy_from_user(buf, (const void *)(uintptr_t)(args->buf + (pos - args->offset)), n);
+        if (ret < 0) {
+            break;
+        }
+        paddr_t page = (paddr_t)alloc_page_high();
+        if (!page) {
+            ret = -ENOMEM;
+            break;
+        }
+        uint8_t *k = vmm_kmap(page);
+        memcpy(k, buf, n);
+        memset(k + n, 0, PAGE_SIZE - n);
+        vmm_kunmap(k);
+
+        uint32_t irq = spin_lock_irqsave(&g_filemap_lock);
+        if (!f->pages[idx] && !f->stale) {
+            f->pages[idx] = page;
+            page          = 0;
+            g_cache_pages++;
+        }
+        spin_unlock_irqrestore(&g_filemap_lock, irq);
+        if (page) {
+            free_page((void *)page);
+        }
+    }
+
+    kfree(buf);
+    file_put(f);
+    return ret;
+}
+
+/*
+ * 服务端改写了 [offset, offset + len): 已缓存的页就地更新, 映射者直接看到新内容,
+ * 登记在旧版本上的会话跟着换到新版本. 文件缩小或长出缓存页数时无法就地更新, 作废.
+ */
+static int cache_update(struct ipc_endpoint *cache_ep, const struct abi_fcache_args *args) {
+    uint32_t end = args->offset + args->len;
+    if (end < args->offset || end > args->file_size) {
+        handle_object_put(HANDLE_ENDPOINT, cache_ep);
+        return -EINVAL;
+    }
+
+    uint32_t        npages = PAGE_ALIGN_UP(args->file_size) / PAGE_SIZE;
+    uint32_t        irq    = spin_lock_irqsave(&g_filemap_lock);
+    struct vm_file *f      = file_find(cache_ep, args->key);
+    if (f && (args->file_size < f->size || npages > f->npages)) {
+        f->stale = true;
+        f        = NULL;
+    }
+    if (f) {
+        for (struct fcache_bind *b = g_binds; b; b = b->next) {
+            if (b->cache_ep == cache_ep && b->key == args->key && b->version == f->version) {
+                b->version = args->version;
+            }
+        }
+        f->version = args->version;
+        f->size    = args->file_size;
+        f->gen++;
+        f->refcount++;
+    }
+    spin_unlock_irqrestore(&g_filemap_lock, irq);
+    handle_object_put(HANDLE_ENDPOINT, cache_ep);
+    if (!f) {
+        filemap_trim(false);
+        return 0;
+    }
+
+    void *buf = args->len ? kmalloc(PAGE_SIZE) : NULL;
+    int   ret = args->len && !buf ? -ENOMEM : 0;
+    for (uint32_t pos = args->offset; buf && pos < end;) {
+        uint32_t idx = pos >> PAGE_SHIFT;
+        uint32_t in  = pos & (PAGE_SIZE - 1);
+        uint32_t n   = end - pos < PAGE_SIZE - in ? end - pos : PAGE_SIZE - in;
+
+        irq          = spin_lock_irqsave(&g_filemap_lock);
+        paddr_t page = f->pages[idx];
+        spin_unlock_irqrestore(&g_filemap_lock, irq);
+
+        if (page) {
+            ret = copy_from_user(buf, (const void *)(uintptr_t)(args->buf + (pos - args->offset)),
+                                 n);
+            if (ret < 0) {
+                break;
+            }
+            uint8_t *k = vmm_kmap(page);
+            memcpy(k + in, buf, n);
+            vmm_kunmap(k);
+        }
+        pos += n;
+    }
+    kfree(buf);
+
+    /* 没更新完的缓存不能再用 */
+    irq = spin_lock_irqsave(&g_filemap_lock);
+    if (ret < 0) {
+        f->stale = true;
+    }
+    f->refcount--;
+    spin_unlock_irqrestore(&g_filemap_lock, irq);
+    return ret;
+}
+
+int filemap_cache_ctl(struct process *proc, const struct abi_fcache_args *args) {
+    if (!proc || !args) {
+        return -EINVAL;
+    }
+
+    /*
+     * 客户端打开文件时也会拿到服务端 endpoint (带接收权限),
+     * 只有持 SERVE 权限的 handle 才能代表服务端, 这个权限不随 IPC/grant 转移
+     */
+    struct handle_entry ce;
+    if (handle_acquire(proc, args->cache_ep, HANDLE_ENDPOINT, &ce) < 0) {
+        return -EBADF;
+    }
+    if (!(ce.rights & HANDLE_RIGHT_READ) || !(ce.rights & HANDLE_RIGHT_SERVE) ||
+        !cap_check(proc, CAP_IPC_RECV)) {
+        handle_object_put(ce.type, ce.object);
+        return -EPERM;
+    }
+    struct ipc_endpoint *cache_ep = ce.object;
+
+    int ret = 0;
+    switch (args->op) {
+    case ABI_FCACHE_BIND:
+    case ABI_FCACHE_UNBIND: {
+        struct handle_entry ee;
+        if (handle_acquire(proc, args->ep, HANDLE_ENDPOINT, &ee) < 0) {
+            ret = -EBADF;
+            break;
+        }
+        if (!(ee.rights & HANDLE_RIGHT_READ)) {
+            handle_object_put(ee.type, ee.object);
+            ret = -EPERM;
+            break;
+        }
+        if (args->op == ABI_FCACHE_BIND) {
+            return cache_bind(cache_ep, ee.object, args->session, args->key, args->version);
+        }
+
+        uint32_t            irq = spin_lock_irqsave(&g_filemap_lock);
+        struct fcache_bind *b   = bind_take(ee.object, args->session);
+        spin_unlock_irqrestore(&g_filemap_lock, irq);
+        if (b) {
+            bind_release(b);
+        }
+        handle_object_put(ee.type, ee.object);
+        break;
+    }
+    case ABI_FCACHE_FILL:
+        ret = cache_fill(cache_ep, args);
+        filemap_trim(false);
+        return ret;
+    case ABI_FCACHE_UPDATE:
+        ret = cache_update(cache_ep, args);
+        filemap_trim(false);
+        return ret;
+    case ABI_FCACHE_INVAL: {
+        uint32_t        irq = spin_lock_irqsave(&g_filemap_lock);
+        struct vm_file *f   = file_find(cache_ep, args->key);
+        if (f) {
+            f->stale = true;
+        }
+        spin_unlock_irqrestore(&g_filemap_lock, irq);
+        handle_object_put(HANDLE_ENDPOINT, cache_ep);
+        filemap_trim(false);
+        return 0;
+    }
+    default:
+        ret = -EINVAL;
+        break;
+    }
+
+    handle_object_put(HANDLE_ENDPOINT, cache_ep);
+    return ret;
+}
+
+int filemap_cache_read(struct process *proc, handle_t handle, uint32_t session, uint32_t offset,
+                       void *ubuf, uint32_t size) {
+    if (!proc) {
+        return -EINVAL;
+    }
+    struct handle_entry entry;
+    if (handle_acquire(proc, handle, HANDLE_ENDPOINT, &entry) < 0) {
+        return -EBADF;
+    }
+
+    uint32_t            irq = spin_lock_irqsave(&g_filemap_lock);
+    struct fcache_bind *b   = g_binds;
+    while (b && (b->ep != entry.object || b->session != session)) {
+        b = b->next;
+    }
+    struct vm_file *f = b ? file_find(b->cache_ep, b->key) : NULL;
+    if (f && f->version != b->version) {
+        f = NULL; /* 会话登记后文件内容变过 */
+    }
+    if (f) {
+        file_unlink(f);
+        f->next = g_files;
+        g_files = f;
+        f->refcount++;
+    }
+    spin_unlock_irqrestore(&g_filemap_lock, irq);
+    handle_object_put(entry.type, entry.object);
+
+    if (!b) {
+        return -ENOENT; /* 会话未登记, 客户端不必再试 */
+    }
+    if (!f || size == 0) {
+        return 0;
+    }
+
+    void *buf = kmalloc(PAGE_SIZE);
+    if (!buf) {
+        file_put(f);
+        return 0;
+    }
+    filemap_prefault(proc, (uint32_t)(uintptr_t)ubuf, size, true);
+
+    /* 从 offset 起连续命中的部分, 遇到未缓存的页即停 */
+    uint32_t done = 0;
+    int      err  = 0;
+    while (done < size) {
+        uint32_t pos = offset + done;
+        if (pos < offset || pos >= f->size) {
+            break;
+        }
+        paddr_t page = f->pages[pos >> PAGE_SHIFT];
+        if (!page) {
+            break;
+        }
+        uint32_t in = pos & (PAGE_SIZE - 1);
+        uint32_t n  = PAGE_SIZE - in;
+        if (n > size - done) {
+            n = size - done;
+        }
+        if (n > f->size - pos) {
+            n = f->size - pos;
+        }
+
+        uint8_t *k = vmm_kmap(page);
+        memcpy(buf, k + in, n);
+        vmm_kunmap(k);
+        err = copy_to_user((uint8_t *)ubuf + done, buf, n);
+        if (err < 0) {
+            break;
+        }
+        done += n;
+    }
+
+    kfree(buf);
+    file_put(f);
+    return done > 0 ? (int)done : err;
+}
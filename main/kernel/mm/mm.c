@@ -76,17 +76,18 @@ extern void  vmm_kunmap(void *vaddr);
  * - 逐页用 vmm_kmap 临时映射到内核,再 memcpy
  *
  * 限制:
- * - 目前不检查 PTE 的 user/write 权限,仅判断是否映射
  * - vmm_kmap 依赖临时窗口,持锁期间不能睡眠
+ *
+ * *_proc 变体按指定进程的页目录解析地址, 用于 IPC 在两个地址空间之间直接搬运数据.
  */
-int copy_from_user(void *dst, const void *user_src, size_t n) {
-    if (!dst || (!user_src && n)) {
+static int user_copy(struct process *proc, void *kbuf, uintptr_t uaddr, size_t n, bool to_user) {
+    if (!kbuf || (!uaddr && n)) {
         return -EINVAL;
     }
     if (!n) {
         return 0;
     }
-    uintptr_t start = (uintptr_t)user_src;
+    uintptr_t start = uaddr;
     uintptr_t end   = start + n;
     if (start >= KERNEL_VIRT_BASE || end < start || end > KERNEL_VIRT_BASE) {
         return -EFAULT;
@@ -100,29 +101,36 @@ int copy_from_user(void *dst, const void *user_src, size_t n) {
         return -ENOSYS;
     }
 
-    /* 获取当前进程的页目录,不依赖 CR3 寄存器 */
-    struct process *cur = process_get_current();
-    void           *pd  = (cur && cur->page_dir_phys) ? cur->page_dir_phys : NULL;
+    /* 使用目标进程的页目录,不依赖 CR3 寄存器 */
+    void *pd = (proc && proc->page_dir_phys) ? proc->page_dir_phys : NULL;
+
+    uint32_t need = MM_QUERY_PRESENT | MM_QUERY_USER;
+    if (to_user) {
+        need |= MM_QUERY_WRITE;
+    }
 
     size_t copied = 0;
     while (copied < n) {
-        uintptr_t uaddr = (uintptr_t)user_src + copied;
+        uintptr_t va    = uaddr + copied;
         uintptr_t paddr = 0;
         uint32_t  flags = 0;
-        int       ret   = mm->query_flags(pd, uaddr, &paddr, &flags);
-        if (ret < 0 || !(flags & MM_QUERY_PRESENT) || !(flags & MM_QUERY_USER) || !paddr) {
+        int       ret   = mm->query_flags(pd, va, &paddr, &flags);
+        if (ret < 0 || (flags & need) != need || !paddr) {
             return -EFAULT;
         }
 
-        size_t page_off   = (size_t)(uaddr & (PAGE_SIZE - 1));
+        size_t page_off   = (size_t)(va & (PAGE_SIZE - 1));
         size_t chunk_size = PAGE_SIZE - page_off;
         if (copied + chunk_size > n) {
             chunk_size = n - copied;
         }
 
         void *page = vmm_kmap((paddr_t)(paddr & PAGE_MASK));
-        memcpy((uint8_t *)dst + copied, (uint8_t *)page + page_off, chunk_size);
-
+        if (to_user) {
+            memcpy((uint8_t *)page + page_off, (const uint8_t *)kbuf + copied, chunk_size);
+        } else {
+            memcpy((uint8_t *)kbuf + copied, (uint8_t *)page + page_off, chunk_size);
+        }
         vmm_kunmap(page);
 
         copied += chunk_size;
@@ -131,54 +139,18 @@ int copy_from_user(void *dst, const void *user_src, size_t n) {
     return 0;
 }
 
-int copy_to_user(void *user_dst, const void *src, size_t n) {
-    if ((!user_dst && n) || !src) {
-        return -EINVAL;
-    }
-    if (!n) {
-        return 0;
-    }
-    uintptr_t start = (uintptr_t)user_dst;
-    uintptr_t end   = start + n;
-    if (start >= KERNEL_VIRT_BASE || end < start || end > KERNEL_VIRT_BASE) {
-        return -EFAULT;
-    }
-    if (!hal_has_feature(HAL_FEATURE_MMU)) {
-        return -ENOSYS;
-    }
-
-    const struct mm_operations *mm = mm_get_ops();
-    if (!mm || !mm->query_flags) {
-        return -ENOSYS;
-    }
-
-    /* 获取当前进程的页目录,不依赖 CR3 寄存器 */
-    struct process *cur = process_get_current();
-    void           *pd  = (cur && cur->page_dir_phys) ? cur->page_dir_phys : NULL;
-
-    size_t copied = 0;
-    while (copied < n) {
-        uintptr_t uaddr = (uintptr_t)user_dst + copied;
-        uintptr_t paddr = 0;
-        uint32_t  flags = 0;
-        int       ret   = mm->query_flags(pd, uaddr, &paddr, &flags);
-        if (ret < 0 || !(flags & MM_QUERY_PRESENT) || !(flags & MM_QUERY_USER) ||
-            !(flags & MM_QUERY_WRITE) || !paddr) {
-            return -EFAULT;
-        }
-
-        size_t page_off   = (size_t)(uaddr & (PAGE_SIZE - 1));
-        size_t chunk_size = PAGE_SIZE - page_off;
-        if (copied + chunk_size > n) {
-            chunk_size = n - copied;
-        }
+int copy_from_proc(struct process *proc, void *dst, const void *user_src, size_t n) {
+    return user_copy(proc, dst, (uintptr_t)user_src, n, false);
+}
 
-        void *page = vmm_kmap((paddr_t)(paddr & PAGE_MASK));
-        memcpy((uint8_t *)page + page_off, (const uint8_t *)src + copied, chunk_size);
-        vmm_kunmap(page);
+int copy_to_proc(struct process *proc, void *user_dst, const void *src, size_t n) {
+    return user_copy(proc, (void *)src, (uintptr_t)user_dst, n, true);
+}
 
-        copied += chunk_size;
-    }
+int copy_from_user(void *dst, const void *user_src, size_t n) {
+    return copy_from_proc(process_get_current(), dst, user_src, n);
+}
 
-    return 0;
+int copy_to_user(void *user_dst, const void *src, size_t n) {
+    return copy_to_proc(process_get_current(), user_dst, src, n);
 }
@@ -259,3 +259,8 @@ uint32_t page_alloc_free_count(void) {
 uint32_t page_alloc_total_count(void) {
     return total_pages;
 }
+
+bool page_alloc_overlaps(paddr_t addr, uint32_t size) {
+    /* 内核映像,bitmap 和可分配页都位于 memory_end 之下 */
+    return addr < memory_end && size > 0;
+}
@@ -5,6 +5,7 @@
 
 #include <xnix/abi/framebuffer.h>
 #include <xnix/boot.h>
+#include <xnix/errno.h>
 #include <xnix/handle.h>
 #include <xnix/mm.h>
 #include <xnix/mm_ops.h>
@@ -12,6 +13,8 @@
 #include <xnix/process_def.h>
 #include <xnix/stdio.h>
 #include <xnix/string.h>
+#include <xnix/sync.h>
+#include <xnix/vm_layout.h>
 #include <xnix/vmm.h>
 
 struct physmem_region *physmem_create(paddr_t phys_addr, uint32_t size, physmem_type_t type) {
@@ -46,13 +49,16 @@ void physmem_put(struct physmem_region *region) {
             }
             kfree(region->shm_info.pages);
         }
+        if (region->type == PHYSMEM_TYPE_DMA) {
+            free_pages((void *)region->phys_addr, region->size / PAGE_SIZE);
+        }
         kfree(region);
     }
 }
 
-handle_t physmem_create_handle_for_proc(struct process *proc, paddr_t phys_addr, uint32_t size,
-                                        const char *name) {
-    struct physmem_region *region = physmem_create(phys_addr, size, PHYSMEM_TYPE_GENERIC);
+static handle_t physmem_handle_for_proc(struct process *proc, paddr_t phys_addr, uint32_t size,
+                                       physmem_type_t type, const char *name) {
+    struct physmem_region *region = physmem_create(phys_addr, size, type);
     if (!region) {
         return HANDLE_INVALID;
     }
@@ -66,6 +72,16 @@ handle_t physmem_create_handle_for_proc(struct process *proc, paddr_t phys_addr,
     return h;
 }
 
+handle_t physmem_create_handle_for_proc(struct process *proc, paddr_t phys_addr, uint32_t size,
+                                        const char *name) {
+    return physmem_handle_for_proc(proc, phys_addr, size, PHYSMEM_TYPE_GENERIC, name);
+}
+
+handle_t physmem_create_module_handle_for_proc(struct process *proc, paddr_t phys_addr,
+                                               uint32_t size, const char *name) {
+    return physmem_handle_for_proc(proc, phys_addr, size, PHYSMEM_TYPE_MODULE, name);
+}
+
 handle_t physmem_create_fb_handle_for_proc(struct process *proc, const char *name) {
     struct boot_framebuffer_info fb;
     if (boot_get_framebuffer(&fb) < 0) {
@@ -160,6 +176,184 @@ struct physmem_region *shm_create(uint32_t size) {
     return region;
 }
 
+struct physmem_region *dma_create(uint32_t size) {
+    if (size == 0) {
+        return NULL;
+    }
+
+    uint32_t num_pages = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+
+    /* alloc_pages 返回恒等映射的低端物理页, 可直接清零 */
+    void *pages = alloc_pages(num_pages);
+    if (!pages) {
+        return NULL;
+    }
+    memset(pages, 0, num_pages * PAGE_SIZE);
+
+    struct physmem_region *region = physmem_create((paddr_t)pages, num_pages * PAGE_SIZE,
+                                                   PHYSMEM_TYPE_DMA);
+    if (!region) {
+        free_pages(pages, num_pages);
+        return NULL;
+    }
+
+    return region;
+}
+
+/* 内核自用的设备寄存器窗口, 不能交给用户态 */
+#define MMIO_RESERVED_MAX 8
+
+static struct {
+    paddr_t  base;
+    uint32_t last; /* 末字节地址, 避免 base + size 在 4GB 处溢出 */
+} g_mmio_reserved[MMIO_RESERVED_MAX];
+static uint32_t g_mmio_reserved_count;
+
+void mmio_reserve(paddr_t base, uint32_t size) {
+    if (size == 0) {
+        return;
+    }
+    if (g_mmio_reserved_count >= MMIO_RESERVED_MAX) {
+        pr_warn("mmio: reserved table full, 0x%x not recorded", base);
+        return;
+    }
+    g_mmio_reserved[g_mmio_reserved_count].base = base;
+    g_mmio_reserved[g_mmio_reserved_count].last = (uint32_t)base + (size - 1);
+    g_mmio_reserved_count++;
+}
+
+static bool mmio_is_reserved(paddr_t base, uint32_t span) {
+    uint32_t last = (uint32_t)base + (span - 1);
+    for (uint32_t i = 0; i < g_mmio_reserved_count; i++) {
+        if ((uint32_t)base <= g_mmio_reserved[i].last && last >= g_mmio_reserved[i].base) {
+            return true;
+        }
+    }
+    return false;
+}
+
+struct physmem_region *mmio_create(paddr_t phys_addr, uint32_t size) {
+    if (size == 0) {
+        return NULL;
+    }
+
+    paddr_t  base = phys_addr & ~(PAGE_SIZE - 1);
+    uint32_t span = (uint32_t)(phys_addr - base) + size;
+    if (span < size || span > 0xFFFFF000) {
+        return NULL;
+    }
+    span = (span + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+
+    /* 末字节不能越过 4GB */
+    if ((uint32_t)base + span - 1 < (uint32_t)base) {
+        return NULL;
+    }
+    if (page_alloc_overlaps(base, span) || mmio_is_reserved(base, span)) {
+        return NULL;
+    }
+
+    return physmem_create(base, span, PHYSMEM_TYPE_MMIO);
+}
+
+/* mmap 区域上界: 用户栈底 */
+#define MMAP_VA_END (USER_STACK_TOP - USER_STACK_SIZE)
+
+/* 在 mmap 区域分配虚拟地址: 在已占用的区间之间首次适配 */
+uint32_t mmap_va_alloc(struct process *proc, uint32_t size, bool phys) {
+    struct mmap_range *r = kzalloc(sizeof(*r));
+    if (!r || size == 0) {
+        kfree(r);
+        return 0;
+    }
+
+    uint32_t            irq  = spin_lock_irqsave(&proc->mmap_lock);
+    uint32_t            base = proc->mmap_base;
+    struct mmap_range **pp   = &proc->mmaps;
+    while (*pp && (*pp)->base - base < size) {
+        base = (*pp)->base + (*pp)->size;
+        pp   = &(*pp)->next;
+    }
+    if (base > MMAP_VA_END || MMAP_VA_END - base < size) {
+        spin_unlock_irqrestore(&proc->mmap_lock, irq);
+        kfree(r);
+        return 0;
+    }
+
+    r->base = base;
+    r->size = size;
+    r->phys = phys;
+    r->next = *pp;
+    *pp     = r;
+    spin_unlock_irqrestore(&proc->mmap_lock, irq);
+    return base;
+}
+
+int mmap_va_claim(struct process *proc, uint32_t base, uint32_t size) {
+    int      ret = -EINVAL;
+    uint32_t irq = spin_lock_irqsave(&proc->mmap_lock);
+    for (struct mmap_range *r = proc->mmaps; r; r = r->next) {
+        if (r->base == base && r->size == size && r->phys && !r->dying) {
+            r->dying = true;
+            ret      = 0;
+            break;
+        }
+    }
+    spin_unlock_irqrestore(&proc->mmap_lock, irq);
+    return ret;
+}
+
+void mmap_va_free(struct process *proc, uint32_t base, uint32_t size) {
+    /* 从一段中间释放要拆成两段, 节点先在锁外备好 */
+    struct mmap_range *spare = kzalloc(sizeof(*spare));
+    struct mmap_range *drop  = NULL;
+    uint32_t           end   = base + size;
+
+    uint32_t irq = spin_lock_irqsave(&proc->mmap_lock);
+    for (struct mmap_range **pp = &proc->mmaps; *pp; pp = &(*pp)->next) {
+        struct mmap_range *r     = *pp;
+        uint32_t           r_end = r->base + r->size;
+        if (base < r->base || end > r_end) {
+            continue;
+        }
+        if (base == r->base && end == r_end) {
+            *pp  = r->next;
+            drop = r;
+        } else if (base == r->base) {
+            r->base = end;
+            r->size = r_end - end;
+        } else if (end == r_end) {
+            r->size = base - r->base;
+        } else if (spare) {
+            spare->base = end;
+            spare->size = r_end - end;
+            spare->phys = r->phys;
+            spare->next = r->next;
+            r->next     = spare;
+            r->size     = base - r->base;
+            spare       = NULL;
+        }
+        /* 没内存拆分时整段留着, 进程退出时一并释放 */
+        break;
+    }
+    spin_unlock_irqrestore(&proc->mmap_lock, irq);
+
+    kfree(drop);
+    kfree(spare);
+}
+
+void mmap_va_release_process(struct process *proc) {
+    uint32_t           irq  = spin_lock_irqsave(&proc->mmap_lock);
+    struct mmap_range *list = proc->mmaps;
+    proc->mmaps             = NULL;
+    spin_unlock_irqrestore(&proc->mmap_lock, irq);
+
+    while (list) {
+        struct mmap_range *next = list->next;
+        kfree(list);
+        list = next;
+    }
+}
+
 uint32_t physmem_map_to_user(struct process *proc, struct physmem_region *region, uint32_t offset,
                              uint32_t size, uint32_t prot) {
     if (!proc || !region) {
@@ -181,11 +375,17 @@ uint32_t physmem_map_to_user(struct process *proc, struct physmem_region *region
     uint32_t num_pages  = (end_page - start_page) / PAGE_SIZE;
 
     /* 选择用户空间映射基地址 */
-    uint32_t user_base;
-    if (region->type == PHYSMEM_TYPE_SHM) {
-        /* SHM: 动态分配虚拟地址 */
-        user_base = proc->mmap_next;
-        proc->mmap_next += num_pages * PAGE_SIZE;
+    physmem_type_t type = region->type;
+    uint32_t       user_base;
+    bool           is_ram =
+        type == PHYSMEM_TYPE_SHM || type == PHYSMEM_TYPE_DMA || type == PHYSMEM_TYPE_MODULE;
+    bool           dynamic = is_ram || type == PHYSMEM_TYPE_MMIO;
+    if (dynamic) {
+        /* SHM/DMA/MMIO/MODULE: 动态分配虚拟地址 */
+        user_base = mmap_va_alloc(proc, num_pages * PAGE_SIZE, true);
+        if (!user_base) {
+            return 0;
+        }
     } else {
         /* FB/GENERIC: 固定地址(保持兼容) */
         user_base = ABI_FB_MAP_BASE;
@@ -199,8 +399,9 @@ uint32_t physmem_map_to_user(struct process *proc, struct physmem_region *region
 
     /* 构建页保护标志 */
     uint32_t page_prot = VMM_PROT_USER;
-    if (region->type != PHYSMEM_TYPE_SHM) {
-        page_prot |= VMM_PROT_NOCACHE; /* 设备内存禁缓存,SHM 是普通 RAM */
+    if (!is_ram) {
+        /* 设备内存禁缓存; SHM/DMA/引导模块是普通 RAM (x86 DMA 缓存一致) */
+        page_prot |= VMM_PROT_NOCACHE;
     }
     if (prot & 0x01) { /* PROT_READ */
         page_prot |= VMM_PROT_READ;
@@ -230,9 +431,9 @@ uint32_t physmem_map_to_user(struct process *proc, struct physmem_region *region
                     mm->unmap(proc->page_dir_phys, user_base + j * PAGE_SIZE);
                 }
             }
-            /* SHM: 回滚 mmap_next */
-            if (region->type == PHYSMEM_TYPE_SHM) {
-                proc->mmap_next -= num_pages * PAGE_SIZE;
+            /* 动态映射: 归还虚拟地址 */
+            if (dynamic) {
+                mmap_va_free(proc, user_base, num_pages * PAGE_SIZE);
             }
             return 0;
         }
@@ -245,3 +446,37 @@ uint32_t physmem_map_to_user(struct process *proc, struct physmem_region *region
 
     return user_addr;
 }
+
+int physmem_unmap_from_user(struct process *proc, uint32_t addr, uint32_t size) {
+    if (!proc || size == 0) {
+        return -EINVAL;
+    }
+
+    uint32_t start = addr & ~(PAGE_SIZE - 1);
+    uint32_t end   = (addr + size + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+    if (end <= start) {
+        return -EINVAL;
+    }
+
+    const struct mm_operations *mm = mm_get_ops();
+    if (!mm || !mm->unmap) {
+        return -ENOSYS;
+    }
+
+    /* 只能取消一段完整的 physmem 映射; 标记之后并发的重复取消会失败 */
+    int ret = mmap_va_claim(proc, start, end - start);
+    if (ret < 0) {
+        return ret;
+    }
+
+    for (uint32_t vaddr = start; vaddr < end; vaddr += PAGE_SIZE) {
+        mm->unmap(proc->page_dir_phys, vaddr);
+    }
+
+    /* 其他核上的线程可能还缓存着旧表项, 刷完才能把地址交给下一次映射 */
+    arch_tlb_shootdown();
+    mmap_va_free(proc, start, end - start);
+
+    pr_debug("physmem: unmapped %u pages at user 0x%08x", (end - start) / PAGE_SIZE, start);
+    return 0;
+}
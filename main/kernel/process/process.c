@@ -7,11 +7,15 @@
 
 #include <arch/cpu.h>
 
+#include <ipc/pipe.h>
+
 #include <xnix/config.h>
 #include <xnix/debug.h>
+#include <xnix/filemap.h>
 #include <xnix/handle.h>
 #include <xnix/mm.h>
 #include <xnix/mm_ops.h>
+#include <xnix/physmem.h>
 #include <xnix/cap.h>
 #include <xnix/process_def.h>
 #include <xnix/stdio.h>
@@ -51,6 +55,8 @@ void process_subsystem_init(void) {
     kernel_process.cap_mask      = CAP_ALL;
     kernel_process.irq_mask      = 0xFFFFFFFF;
     kernel_process.ioport_bitmap = NULL; /* 内核进程隐式拥有所有 IO 端口 */
+    spin_init(&kernel_process.cap_lock);
+    spin_init(&kernel_process.mmap_lock);
 
     kernel_process.threads      = NULL;
     kernel_process.thread_count = 0;
@@ -175,6 +181,8 @@ void process_unref(struct process *proc) {
         cpu_irq_restore(flags);
 
         /* 销毁进程 */
+        filemap_release_process(proc);
+        mmap_va_release_process(proc);
         if (proc->page_dir_phys) {
             const struct mm_operations *mm = mm_get_ops();
             if (mm && mm->destroy_as) {
@@ -185,10 +193,10 @@ void process_unref(struct process *proc) {
         if (proc->handles) {
             handle_table_destroy(proc->handles);
         }
-        if (proc->ioport_bitmap) {
-            kfree(proc->ioport_bitmap);
-            proc->ioport_bitmap = NULL;
-        }
+        ioport_bitmap_put(proc->ioport_bitmap);
+        proc->ioport_bitmap = NULL;
+        pipe_quota_put(proc->pipe_quota);
+        proc->pipe_quota = NULL;
         if (proc->thread_lock) {
             mutex_destroy(proc->thread_lock);
         }
@@ -273,6 +281,7 @@ process_t process_create(const char *name, const struct spawn_caps *caps) {
     proc->cap_mask       = 0;
     proc->ioport_bitmap  = NULL;
     proc->irq_mask       = 0;
+    spin_init(&proc->cap_lock);
     if (caps) {
         proc->cap_mask      = caps->cap_mask;
         proc->ioport_bitmap = cap_build_ioport_bitmap(caps);
@@ -282,6 +291,7 @@ process_t process_create(const char *name, const struct spawn_caps *caps) {
     proc->threads      = NULL;
     proc->thread_count = 0;
     proc->thread_lock  = mutex_create();
+    spin_init(&proc->mmap_lock);
     proc->sync_table   = kzalloc(sizeof(struct sync_table));
     proc->parent       = NULL;
     proc->children     = NULL;
@@ -302,9 +312,7 @@ process_t process_create(const char *name, const struct spawn_caps *caps) {
         if (proc->handles) {
             handle_table_destroy(proc->handles);
         }
-        if (proc->ioport_bitmap) {
-            kfree(proc->ioport_bitmap);
-        }
+        ioport_bitmap_put(proc->ioport_bitmap);
         if (proc->thread_lock) {
             mutex_destroy(proc->thread_lock);
         }
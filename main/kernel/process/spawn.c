@@ -279,14 +279,12 @@ static pid_t spawn_core(const char *name, void *elf_data, uint32_t elf_size,
 
     /* caps=NULL: 继承父进程的全部能力 (过渡期兼容) */
     if (!caps && creator) {
-        proc->cap_mask = creator->cap_mask;
-        proc->irq_mask = creator->irq_mask;
-        if (creator->ioport_bitmap) {
-            proc->ioport_bitmap = kzalloc(8192);
-            if (proc->ioport_bitmap) {
-                memcpy(proc->ioport_bitmap, creator->ioport_bitmap, 8192);
-            }
-        }
+        /* 端口表只读共享, 上下文切换在同一张表的进程间无需重载 TSS 位图 */
+        uint32_t flags      = spin_lock_irqsave(&creator->cap_lock);
+        proc->cap_mask      = creator->cap_mask;
+        proc->irq_mask      = creator->irq_mask;
+        proc->ioport_bitmap = ioport_bitmap_get(creator->ioport_bitmap);
+        spin_unlock_irqrestore(&creator->cap_lock, flags);
     }
 
     spawn_setup_parent(proc, creator);
@@ -193,6 +193,62 @@ void sched_wakeup_thread(struct thread *t) {
     }
 }
 
+void sched_wakeup_donate(struct thread *t, struct thread *donor) {
+    struct sched_policy *current_policy = sched_get_policy();
+    if (!current_policy || !t) {
+        return;
+    }
+    if (!donor || !current_policy->enqueue_front) {
+        sched_wakeup_thread(t);
+        return;
+    }
+
+    uint32_t flags = spin_lock_irqsave(&sched_lock);
+
+    struct thread **pp      = &blocked_list;
+    bool            removed = false;
+    while (*pp) {
+        if (*pp == t) {
+            *pp     = t->next;
+            t->next = NULL;
+            removed = true;
+            break;
+        }
+        pp = &(*pp)->next;
+    }
+
+    t->wait_chan      = NULL;
+    t->pending_wakeup = true;
+
+    cpu_id_t this_cpu   = cpu_current_id();
+    cpu_id_t target_cpu = this_cpu;
+
+    if (removed || t->state == THREAD_BLOCKED) {
+        t->state = THREAD_READY;
+        if (CPUS_TEST(t->cpus_workable, this_cpu)) {
+            /*
+             * 留在 donor 的 CPU 上, 接过 donor 剩余的时间片排到同优先级段队首.
+             * 时间片是转交不是复制: donor 只留一个 tick, 到点即轮转
+             * (tick 不处理为 0 的时间片, 所以不能清零).
+             */
+            t->time_slice = donor->time_slice;
+            if (donor->time_slice > 1) {
+                donor->time_slice = 1;
+            }
+            current_policy->enqueue_front(t, this_cpu);
+        } else {
+            target_cpu = current_policy->select_cpu ? current_policy->select_cpu(t) : 0;
+            current_policy->enqueue(t, target_cpu);
+        }
+    }
+
+    spin_unlock_irqrestore(&sched_lock, flags);
+
+    if (target_cpu != this_cpu && cpu_is_online(target_cpu)) {
+        smp_send_ipi(target_cpu, IPI_VECTOR_RESCHED);
+    }
+}
+
 /**
  * 带超时的阻塞
  *
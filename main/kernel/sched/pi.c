@@ -0,0 +1,214 @@
+/**
+ * @file pi.c
+ * @brief 优先级继承
+ *
+ * 两个继承来源:
+ *   - IPC: 客户端 call 时把优先级捐赠给处理请求的服务线程, reply 时收回
+ *   - Mutex: 等锁线程把优先级借给持锁者, unlock 时按剩余等待者重新计算
+ *
+ * 有效优先级 = min(base_priority, pi_ipc_prio, pi_mutex_prio).
+ * 只做一层继承, 不沿阻塞链传递.
+ *
+ * IPC 捐赠挂在 reply token (阻塞中的调用方) 上: 调用方记录 pi_donee,
+ * 受赠线程用 pi_donors 链起所有未回复的调用方, pi_ipc_prio 是它们的最小值.
+ * 同一线程连续 receive 多个请求不会互相覆盖; 延迟回复由别的线程接管时,
+ * 捐赠随 token 一起转移 (sched_pi_ipc_adopt).
+ */
+
+#include "sched_internal.h"
+
+#include <xnix/errno.h>
+#include <xnix/sync.h>
+#include <xnix/sync_def.h>
+#include <xnix/thread_def.h>
+
+extern spinlock_t sched_lock;
+
+/* 重新计算有效优先级, 调用者持有 sched_lock */
+static void pi_update_locked(struct thread *t) {
+    int prio = t->base_priority;
+    if (t->pi_ipc_prio < prio) {
+        prio = t->pi_ipc_prio;
+    }
+    if (t->pi_mutex_prio < prio) {
+        prio = t->pi_mutex_prio;
+    }
+
+    if (prio == t->priority) {
+        return;
+    }
+    t->priority = prio;
+
+    /* 就绪线程需要按新优先级重新排队; 运行中的线程在下次轮转时自然归位 */
+    struct sched_policy *policy = sched_get_policy();
+    if (t->state == THREAD_READY && policy && policy->reprio) {
+        policy->reprio(t);
+    }
+}
+
+/* ---- IPC ---- */
+
+/* 按剩余捐赠者重新计算 pi_ipc_prio, 调用者持有 sched_lock */
+static void pi_ipc_recalc_locked(struct thread *t) {
+    int prio = THREAD_PRIO_NONE;
+    for (struct thread *d = t->pi_donors; d; d = d->pi_donor_next) {
+        if (d->priority < prio) {
+            prio = d->priority;
+        }
+    }
+    t->pi_ipc_prio = prio;
+    pi_update_locked(t);
+}
+
+/* 把 donor 从受赠线程的链表上摘下, 返回原受赠线程, 调用者持有 sched_lock */
+static struct thread *pi_ipc_unlink_locked(struct thread *donor) {
+    struct thread *t = donor->pi_donee;
+    if (!t) {
+        return NULL;
+    }
+
+    struct thread **pp = &t->pi_donors;
+    while (*pp) {
+        if (*pp == donor) {
+            *pp = donor->pi_donor_next;
+            break;
+        }
+        pp = &(*pp)->pi_donor_next;
+    }
+    donor->pi_donee      = NULL;
+    donor->pi_donor_next = NULL;
+    return t;
+}
+
+static void pi_ipc_link_locked(struct thread *donor, struct thread *t) {
+    donor->pi_donee      = t;
+    donor->pi_donor_next = t->pi_donors;
+    t->pi_donors         = donor;
+    pi_ipc_recalc_locked(t);
+}
+
+void sched_pi_ipc_donate(struct thread *t, struct thread *donor) {
+    if (!t || !donor || t == donor) {
+        return;
+    }
+
+    uint32_t       flags = spin_lock_irqsave(&sched_lock);
+    struct thread *old   = pi_ipc_unlink_locked(donor);
+    if (old) {
+        pi_ipc_recalc_locked(old);
+    }
+    pi_ipc_link_locked(donor, t);
+    spin_unlock_irqrestore(&sched_lock, flags);
+}
+
+void sched_pi_ipc_return(struct thread *donor) {
+    if (!donor || !donor->pi_donee) {
+        return;
+    }
+
+    uint32_t       flags = spin_lock_irqsave(&sched_lock);
+    struct thread *t     = pi_ipc_unlink_locked(donor);
+    if (t) {
+        pi_ipc_recalc_locked(t);
+    }
+    spin_unlock_irqrestore(&sched_lock, flags);
+}
+
+int sched_pi_ipc_adopt(struct thread *donor, struct thread *t) {
+    if (!donor || !t) {
+        return -EINVAL;
+    }
+
+    uint32_t flags = spin_lock_irqsave(&sched_lock);
+
+    /* 只能在同一进程的线程之间转交 */
+    struct thread *old = donor->pi_donee;
+    if (!old || old->owner != t->owner) {
+        spin_unlock_irqrestore(&sched_lock, flags);
+        return -EINVAL;
+    }
+
+    if (old != t) {
+        pi_ipc_unlink_locked(donor);
+        pi_ipc_recalc_locked(old);
+        pi_ipc_link_locked(donor, t);
+    }
+
+    spin_unlock_irqrestore(&sched_lock, flags);
+    return 0;
+}
+
+void sched_pi_exit_locked(struct thread *t) {
+    struct thread *old = pi_ipc_unlink_locked(t);
+    if (old) {
+        pi_ipc_recalc_locked(old);
+    }
+
+    /* 受赠线程退出: 还在等 reply 的调用方不再捐给任何人 */
+    struct thread *d = t->pi_donors;
+    while (d) {
+        struct thread *next = d->pi_donor_next;
+        d->pi_donee         = NULL;
+        d->pi_donor_next    = NULL;
+        d                   = next;
+    }
+    t->pi_donors   = NULL;
+    t->pi_ipc_prio = THREAD_PRIO_NONE;
+}
+
+/* ---- Mutex ---- */
+
+void sched_pi_mutex_wait(struct mutex *m, thread_t waiter) {
+    if (!m || !waiter) {
+        return;
+    }
+
+    uint32_t flags       = spin_lock_irqsave(&sched_lock);
+    waiter->pi_wait_lock = m;
+
+    struct thread *owner = m->owner;
+    if (owner && waiter->priority < owner->pi_mutex_prio) {
+        owner->pi_mutex_prio = waiter->priority;
+        pi_update_locked(owner);
+    }
+    spin_unlock_irqrestore(&sched_lock, flags);
+}
+
+void sched_pi_mutex_acquired(thread_t t) {
+    if (t) {
+        t->pi_wait_lock = NULL;
+    }
+}
+
+void sched_pi_mutex_release(thread_t t) {
+    if (!t || t->pi_mutex_prio == THREAD_PRIO_NONE) {
+        return;
+    }
+
+    uint32_t flags = spin_lock_irqsave(&sched_lock);
+
+    /* t 可能还持有别的锁: 继承值取仍阻塞在这些锁上的线程的最高优先级 */
+    int prio = THREAD_PRIO_NONE;
+    for (struct thread *w = *sched_get_blocked_list(); w; w = w->next) {
+        if (w->pi_wait_lock && w->pi_wait_lock->owner == t && w->priority < prio) {
+            prio = w->priority;
+        }
+    }
+    t->pi_mutex_prio = prio;
+    pi_update_locked(t);
+
+    spin_unlock_irqrestore(&sched_lock, flags);
+}
+
+/* ---- 自身优先级 ---- */
+
+void sched_set_base_priority(struct thread *t, int prio) {
+    if (!t) {
+        return;
+    }
+
+    uint32_t flags   = spin_lock_irqsave(&sched_lock);
+    t->base_priority = prio;
+    pi_update_locked(t);
+    spin_unlock_irqrestore(&sched_lock, flags);
+}
@@ -4,8 +4,9 @@
  *
  * 简单的时间片轮转:
  * - 每个线程固定时间片
- * - 用完时间片或主动 yield 后,移到队尾
- * - FIFO 队列,公平轮转
+ * - 用完时间片或主动 yield 后,移到同优先级段的队尾
+ * - 队列按有效优先级排序,同优先级内 FIFO 公平轮转
+ * - 更高优先级线程排到当前线程前面时,下一个 tick 抢占
  */
 
 #include "sched_internal.h"
@@ -19,6 +20,33 @@ extern struct runqueue *sched_get_runqueue(cpu_id_t cpu);
  * 队列操作
  **/
 
+/*
+ * 按优先级插入队列
+ * front=false: 插到同优先级段末尾; front=true: 插到同优先级段最前
+ */
+static void rr_insert(struct runqueue *rq, struct thread *t, bool front) {
+    struct thread *prev = NULL;
+    struct thread *curr = rq->head;
+
+    while (curr) {
+        if (front ? curr->priority >= t->priority : curr->priority > t->priority) {
+            break;
+        }
+        prev = curr;
+        curr = curr->next;
+    }
+
+    t->next = curr;
+    if (prev) {
+        prev->next = t;
+    } else {
+        rq->head = t;
+    }
+    if (!curr) {
+        rq->tail = t;
+    }
+}
+
 static void rr_enqueue(struct thread *t, cpu_id_t cpu) {
     struct runqueue *rq = sched_get_runqueue(cpu);
 
@@ -26,16 +54,20 @@ static void rr_enqueue(struct thread *t, cpu_id_t cpu) {
     t->state      = THREAD_READY;
     t->time_slice = CFG_DEF_TIME_SLICE; /* 重置时间片 */
 
-    if (!rq->head) {
-        /* 队列为空 */
-        rq->head = t;
-        rq->tail = t;
-    } else {
-        /* 加入队尾 */
-        rq->tail->next = t;
-        rq->tail       = t;
+    rr_insert(rq, t, false);
+    rq->nr_running++;
+}
+
+static void rr_enqueue_front(struct thread *t, cpu_id_t cpu) {
+    struct runqueue *rq = sched_get_runqueue(cpu);
+
+    t->next  = NULL;
+    t->state = THREAD_READY;
+    if (t->time_slice == 0) {
+        t->time_slice = CFG_DEF_TIME_SLICE;
     }
 
+    rr_insert(rq, t, true);
     rq->nr_running++;
 }
 
@@ -79,7 +111,7 @@ static struct thread *rr_pick_next(void) {
         return NULL;
     }
 
-    /* 如果队列头的线程时间片为 0,轮转到队尾 */
+    /* 如果队列头的线程时间片为 0,轮转到同优先级段队尾 */
     if (rq->head->time_slice == 0) {
         struct thread *t = rq->head;
 
@@ -89,18 +121,10 @@ static struct thread *rr_pick_next(void) {
             rq->tail = NULL;
         }
 
-        /* 加到队尾(会在 enqueue 中重置时间片) */
-        t->next = NULL;
-        if (rq->tail) {
-            rq->tail->next = t;
-            rq->tail       = t;
-        } else {
-            rq->head = t;
-            rq->tail = t;
-        }
-
-        /* 重置时间片 */
+        /* 重置时间片后重新插入 */
+        t->next       = NULL;
         t->time_slice = CFG_DEF_TIME_SLICE;
+        rr_insert(rq, t, false);
     }
 
     return rq->head;
@@ -121,9 +145,47 @@ static bool rr_tick(struct thread *current) {
         return true;
     }
 
+    /* 有线程排到了当前线程前面(更高优先级或被捐赠了时间片),让它先运行 */
+    struct runqueue *rq = sched_get_runqueue(cpu_current_id());
+    if (rq->head && rq->head != current && current->state == THREAD_RUNNING) {
+        return true;
+    }
+
     return false;
 }
 
+/* 在所有 CPU 的队列中找到线程并按新优先级重新排队 */
+static void rr_reprio(struct thread *t) {
+    uint32_t total_cpus = percpu_cpu_count();
+
+    for (cpu_id_t i = 0; i < total_cpus; i++) {
+        struct runqueue *rq   = sched_get_runqueue(i);
+        struct thread   *prev = NULL;
+        struct thread   *curr = rq->head;
+
+        while (curr && curr != t) {
+            prev = curr;
+            curr = curr->next;
+        }
+        if (!curr) {
+            continue;
+        }
+
+        if (prev) {
+            prev->next = t->next;
+        } else {
+            rq->head = t->next;
+        }
+        if (rq->tail == t) {
+            rq->tail = prev;
+        }
+
+        t->next = NULL;
+        rr_insert(rq, t, false);
+        return;
+    }
+}
+
 /**
  * 选择负载最轻的 CPU
  */
@@ -183,4 +245,7 @@ struct sched_policy sched_policy_rr = {
     .pick_next  = rr_pick_next,
     .tick       = rr_tick,
     .select_cpu = rr_select_cpu,
+
+    .enqueue_front = rr_enqueue_front,
+    .reprio        = rr_reprio,
 };
@@ -44,6 +44,11 @@ struct thread *sched_get_idle_thread(cpu_id_t cpu);
  */
 struct thread **sched_get_zombie_list(cpu_id_t cpu);
 
+/**
+ * 线程退出时解除它参与的优先级继承关系(pi.c), 调用者持有 sched_lock
+ */
+void sched_pi_exit_locked(struct thread *t);
+
 /*
  * 睡眠模块(sleep.c)
  */
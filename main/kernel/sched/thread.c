@@ -161,6 +161,9 @@ static struct thread *sched_spawn(const char *name, void (*entry)(void *), void
     t->name            = name;
     t->state           = THREAD_READY;
     t->priority        = 0;
+    t->base_priority   = 0;
+    t->pi_ipc_prio     = THREAD_PRIO_NONE;
+    t->pi_mutex_prio   = THREAD_PRIO_NONE;
     t->time_slice      = 0;
     t->cpus_workable   = CPUS_ALL;
     t->running_on      = CPU_ID_INVALID;
@@ -210,6 +213,9 @@ void thread_init_idle(void) {
             idle->name            = "idle";
             idle->state           = THREAD_READY;
             idle->priority        = 255;
+            idle->base_priority   = 255;
+            idle->pi_ipc_prio     = THREAD_PRIO_NONE;
+            idle->pi_mutex_prio   = THREAD_PRIO_NONE;
             idle->stack_size      = CFG_THREAD_STACK_SIZE;
             idle->stack           = kmalloc(CFG_THREAD_STACK_SIZE);
             idle->cpus_workable   = (1 << i); /* 绑定到特定 CPU */
@@ -273,6 +279,7 @@ void thread_force_exit(struct thread *t) {
     t->state       = THREAD_EXITED;
     t->exit_code   = -1;
     t->is_detached = true;
+    sched_pi_exit_locked(t);
 
     /* 从运行队列移除 */
     if (current_policy && current_policy->dequeue) {
@@ -322,6 +329,10 @@ void thread_exit(int code) {
         current->state     = THREAD_EXITED;
         current->exit_code = code;
 
+        uint32_t flags = spin_lock_irqsave(&sched_lock);
+        sched_pi_exit_locked(current);
+        spin_unlock_irqrestore(&sched_lock, flags);
+
         pr_debug("[SCHED] thread exit: tid=%d name='%s' code=%d\n", current->tid, current->name,
                  code);
 
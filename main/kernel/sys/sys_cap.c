@@ -34,7 +34,9 @@ static int32_t sys_cap_grant(const uint32_t *args) {
         return -ENOENT;
     }
 
+    uint32_t flags = spin_lock_irqsave(&target->cap_lock);
     target->cap_mask |= cap_bits;
+    spin_unlock_irqrestore(&target->cap_lock, flags);
     process_unref(target);
     return 0;
 }
@@ -53,7 +55,9 @@ static int32_t sys_cap_revoke(const uint32_t *args) {
         return -ENOENT;
     }
 
+    uint32_t flags = spin_lock_irqsave(&target->cap_lock);
     target->cap_mask &= ~cap_bits;
+    spin_unlock_irqrestore(&target->cap_lock, flags);
     process_unref(target);
     return 0;
 }
@@ -64,9 +68,72 @@ static int32_t sys_cap_query(const uint32_t *args) {
     return (int32_t)proc->cap_mask;
 }
 
+/**
+ * SYS_IOPORT_GRANT: 把调用者拥有的端口区间授予目标进程
+ *
+ * 总线驱动(pcid)用它把 BAR 描述的 IO 区间交给具体设备驱动.
+ */
+static int32_t sys_ioport_grant(const uint32_t *args) {
+    pid_t           pid    = (pid_t)args[0];
+    uint32_t        start  = args[1];
+    uint32_t        end    = args[2];
+    struct process *caller = (struct process *)process_current();
+
+    if (start > end || end > 0xFFFF) {
+        return -EINVAL;
+    }
+    if (!cap_check(caller, CAP_CAP_DELEGATE)) {
+        return -EPERM;
+    }
+    for (uint32_t port = start; port <= end; port++) {
+        if (!cap_check_ioport(caller, (uint16_t)port)) {
+            return -EPERM;
+        }
+    }
+
+    struct process *target = process_find_by_pid(pid);
+    if (!target) {
+        return -ENOENT;
+    }
+
+    int ret = cap_grant_ioport(target, (uint16_t)start, (uint16_t)end);
+    process_unref(target);
+    return ret;
+}
+
+/**
+ * SYS_IRQ_GRANT: 把调用者拥有的 IRQ 授予目标进程
+ */
+static int32_t sys_irq_grant(const uint32_t *args) {
+    pid_t           pid    = (pid_t)args[0];
+    uint32_t        irq    = args[1];
+    struct process *caller = (struct process *)process_current();
+
+    if (irq >= 32) {
+        return -EINVAL;
+    }
+    if (!cap_check(caller, CAP_CAP_DELEGATE) || !cap_check_irq(caller, (uint8_t)irq)) {
+        return -EPERM;
+    }
+
+    struct process *target = process_find_by_pid(pid);
+    if (!target) {
+        return -ENOENT;
+    }
+
+    uint32_t flags = spin_lock_irqsave(&target->cap_lock);
+    target->irq_mask |= 1u << irq;
+    target->cap_mask |= CAP_IRQ;
+    spin_unlock_irqrestore(&target->cap_lock, flags);
+    process_unref(target);
+    return 0;
+}
+
 void sys_cap_init(void) {
     syscall_register(SYS_CAP_CHECK, sys_cap_check, 1, "cap_check");
     syscall_register(SYS_CAP_GRANT, sys_cap_grant, 2, "cap_grant");
     syscall_register(SYS_CAP_REVOKE, sys_cap_revoke, 2, "cap_revoke");
     syscall_register(SYS_CAP_QUERY, sys_cap_query, 2, "cap_query");
+    syscall_register(SYS_IOPORT_GRANT, sys_ioport_grant, 3, "ioport_grant");
+    syscall_register(SYS_IRQ_GRANT, sys_irq_grant, 2, "irq_grant");
 }
@@ -84,6 +84,12 @@ static int32_t sys_handle_grant(const uint32_t *args) {
         return -EPERM;
     }
 
+    /* SERVE 不能 grant 给别的进程 */
+    rights = (rights ? rights : HANDLE_RIGHT_ALL) & ~HANDLE_RIGHT_SERVE;
+    if (!rights) {
+        return -EINVAL;
+    }
+
     struct process *dst = process_find_by_pid(pid);
     if (!dst) {
         return -ENOENT;
@@ -13,6 +13,11 @@
 #include <xnix/process.h>
 #include <xnix/syscall.h>
 #include <xnix/types.h>
+#include <xnix/usraccess.h>
+
+/* 串操作单次最多传输的单元数, 以及内核中转缓冲大小 */
+#define IOPORT_STR_MAX_COUNT 65536
+#define IOPORT_STR_CHUNK     512
 
 static inline bool is_com1_port(uint16_t port) {
     return (port >= 0x3F8) && (port <= 0x3FF);
@@ -98,6 +103,88 @@ static int32_t sys_ioport_inw(const uint32_t *args) {
     return (int32_t)inw(port);
 }
 
+/*
+ * 串端口操作: 在一次内核入口里完成 count 个单元的 rep ins/outs.
+ * width 为单元字节数(1/2), 端口的每个字节都需要授权.
+ * 经内核缓冲中转, 避免在关中断或持串口锁时访问用户页.
+ */
+static int32_t ioport_string(const uint32_t *args, uint32_t width, bool in) {
+    uint16_t        port  = (uint16_t)args[0];
+    uint8_t        *ubuf  = (uint8_t *)(uintptr_t)args[1];
+    uint32_t        count = args[2];
+    struct process *proc  = (struct process *)process_current();
+
+    for (uint32_t i = 0; i < width; i++) {
+        if (!cap_check_ioport(proc, (uint16_t)(port + i))) {
+            return -EPERM;
+        }
+    }
+    if (!ubuf) {
+        return -EFAULT;
+    }
+    if (count > IOPORT_STR_MAX_COUNT) {
+        count = IOPORT_STR_MAX_COUNT;
+    }
+
+    uint8_t  kbuf[IOPORT_STR_CHUNK];
+    uint32_t done = 0;
+    bool     com1 = is_com1_port(port);
+
+    while (done < count) {
+        uint32_t n     = count - done;
+        uint32_t bytes = n * width;
+        if (bytes > IOPORT_STR_CHUNK) {
+            n     = IOPORT_STR_CHUNK / width;
+            bytes = n * width;
+        }
+
+        if (!in && copy_from_user(kbuf, ubuf + done * width, bytes) < 0) {
+            return done ? (int32_t)done : -EFAULT;
+        }
+
+        uint32_t flags = com1 ? serial_hw_lock_irqsave() : 0;
+        if (width == 1 && in) {
+            insb(port, kbuf, n);
+        } else if (width == 1) {
+            outsb(port, kbuf, n);
+        } else if (in) {
+            insw(port, kbuf, n);
+        } else {
+            outsw(port, kbuf, n);
+        }
+        if (com1) {
+            serial_hw_unlock_irqrestore(flags);
+        }
+
+        if (in && copy_to_user(ubuf + done * width, kbuf, bytes) < 0) {
+            return done ? (int32_t)done : -EFAULT;
+        }
+        done += n;
+    }
+
+    return (int32_t)done;
+}
+
+/* SYS_IOPORT_INSB: ebx=port, ecx=buf, edx=count */
+static int32_t sys_ioport_insb(const uint32_t *args) {
+    return ioport_string(args, 1, true);
+}
+
+/* SYS_IOPORT_OUTSB: ebx=port, ecx=buf, edx=count */
+static int32_t sys_ioport_outsb(const uint32_t *args) {
+    return ioport_string(args, 1, false);
+}
+
+/* SYS_IOPORT_INSW: ebx=port, ecx=buf, edx=count(字数) */
+static int32_t sys_ioport_insw(const uint32_t *args) {
+    return ioport_string(args, 2, true);
+}
+
+/* SYS_IOPORT_OUTSW: ebx=port, ecx=buf, edx=count(字数) */
+static int32_t sys_ioport_outsw(const uint32_t *args) {
+    return ioport_string(args, 2, false);
+}
+
 /**
  * 注册 I/O 系统调用
  */
@@ -106,4 +193,8 @@ void sys_io_init(void) {
     syscall_register(SYS_IOPORT_INB, sys_ioport_inb, 1, "ioport_inb");
     syscall_register(SYS_IOPORT_OUTW, sys_ioport_outw, 2, "ioport_outw");
     syscall_register(SYS_IOPORT_INW, sys_ioport_inw, 1, "ioport_inw");
+    syscall_register(SYS_IOPORT_INSB, sys_ioport_insb, 3, "ioport_insb");
+    syscall_register(SYS_IOPORT_OUTSB, sys_ioport_outsb, 3, "ioport_outsb");
+    syscall_register(SYS_IOPORT_INSW, sys_ioport_insw, 3, "ioport_insw");
+    syscall_register(SYS_IOPORT_OUTSW, sys_ioport_outsw, 3, "ioport_outsw");
 }
@@ -5,9 +5,12 @@
 
 #include <ipc/endpoint.h>
 #include <ipc/event.h>
+#include <ipc/iov.h>
+#include <ipc/ring.h>
 #include <sys/syscall.h>
 #include <xnix/config.h>
 #include <xnix/errno.h>
+#include <xnix/filemap.h>
 #include <xnix/ipc.h>
 #include <xnix/mm.h>
 #include <xnix/cap.h>
@@ -16,6 +19,18 @@
 #include <xnix/syscall.h>
 #include <xnix/usraccess.h>
 
+/**
+ * 调入 IOV 各段中的文件映射页
+ *
+ * 拷贝不处理缺页, IOV 段要到会合时才在对端上下文中搬运, 此时必须已经就位.
+ */
+static void ipc_iov_prefault(const struct ipc_iov_desc *desc, bool write) {
+    struct process *proc = process_current();
+    for (uint32_t i = 0; i < desc->count; i++) {
+        filemap_prefault(proc, (uint32_t)desc->seg[i].data, desc->seg[i].size, write);
+    }
+}
+
 /**
  * 将用户态 IPC 消息复制到内核缓冲区
  */
@@ -30,6 +45,30 @@ static int ipc_msg_copy_in(struct ipc_message **out_kmsg, struct ipc_message *us
     if (ret < 0) {
         return ret;
     }
+    umsg.flags &= ~IPC_FLAG_KERNEL; /* 只有内核能代发 */
+
+    if (copy_buffer && (umsg.flags & IPC_FLAG_IOV)) {
+        /* 分散/聚集: 只拷段描述, 数据在会合时直接搬运 */
+        struct ipc_iov_desc *desc = NULL;
+        ret = ipc_iov_desc_create((const void *)(uintptr_t)umsg.buffer.data, umsg.buffer.size,
+                                  &desc);
+        if (ret < 0) {
+            return ret;
+        }
+        ipc_iov_prefault(desc, false);
+
+        struct ipc_message *kmsg = kzalloc(sizeof(*kmsg));
+        if (!kmsg) {
+            kfree(desc);
+            return -ENOMEM;
+        }
+        memcpy(kmsg, &umsg, sizeof(*kmsg));
+        kmsg->buffer.data = (uint64_t)(uintptr_t)desc;
+        kmsg->buffer.size = desc->total;
+
+        *out_kmsg = kmsg;
+        return 0;
+    }
 
     if (copy_buffer) {
         if (umsg.buffer.size > CFG_IPC_MAX_BUF) {
@@ -54,6 +93,7 @@ static int ipc_msg_copy_in(struct ipc_message **out_kmsg, struct ipc_message *us
             kfree(kmsg);
             return -ENOMEM;
         }
+        filemap_prefault(process_current(), (uint32_t)umsg.buffer.data, umsg.buffer.size, false);
         ret = copy_from_user(kbuf, (const void *)(uintptr_t)umsg.buffer.data, umsg.buffer.size);
         if (ret < 0) {
             kfree(kbuf);
@@ -73,6 +113,9 @@ static int ipc_msg_copy_in(struct ipc_message **out_kmsg, struct ipc_message *us
 
 /**
  * 将内核 IPC 消息复制回用户态
+ *
+ * IOV 消息的数据已在会合时写入用户段, 这里只回写消息头,
+ * buffer.data 保持为用户的 iovec 数组, buffer.size 为实际字节数.
  */
 static int ipc_msg_copy_out(struct ipc_message *user_msg, const struct ipc_message *kmsg,
                             void *user_buf_ptr, size_t user_buf_size) {
@@ -80,7 +123,7 @@ static int ipc_msg_copy_out(struct ipc_message *user_msg, const struct ipc_messa
         return -EINVAL;
     }
 
-    if (user_buf_ptr && user_buf_size) {
+    if ((kmsg->flags & IPC_FLAG_IOV) == 0 && user_buf_ptr && user_buf_size) {
         size_t n = kmsg->buffer.size;
         if (n > user_buf_size) {
             n = user_buf_size;
@@ -132,6 +175,31 @@ static int ipc_msg_alloc_recv(struct ipc_message **out_kmsg, struct ipc_message
 
     void  *user_buf_ptr  = (void *)(uintptr_t)umsg.buffer.data;
     size_t user_buf_size = umsg.buffer.size;
+    umsg.flags &= ~IPC_FLAG_KERNEL;
+
+    if (umsg.flags & IPC_FLAG_IOV) {
+        struct ipc_iov_desc *desc = NULL;
+        ret = ipc_iov_desc_create(user_buf_ptr, umsg.buffer.size, &desc);
+        if (ret < 0) {
+            return ret;
+        }
+        ipc_iov_prefault(desc, true);
+
+        struct ipc_message *kmsg = kzalloc(sizeof(*kmsg));
+        if (!kmsg) {
+            kfree(desc);
+            return -ENOMEM;
+        }
+        memcpy(&kmsg->regs, &umsg.regs, sizeof(kmsg->regs));
+        kmsg->flags       = umsg.flags;
+        kmsg->buffer.data = (uint64_t)(uintptr_t)desc;
+        kmsg->buffer.size = desc->total;
+
+        *out_kmsg          = kmsg;
+        *out_user_buf      = user_buf_ptr;
+        *out_user_buf_size = 0;
+        return 0;
+    }
 
     if (user_buf_size > CFG_IPC_MAX_BUF) {
         return -E2BIG;
@@ -150,6 +218,8 @@ static int ipc_msg_alloc_recv(struct ipc_message **out_kmsg, struct ipc_message
     kmsg->handles.count = 0;
 
     if (user_buf_ptr && user_buf_size) {
+        filemap_prefault(process_current(), (uint32_t)(uintptr_t)user_buf_ptr, user_buf_size,
+                         true);
         void *kbuf = kmalloc(user_buf_size);
         if (!kbuf) {
             kfree(kmsg);
@@ -329,6 +399,11 @@ static int32_t sys_ipc_reply_to(const uint32_t *args) {
     return ret;
 }
 
+/* SYS_IPC_REPLY_ADOPT: ebx=sender_tid */
+static int32_t sys_ipc_reply_adopt(const uint32_t *args) {
+    return ipc_reply_adopt((tid_t)args[0]);
+}
+
 /* SYS_EVENT_CREATE */
 static int32_t sys_event_create(const uint32_t *args) {
     (void)args;
@@ -384,6 +459,41 @@ static int32_t sys_ipc_wait_any(const uint32_t *args) {
     return (int32_t)result;
 }
 
+/* SYS_RING_CREATE: ebx=abi_ring_create_args* */
+static int32_t sys_ring_create(const uint32_t *args) {
+    struct abi_ring_create_args *user_args = (struct abi_ring_create_args *)(uintptr_t)args[0];
+
+    struct process *proc = process_current();
+    if (!proc || !user_args) {
+        return -EINVAL;
+    }
+
+    /* 通道两端都要 mmap SHM */
+    if (!cap_check(proc, CAP_MM_MMAP)) {
+        return -EPERM;
+    }
+
+    struct abi_ring_create_args kargs;
+    int ret = copy_from_user(&kargs, user_args, sizeof(kargs));
+    if (ret < 0) {
+        return ret;
+    }
+
+    ret = ring_create(&kargs);
+    if (ret < 0) {
+        return ret;
+    }
+
+    ret = copy_to_user(user_args, &kargs, sizeof(kargs));
+    if (ret < 0) {
+        handle_free(proc, kargs.cq_event);
+        handle_free(proc, kargs.sq_event);
+        handle_free(proc, kargs.shm);
+        return ret;
+    }
+    return 0;
+}
+
 /**
  * 注册 IPC 系统调用(新编号:100-119)
  */
@@ -394,9 +504,11 @@ void sys_ipc_init(void) {
     syscall_register(SYS_IPC_CALL, sys_ipc_call, 4, "ipc_call");
     syscall_register(SYS_IPC_REPLY, sys_ipc_reply, 1, "ipc_reply");
     syscall_register(SYS_IPC_REPLY_TO, sys_ipc_reply_to, 2, "ipc_reply_to");
+    syscall_register(SYS_IPC_REPLY_ADOPT, sys_ipc_reply_adopt, 1, "ipc_reply_adopt");
     /* 事件系统调用 (800-819) */
     syscall_register(SYS_EVENT_CREATE, sys_event_create, 0, "event_create");
     syscall_register(SYS_EVENT_WAIT, sys_event_wait, 1, "event_wait");
     syscall_register(SYS_EVENT_SIGNAL, sys_event_signal, 2, "event_signal");
     syscall_register(SYS_IPC_WAIT_ANY, sys_ipc_wait_any, 2, "ipc_wait_any");
+    syscall_register(SYS_RING_CREATE, sys_ring_create, 1, "ring_create");
 }
@@ -70,8 +70,41 @@ static int32_t sys_irq_read(const uint32_t *args) {
     return irq_user_read(irq, buf, size, block);
 }
 
+/*
+ * SYS_IRQ_ROUTE: ebx=bus, ecx=dev, edx=pin, esi=legacy
+ *
+ * 解析 PCI INTx 到 IRQ 号并配置触发模式, 由总线驱动在分配设备时调用.
+ */
+static int32_t sys_irq_route(const uint32_t *args) {
+    struct process *proc = process_current();
+
+    if (!cap_check(proc, CAP_IRQ)) {
+        return -EPERM;
+    }
+    if (args[0] > 0xFF || args[1] > 31) {
+        return -EINVAL;
+    }
+
+    return irq_route_pci((uint8_t)args[0], (uint8_t)args[1], (uint8_t)args[2],
+                         (uint8_t)args[3]);
+}
+
+/* SYS_IRQ_ACK: ebx=irq */
+static int32_t sys_irq_ack(const uint32_t *args) {
+    uint8_t         irq  = (uint8_t)args[0];
+    struct process *proc = process_current();
+
+    if (!proc) {
+        return -ESRCH;
+    }
+
+    return irq_user_ack(irq, proc);
+}
+
 void sys_irq_init(void) {
     syscall_register(SYS_IRQ_BIND, sys_irq_bind, 3, "irq_bind");
     syscall_register(SYS_IRQ_UNBIND, sys_irq_unbind, 1, "irq_unbind");
     syscall_register(SYS_IRQ_READ, sys_irq_read, 4, "irq_read");
+    syscall_register(SYS_IRQ_ROUTE, sys_irq_route, 4, "irq_route");
+    syscall_register(SYS_IRQ_ACK, sys_irq_ack, 1, "irq_ack");
 }
@@ -4,7 +4,10 @@
  */
 
 #include <sys/syscall.h>
+#include <xnix/abi/fcache.h>
+#include <xnix/abi/mman.h>
 #include <xnix/errno.h>
+#include <xnix/filemap.h>
 #include <xnix/handle.h>
 #include <xnix/mm.h>
 #include <xnix/mm_ops.h>
@@ -17,6 +20,9 @@
 #include <xnix/usraccess.h>
 #include <xnix/vmm.h>
 
+/* 单个 DMA 缓冲区上限: 连续物理页来自低端内存, 不宜过大 */
+#define DMA_BUF_MAX_SIZE (256 * 1024)
+
 extern void *vmm_kmap(paddr_t paddr);
 extern void  vmm_kunmap(void *vaddr);
 
@@ -180,6 +186,128 @@ static int32_t sys_mmap_phys(const uint32_t *args) {
     return (int32_t)user_addr;
 }
 
+/**
+ * SYS_MUNMAP: 取消 sys_mmap_phys/sys_mmap_file 建立的映射
+ *
+ * @param args[0] addr 映射起始地址
+ * @param args[1] size 映射大小(字节)
+ * @return 0 成功,负数失败
+ */
+static int32_t sys_munmap(const uint32_t *args) {
+    uint32_t addr = args[0];
+    uint32_t size = args[1];
+
+    struct process *proc = process_get_current();
+    if (!proc) {
+        return -EINVAL;
+    }
+
+    if (!cap_check(proc, CAP_MM_MMAP)) {
+        return -EPERM;
+    }
+
+    int ret = filemap_unmap(proc, addr, size);
+    if (ret != -ENOENT) {
+        return ret;
+    }
+    return physmem_unmap_from_user(proc, addr, size);
+}
+
+/**
+ * SYS_MMAP_FILE: 映射已打开的文件
+ *
+ * @param args[0] 用户空间 abi_mmap_file_args 指针, 成功时写回 addr
+ * @return 0 成功, 负数失败 (-ENODEV 表示服务端不支持映射)
+ *
+ * 权限检查: 需要 xnix.mm.mmap 权限
+ */
+static int32_t sys_mmap_file(const uint32_t *args) {
+    struct abi_mmap_file_args *user_args = (struct abi_mmap_file_args *)(uintptr_t)args[0];
+
+    struct process *proc = process_get_current();
+    if (!proc) {
+        return -EINVAL;
+    }
+
+    if (!cap_check(proc, CAP_MM_MMAP)) {
+        return -EPERM;
+    }
+
+    struct abi_mmap_file_args kargs;
+    int                       ret = copy_from_user(&kargs, user_args, sizeof(kargs));
+    if (ret < 0) {
+        return ret;
+    }
+
+    ret = filemap_map(proc, kargs.handle, kargs.session, kargs.offset, kargs.size, kargs.prot,
+                      kargs.flags, &kargs.addr);
+    if (ret < 0) {
+        return ret;
+    }
+
+    ret = copy_to_user(&user_args->addr, &kargs.addr, sizeof(kargs.addr));
+    if (ret < 0) {
+        filemap_unmap(proc, kargs.addr, kargs.size);
+    }
+    return ret;
+}
+
+/**
+ * SYS_MSYNC: 把共享文件映射中的修改写回文件
+ *
+ * @param args[0] addr 起始地址
+ * @param args[1] size 大小(字节)
+ * @return 0 成功, 负数失败
+ */
+static int32_t sys_msync(const uint32_t *args) {
+    struct process *proc = process_get_current();
+    if (!proc) {
+        return -EINVAL;
+    }
+
+    return filemap_sync(proc, args[0], args[1]);
+}
+
+/**
+ * SYS_FCACHE_CTL: 文件系统服务端填充/登记/作废文件页缓存
+ *
+ * @param args[0] 用户空间 abi_fcache_args 指针
+ * @return 0 成功, 负数失败
+ */
+static int32_t sys_fcache_ctl(const uint32_t *args) {
+    struct process *proc = process_get_current();
+    if (!proc) {
+        return -EINVAL;
+    }
+
+    struct abi_fcache_args kargs;
+    int                    ret = copy_from_user(&kargs, (void *)(uintptr_t)args[0], sizeof(kargs));
+    if (ret < 0) {
+        return ret;
+    }
+    return filemap_cache_ctl(proc, &kargs);
+}
+
+/**
+ * SYS_FCACHE_READ: 从文件页缓存读
+ *
+ * @param args[0] handle  文件所在服务端的 endpoint
+ * @param args[1] session 已打开文件的会话
+ * @param args[2] offset  文件内偏移
+ * @param args[3] buf     用户缓冲区
+ * @param args[4] size    大小
+ * @return 命中的字节数, 0 未命中, -ENOENT 会话不走缓存
+ */
+static int32_t sys_fcache_read(const uint32_t *args) {
+    struct process *proc = process_get_current();
+    if (!proc) {
+        return -EINVAL;
+    }
+
+    return filemap_cache_read(proc, args[0], args[1], args[2], (void *)(uintptr_t)args[3],
+                              args[4]);
+}
+
 /**
  * SYS_PHYSMEM_INFO: 查询物理内存区域信息
  *
@@ -200,7 +328,8 @@ static int32_t sys_mmap_phys(const uint32_t *args) {
  * - [24]    green_size(仅 type=1)
  * - [25]    blue_pos  (仅 type=1)
  * - [26]    blue_size (仅 type=1)
- * - [27-31] reserved
+ * - [27]    reserved
+ * - [28-31] phys_addr 物理起始地址(仅 type=3/4, DMA 缓冲区与 MMIO 窗口)
  */
 static int32_t sys_physmem_info(const uint32_t *args) {
     handle_t handle   = (handle_t)args[0];
@@ -242,6 +371,9 @@ static int32_t sys_physmem_info(const uint32_t *args) {
         info[25]                 = region->fb_info.blue_pos;
         info[26]                 = region->fb_info.blue_size;
     }
+    if (region->type == PHYSMEM_TYPE_DMA || region->type == PHYSMEM_TYPE_MMIO) {
+        *(uint32_t *)(info + 28) = (uint32_t)region->phys_addr;
+    }
 
     int ret = copy_to_user(info_ptr, info, sizeof(info));
     handle_object_put(entry.type, entry.object);
@@ -284,12 +416,99 @@ static int32_t sys_shm_create(const uint32_t *args) {
     return (int32_t)h;
 }
 
+/**
+ * SYS_DMA_CREATE: 创建物理连续的 DMA 缓冲区
+ *
+ * 设备按物理地址访问缓冲区, 只有能直接编程硬件的驱动才需要,
+ * 因此额外要求 CAP_IO_PORT.
+ *
+ * @param args[0] size 缓冲区大小(字节, 不超过 DMA_BUF_MAX_SIZE)
+ * @return handle 值,失败返回负错误码
+ */
+static int32_t sys_dma_create(const uint32_t *args) {
+    uint32_t size = args[0];
+
+    if (size == 0 || size > DMA_BUF_MAX_SIZE) {
+        return -EINVAL;
+    }
+
+    struct process *proc = process_get_current();
+    if (!proc) {
+        return -EINVAL;
+    }
+
+    if (!cap_check(proc, CAP_MM_MMAP | CAP_IO_PORT)) {
+        return -EPERM;
+    }
+
+    struct physmem_region *region = dma_create(size);
+    if (!region) {
+        return -ENOMEM;
+    }
+
+    handle_t h = handle_alloc(proc, HANDLE_PHYSMEM, region, NULL);
+    if (h == HANDLE_INVALID) {
+        physmem_put(region);
+        return -ENOMEM;
+    }
+
+    return (int32_t)h;
+}
+
+/**
+ * SYS_MMIO_CREATE: 包装设备寄存器窗口
+ *
+ * 只接受受管 RAM 和内核保留窗口 (LAPIC, IOAPIC 等) 之外的物理地址,
+ * 总线驱动据此把 PCI 内存 BAR 以 physmem handle 的形式交给设备驱动.
+ *
+ * @param args[0] phys 物理起始地址
+ * @param args[1] size 区域大小(字节)
+ * @return handle 值,失败返回负错误码
+ */
+static int32_t sys_mmio_create(const uint32_t *args) {
+    paddr_t  phys = (paddr_t)args[0];
+    uint32_t size = args[1];
+
+    if (size == 0) {
+        return -EINVAL;
+    }
+
+    struct process *proc = process_get_current();
+    if (!proc) {
+        return -EINVAL;
+    }
+
+    if (!cap_check(proc, CAP_MM_MMAP | CAP_IO_PORT)) {
+        return -EPERM;
+    }
+
+    struct physmem_region *region = mmio_create(phys, size);
+    if (!region) {
+        return -EINVAL;
+    }
+
+    handle_t h = handle_alloc(proc, HANDLE_PHYSMEM, region, NULL);
+    if (h == HANDLE_INVALID) {
+        physmem_put(region);
+        return -ENOMEM;
+    }
+
+    return (int32_t)h;
+}
+
 /**
  * 注册内存管理系统调用(编号:200-219)
  */
 void sys_mm_init(void) {
     syscall_register(SYS_SBRK, sys_sbrk, 1, "sbrk");
     syscall_register(SYS_MMAP_PHYS, sys_mmap_phys, 5, "mmap_phys");
+    syscall_register(SYS_MUNMAP, sys_munmap, 2, "munmap");
     syscall_register(SYS_PHYSMEM_INFO, sys_physmem_info, 2, "physmem_info");
     syscall_register(SYS_SHM_CREATE, sys_shm_create, 1, "shm_create");
+    syscall_register(SYS_DMA_CREATE, sys_dma_create, 1, "dma_create");
+    syscall_register(SYS_MMIO_CREATE, sys_mmio_create, 2, "mmio_create");
+    syscall_register(SYS_MMAP_FILE, sys_mmap_file, 1, "mmap_file");
+    syscall_register(SYS_MSYNC, sys_msync, 2, "msync");
+    syscall_register(SYS_FCACHE_CTL, sys_fcache_ctl, 1, "fcache_ctl");
+    syscall_register(SYS_FCACHE_READ, sys_fcache_read, 5, "fcache_read");
 }
@@ -6,6 +6,7 @@
 #include <ipc/pipe.h>
 #include <sys/syscall.h>
 #include <xnix/errno.h>
+#include <xnix/filemap.h>
 #include <xnix/handle.h>
 #include <xnix/process.h>
 #include <xnix/syscall.h>
@@ -45,11 +46,12 @@ static int32_t sys_pipe_create(const uint32_t *args) {
     return 0;
 }
 
-/* SYS_PIPE_READ: ebx=handle, ecx=buf, edx=size */
+/* SYS_PIPE_READ: ebx=handle, ecx=buf, edx=size, esi=flags */
 static int32_t sys_pipe_read(const uint32_t *args) {
     handle_t handle = (handle_t)args[0];
     void    *ubuf   = (void *)(uintptr_t)args[1];
     uint32_t size   = args[2];
+    uint32_t flags  = args[3];
 
     struct process     *proc = process_current();
     struct handle_entry entry;
@@ -60,18 +62,22 @@ static int32_t sys_pipe_read(const uint32_t *args) {
         return -EBADF;
     }
 
+    /* copy_to_user 不处理缺页, 文件映射页须先调入 */
+    filemap_prefault(proc, (uint32_t)(uintptr_t)ubuf, size, true);
+
     struct ipc_pipe *p = entry.object;
-    int ret = pipe_read(p, ubuf, size);
+    int ret = pipe_read(p, ubuf, size, flags);
 
     handle_object_put(entry.type, entry.object);
     return ret;
 }
 
-/* SYS_PIPE_WRITE: ebx=handle, ecx=buf, edx=size */
+/* SYS_PIPE_WRITE: ebx=handle, ecx=buf, edx=size, esi=flags */
 static int32_t sys_pipe_write(const uint32_t *args) {
     handle_t    handle = (handle_t)args[0];
     const void *ubuf   = (const void *)(uintptr_t)args[1];
     uint32_t    size   = args[2];
+    uint32_t    flags  = args[3];
 
     struct process     *proc = process_current();
     struct handle_entry entry;
@@ -82,8 +88,36 @@ static int32_t sys_pipe_write(const uint32_t *args) {
         return -EBADF;
     }
 
+    filemap_prefault(proc, (uint32_t)(uintptr_t)ubuf, size, false);
+
+    struct ipc_pipe *p = entry.object;
+    int ret = pipe_write(p, ubuf, size, flags);
+
+    handle_object_put(entry.type, entry.object);
+    return ret;
+}
+
+/* SYS_PIPE_SET_SIZE: ebx=handle, ecx=size */
+static int32_t sys_pipe_set_size(const uint32_t *args) {
+    handle_t handle = (handle_t)args[0];
+    uint32_t size   = args[1];
+
+    struct process     *proc = process_current();
+    struct handle_entry entry;
+
+    if (!proc) return -EINVAL;
+
+    /* 读端写端都可以调整, 两端共享同一个 ipc_pipe */
+    if (handle_acquire(proc, handle, HANDLE_NONE, &entry) < 0) {
+        return -EBADF;
+    }
+    if (entry.type != HANDLE_PIPE_READ && entry.type != HANDLE_PIPE_WRITE) {
+        handle_object_put(entry.type, entry.object);
+        return -EBADF;
+    }
+
     struct ipc_pipe *p = entry.object;
-    int ret = pipe_write(p, ubuf, size);
+    int ret = pipe_set_size(p, size);
 
     handle_object_put(entry.type, entry.object);
     return ret;
@@ -91,6 +125,7 @@ static int32_t sys_pipe_write(const uint32_t *args) {
 
 void sys_pipe_init(void) {
     syscall_register(SYS_PIPE_CREATE, sys_pipe_create, 2, "pipe_create");
-    syscall_register(SYS_PIPE_READ, sys_pipe_read, 3, "pipe_read");
-    syscall_register(SYS_PIPE_WRITE, sys_pipe_write, 3, "pipe_write");
+    syscall_register(SYS_PIPE_READ, sys_pipe_read, 4, "pipe_read");
+    syscall_register(SYS_PIPE_WRITE, sys_pipe_write, 4, "pipe_write");
+    syscall_register(SYS_PIPE_SET_SIZE, sys_pipe_set_size, 2, "pipe_set_size");
 }
@@ -11,6 +11,7 @@
 #include <xnix/abi/process.h>
 #include <xnix/boot.h>
 #include <xnix/errno.h>
+#include <xnix/filemap.h>
 #include <xnix/handle.h>
 #include <xnix/mm.h>
 #include <xnix/percpu.h>
@@ -139,6 +140,8 @@ static int32_t sys_exec(const uint32_t *args) {
 
     void *elf_kvirt = PHYS_TO_VIRT((paddr_t)(uintptr_t)elf_paddr);
 
+    /* 镜像可以是文件映射, copy_from_user 不处理缺页, 先调入 */
+    filemap_prefault(proc, kargs->elf_ptr, kargs->elf_size, false);
     ret = copy_from_user(elf_kvirt, (const void *)(uintptr_t)kargs->elf_ptr, kargs->elf_size);
     if (ret < 0) {
         free_pages(elf_paddr, page_count);
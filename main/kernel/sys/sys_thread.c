@@ -317,6 +317,38 @@ static int32_t sys_thread_detach(const uint32_t *args) {
     return 0;
 }
 
+/**
+ * SYS_THREAD_PRIO - 设置/查询线程优先级
+ *
+ * 只能调整本进程的线程, 数值范围 [0, THREAD_PRIO_USER_MAX], 小 = 高优先级.
+ * 返回的是含继承的有效优先级.
+ *
+ * @param args[0] tid 目标线程 TID, 0 表示当前线程
+ * @param args[1] prio 新的自身优先级, -1 表示只查询
+ * @return 有效优先级, 负错误码失败
+ */
+static int32_t sys_thread_prio(const uint32_t *args) {
+    tid_t   tid  = (tid_t)args[0];
+    int32_t prio = (int32_t)args[1];
+
+    struct process *proc   = process_get_current();
+    struct thread  *target = tid == 0 ? sched_current() : thread_find_by_tid(tid);
+    if (!proc || !target) {
+        return -ESRCH;
+    }
+    if (target->owner != proc) {
+        return -EPERM;
+    }
+
+    if (prio != -1) {
+        if (prio < 0 || prio > THREAD_PRIO_USER_MAX) {
+            return -EINVAL;
+        }
+        sched_set_base_priority(target, prio);
+    }
+    return target->priority;
+}
+
 /**
  * 注册线程管理系统调用
  */
@@ -327,4 +359,5 @@ void sys_thread_init(void) {
     syscall_register(SYS_THREAD_SELF, sys_thread_self, 0, "thread_self");
     syscall_register(SYS_THREAD_YIELD, sys_thread_yield, 0, "thread_yield");
     syscall_register(SYS_THREAD_DETACH, sys_thread_detach, 1, "thread_detach");
+    syscall_register(SYS_THREAD_PRIO, sys_thread_prio, 2, "thread_prio");
 }
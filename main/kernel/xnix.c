@@ -200,13 +200,15 @@ static void boot_start_services(void) {
     if (init_pid != PID_INVALID) {
         struct process *init_proc = process_find_by_pid(init_pid);
         if (init_proc) {
-            init_proc->cap_mask = CAP_ALL;
-            init_proc->irq_mask = 0xFFFFFFFF;
             /* ioport_bitmap: init 全端口授权, 子进程继承后可访问 IO 端口 */
-            init_proc->ioport_bitmap = kzalloc(8192);
-            if (init_proc->ioport_bitmap) {
-                memset(init_proc->ioport_bitmap, 0xFF, 8192);
-            }
+            struct ioport_bitmap *all   = ioport_bitmap_create(0xFF);
+            uint32_t              flags = spin_lock_irqsave(&init_proc->cap_lock);
+            struct ioport_bitmap *old   = init_proc->ioport_bitmap;
+            init_proc->cap_mask         = CAP_ALL;
+            init_proc->irq_mask         = 0xFFFFFFFF;
+            init_proc->ioport_bitmap    = all;
+            spin_unlock_irqrestore(&init_proc->cap_lock, flags);
+            ioport_bitmap_put(old);
         }
     }
 
@@ -9,6 +9,7 @@
  *   1. 用 spinlock 保护内部状态(locked,waiters)
  *   2. 获取失败时加入等待队列,然后释放 spinlock 并睡眠
  *   3. 释放时唤醒一个等待者
+ *   4. 优先级继承: 等锁线程把优先级借给持锁者, 释放时按剩余等待者重算
  */
 
 #include <xnix/mm.h>
@@ -40,7 +41,10 @@ void mutex_lock(mutex_t *m) {
     uint32_t flags = spin_lock_irqsave(&m->guard);
 
     while (m->locked) {
-        /* 锁被占用,需要睡眠等待 */
+        /* 锁被占用,把优先级借给持锁者,避免被中间优先级线程饿死 */
+        sched_pi_mutex_wait(m, thread_current());
+
+        /* 需要睡眠等待 */
         spin_unlock_irqrestore(&m->guard, flags);
 
         /* 阻塞当前线程,wait_chan 设为 mutex 地址 */
@@ -53,6 +57,7 @@ void mutex_lock(mutex_t *m) {
     /* 获取锁成功 */
     m->locked = 1;
     m->owner  = thread_current();
+    sched_pi_mutex_acquired(m->owner);
 
     spin_unlock_irqrestore(&m->guard, flags);
 }
@@ -65,6 +70,10 @@ void mutex_unlock(mutex_t *m) {
 
     spin_unlock_irqrestore(&m->guard, flags);
 
+    /* 本锁的等待者不再计入; 仍持有的其他锁的等待者继续借出优先级.
+     * 本锁的等待者重新竞争后会借给新持锁者 */
+    sched_pi_mutex_release(thread_current());
+
     /* 唤醒所有等待此 mutex 的线程 */
     sched_wakeup(m);
 }
@@ -0,0 +1,62 @@
+#!/bin/bash
+# initramfs 启动耗时对比 (未压缩 TAR vs LZ4)
+#
+# 用法: ./scripts/initramfs_bench.sh [RUNS]
+#
+# 分别以 CFG_INITRAMFS_LZ4=OFF/ON 构建 ISO (build/bench_tar, build/bench_lz4),
+# 两者都打开 CFG_INITRAMFS_BENCH 让 init 输出计时,
+# 每种各启动 RUNS 次 (默认 3), 从串口输出中取 init 打印的
+# "[INIT] initramfs timing:" 行, 汇总模块大小和各阶段周期数.
+# 引导器读入模块的耗时不在 init 计时内, 它随 module 字节数变化.
+
+set -e
+
+RUNS=${1:-3}
+PROJECT_ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+BOOT_TIMEOUT=${BOOT_TIMEOUT:-30}
+JOBS=$(nproc 2>/dev/null || echo 4)
+
+# 颜色输出
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+CYAN='\033[0;36m'
+NC='\033[0m'
+
+info() { echo -e "${GREEN}[INFO]${NC} $*"; }
+error() { echo -e "${RED}[ERROR]${NC} $*"; exit 1; }
+section() { echo -e "${CYAN}==>${NC} $*"; }
+
+for cmd in cmake qemu-system-i386 timeout; do
+    command -v $cmd &>/dev/null || error "缺少依赖: $cmd"
+done
+
+# 构建一种配置: $1=名字 $2=ON/OFF
+build_variant() {
+    local dir="$PROJECT_ROOT/build/bench_$1"
+    section "构建 $1 (CFG_INITRAMFS_LZ4=$2)"
+    cmake -S "$PROJECT_ROOT" -B "$dir" -DCFG_INITRAMFS_LZ4="$2" -DCFG_INITRAMFS_BENCH=ON >/dev/null
+    cmake --build "$dir" -j"$JOBS" --target iso >/dev/null
+    info "initramfs.img: $(stat -c %s "$dir/initramfs.img") bytes"
+}
+
+# 启动一次, 输出 timing 行 (去掉前缀)
+boot_once() {
+    local dir="$PROJECT_ROOT/build/bench_$1"
+    local log="$dir/bench_serial.log"
+    rm -f "$log"
+    timeout "$BOOT_TIMEOUT" qemu-system-i386 -cdrom "$dir/xnix.iso" -boot d \
+        -display none -serial file:"$log" -no-reboot -m 512M -smp 2 || true
+    grep -a -m1 "initramfs timing:" "$log" | sed 's/.*initramfs timing: //'
+}
+
+build_variant tar OFF
+build_variant lz4 ON
+
+for variant in tar lz4; do
+    section "启动 $variant x $RUNS"
+    for i in $(seq 1 "$RUNS"); do
+        line=$(boot_once "$variant")
+        [ -n "$line" ] || error "$variant 第 $i 次启动未输出 timing 行 (见 build/bench_$variant/bench_serial.log)"
+        echo "  #$i $line"
+    done
+done
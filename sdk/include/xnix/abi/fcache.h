@@ -0,0 +1,48 @@
+/**
+ * @file abi/fcache.h
+ * @brief 文件页缓存 ABI 定义
+ *
+ * 内核按 (缓存 endpoint, 文件标识, 页号) 缓存文件页, 与文件映射 (abi/mman.h)
+ * 共用同一份缓存. 文件系统服务端读文件时把整页交给内核 (FILL), 打开文件时
+ * 登记客户端会话 (BIND), 客户端之后用 SYS_FCACHE_READ 直接从缓存读,
+ * 命中时不经过服务端. 服务端写文件后把写入的数据交给内核 (UPDATE),
+ * 已缓存的页就地更新, 文件映射也随之看到; 截断等其他改动整份作废 (INVAL).
+ *
+ * 缓存 endpoint 和文件标识与 IO_MAP 回复中的缓页 endpoint/文件标识一致.
+ * 只有持有缓存 endpoint 的 SERVE 权限 (HANDLE_RIGHT_SERVE) 的进程可以操作缓存.
+ * 这个权限只在 endpoint 创建者和 spawn 时交给的子进程手里, 经 IPC 拿到 endpoint 的
+ * 客户端即使能在上面接收, 也不能填入伪造的页.
+ */
+
+#ifndef XNIX_ABI_FCACHE_H
+#define XNIX_ABI_FCACHE_H
+
+#include <xnix/abi/handle.h>
+#include <xnix/abi/stdint.h>
+
+#define ABI_FCACHE_PAGE_SIZE 4096 /* 缓存粒度, FILL 只收整页 */
+
+#define ABI_FCACHE_BIND   1 /* 会话 (ep, session) 的读走 (cache_ep, key) 的缓存 */
+#define ABI_FCACHE_UNBIND 2 /* 会话关闭 */
+#define ABI_FCACHE_FILL   3 /* 填入 [offset, offset + len) 中的整页 (末页可到文件末尾) */
+#define ABI_FCACHE_INVAL  4 /* 文件内容已变, 丢弃缓存 */
+#define ABI_FCACHE_UPDATE 5 /* [offset, offset + len) 已写为 buf 中的数据, 缓存页就地更新 */
+
+/**
+ * SYS_FCACHE_CTL 参数
+ */
+struct abi_fcache_args {
+    uint32_t op;        /* ABI_FCACHE_* */
+    handle_t cache_ep;  /* 缓存所属 endpoint (服务端持有接收权) */
+    uint32_t key;       /* 文件标识 */
+    handle_t ep;        /* BIND/UNBIND: 客户端发请求用的 endpoint */
+    uint32_t session;   /* BIND/UNBIND: 客户端会话 */
+    uint32_t version;   /* BIND: 会话只读这个版本的缓存; FILL: 与已有缓存不同时旧缓存作废;
+                           UPDATE: 写入后的版本 */
+    uint32_t file_size; /* FILL/UPDATE: 当前文件大小 */
+    uint32_t offset;    /* FILL/UPDATE: 数据在文件内的偏移 */
+    uint32_t len;       /* FILL/UPDATE: 数据长度 */
+    uint32_t buf;       /* FILL/UPDATE: 数据地址 */
+};
+
+#endif /* XNIX_ABI_FCACHE_H */
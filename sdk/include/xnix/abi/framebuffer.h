@@ -37,7 +37,7 @@ struct abi_fb_info {
 /**
  * 用户空间共享内存映射基地址
  *
- * SHM 区域从 0x50000000 开始,每次映射线性推进.
+ * SHM 区域从 0x50000000 开始,每次映射取最低的一段空闲地址, munmap 释放的地址可以复用.
  */
 #define ABI_SHM_MAP_BASE 0x50000000
 
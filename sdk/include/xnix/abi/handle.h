@@ -29,13 +29,15 @@ typedef uint32_t handle_t;
  *
  * 每个 handle 携带 rights 位图,控制该 handle 能执行的操作.
  * 传递 handle 时 rights 只能缩小(取交集),不能增加.
+ * SERVE 不随 IPC 或 grant 转移, 只在创建者和 spawn 时交给的子进程手里.
  */
 #define HANDLE_RIGHT_READ      0x01 /* 可读/可接收 */
 #define HANDLE_RIGHT_WRITE     0x02 /* 可写/可发送 */
 #define HANDLE_RIGHT_EXECUTE   0x04 /* 可执行(预留) */
 #define HANDLE_RIGHT_TRANSFER  0x08 /* 可转移给其他进程 */
 #define HANDLE_RIGHT_DUPLICATE 0x10 /* 可复制 */
-#define HANDLE_RIGHT_ALL       0x1F /* 全部权限 */
+#define HANDLE_RIGHT_SERVE     0x20 /* endpoint: 以服务端身份操作内核页缓存 */
+#define HANDLE_RIGHT_ALL       0x3F /* 全部权限 */
 
 /**
  * @brief Handle 对象类型枚举
@@ -29,6 +29,9 @@
  *   请求: data[0]=IO_WRITE, data[1]=session, data[2]=offset, data[3]=size
  *          buffer = 写入数据
  *   回复: data[0]=bytes_written (<0=errno)
+ *
+ * IOV 发出的数据会被截断到服务端接收缓冲区的大小, 服务端最多写
+ * min(size, 实际收到的字节数) 并回复这个数, 调用者据此看到短写.
  */
 #define IO_WRITE 0x101
 
@@ -47,4 +50,69 @@
  */
 #define IO_IOCTL 0x103
 
+/*
+ * IO_SPLICE_OUT: 文件 -> 管道, 数据由服务端直接写入管道, 不经过调用者地址空间
+ *   请求: data[0]=IO_SPLICE_OUT, data[1]=session, data[2]=offset, data[3]=max_size
+ *          handles[0] = 管道写端
+ *   回复: data[0]=搬运字节数 (0=EOF, -EAGAIN=管道已满, <0=errno)
+ *
+ * IO_SPLICE_IN: 管道 -> 文件, 服务端从管道读出后直接写入文件
+ *   请求: data[0]=IO_SPLICE_IN, data[1]=session, data[2]=offset, data[3]=max_size
+ *          handles[0] = 管道读端
+ *   回复: data[0]=搬运字节数 (0=管道 EOF, -EAGAIN=管道为空, <0=errno)
+ *
+ * 服务端以 ABI_PIPE_NONBLOCK 访问管道, 用完后关闭收到的 handle.
+ * 不支持的服务端回复 -ENOSYS, 客户端退回普通 read/write.
+ */
+#define IO_SPLICE_OUT 0x104
+#define IO_SPLICE_IN  0x105
+
+/*
+ * 共享内存窗口: 客户端把一块 SHM 借给服务端, 大块数据经窗口搬运, IPC 只带完成结果
+ *
+ * IO_WIN_ATTACH: 把窗口绑定到会话, 会话关闭时服务端解除映射
+ *   请求: data[0]=IO_WIN_ATTACH, data[1]=session, data[2]=窗口大小
+ *          handles[0] = SHM handle
+ *   回复: data[0]=0 或负 errno
+ *
+ * IO_WIN_READ: 服务端把数据直接读进窗口起始处
+ *   请求: data[0]=IO_WIN_READ, data[1]=session, data[2]=offset, data[3]=max_size
+ *   回复: data[0]=bytes_read (0=EOF, <0=errno)
+ *
+ * IO_WIN_WRITE: 服务端从窗口起始处取数据写入
+ *   请求: data[0]=IO_WIN_WRITE, data[1]=session, data[2]=offset, data[3]=size
+ *   回复: data[0]=bytes_written (<0=errno)
+ *
+ * 会话未绑定窗口时 IO_WIN_READ/IO_WIN_WRITE 回复 -ENOENT, 客户端随后 ATTACH 再重试;
+ * 不支持的服务端回复 -ENOSYS, 客户端退回 IO_READ/IO_WRITE.
+ */
+#define IO_WIN_ATTACH 0x106
+#define IO_WIN_READ   0x107
+#define IO_WIN_WRITE  0x108
+
+/*
+ * 文件映射缓页: 以下请求只由内核发出 (消息带 ABI_IPC_FLAG_KERNEL), 服务端拒绝其他来源
+ *
+ * IO_MAP: 为已打开的文件建立缓页会话, 供内核之后按页读写
+ *   请求: data[0]=IO_MAP, data[1]=session
+ *   回复: data[0]=0 或负 errno, data[1]=缓页 session, data[2]=文件标识 (服务端内唯一),
+ *         data[3]=文件大小, data[4]=内容版本 (IO_WRITE 等修改后变化, 缓页写回不变)
+ *          handles[0] = 接收缓页请求的 endpoint (可选, 缺省为收到 IO_MAP 的 endpoint)
+ *
+ * IO_PAGE_IN: 读一页
+ *   请求: data[0]=IO_PAGE_IN, data[1]=缓页 session, data[2]=offset (页对齐), data[3]=size
+ *          reply.buffer = 页缓冲区
+ *   回复: data[0]=bytes_read (<0=errno), buffer=数据, 不足一页的部分内核补零
+ *
+ * IO_PAGE_OUT: 写回一页, 不改变文件大小
+ *   请求: data[0]=IO_PAGE_OUT, data[1]=缓页 session, data[2]=offset, data[3]=size
+ *          buffer = 页数据
+ *   回复: data[0]=bytes_written (<0=errno)
+ *
+ * 缓页会话由内核在缓存页淘汰后用 IO_CLOSE 关闭. 不支持的服务端回复 -ENOSYS.
+ */
+#define IO_MAP      0x109
+#define IO_PAGE_IN  0x10A
+#define IO_PAGE_OUT 0x10B
+
 #endif /* XNIX_ABI_IO_H */
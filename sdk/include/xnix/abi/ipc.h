@@ -38,6 +38,20 @@ struct abi_ipc_msg_buffer {
     uint32_t _pad;
 };
 
+/**
+ * 分散/聚集段(ABI_IPC_FLAG_IOV)
+ *
+ * 与 abi_ipc_msg_buffer 布局相同, 一个段描述一块用户空间内存.
+ */
+struct abi_ipc_iovec {
+    uint64_t data;
+    uint32_t size;
+    uint32_t _pad;
+};
+
+/** 单条消息最多段数 */
+#define ABI_IPC_IOV_MAX 8
+
 /** 消息句柄传递 */
 struct abi_ipc_msg_handles {
     handle_t handles[ABI_IPC_MSG_HANDLES_MAX];
@@ -58,6 +72,20 @@ struct abi_ipc_message {
 #define ABI_IPC_FLAG_NONBLOCK (1 << 0) /* 非阻塞 */
 #define ABI_IPC_FLAG_TIMEOUT  (1 << 1) /* 使用超时 */
 #define ABI_IPC_FLAG_NOREPLY  (1 << 2) /* 单向消息: 接收端无需 reply */
+#define ABI_IPC_FLAG_IOV      (1 << 3) /* buffer 指向 abi_ipc_iovec 数组 */
+#define ABI_IPC_FLAG_KERNEL   (1 << 4) /* 内核代进程发出(文件映射取页等), 用户态设置无效 */
+
+/*
+ * 分散/聚集消息 (ABI_IPC_FLAG_IOV)
+ *
+ * 置位时 buffer.data 指向 abi_ipc_iovec 数组, buffer.size 为段数(<= ABI_IPC_IOV_MAX).
+ * 发送方的段按顺序拼接, 内核在会合时直接从发送方地址空间拷到接收方预置的段中,
+ * 不经过内核中转缓冲区, 因此不受 CFG_IPC_MAX_BUF 限制, 上限是接收方预置段的总长.
+ * 发送方数据超出部分被截断.
+ *
+ * 接收完成后 buffer.data 仍指向接收方的 iovec 数组, buffer.size 改为实际收到的字节数.
+ * 任意一端都可以单独使用 IOV, 另一端用普通 buffer(此时受 CFG_IPC_MAX_BUF 限制).
+ */
 
 /*
  * IPC 错误码
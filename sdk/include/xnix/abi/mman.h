@@ -0,0 +1,37 @@
+/**
+ * @file abi/mman.h
+ * @brief 文件映射 ABI 定义
+ *
+ * 文件页由内核缓存, 缺页时内核向文件所在服务端发 IO_PAGE_IN 取页
+ * (见 abi/io.h), 同一文件的各个映射共享缓存页.
+ */
+
+#ifndef XNIX_ABI_MMAN_H
+#define XNIX_ABI_MMAN_H
+
+#include <xnix/abi/handle.h>
+#include <xnix/abi/stdint.h>
+
+#define ABI_PROT_READ  0x01
+#define ABI_PROT_WRITE 0x02
+
+#define ABI_MAP_SHARED  0x01 /* 写入落到缓存页, msync/munmap 时写回文件 */
+#define ABI_MAP_PRIVATE 0x02 /* 写时复制, 修改不写回 */
+
+/**
+ * SYS_MMAP_FILE 参数
+ *
+ * handle/session 即 fd 表中的 IPC endpoint 和服务端会话,
+ * 内核用它们向服务端申请一个只供内核取页的缓页会话.
+ */
+struct abi_mmap_file_args {
+    handle_t handle;  /* in: 文件所在服务端的 endpoint */
+    uint32_t session; /* in: 已打开文件的会话 */
+    uint32_t offset;  /* in: 文件内偏移(页对齐) */
+    uint32_t size;    /* in: 映射大小 */
+    uint32_t prot;    /* in: ABI_PROT_* (必须可读) */
+    uint32_t flags;   /* in: ABI_MAP_SHARED 或 ABI_MAP_PRIVATE */
+    uint32_t addr;    /* out: 映射起始地址 */
+};
+
+#endif /* XNIX_ABI_MMAN_H */
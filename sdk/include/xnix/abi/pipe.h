@@ -0,0 +1,17 @@
+/**
+ * @file abi/pipe.h
+ * @brief 管道 ABI 定义
+ */
+
+#ifndef XNIX_ABI_PIPE_H
+#define XNIX_ABI_PIPE_H
+
+/*
+ * SYS_PIPE_READ / SYS_PIPE_WRITE 的 flags 参数
+ *
+ * ABI_PIPE_NONBLOCK: 缓冲区空(读)或满(写)时立即返回 -EAGAIN, 不阻塞.
+ * 服务端代替客户端搬运管道数据(IO_SPLICE_*)时必须使用, 避免被慢速对端卡住.
+ */
+#define ABI_PIPE_NONBLOCK (1u << 0)
+
+#endif /* XNIX_ABI_PIPE_H */
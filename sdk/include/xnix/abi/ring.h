@@ -0,0 +1,65 @@
+/**
+ * @file abi/ring.h
+ * @brief 共享内存环形通道 ABI 定义
+ *
+ * 一个 ring 通道由一块 SHM 区域和两个 event 组成:
+ *   - SHM 头部之后依次是提交环(SQ)和完成环(CQ)的槽数组
+ *   - sq_event: 提交门铃, 服务端等待
+ *   - cq_event: 完成门铃, 客户端等待
+ *
+ * head 只由消费者推进, tail 只由生产者推进, 两端无锁读写.
+ * 只有队列在"空 <-> 非空"或"满 -> 非满"之间切换时才需要敲门铃,
+ * 稳态下批量收发不进内核.
+ */
+
+#ifndef XNIX_ABI_RING_H
+#define XNIX_ABI_RING_H
+
+#include <xnix/abi/handle.h>
+#include <xnix/abi/stdint.h>
+
+#define ABI_RING_MAGIC       0x474E4952 /* "RING" */
+#define ABI_RING_ENTRIES_MAX 4096       /* 单个环最多槽数(2 的幂) */
+#define ABI_RING_ENTRY_MAX   256        /* 单槽最大字节数(4 字节对齐) */
+#define ABI_RING_HDR_SIZE    256        /* 头部大小, 槽数组从此偏移开始 */
+
+/**
+ * 单向队列控制块
+ *
+ * head/tail 是自由增长的计数器, 下标 = 计数 & mask.
+ * 独占一个 cache line, 避免生产者/消费者互相踩缓存.
+ */
+struct abi_ring_queue {
+    volatile uint32_t head;   /* 消费者推进 */
+    volatile uint32_t tail;   /* 生产者推进 */
+    uint32_t          offset; /* 槽数组在 SHM 中的偏移 */
+    uint32_t          _pad[13];
+};
+
+/** SHM 起始处的通道头 */
+struct abi_ring_header {
+    uint32_t              magic;
+    uint32_t              entry_size; /* 单槽字节数 */
+    uint32_t              entries;    /* 每个环的槽数 */
+    uint32_t              mask;       /* entries - 1 */
+    uint32_t              _pad[12];
+    struct abi_ring_queue sq; /* 客户端 -> 服务端 */
+    struct abi_ring_queue cq; /* 服务端 -> 客户端 */
+};
+
+/**
+ * SYS_RING_CREATE 参数
+ *
+ * 成功后调用者持有三个 handle, 把它们通过 IPC 或 grant 交给对端,
+ * 对端 mmap 同一块 SHM 即可收发.
+ */
+struct abi_ring_create_args {
+    uint32_t entries;    /* in: 每个环的槽数(2 的幂) */
+    uint32_t entry_size; /* in: 单槽字节数 */
+    handle_t shm;        /* out: SHM handle */
+    handle_t sq_event;   /* out: 提交门铃 */
+    handle_t cq_event;   /* out: 完成门铃 */
+    uint32_t size;       /* out: SHM 总大小 */
+};
+
+#endif /* XNIX_ABI_RING_H */
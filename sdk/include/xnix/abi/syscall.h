@@ -26,11 +26,14 @@
 #define SYS_IPC_REPLY       104 /* RPC 回复: ecx=msg* */
 #define SYS_IPC_REPLY_TO    105 /* 延迟回复: ebx=sender_tid, ecx=msg* */
 #define SYS_IPC_WAIT_ANY    106 /* 等待多个对象: ebx=wait_set*, ecx=timeout_ms */
+#define SYS_RING_CREATE     107 /* 创建共享内存环形通道: ebx=abi_ring_create_args* */
+#define SYS_IPC_REPLY_ADOPT 108 /* 接管延迟回复(优先级捐赠随之转移): ebx=sender_tid */
 
 /* Pipe (110-119) — 字节流通道 */
 #define SYS_PIPE_CREATE     110 /* 创建管道: ebx=read_h*, ecx=write_h* */
-#define SYS_PIPE_READ       111 /* 读管道: ebx=handle, ecx=buf, edx=size */
-#define SYS_PIPE_WRITE      112 /* 写管道: ebx=handle, ecx=buf, edx=size */
+#define SYS_PIPE_READ       111 /* 读管道: ebx=handle, ecx=buf, edx=size, esi=flags */
+#define SYS_PIPE_WRITE      112 /* 写管道: ebx=handle, ecx=buf, edx=size, esi=flags */
+#define SYS_PIPE_SET_SIZE   113 /* 调整管道容量: ebx=handle(任一端), ecx=size(0=查询) */
 
 /* 内存管理 (200-219) */
 #define SYS_SBRK 200 /* 堆管理: ebx=increment, 返回旧堆顶或 -1 */
@@ -39,6 +42,13 @@
 #define SYS_MUNMAP       202 /* 取消映射: ebx=addr, ecx=size */
 #define SYS_PHYSMEM_INFO 203 /* 查询物理内存信息: ebx=handle, ecx=info_ptr */
 #define SYS_SHM_CREATE   204 /* 创建匿名共享内存: ebx=size, 返回 handle */
+#define SYS_DMA_CREATE   205 /* 创建物理连续 DMA 缓冲区: ebx=size, 返回 handle */
+#define SYS_MMIO_CREATE  206 /* 包装设备 MMIO 区域: ebx=phys, ecx=size, 返回 handle */
+#define SYS_MMAP_FILE    207 /* 映射文件: ebx=abi_mmap_file_args*, 返回 0 或负 errno */
+#define SYS_MSYNC        208 /* 写回文件映射: ebx=addr, ecx=size */
+#define SYS_FCACHE_CTL   209 /* 文件页缓存控制 (服务端): ebx=abi_fcache_args* */
+#define SYS_FCACHE_READ \
+    210 /* 从文件页缓存读: ebx=handle, ecx=session, edx=offset, esi=buf, edi=size */
 
 /* 任务/线程 (300-319) */
 #define SYS_THREAD_CREATE 301 /* 创建用户线程: ebx=entry, ecx=arg, edx=stack_top */
@@ -48,6 +58,7 @@
 #define SYS_EXIT          305 /* 退出进程: ebx=exit_code */
 #define SYS_THREAD_SELF   306 /* 获取当前 tid */
 #define SYS_THREAD_DETACH 307 /* 分离线程: ebx=tid */
+#define SYS_THREAD_PRIO   308 /* 设置/查询优先级: ebx=tid(0=自身), ecx=prio(-1=查询), 返回有效优先级 */
 
 /* Handle 管理 (400-419) */
 #define SYS_HANDLE_FIND      400 /* 查找命名 handle: ebx=name, 返回 handle 或 -1 */
@@ -57,20 +68,28 @@
 #define SYS_HANDLE_LIST      404 /* 列出 handle: ebx=buf, ecx=max_count, 返回条目数 */
 
 /* 能力 (420-439) */
-#define SYS_CAP_CHECK  420 /* 检查能力: ebx=cap_bit */
-#define SYS_CAP_GRANT  422 /* 委托能力: ebx=pid, ecx=cap_bits */
-#define SYS_CAP_REVOKE 423 /* 撤销能力: ebx=pid, ecx=cap_bits */
-#define SYS_CAP_QUERY  424 /* 查询能力: 返回当前进程 cap_mask */
+#define SYS_CAP_CHECK    420 /* 检查能力: ebx=cap_bit */
+#define SYS_CAP_GRANT    422 /* 委托能力: ebx=pid, ecx=cap_bits */
+#define SYS_CAP_REVOKE   423 /* 撤销能力: ebx=pid, ecx=cap_bits */
+#define SYS_CAP_QUERY    424 /* 查询能力: 返回当前进程 cap_mask */
+#define SYS_IOPORT_GRANT 425 /* 授予端口区间: ebx=pid, ecx=start, edx=end */
+#define SYS_IRQ_GRANT    426 /* 授予 IRQ: ebx=pid, ecx=irq */
 
 /* 硬件访问 (500-519) - 基于能力位 */
-#define SYS_IOPORT_OUTB 500 /* 写端口 8位: ebx=port, ecx=val (需 CAP_IO_PORT) */
-#define SYS_IOPORT_INB  501 /* 读端口 8位: ebx=port */
-#define SYS_IOPORT_OUTW 502 /* 写端口 16位: ebx=port, ecx=val */
-#define SYS_IOPORT_INW  503 /* 读端口 16位: ebx=port */
-#define SYS_IRQ_BIND    504 /* 绑定 IRQ: ebx=irq, ecx=notif_handle (需 CAP_IRQ) */
-#define SYS_IRQ_UNBIND  505 /* 解绑 IRQ: ebx=irq */
-#define SYS_IRQ_WAIT    506 /* 等待 IRQ: ebx=notif_handle */
-#define SYS_IRQ_READ    507 /* 读取 IRQ 数据: ebx=irq, ecx=buf, edx=size, esi=flags */
+#define SYS_IOPORT_OUTB  500 /* 写端口 8位: ebx=port, ecx=val (需 CAP_IO_PORT) */
+#define SYS_IOPORT_INB   501 /* 读端口 8位: ebx=port */
+#define SYS_IOPORT_OUTW  502 /* 写端口 16位: ebx=port, ecx=val */
+#define SYS_IOPORT_INW   503 /* 读端口 16位: ebx=port */
+#define SYS_IRQ_BIND     504 /* 绑定 IRQ: ebx=irq, ecx=notif_handle (需 CAP_IRQ) */
+#define SYS_IRQ_UNBIND   505 /* 解绑 IRQ: ebx=irq */
+#define SYS_IRQ_WAIT     506 /* 等待 IRQ: ebx=notif_handle */
+#define SYS_IRQ_READ     507 /* 读取 IRQ 数据: ebx=irq, ecx=buf, edx=size, esi=flags */
+#define SYS_IOPORT_INSB  508 /* 连续读端口 8位: ebx=port, ecx=buf, edx=count */
+#define SYS_IOPORT_OUTSB 509 /* 连续写端口 8位: ebx=port, ecx=buf, edx=count */
+#define SYS_IOPORT_INSW  510 /* 连续读端口 16位: ebx=port, ecx=buf, edx=count(字数) */
+#define SYS_IOPORT_OUTSW 511 /* 连续写端口 16位: ebx=port, ecx=buf, edx=count(字数) */
+#define SYS_IRQ_ROUTE    512 /* 解析 PCI 中断: ebx=bus, ecx=dev, edx=pin, esi=legacy, 返回 irq */
+#define SYS_IRQ_ACK      513 /* 重新使能电平触发 IRQ: ebx=irq */
 
 /* 进程管理 (600-619) */
 #define SYS_GETPID         600 /* 获取当前进程 PID */
@@ -4,6 +4,10 @@
  *
  * 提供内联包装器用于 I/O 端口访问系统调用.
  * 基于权限检查,无需 handle.
+ *
+ * 拥有 CAP_IO_PORT 的进程, 内核在切换到它时会把端口表载入 TSS 的
+ * I/O 权限位图, 因此也可以用 ioport_native_* 直接执行 in/out 指令.
+ * 越权的直接访问会触发 #GP, 驱动应先用系统调用版本探测一次权限.
  */
 
 #ifndef XNIX_DRIVER_IOPORT_H
@@ -66,4 +70,48 @@ static inline int ioport_inw(uint16_t port) {
     return ret;
 }
 
+/*
+ * 直接端口访问 (不进内核)
+ */
+
+static inline void ioport_native_outb(uint16_t port, uint8_t val) {
+    asm volatile("outb %0, %1" : : "a"(val), "Nd"(port));
+}
+
+static inline uint8_t ioport_native_inb(uint16_t port) {
+    uint8_t val;
+    asm volatile("inb %1, %0" : "=a"(val) : "Nd"(port));
+    return val;
+}
+
+static inline void ioport_native_outw(uint16_t port, uint16_t val) {
+    asm volatile("outw %0, %1" : : "a"(val), "Nd"(port));
+}
+
+static inline uint16_t ioport_native_inw(uint16_t port) {
+    uint16_t val;
+    asm volatile("inw %1, %0" : "=a"(val) : "Nd"(port));
+    return val;
+}
+
+static inline void ioport_native_outl(uint16_t port, uint32_t val) {
+    asm volatile("outl %0, %1" : : "a"(val), "Nd"(port));
+}
+
+static inline uint32_t ioport_native_inl(uint16_t port) {
+    uint32_t val;
+    asm volatile("inl %1, %0" : "=a"(val) : "Nd"(port));
+    return val;
+}
+
+/** 从端口连续读取 count 个 16 位字 (rep insw) */
+static inline void ioport_native_insw(uint16_t port, void *buf, uint32_t count) {
+    asm volatile("cld; rep insw" : "+D"(buf), "+c"(count) : "d"(port) : "memory");
+}
+
+/** 向端口连续写入 count 个 16 位字 (rep outsw) */
+static inline void ioport_native_outsw(uint16_t port, const void *buf, uint32_t count) {
+    asm volatile("cld; rep outsw" : "+S"(buf), "+c"(count) : "d"(port) : "memory");
+}
+
 #endif /* XNIX_DRIVER_IOPORT_H */
@@ -60,6 +60,23 @@
  */
 #define UDM_BLK_INFO  102
 
+/**
+ * BLK_STATS - 获取块缓存统计
+ *
+ * Request:
+ *   regs[0] = UDM_BLK_STATS
+ *
+ * Reply:
+ *   regs[1] = 0 (成功) 或错误码 (设备无缓存时为 -ENOSYS)
+ *   regs[2] = 命中块次数
+ *   regs[3] = 未命中块次数
+ *   regs[4] = 预读块数
+ *   regs[5] = 写回块数
+ *   regs[6] = 当前缓存块数
+ *   regs[7] = 当前脏块数
+ */
+#define UDM_BLK_STATS 103
+
 /* ============== devfs 注册协议 (devfsd 端处理) ============== */
 
 /**
@@ -32,4 +32,22 @@
  */
 #define UDM_DEVFS_REGISTER_TTY 201
 
+/**
+ * DEVFS_REGISTER_DEV - 向 devfsd 注册由服务端处理 IO 的通用设备节点
+ *
+ * 打开节点时 devfsd 返回注册的 endpoint, 并把 minor 作为 session,
+ * 之后的 IO_READ/IO_WRITE/IO_CLOSE 直接发给服务端, data[1] 即 minor.
+ * 用于 pcid 发布 /dev/pciBB:DD.F 这类一个服务多个节点的场景.
+ *
+ * Request:
+ *   regs[0] = UDM_DEVFS_REGISTER_DEV
+ *   regs[1] = minor
+ *   handles[0] = 服务 endpoint handle
+ *   buffer  = 设备名 (不含 \0 终止)
+ *
+ * Reply:
+ *   regs[1] = 0 (成功) 或错误码
+ */
+#define UDM_DEVFS_REGISTER_DEV 202
+
 #endif /* XNIX_PROTOCOL_DEVFS_H */
@@ -0,0 +1,138 @@
+/**
+ * @file xnix/protocol/pci.h
+ * @brief PCI 总线服务 (pcid) IPC 协议
+ *
+ * pcid 在启动时枚举配置空间, 把每个功能以 /dev/pciBB:DD.F 发布到 devfs
+ * (读取得到文本描述), 并通过本协议把设备资源分配给驱动:
+ *   - 内存 BAR 包装成 physmem handle, 驱动直接 sys_mmap_phys
+ *   - IO BAR 端口区间和解析后的 IRQ 授予驱动进程
+ *
+ * pcid 有两个 endpoint: pci_ep 由 sys.conf 交给驱动服务, 支持全部操作;
+ * /dev/pci* 背后的 endpoint 任何打开者都能拿到, 只支持 FIND 和 CFG_READ,
+ * 其余操作返回 -EPERM.
+ *
+ * Opcode 范围 300-399.
+ */
+
+#ifndef XNIX_PROTOCOL_PCI_H
+#define XNIX_PROTOCOL_PCI_H
+
+#include <stdint.h>
+
+#define PCI_BAR_COUNT 6
+#define PCI_ANY_ID    0xFFFF
+
+/* bar_flags */
+#define PCI_BAR_IO       0x01 /* IO 端口 BAR, 否则为内存 BAR */
+#define PCI_BAR_PREFETCH 0x02 /* 可预取 */
+#define PCI_BAR_MEM64    0x04 /* 64 位 BAR (占用下一个 BAR 槽) */
+
+/* 配置空间寄存器 */
+#define PCI_CFG_VENDOR  0x00
+#define PCI_CFG_COMMAND 0x04
+#define PCI_CFG_CLASS   0x08
+#define PCI_CFG_HEADER  0x0C
+#define PCI_CFG_BAR0    0x10
+#define PCI_CFG_SUBSYS  0x2C
+#define PCI_CFG_CAP_PTR 0x34
+#define PCI_CFG_IRQ     0x3C
+
+#define PCI_CMD_IO           0x0001
+#define PCI_CMD_MEM          0x0002
+#define PCI_CMD_BUSMASTER    0x0004
+#define PCI_CMD_INTX_DISABLE 0x0400
+
+/**
+ * 设备描述 (FIND/CLAIM 回复的 buffer)
+ */
+struct pci_dev_info {
+    uint8_t  bus;
+    uint8_t  dev;
+    uint8_t  fn;
+    uint8_t  irq_pin;  /* 0=无, 1=INTA# ... 4=INTD# */
+    uint16_t vendor;
+    uint16_t device;
+    uint8_t  class_code;
+    uint8_t  subclass;
+    uint8_t  prog_if;
+    uint8_t  revision;
+    uint16_t subsys_vendor;
+    uint16_t subsys_id;
+    uint8_t  irq_line; /* BIOS 分配的 legacy IRQ (0xFF=未分配) */
+    uint8_t  bar_flags[PCI_BAR_COUNT];
+    uint8_t  _pad;
+    uint32_t bar_base[PCI_BAR_COUNT]; /* 物理地址或端口号 */
+    uint32_t bar_size[PCI_BAR_COUNT]; /* 0 表示该 BAR 未实现 */
+};
+
+/**
+ * PCI_FIND - 按 ID 或类别查找设备
+ *
+ * Request:
+ *   regs[0] = UDM_PCI_FIND
+ *   regs[1] = vendor | (device << 16)  (PCI_ANY_ID 通配)
+ *   regs[2] = (class << 8) | subclass  (PCI_ANY_ID 通配)
+ *   regs[3] = 起始序号 (从该序号开始查找, 用于遍历)
+ *
+ * Reply:
+ *   regs[1] = 设备序号 (>=0) 或 -ENOENT
+ *   buffer  = struct pci_dev_info
+ */
+#define UDM_PCI_FIND 300
+
+/**
+ * PCI_CLAIM - 独占设备并取得资源
+ *
+ * 打开 IO/内存解码和总线主控, 把 IO BAR 端口和 IRQ 授予调用进程.
+ * 同一进程可重复 claim, 其他进程 claim 已被占用的设备返回 -EBUSY.
+ * 调用进程退出时设备自动释放 (同 PCI_RELEASE).
+ *
+ * Request:
+ *   regs[0] = UDM_PCI_CLAIM
+ *   regs[1] = 设备序号
+ *
+ * Reply:
+ *   regs[1] = 0 或错误码
+ *   regs[2] = IRQ 号 (无中断时为 -1)
+ *   regs[3] = 内存 BAR 位图: bit N 置位表示 handles 中按序带有 BAR N 的 physmem handle
+ *   handles = 内存 BAR 的 physmem handle (最多 4 个)
+ *   buffer  = struct pci_dev_info
+ */
+#define UDM_PCI_CLAIM 301
+
+/**
+ * PCI_CFG_READ / PCI_CFG_WRITE - 访问配置空间
+ *
+ * 读不限制调用者, 写只允许 claim 了设备的进程.
+ *
+ * Request:
+ *   regs[0] = UDM_PCI_CFG_READ / UDM_PCI_CFG_WRITE
+ *   regs[1] = 设备序号
+ *   regs[2] = 寄存器偏移 (按宽度对齐, < 256)
+ *   regs[3] = 宽度 (1/2/4)
+ *   regs[4] = 写入值 (仅 WRITE)
+ *
+ * Reply:
+ *   regs[1] = 0 或错误码
+ *   regs[2] = 读出值 (仅 READ)
+ */
+#define UDM_PCI_CFG_READ  302
+#define UDM_PCI_CFG_WRITE 303
+
+/**
+ * PCI_RELEASE - 放弃设备
+ *
+ * 关闭设备的 IO/内存解码和总线主控, 设备可被其他进程 claim.
+ * 兼容模式 IDE 和显示设备只关总线主控, 它们的固定端口还有别的使用者.
+ * 只有属主可以 release, 否则返回 -EPERM.
+ *
+ * Request:
+ *   regs[0] = UDM_PCI_RELEASE
+ *   regs[1] = 设备序号
+ *
+ * Reply:
+ *   regs[1] = 0 或错误码
+ */
+#define UDM_PCI_RELEASE 304
+
+#endif /* XNIX_PROTOCOL_PCI_H */
@@ -29,6 +29,10 @@
 #define UDM_VFS_CHDIR    14 /* 改变当前工作目录 */
 #define UDM_VFS_GETCWD   15 /* 获取当前工作目录 */
 #define UDM_VFS_COPY_CWD 16 /* 复制CWD到子进程 */
+#define UDM_VFS_WATCH    17 /* vfsd -> FS: 登记变化通知 (handles[0]=event, data[1]=bits) */
+#define UDM_VFS_READFILE 18 /* 一次读出小文件 */
+#define UDM_VFS_STATV    19 /* 一次查询多个路径 */
+#define UDM_VFS_COPY     20 /* 服务端复制文件 */
 
 /* Helper macros for message parsing */
 #define UDM_MSG_OPCODE(msg) ((msg)->regs.data[0])
@@ -46,6 +50,7 @@
 #define VFS_O_TRUNC  0x0200
 #define VFS_O_APPEND 0x0400
 #define VFS_O_EXCL   0x0800
+#define VFS_O_STAT   0x1000 /* OPEN 回复附带文件信息: data[2]=size, data[3]=type */
 
 /* File types */
 #define VFS_TYPE_FILE 1
@@ -66,7 +71,70 @@ struct vfs_dirent {
     uint32_t size;
 };
 
+/*
+ * UDM_VFS_READFILE: read the head of a file in one round trip (no open/close).
+ * Client -> vfsd: data[1] = pid, data[2] = max bytes, buffer = path.
+ * vfsd -> FS:     data[1] = max bytes, buffer = relative path.
+ * Reply buffer holds the data, data[0] = bytes read or negative errno,
+ * data[2] = file size, data[3] = type. max is capped at VFS_READFILE_MAX.
+ */
+#define VFS_READFILE_MAX 4096
+
+/*
+ * UDM_VFS_STATV: stat several paths in one round trip (client -> vfsd only).
+ * data[1] = pid, data[2] = count, buffer = count NUL-terminated paths back to back.
+ * Reply buffer holds count struct vfs_stat_rec, data[0] = count or negative errno.
+ */
+#define VFS_STATV_MAX 16
+
+struct vfs_stat_rec {
+    int32_t  result; /* 0 or negative errno */
+    uint32_t type;
+    uint32_t size;
+};
+
+/*
+ * UDM_VFS_COPY: copy a regular file without moving the data through the client.
+ * Client -> vfsd: data[1] = pid, data[2] = src length, buffer = src path, NUL, dst path.
+ * vfsd -> FS:     data[1] = src length, buffer = relative src, NUL, relative dst
+ *                 (only when both paths are on the same backend).
+ * The destination is created or truncated. Reply data[0] = bytes copied or negative errno.
+ */
+
 /* Directory object ioctl commands (after-open object control plane) */
 #define VFS_IOCTL_READDIR 1
 
+/*
+ * File object ioctl: preallocate contiguous space, data[3] = expected final size.
+ * A contiguous free run is reserved in memory for later extending writes (reply 1).
+ * Nothing is written to disk: the file size is always what has been written and a
+ * crash leaves no orphaned clusters. The unused part is released at close.
+ * Reply 0 when no run that long is free.
+ */
+#define VFS_IOCTL_PREALLOC 2
+
+/*
+ * Directory object ioctl: batched read (getdents).
+ * data[3] = cookie to start from (0 = beginning), data[4] = reply buffer capacity.
+ * The reply buffer holds packed struct vfs_dirent_rec records, data[0] = record
+ * count (0 = end of directory), data[1] = cookie to continue from.
+ */
+#define VFS_IOCTL_GETDENTS 3
+
+/* File object ioctl: current file size, reply data[0] = 0 or negative errno, data[1] = size. */
+#define VFS_IOCTL_GETSIZE 4
+
+/* Packed directory record, reclen is 4-byte aligned */
+struct vfs_dirent_rec {
+    uint16_t reclen;
+    uint8_t  type;
+    uint8_t  namelen;
+    uint32_t size;
+    char     name[]; /* NUL terminated */
+};
+
+#define VFS_DIRENT_REC_LEN(namelen) \
+    ((uint32_t)(sizeof(struct vfs_dirent_rec) + (namelen) + 1 + 3) & ~3u)
+#define VFS_DIRENT_REC_MAX VFS_DIRENT_REC_LEN(VFS_NAME_MAX - 1)
+
 #endif /* XNIX_PROTOCOL_VFS_H */
@@ -4,6 +4,7 @@
  */
 
 #include <errno.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <vfs_client.h>
@@ -16,10 +17,14 @@ static int cat_fd(int fd, const char *name, int is_vfs) {
     int  n;
 
     if (is_vfs) {
-        while ((n = vfs_read(fd, buf, sizeof(buf))) > 0) {
-            for (int i = 0; i < n; i++)
-                putchar(buf[i]);
+        /* 文件内容由文件服务端直接送到 stdout, 不经过本进程缓冲区 */
+        fflush(stdout);
+        n = (int)sendfile(STDOUT_FILENO, fd, SIZE_MAX);
+        if (n < 0) {
+            printf("cat: %s: %s\n", name, strerror(errno));
+            return 1;
         }
+        return 0;
     } else {
         while ((n = (int)read(fd, buf, sizeof(buf))) > 0) {
             for (int i = 0; i < n; i++)
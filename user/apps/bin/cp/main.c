@@ -0,0 +1,48 @@
+/**
+ * @file main.c
+ * @brief 复制文件
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <vfs_client.h>
+#include <xnix/protocol/vfs.h>
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        printf("Usage: cp <src> <dst>\n");
+        return 1;
+    }
+
+    const char *src = argv[1];
+    const char *dst = argv[2];
+    char        path[VFS_PATH_MAX];
+
+    /* 目标是目录时复制到目录下的同名文件 */
+    struct vfs_stat st;
+    if (vfs_stat(dst, &st) == 0 && st.type == VFS_TYPE_DIR) {
+        const char *name = src;
+        for (const char *p = src; *p; p++) {
+            if (*p == '/') {
+                name = p + 1;
+            }
+        }
+        size_t      len = strlen(dst);
+        const char *sep = len > 0 && dst[len - 1] == '/' ? "" : "/";
+        if (snprintf(path, sizeof(path), "%s%s%s", dst, sep, name) >= (int)sizeof(path)) {
+            printf("cp: '%s': %s\n", dst, strerror(ENAMETOOLONG));
+            return 1;
+        }
+        dst = path;
+    }
+
+    /* 数据在文件系统服务端之间搬运, 不经过本进程 */
+    ssize_t ret = vfs_copy(src, dst);
+    if (ret < 0) {
+        printf("cp: cannot copy '%s' to '%s': %s\n", src, dst, strerror((int)-ret));
+        return 1;
+    }
+
+    return 0;
+}
@@ -26,7 +26,8 @@ static void rights_str(uint32_t rights, char *buf) {
     buf[2] = (rights & HANDLE_RIGHT_EXECUTE)   ? 'X' : '-';
     buf[3] = (rights & HANDLE_RIGHT_TRANSFER)  ? 'T' : '-';
     buf[4] = (rights & HANDLE_RIGHT_DUPLICATE) ? 'D' : '-';
-    buf[5] = '\0';
+    buf[5] = (rights & HANDLE_RIGHT_SERVE)     ? 'S' : '-';
+    buf[6] = '\0';
 }
 
 int main(int argc, char **argv) {
@@ -42,9 +43,9 @@ int main(int argc, char **argv) {
 
     printf("HANDLE  TYPE       RIGHTS  NAME\n");
     for (int i = 0; i < count; i++) {
-        char r[6];
+        char r[7];
         rights_str(handles[i].rights, r);
-        printf("%-7u %-10s %s   %s\n",
+        printf("%-7u %-10s %s  %s\n",
                handles[i].handle,
                type_str(handles[i].type),
                r,
@@ -0,0 +1,266 @@
+/**
+ * @file main.c
+ * @brief 优先级继承测试程序
+ *
+ * 各线程设置不同的非零优先级, 检查 IPC 捐赠和 mutex 继承后的有效优先级:
+ *   1. call/reply: 服务线程在处理期间拿到调用方优先级, reply 后恢复
+ *   2. 连续收下两个请求: 取两者较高者, 回复一个后降到另一个
+ *   3. 延迟回复交给工作线程: 捐赠随 sys_ipc_reply_adopt 转到工作线程
+ *   4. 同时持有两把锁: 释放一把后按另一把的等待者继承, 而不是直接归零
+ *
+ * 用法: pitest, 全部通过返回 0
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <xnix/ipc.h>
+#include <xnix/syscall.h>
+
+#define PRIO_HIGH   5
+#define PRIO_MID    8
+#define PRIO_SERVER 20
+#define PRIO_WORKER 30
+
+static uint32_t        g_ep;
+static int             g_fail;
+static volatile int    g_stage;
+static volatile tid_t  g_token;
+static pthread_mutex_t g_m1;
+static pthread_mutex_t g_m2;
+
+static int prio_self(void) {
+    return sys_thread_prio(0, -1);
+}
+
+static void check(const char *what, int got, int want) {
+    printf("  %-44s %3d  %s\n", what, got, got == want ? "ok" : "FAIL");
+    if (got != want) {
+        g_fail++;
+    }
+}
+
+/* 等 g_stage 到达 stage, 超时返回 -1 */
+static int wait_stage(int stage) {
+    for (int i = 0; i < 500; i++) {
+        if (g_stage >= stage) {
+            return 0;
+        }
+        sys_sleep(10);
+    }
+    printf("  timeout waiting for stage %d\n", stage);
+    g_fail++;
+    return -1;
+}
+
+/* 等自身有效优先级变成 want (等锁线程阻塞后才会借出) */
+static void wait_prio(int want) {
+    for (int i = 0; i < 500 && prio_self() != want; i++) {
+        sys_sleep(10);
+    }
+}
+
+static void *client(void *arg) {
+    int                prio = (int)(uintptr_t)arg;
+    struct ipc_message msg  = {0};
+    struct ipc_message rep  = {0};
+
+    sys_thread_prio(0, prio);
+    msg.regs.data[0] = (uint32_t)prio;
+    if (sys_ipc_call(g_ep, &msg, &rep, 5000) < 0) {
+        printf("  call from prio %d failed\n", prio);
+        g_fail++;
+    }
+    return NULL;
+}
+
+static void reply_to(tid_t tid) {
+    struct ipc_message rep = {0};
+    sys_ipc_reply_to(tid, &rep);
+}
+
+/* ---- 1. call/reply ---- */
+
+static void *server_simple(void *arg) {
+    struct ipc_message msg = {0};
+    (void)arg;
+
+    sys_thread_prio(0, PRIO_SERVER);
+    g_stage = 1;
+    if (sys_ipc_receive(g_ep, &msg, 5000) < 0) {
+        g_fail++;
+        return NULL;
+    }
+    check("server while handling call", prio_self(), PRIO_HIGH);
+    reply_to(msg.sender_tid);
+    check("server after reply", prio_self(), PRIO_SERVER);
+    return NULL;
+}
+
+static void test_call(void) {
+    pthread_t s, c;
+
+    printf("call/reply:\n");
+    g_stage = 0;
+    pthread_create(&s, NULL, server_simple, NULL);
+    wait_stage(1);
+    pthread_create(&c, NULL, client, (void *)(uintptr_t)PRIO_HIGH);
+    pthread_join(c, NULL);
+    pthread_join(s, NULL);
+}
+
+/* ---- 2. 连续收下两个请求 ---- */
+
+static void *server_two(void *arg) {
+    struct ipc_message a = {0};
+    struct ipc_message b = {0};
+    (void)arg;
+
+    sys_thread_prio(0, PRIO_SERVER);
+    g_stage = 1;
+    if (sys_ipc_receive(g_ep, &a, 5000) < 0 || sys_ipc_receive(g_ep, &b, 5000) < 0) {
+        g_fail++;
+        return NULL;
+    }
+    check("server holding two calls", prio_self(), PRIO_HIGH);
+
+    /* 先回复优先级高的那个 */
+    struct ipc_message *hi = a.regs.data[0] == PRIO_HIGH ? &a : &b;
+    struct ipc_message *lo = hi == &a ? &b : &a;
+    reply_to(hi->sender_tid);
+    check("server after replying the higher one", prio_self(), PRIO_MID);
+    reply_to(lo->sender_tid);
+    check("server after replying both", prio_self(), PRIO_SERVER);
+    return NULL;
+}
+
+static void test_two_calls(void) {
+    pthread_t s, c1, c2;
+
+    printf("two outstanding calls:\n");
+    g_stage = 0;
+    pthread_create(&s, NULL, server_two, NULL);
+    wait_stage(1);
+    pthread_create(&c1, NULL, client, (void *)(uintptr_t)PRIO_MID);
+    pthread_create(&c2, NULL, client, (void *)(uintptr_t)PRIO_HIGH);
+    pthread_join(c1, NULL);
+    pthread_join(c2, NULL);
+    pthread_join(s, NULL);
+}
+
+/* ---- 3. 延迟回复交给工作线程 ---- */
+
+static void *worker(void *arg) {
+    (void)arg;
+
+    sys_thread_prio(0, PRIO_WORKER);
+    if (wait_stage(2) < 0) {
+        return NULL;
+    }
+    check("worker before adopt", prio_self(), PRIO_WORKER);
+    if (sys_ipc_reply_adopt(g_token) < 0) {
+        printf("  adopt failed\n");
+        g_fail++;
+    }
+    check("worker after adopt", prio_self(), PRIO_HIGH);
+    g_stage = 3;
+    if (wait_stage(4) < 0) {
+        return NULL;
+    }
+    reply_to(g_token);
+    check("worker after reply", prio_self(), PRIO_WORKER);
+    return NULL;
+}
+
+static void *server_deferred(void *arg) {
+    struct ipc_message msg = {0};
+    (void)arg;
+
+    sys_thread_prio(0, PRIO_SERVER);
+    g_stage = 1;
+    if (sys_ipc_receive(g_ep, &msg, 5000) < 0) {
+        g_fail++;
+        return NULL;
+    }
+    check("receiver before handing off", prio_self(), PRIO_HIGH);
+    g_token = msg.sender_tid;
+    g_stage = 2;
+    if (wait_stage(3) < 0) {
+        return NULL;
+    }
+    check("receiver after worker adopted", prio_self(), PRIO_SERVER);
+    g_stage = 4;
+    return NULL;
+}
+
+static void test_deferred(void) {
+    pthread_t s, w, c;
+
+    printf("deferred reply:\n");
+    g_stage = 0;
+    pthread_create(&w, NULL, worker, NULL);
+    pthread_create(&s, NULL, server_deferred, NULL);
+    wait_stage(1);
+    pthread_create(&c, NULL, client, (void *)(uintptr_t)PRIO_HIGH);
+    pthread_join(c, NULL);
+    pthread_join(s, NULL);
+    pthread_join(w, NULL);
+}
+
+/* ---- 4. mutex ---- */
+
+static void *locker(void *arg) {
+    int              prio = (int)(uintptr_t)arg;
+    pthread_mutex_t *m    = prio == PRIO_HIGH ? &g_m1 : &g_m2;
+
+    sys_thread_prio(0, prio);
+    pthread_mutex_lock(m);
+    pthread_mutex_unlock(m);
+    return NULL;
+}
+
+static void test_mutex(void) {
+    pthread_t w1, w2;
+
+    printf("mutex:\n");
+    pthread_mutex_init(&g_m1, NULL);
+    pthread_mutex_init(&g_m2, NULL);
+
+    sys_thread_prio(0, PRIO_SERVER);
+    pthread_mutex_lock(&g_m1);
+    pthread_mutex_lock(&g_m2);
+
+    pthread_create(&w2, NULL, locker, (void *)(uintptr_t)PRIO_MID);
+    wait_prio(PRIO_MID);
+    pthread_create(&w1, NULL, locker, (void *)(uintptr_t)PRIO_HIGH);
+    wait_prio(PRIO_HIGH);
+    check("owner with two waiters", prio_self(), PRIO_HIGH);
+
+    pthread_mutex_unlock(&g_m1);
+    check("owner after releasing the first lock", prio_self(), PRIO_MID);
+    pthread_mutex_unlock(&g_m2);
+    check("owner after releasing both", prio_self(), PRIO_SERVER);
+
+    pthread_join(w1, NULL);
+    pthread_join(w2, NULL);
+    pthread_mutex_destroy(&g_m1);
+    pthread_mutex_destroy(&g_m2);
+    sys_thread_prio(0, 0);
+}
+
+int main(void) {
+    int ep = sys_endpoint_create("pitest");
+    if (ep < 0) {
+        printf("pitest: cannot create endpoint\n");
+        return 1;
+    }
+    g_ep = (uint32_t)ep;
+
+    test_call();
+    test_two_calls();
+    test_deferred();
+    test_mutex();
+
+    sys_handle_close(g_ep);
+    printf("pitest: %s\n", g_fail ? "FAILED" : "passed");
+    return g_fail ? 1 : 0;
+}
@@ -0,0 +1,146 @@
+/**
+ * @file main.c
+ * @brief 共享内存环形通道压力测试
+ *
+ * 客户端线程和服务端线程各自映射同一个 ring, 客户端 submit 递增序号,
+ * 服务端 take 后把序号加一 complete 回去, 客户端 reap 校验顺序和内容.
+ * 槽数取得很小, 让两端频繁在空/满之间切换, 门铃丢失会表现为卡死超时.
+ *
+ * 用法: ringtest [次数], 全部通过返回 0
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <xnix/sys/ring.h>
+#include <xnix/syscall.h>
+
+#define DEFAULT_COUNT 100000
+#define ENTRY_WORDS   4
+
+struct ring_entry {
+    uint32_t seq;
+    uint32_t data[ENTRY_WORDS - 1];
+};
+
+static struct sys_ring g_client;
+static uint32_t        g_count;
+static volatile int    g_server_fail;
+static volatile int    g_server_done;
+
+static int simple_atoi(const char *s) {
+    int n = 0;
+    while (*s >= '0' && *s <= '9') {
+        n = n * 10 + (*s - '0');
+        s++;
+    }
+    return n;
+}
+
+static void *server(void *arg) {
+    struct sys_ring   ring;
+    struct ring_entry e;
+    (void)arg;
+
+    /* 单独映射一次, 和跨进程的服务端一样只通过共享内存通信 */
+    if (sys_ring_attach(&ring, g_client.shm, g_client.sq_event, g_client.cq_event) < 0) {
+        printf("  server attach failed: %d\n", errno);
+        g_server_fail = 1;
+        return NULL;
+    }
+
+    for (uint32_t n = 0; n < g_count; n++) {
+        while (sys_ring_take(&ring, &e) < 0) {
+            sys_ring_wait_submit(&ring);
+        }
+        if (e.seq != n || e.data[0] != ~n) {
+            printf("  server got seq %u, want %u\n", e.seq, n);
+            g_server_fail = 1;
+        }
+        e.seq++;
+        while (sys_ring_complete(&ring, &e) < 0) {
+            /* CQ 满: 客户端 reap 时会敲提交门铃 */
+            sys_event_wait(ring.sq_event);
+        }
+    }
+
+    sys_munmap(ring.hdr, ring.size);
+    g_server_done = 1;
+    return NULL;
+}
+
+static int run(uint32_t entries, uint32_t count) {
+    struct ring_entry e;
+    pthread_t         t;
+    uint32_t          sent = 0;
+    uint32_t          got  = 0;
+    int               fail = 0;
+
+    printf("ring entries=%u count=%u:\n", entries, count);
+    if (sys_ring_create_chan(&g_client, entries, sizeof(e)) < 0) {
+        printf("  create failed: %d\n", errno);
+        return 1;
+    }
+
+    g_count       = count;
+    g_server_fail = 0;
+    g_server_done = 0;
+    pthread_create(&t, NULL, server, NULL);
+
+    while (got < count) {
+        int progress = 0;
+
+        while (sent < count) {
+            memset(&e, 0, sizeof(e));
+            e.seq     = sent;
+            e.data[0] = ~sent;
+            if (sys_ring_submit(&g_client, &e) < 0) {
+                break;
+            }
+            sent++;
+            progress = 1;
+        }
+
+        while (sys_ring_reap(&g_client, &e) == 0) {
+            if (e.seq != got + 1) {
+                printf("  client got seq %u, want %u\n", e.seq, got + 1);
+                fail = 1;
+            }
+            got++;
+            progress = 1;
+        }
+
+        if (!progress) {
+            /* SQ 满且 CQ 空: 服务端 take 或 complete 时会敲完成门铃 */
+            sys_ring_wait_complete(&g_client);
+        }
+    }
+
+    pthread_join(t, NULL);
+    fail |= g_server_fail || !g_server_done;
+
+    sys_munmap(g_client.hdr, g_client.size);
+    sys_handle_close(g_client.cq_event);
+    sys_handle_close(g_client.sq_event);
+    sys_handle_close(g_client.shm);
+
+    printf("  %u round trips  %s\n", got, fail ? "FAIL" : "ok");
+    return fail;
+}
+
+int main(int argc, char **argv) {
+    uint32_t count = DEFAULT_COUNT;
+    int      fail  = 0;
+
+    if (argc > 1) {
+        count = (uint32_t)simple_atoi(argv[1]);
+    }
+
+    fail += run(1, count);
+    fail += run(2, count);
+    fail += run(64, count);
+
+    printf("ringtest: %s\n", fail ? "FAIL" : "PASS");
+    return fail ? 1 : 0;
+}
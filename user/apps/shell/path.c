@@ -91,32 +91,41 @@ bool path_find(const char *name, char *out, size_t max_len) {
         return file_exists(out);
     }
 
-    /* 遍历 PATH 查找 */
+    /* 遍历 PATH: 先拼出全部候选 (path/name, path/name.elf), 一次批量 stat */
+    static char     cands[SHELL_MAX_PATHS * 2][SHELL_PATH_LEN + VFS_NAME_MAX];
+    const char     *cand_ptrs[SHELL_MAX_PATHS * 2];
+    struct vfs_stat st[SHELL_MAX_PATHS * 2];
+    int             results[SHELL_MAX_PATHS * 2];
+    int             n = 0;
+
     for (int i = 0; i < g_path_count; i++) {
         size_t dir_len  = strlen(g_paths[i]);
         size_t name_len = strlen(name);
 
-        /* 尝试 path/name */
-        if (dir_len + 1 + name_len < max_len) {
-            memcpy(out, g_paths[i], dir_len);
-            out[dir_len] = '/';
-            memcpy(out + dir_len + 1, name, name_len + 1);
-
-            if (file_exists(out)) {
-                return true;
-            }
+        if (dir_len + 1 + name_len + 4 >= sizeof(cands[0])) {
+            continue;
         }
 
-        /* 尝试 path/name.elf */
-        if (dir_len + 1 + name_len + 4 < max_len) {
-            memcpy(out, g_paths[i], dir_len);
-            out[dir_len] = '/';
-            strcpy(out + dir_len + 1, name);
-            memcpy(out + dir_len + 1 + name_len, ".elf", 5);
+        memcpy(cands[n], g_paths[i], dir_len);
+        cands[n][dir_len] = '/';
+        memcpy(cands[n] + dir_len + 1, name, name_len + 1);
+        cand_ptrs[n] = cands[n];
+        n++;
+
+        memcpy(cands[n], cands[n - 1], dir_len + 1 + name_len);
+        memcpy(cands[n] + dir_len + 1 + name_len, ".elf", 5);
+        cand_ptrs[n] = cands[n];
+        n++;
+    }
+
+    if (n == 0 || vfs_stat_many(cand_ptrs, n, st, results) < 0) {
+        return false;
+    }
 
-            if (file_exists(out)) {
-                return true;
-            }
+    for (int i = 0; i < n; i++) {
+        if (results[i] == 0 && st[i].type == VFS_TYPE_FILE && strlen(cands[i]) < max_len) {
+            strcpy(out, cands[i]);
+            return true;
         }
     }
 
@@ -1,7 +1,13 @@
 #include "ata.h"
 
+#include <errno.h>
 #include <stdio.h>
 #include <string.h>
+#include <xnix/abi/handle.h>
+#include <xnix/abi/ipc.h>
+#include <xnix/driver/ioport.h>
+#include <xnix/ipc.h>
+#include <xnix/protocol/pci.h>
 #include <xnix/syscall.h>
 
 /* I/O 端口定义 */
@@ -17,10 +23,14 @@
 
 #define ATA_CTRL_STATUS  0x3F6
 #define ATA_CTRL_COMMAND 0x3F6
+#define ATA_CTRL_NIEN    0x02 /* 禁用设备中断 */
+#define ATA_CTRL_SRST    0x04 /* 软件复位整个通道 */
 
 /* 命令 */
 #define ATA_CMD_READ_PIO    0x20
 #define ATA_CMD_WRITE_PIO   0x30
+#define ATA_CMD_READ_DMA    0xC8
+#define ATA_CMD_WRITE_DMA   0xCA
 #define ATA_CMD_CACHE_FLUSH 0xE7
 #define ATA_CMD_IDENTIFY    0xEC
 
@@ -34,16 +44,118 @@
 #define ATA_SR_IDX  0x02 /* Index */
 #define ATA_SR_ERR  0x01 /* Error */
 
+/* 单条 PIO 命令最多扇区数(sector count 寄存器 8 位, 0 表示 256, 不使用) */
+#define ATA_PIO_MAX_SECTORS 255
+
 /* 等待超时(迭代次数, 每次含 syscall 开销约 ~1us, 总计约数百毫秒) */
 #define ATA_TIMEOUT_LOOPS 500000
 
+/* PCI IDE 控制器 (经 pcid 查找和 claim) */
+#define PCI_CLASS_IDE        0x0101 /* class=01 (存储), subclass=01 (IDE) */
+#define PCI_PROGIF_BUSMASTER 0x80
+#define PCI_BAR_BUSMASTER    4
+
+/* Bus-master IDE 寄存器(BAR4, 主通道偏移 0) */
+#define BM_CMD       0x00
+#define BM_STATUS    0x02
+#define BM_PRDT      0x04
+#define BM_CMD_START 0x01
+#define BM_CMD_READ  0x08 /* 方向: 设备 -> 内存 */
+#define BM_SR_ACTIVE 0x01
+#define BM_SR_ERR    0x02
+#define BM_SR_IRQ    0x04
+
+/*
+ * 同一通道的主从盘由两个 fatfs 实例分别驱动, 但 BM 寄存器, IRQ 14 和
+ * nIEN 是整个通道共用的. 只有主盘实例是通道属主, 负责这些共享状态并
+ * 使用 DMA; 从盘实例不碰它们, 始终走 PIO.
+ */
+#define ATA_CHANNEL_OWNER   0
+
+#define ATA_IRQ_PRIMARY     14
+#define ATA_IRQ_BIT         (1u << 0)
+#define ATA_PROBE_BIT       (1u << 31)
+#define ATA_DMA_PRDT_SIZE   4096
+#define ATA_DMA_BUF_SIZE    (64 * 1024)
+#define ATA_DMA_MAX_SECTORS (ATA_DMA_BUF_SIZE / ATA_SECTOR_SIZE)
+#define ATA_DMA_TIMEOUT_MS  2000 /* 单次等待 IRQ 的上限, 64KB 传输远用不了这么久 */
+#define PRD_EOT             0x8000
+#define PRD_MAX             4
+
+/* 基准测试: 每次读取的扇区数, tick 频率(与内核 CFG_SCHED_HZ 默认值一致) */
+#define ATA_BENCH_BATCH ATA_DMA_MAX_SECTORS
+#define ATA_BENCH_HZ    100
+
+/* Physical Region Descriptor: 每项描述一段不跨 64KB 边界的物理内存 */
+struct ata_prd {
+    uint32_t addr;
+    uint16_t count; /* 字节数, 0 表示 64KB */
+    uint16_t flags;
+} __attribute__((packed));
+
+/*
+ * Bus-master DMA 状态
+ *
+ * DMA 缓冲区由内核分配(物理连续), 首页放 PRD 表, 其后 64KB 为数据区.
+ * 传输完成由 IRQ 14 通过 event 唤醒, 等待期间不占 CPU.
+ */
+static struct {
+    bool            ready;
+    int             pci_dev; /* claim 的 pcid 设备序号, -1=未 claim */
+    handle_t        pci_ep;
+    uint16_t        bm_base;
+    handle_t        irq_event;
+    struct ata_prd *prdt;
+    uint32_t        prdt_phys;
+    uint8_t        *buf;
+    uint32_t        buf_phys;
+} g_dma;
+
+static void ata_dma_init(uint8_t drive, handle_t pci_ep);
+
+/*
+ * 端口访问方式
+ *
+ * ata_init 用系统调用探测一次状态端口, 成功说明内核已把本进程的端口表
+ * 载入 TSS I/O 位图, 之后直接执行 in/out, 数据传输使用 rep insw/outsw.
+ */
+static bool g_ata_native;
+
+static inline uint8_t ata_inb(uint16_t port) {
+    return g_ata_native ? ioport_native_inb(port) : (uint8_t)sys_ioport_inb(port);
+}
+
+static inline void ata_outb(uint16_t port, uint8_t val) {
+    if (g_ata_native) {
+        ioport_native_outb(port, val);
+    } else {
+        sys_ioport_outb(port, val);
+    }
+}
+
+static void ata_read_data(uint16_t *buf) {
+    if (g_ata_native) {
+        ioport_native_insw(ATA_DATA, buf, 256);
+    } else {
+        sys_ioport_insw(ATA_DATA, buf, 256);
+    }
+}
+
+static void ata_write_data(const uint16_t *buf) {
+    if (g_ata_native) {
+        ioport_native_outsw(ATA_DATA, buf, 256);
+    } else {
+        sys_ioport_outsw(ATA_DATA, buf, 256);
+    }
+}
+
 /**
  * 等待 BSY 位清除(带超时)
  * @return 0 成功, -1 超时
  */
 static int ata_wait_bsy(void) {
     for (int i = 0; i < ATA_TIMEOUT_LOOPS; i++) {
-        if (!(sys_ioport_inb(ATA_STATUS) & ATA_SR_BSY)) {
+        if (!(ata_inb(ATA_STATUS) & ATA_SR_BSY)) {
             return 0;
         }
     }
@@ -56,7 +168,7 @@ static int ata_wait_bsy(void) {
  */
 static int ata_wait_drq(void) {
     for (int i = 0; i < ATA_TIMEOUT_LOOPS; i++) {
-        uint8_t status = sys_ioport_inb(ATA_STATUS);
+        uint8_t status = ata_inb(ATA_STATUS);
         if (status & ATA_SR_DRQ) {
             return 0;
         }
@@ -67,11 +179,21 @@ static int ata_wait_drq(void) {
     return -1;
 }
 
-int ata_init(void) {
-    sys_ioport_outb(ATA_CTRL_COMMAND, 0x02); /* 禁用中断 */
+int ata_init(uint8_t drive, handle_t pci_ep) {
+    /* 探测端口权限, 系统调用越权返回 -EPERM 而不是 #GP */
+    int probe = sys_ioport_inb(ATA_STATUS);
+    if (probe < 0) {
+        return -1;
+    }
+    g_ata_native = true;
+
+    /* 设备控制寄存器由通道属主管理, 见 ata_dma_init */
+    if (drive == ATA_CHANNEL_OWNER) {
+        ata_outb(ATA_CTRL_COMMAND, 0x02); /* 禁用中断 */
+    }
 
     /* 浮动总线检测: 无设备时端口读回 0xFF */
-    uint8_t status = sys_ioport_inb(ATA_STATUS);
+    uint8_t status = ata_inb(ATA_STATUS);
     if (status == 0xFF) {
         return -1;
     }
@@ -81,35 +203,40 @@ int ata_init(void) {
         return -1;
     }
 
-    /* 验证主盘就绪 */
-    if (!ata_is_ready(0)) {
+    /* 验证目标驱动器就绪 */
+    if (!ata_is_ready(drive)) {
         return -1;
     }
 
+    ata_dma_init(drive, pci_ep);
     return 0;
 }
 
 bool ata_is_ready(uint8_t drive) {
-    sys_ioport_outb(ATA_DRIVE_HEAD, (drive == 0 ? 0xA0 : 0xB0));
-    sys_ioport_inb(ATA_STATUS);
-    sys_ioport_inb(ATA_STATUS);
-    sys_ioport_inb(ATA_STATUS);
-    sys_ioport_inb(ATA_STATUS);
-    return (sys_ioport_inb(ATA_STATUS) & ATA_SR_DRDY) != 0;
+    ata_outb(ATA_DRIVE_HEAD, (drive == 0 ? 0xA0 : 0xB0));
+    ata_inb(ATA_STATUS);
+    ata_inb(ATA_STATUS);
+    ata_inb(ATA_STATUS);
+    ata_inb(ATA_STATUS);
+    return (ata_inb(ATA_STATUS) & ATA_SR_DRDY) != 0;
 }
 
-int ata_read(uint8_t drive, uint32_t lba, uint32_t count, void *buffer) {
+static void ata_select_lba(uint8_t drive, uint32_t lba, uint32_t count) {
+    ata_outb(ATA_DRIVE_HEAD, 0xE0 | (drive << 4) | ((lba >> 24) & 0x0F));
+    ata_outb(ATA_SECTOR_COUNT, (uint8_t)count);
+    ata_outb(ATA_LBA_LOW, (uint8_t)lba);
+    ata_outb(ATA_LBA_MID, (uint8_t)(lba >> 8));
+    ata_outb(ATA_LBA_HIGH, (uint8_t)(lba >> 16));
+}
+
+static int ata_pio_read(uint8_t drive, uint32_t lba, uint32_t count, void *buffer) {
     uint16_t *buf = (uint16_t *)buffer;
 
     if (ata_wait_bsy() < 0) {
         return -1;
     }
-    sys_ioport_outb(ATA_DRIVE_HEAD, 0xE0 | (drive << 4) | ((lba >> 24) & 0x0F));
-    sys_ioport_outb(ATA_SECTOR_COUNT, (uint8_t)count);
-    sys_ioport_outb(ATA_LBA_LOW, (uint8_t)lba);
-    sys_ioport_outb(ATA_LBA_MID, (uint8_t)(lba >> 8));
-    sys_ioport_outb(ATA_LBA_HIGH, (uint8_t)(lba >> 16));
-    sys_ioport_outb(ATA_COMMAND, ATA_CMD_READ_PIO);
+    ata_select_lba(drive, lba, count);
+    ata_outb(ATA_COMMAND, ATA_CMD_READ_PIO);
 
     for (uint32_t i = 0; i < count; i++) {
         if (ata_wait_bsy() < 0) {
@@ -118,26 +245,20 @@ int ata_read(uint8_t drive, uint32_t lba, uint32_t count, void *buffer) {
         if (ata_wait_drq() < 0) {
             return -1;
         }
-        for (int j = 0; j < 256; j++) {
-            buf[i * 256 + j] = sys_ioport_inw(ATA_DATA);
-        }
+        ata_read_data(&buf[i * 256]);
     }
 
     return 0;
 }
 
-int ata_write(uint8_t drive, uint32_t lba, uint32_t count, const void *buffer) {
+static int ata_pio_write(uint8_t drive, uint32_t lba, uint32_t count, const void *buffer) {
     const uint16_t *buf = (const uint16_t *)buffer;
 
     if (ata_wait_bsy() < 0) {
         return -1;
     }
-    sys_ioport_outb(ATA_DRIVE_HEAD, 0xE0 | (drive << 4) | ((lba >> 24) & 0x0F));
-    sys_ioport_outb(ATA_SECTOR_COUNT, (uint8_t)count);
-    sys_ioport_outb(ATA_LBA_LOW, (uint8_t)lba);
-    sys_ioport_outb(ATA_LBA_MID, (uint8_t)(lba >> 8));
-    sys_ioport_outb(ATA_LBA_HIGH, (uint8_t)(lba >> 16));
-    sys_ioport_outb(ATA_COMMAND, ATA_CMD_WRITE_PIO);
+    ata_select_lba(drive, lba, count);
+    ata_outb(ATA_COMMAND, ATA_CMD_WRITE_PIO);
 
     for (uint32_t i = 0; i < count; i++) {
         if (ata_wait_bsy() < 0) {
@@ -146,10 +267,329 @@ int ata_write(uint8_t drive, uint32_t lba, uint32_t count, const void *buffer) {
         if (ata_wait_drq() < 0) {
             return -1;
         }
-        for (int j = 0; j < 256; j++) {
-            sys_ioport_outw(ATA_DATA, buf[i * 256 + j]);
+        ata_write_data(&buf[i * 256]);
+        ata_outb(ATA_COMMAND, ATA_CMD_CACHE_FLUSH);
+        if (ata_wait_bsy() < 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Bus-master DMA
+ */
+
+/**
+ * 通过 pcid 找到并 claim 支持 bus-master 的 IDE 控制器
+ *
+ * pcid 打开控制器的 IO 解码和总线主控, 本进程退出时由它关掉总线主控,
+ * 配置空间不由驱动直接访问.
+ *
+ * @return BAR4 I/O 基址, 0 表示未找到或 claim 失败
+ */
+static uint16_t ata_claim_busmaster(handle_t pci_ep) {
+    struct pci_dev_info info;
+    uint32_t            start = 0;
+
+    while (1) {
+        struct ipc_message msg   = {0};
+        struct ipc_message reply = {0};
+
+        msg.regs.data[0]  = UDM_PCI_FIND;
+        msg.regs.data[1]  = PCI_ANY_ID | ((uint32_t)PCI_ANY_ID << 16);
+        msg.regs.data[2]  = PCI_CLASS_IDE;
+        msg.regs.data[3]  = start;
+        reply.buffer.data = (uint64_t)(uintptr_t)&info;
+        reply.buffer.size = sizeof(info);
+
+        if (sys_ipc_call(pci_ep, &msg, &reply, 1000) < 0) {
+            return 0;
+        }
+        int dev = (int32_t)reply.regs.data[1];
+        if (dev < 0) {
+            return 0;
+        }
+        start = (uint32_t)dev + 1;
+
+        if ((info.prog_if & PCI_PROGIF_BUSMASTER) &&
+            (info.bar_flags[PCI_BAR_BUSMASTER] & PCI_BAR_IO) &&
+            info.bar_size[PCI_BAR_BUSMASTER] != 0) {
+            memset(&msg, 0, sizeof(msg));
+            memset(&reply, 0, sizeof(reply));
+            msg.regs.data[0]  = UDM_PCI_CLAIM;
+            msg.regs.data[1]  = (uint32_t)dev;
+            reply.buffer.data = (uint64_t)(uintptr_t)&info;
+            reply.buffer.size = sizeof(info);
+
+            if (sys_ipc_call(pci_ep, &msg, &reply, 1000) < 0 ||
+                (int32_t)reply.regs.data[1] < 0) {
+                return 0;
+            }
+            /* 只用 BAR4 端口, 不需要内存 BAR 的 handle */
+            for (uint32_t i = 0; i < reply.handles.count; i++) {
+                sys_handle_close(reply.handles.handles[i]);
+            }
+            g_dma.pci_dev = dev;
+            g_dma.pci_ep  = pci_ep;
+            return (uint16_t)info.bar_base[PCI_BAR_BUSMASTER];
+        }
+    }
+}
+
+/* 放弃 DMA 时交还控制器, pcid 关掉总线主控 */
+static void ata_release_busmaster(void) {
+    struct ipc_message msg   = {0};
+    struct ipc_message reply = {0};
+
+    if (g_dma.pci_dev < 0) {
+        return;
+    }
+    msg.regs.data[0] = UDM_PCI_RELEASE;
+    msg.regs.data[1] = (uint32_t)g_dma.pci_dev;
+    sys_ipc_call(g_dma.pci_ep, &msg, &reply, 1000);
+    g_dma.pci_dev = -1;
+}
+
+/*
+ * 等 IRQ 门铃, 最多 ATA_DMA_TIMEOUT_MS
+ *
+ * event_wait 没有超时, 先用 wait_any 带超时等它变为就绪, 再取走 pending 位.
+ * @return 0 收到门铃, -1 超时
+ */
+static int ata_irq_wait(void) {
+    struct abi_ipc_wait_set set = {0};
+    set.handles[0]              = g_dma.irq_event;
+    set.count                   = 1;
+
+    if (sys_ipc_wait_any(&set, ATA_DMA_TIMEOUT_MS) == HANDLE_INVALID) {
+        return -1;
+    }
+    sys_event_wait(g_dma.irq_event);
+    return 0;
+}
+
+/*
+ * 软件复位通道, 丢弃卡住的 DMA 命令
+ *
+ * 复位同时作用于从盘; 从盘实例的 PIO 命令会超时失败, 不会挂住.
+ */
+static void ata_reset_channel(void) {
+    ata_outb(ATA_CTRL_COMMAND, ATA_CTRL_SRST | ATA_CTRL_NIEN);
+    sys_sleep(1);
+    ata_outb(ATA_CTRL_COMMAND, ATA_CTRL_NIEN);
+    sys_sleep(2);
+    ata_wait_bsy();
+}
+
+/* 放弃 DMA 回到 PIO: 关设备中断, 解绑 IRQ, 交还控制器. DMA 缓冲区保留不再使用 */
+static void ata_dma_disable(void) {
+    g_dma.ready = false;
+    ata_outb(ATA_CTRL_COMMAND, ATA_CTRL_NIEN);
+    sys_irq_unbind(ATA_IRQ_PRIMARY);
+    ata_release_busmaster();
+}
+
+/* 为 bytes 字节的数据区构建 PRD 表, 在 64KB 物理边界处拆分 */
+static void ata_dma_build_prdt(uint32_t bytes) {
+    uint32_t phys = g_dma.buf_phys;
+    int      i    = 0;
+
+    while (bytes > 0 && i < PRD_MAX) {
+        uint32_t room = 0x10000 - (phys & 0xFFFF);
+        uint32_t n    = bytes < room ? bytes : room;
+
+        g_dma.prdt[i].addr  = phys;
+        g_dma.prdt[i].count = (uint16_t)n; /* n == 64KB 时截断为 0, 即 64KB */
+        g_dma.prdt[i].flags = 0;
+        phys += n;
+        bytes -= n;
+        i++;
+    }
+    g_dma.prdt[i - 1].flags = PRD_EOT;
+}
+
+/**
+ * 执行一次 DMA 传输(数据在 g_dma.buf 中)
+ *
+ * @param polled true 时轮询 bus-master 状态, 用于初始化时验证 IRQ 投递
+ * @return 0 成功, -EIO 设备或总线报错, -ETIMEDOUT 超时未完成(引擎已停, 通道已复位)
+ */
+static int ata_dma_xfer(uint8_t drive, uint32_t lba, uint32_t count, bool write, bool polled) {
+    uint16_t bm  = g_dma.bm_base;
+    uint8_t  dir = write ? 0 : BM_CMD_READ;
+
+    ata_dma_build_prdt(count * ATA_SECTOR_SIZE);
+
+    if (ata_wait_bsy() < 0) {
+        return -EIO;
+    }
+
+    ioport_native_outb(bm + BM_CMD, dir);
+    ioport_native_outl(bm + BM_PRDT, g_dma.prdt_phys);
+    ioport_native_outb(bm + BM_STATUS, BM_SR_ERR | BM_SR_IRQ); /* 写 1 清除 */
+
+    ata_select_lba(drive, lba, count);
+    ata_outb(ATA_COMMAND, write ? ATA_CMD_WRITE_DMA : ATA_CMD_READ_DMA);
+    ioport_native_outb(bm + BM_CMD, dir | BM_CMD_START);
+
+    /*
+     * 先查状态再等 event: 残留的 event 位(例如 PIO 命令产生的中断)
+     * 只会多转一圈, 而在检查与等待之间到达的中断会留在 pending 位里.
+     * 中断丢失或设备不响应时靠超时退出, 不会永远睡在 event 上.
+     */
+    uint8_t bm_status;
+    int     loops = 0;
+    while (!((bm_status = ioport_native_inb(bm + BM_STATUS)) & BM_SR_IRQ)) {
+        if (bm_status & BM_SR_ERR) {
+            break;
+        }
+        if (++loops > ATA_TIMEOUT_LOOPS || (!polled && ata_irq_wait() < 0)) {
+            break;
         }
-        sys_ioport_outb(ATA_COMMAND, ATA_CMD_CACHE_FLUSH);
+    }
+
+    ioport_native_outb(bm + BM_CMD, dir);
+    uint8_t status = ata_inb(ATA_STATUS); /* 读状态寄存器清除设备 INTRQ */
+    ioport_native_outb(bm + BM_STATUS, BM_SR_ERR | BM_SR_IRQ);
+
+    if (!(bm_status & (BM_SR_IRQ | BM_SR_ERR))) {
+        printf("[ata] DMA lba %u timed out, resetting channel\n", lba);
+        ata_reset_channel();
+        return -ETIMEDOUT;
+    }
+    if ((bm_status & BM_SR_ERR) || (status & (ATA_SR_ERR | ATA_SR_DF))) {
+        return -EIO;
+    }
+    return 0;
+}
+
+/**
+ * 初始化 bus-master DMA
+ *
+ * 需要直接端口访问(BM 寄存器是 32 位端口), pcid 分配控制器, IRQ 绑定和
+ * DMA 缓冲区权限, 任何一步失败都回退到 PIO. 非通道属主直接使用 PIO.
+ */
+static void ata_dma_init(uint8_t drive, handle_t pci_ep) {
+    g_dma.pci_dev = -1;
+    if (!g_ata_native || drive != ATA_CHANNEL_OWNER || pci_ep == HANDLE_INVALID) {
+        return;
+    }
+
+    uint16_t bm = ata_claim_busmaster(pci_ep);
+    if (!bm) {
+        return;
+    }
+
+    handle_t h = sys_dma_create(ATA_DMA_PRDT_SIZE + ATA_DMA_BUF_SIZE);
+    if (h == HANDLE_INVALID) {
+        ata_release_busmaster();
+        return;
+    }
+    uint8_t *va = sys_mmap_phys(h, 0, 0, 0x03, NULL);
+    struct physmem_info info;
+    if (!va || (intptr_t)va < 0 || sys_physmem_info(h, &info) < 0) {
+        sys_handle_close(h);
+        ata_release_busmaster();
+        return;
+    }
+
+    int ev = sys_event_create();
+    if (ev < 0) {
+        sys_handle_close(h);
+        ata_release_busmaster();
+        return;
+    }
+    if (sys_irq_bind(ATA_IRQ_PRIMARY, (uint32_t)ev, ATA_IRQ_BIT) < 0) {
+        sys_handle_close((handle_t)ev);
+        sys_handle_close(h);
+        ata_release_busmaster();
+        return;
+    }
+
+    g_dma.bm_base   = bm;
+    g_dma.irq_event = (handle_t)ev;
+    g_dma.prdt      = (struct ata_prd *)va;
+    g_dma.prdt_phys = info.phys_addr;
+    g_dma.buf       = va + ATA_DMA_PRDT_SIZE;
+    g_dma.buf_phys  = info.phys_addr + ATA_DMA_PRDT_SIZE;
+
+    /* 打开设备中断(nIEN=0), 然后轮询完成一次读, 检查 IRQ 是否送达 */
+    ata_outb(ATA_CTRL_COMMAND, 0x00);
+    if (ata_dma_xfer(drive, 0, 1, false, true) == 0) {
+        sys_sleep(10);
+        sys_event_signal(g_dma.irq_event, ATA_PROBE_BIT);
+        if (sys_event_wait(g_dma.irq_event) & ATA_IRQ_BIT) {
+            g_dma.ready = true;
+            return;
+        }
+    }
+
+    /* IRQ 未送达或 DMA 失败: 回到 PIO */
+    ata_dma_disable();
+}
+
+int ata_read(uint8_t drive, uint32_t lba, uint32_t count, void *buffer) {
+    uint8_t *buf = (uint8_t *)buffer;
+
+    while (count > 0) {
+        uint32_t n;
+        if (g_dma.ready) {
+            n       = count < ATA_DMA_MAX_SECTORS ? count : ATA_DMA_MAX_SECTORS;
+            int ret = ata_dma_xfer(drive, lba, n, false, false);
+            if (ret == -ETIMEDOUT) {
+                ata_dma_disable(); /* 本段及以后改走 PIO */
+                continue;
+            }
+            if (ret < 0) {
+                return -1;
+            }
+            memcpy(buf, g_dma.buf, n * ATA_SECTOR_SIZE);
+        } else {
+            n = count < ATA_PIO_MAX_SECTORS ? count : ATA_PIO_MAX_SECTORS;
+            if (ata_pio_read(drive, lba, n, buf) < 0) {
+                return -1;
+            }
+        }
+        buf += n * ATA_SECTOR_SIZE;
+        lba += n;
+        count -= n;
+    }
+
+    return 0;
+}
+
+int ata_write(uint8_t drive, uint32_t lba, uint32_t count, const void *buffer) {
+    const uint8_t *buf = (const uint8_t *)buffer;
+
+    while (count > 0) {
+        uint32_t n;
+        if (g_dma.ready) {
+            n = count < ATA_DMA_MAX_SECTORS ? count : ATA_DMA_MAX_SECTORS;
+            memcpy(g_dma.buf, buf, n * ATA_SECTOR_SIZE);
+            int ret = ata_dma_xfer(drive, lba, n, true, false);
+            if (ret == -ETIMEDOUT) {
+                ata_dma_disable();
+                continue;
+            }
+            if (ret < 0) {
+                return -1;
+            }
+        } else {
+            n = count < ATA_PIO_MAX_SECTORS ? count : ATA_PIO_MAX_SECTORS;
+            if (ata_pio_write(drive, lba, n, buf) < 0) {
+                return -1;
+            }
+        }
+        buf += n * ATA_SECTOR_SIZE;
+        lba += n;
+        count -= n;
+    }
+
+    /* DMA 写不逐扇区刷新, 每次请求结束刷一次写缓存 */
+    if (g_dma.ready) {
+        ata_outb(ATA_COMMAND, ATA_CMD_CACHE_FLUSH);
         if (ata_wait_bsy() < 0) {
             return -1;
         }
@@ -166,17 +606,17 @@ uint32_t ata_get_sector_count(uint8_t drive) {
     }
 
     /* 选择驱动器 */
-    sys_ioport_outb(ATA_DRIVE_HEAD, drive == 0 ? 0xA0 : 0xB0);
+    ata_outb(ATA_DRIVE_HEAD, drive == 0 ? 0xA0 : 0xB0);
 
     /* 发送 IDENTIFY 命令 */
-    sys_ioport_outb(ATA_COMMAND, ATA_CMD_IDENTIFY);
+    ata_outb(ATA_COMMAND, ATA_CMD_IDENTIFY);
 
     if (ata_wait_bsy() < 0) {
         return 0;
     }
 
     /* 检查状态 */
-    uint8_t status = sys_ioport_inb(ATA_STATUS);
+    uint8_t status = ata_inb(ATA_STATUS);
     if (status == 0 || (status & ATA_SR_ERR)) {
         return 0;
     }
@@ -186,9 +626,7 @@ uint32_t ata_get_sector_count(uint8_t drive) {
     }
 
     /* 读取 IDENTIFY 数据(256 个 16 位字) */
-    for (int i = 0; i < 256; i++) {
-        identify_data[i] = sys_ioport_inw(ATA_DATA);
-    }
+    ata_read_data(identify_data);
 
     /*
      * ATA IDENTIFY 返回的扇区数位于:
@@ -213,3 +651,52 @@ uint32_t ata_get_sector_count(uint8_t drive) {
 
     return sector_count;
 }
+
+/* 读取系统 tick 计数(所有 CPU 的 tick 之和) */
+static uint64_t ata_bench_ticks(uint32_t *cpu_count) {
+    struct proc_info     info;
+    struct sys_info      sys = {0};
+    struct proclist_args args = {
+        .buf         = &info,
+        .buf_count   = 1,
+        .start_index = 0,
+        .sys_info    = &sys,
+    };
+    sys_proclist(&args);
+    *cpu_count = sys.cpu_count ? sys.cpu_count : 1;
+    return sys.total_ticks;
+}
+
+static uint32_t ata_bench_run(uint8_t drive, uint32_t sectors, void *buf) {
+    uint32_t cpus;
+    uint64_t start = ata_bench_ticks(&cpus);
+    for (uint32_t lba = 0; lba < sectors; lba += ATA_BENCH_BATCH) {
+        uint32_t n = sectors - lba < ATA_BENCH_BATCH ? sectors - lba : ATA_BENCH_BATCH;
+        if (ata_read(drive, lba, n, buf) < 0) {
+            return 0;
+        }
+    }
+    /* 用户态没有 64 位除法支持, 基准时长远小于 2^32 tick */
+    uint32_t ticks = (uint32_t)(ata_bench_ticks(&cpus) - start) / cpus;
+    if (ticks == 0) {
+        ticks = 1;
+    }
+    return sectors * ATA_BENCH_HZ / ticks;
+}
+
+void ata_bench(uint8_t drive, uint32_t sectors) {
+    static uint16_t buf[ATA_BENCH_BATCH * 256];
+    bool            native = g_ata_native;
+    bool            dma    = g_dma.ready;
+
+    g_dma.ready     = false;
+    g_ata_native    = false;
+    uint32_t sys_ps = ata_bench_run(drive, sectors, buf);
+    g_ata_native    = native;
+    uint32_t nat_ps = native ? ata_bench_run(drive, sectors, buf) : 0;
+    g_dma.ready     = dma;
+    uint32_t dma_ps = dma ? ata_bench_run(drive, sectors, buf) : 0;
+
+    printf("[ata] bench drive=%u sectors=%u: syscall %u, native %u, dma %u sectors/s\n", drive,
+           sectors, sys_ps, nat_ps, dma_ps);
+}
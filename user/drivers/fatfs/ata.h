@@ -8,15 +8,21 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <xnix/abi/handle.h>
 
 #define ATA_SECTOR_SIZE 512
 
 /**
  * 初始化 ATA 驱动
  *
+ * 主盘实例是通道属主, 可通过 pcid claim IDE 控制器启用 bus-master DMA;
+ * 从盘实例只用 PIO.
+ *
+ * @param drive  本实例驱动的驱动器号 (0=主盘, 1=从盘)
+ * @param pci_ep pcid endpoint, HANDLE_INVALID 时只用 PIO
  * @return 0 成功,负数失败
  */
-int ata_init(void);
+int ata_init(uint8_t drive, handle_t pci_ep);
 
 /**
  * 检查磁盘是否就绪
@@ -56,4 +62,14 @@ int ata_write(uint8_t drive, uint32_t lba, uint32_t count, const void *buffer);
  */
 uint32_t ata_get_sector_count(uint8_t drive);
 
+/**
+ * 顺序读基准测试
+ *
+ * 分别用系统调用和直接端口访问读取前 sectors 个扇区, 打印 sectors/s.
+ *
+ * @param drive   驱动器号
+ * @param sectors 读取扇区数
+ */
+void ata_bench(uint8_t drive, uint32_t sectors);
+
 #endif /* ATA_H */
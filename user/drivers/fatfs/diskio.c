@@ -5,6 +5,7 @@
  * 实现 FatFs 的 diskio 接口, 支持两种后端:
  * - 内存模式: 从 boot.system mmap 的内存区域
  * - ATA 模式: ATA PIO 磁盘 (带分区偏移)
+ * - 块设备模式: 经 libblock 缓存访问的磁盘 (ATA, virtio-blk)
  *
  * FatFs 始终使用 pdrv=0 (FF_VOLUMES=1), diskio 内部根据模式路由.
  */
@@ -17,12 +18,14 @@
 #include <diskio.h>
 // clang-format on
 
+#include <block.h>
 #include <string.h>
 
 /* 设备模式 */
 #define DISK_MODE_NONE   0
 #define DISK_MODE_MEMORY 1
 #define DISK_MODE_ATA    2
+#define DISK_MODE_BLOCK  3
 
 static int g_mode;
 
@@ -34,6 +37,10 @@ static uint32_t g_mem_size;
 static int      g_ata_drive;
 static uint32_t g_ata_base_lba;
 
+/* 块设备状态 */
+static struct block_device *g_blk;
+static uint32_t             g_blk_base_lba;
+
 void disk_init_memory(void *data, uint32_t size) {
     g_mem_data = (uint8_t *)data;
     g_mem_size = size;
@@ -46,6 +53,12 @@ void disk_init_ata(int drive, uint32_t base_lba) {
     g_mode         = DISK_MODE_ATA;
 }
 
+void disk_init_block(struct block_device *dev, uint32_t base_lba) {
+    g_blk          = dev;
+    g_blk_base_lba = base_lba;
+    g_mode         = DISK_MODE_BLOCK;
+}
+
 DSTATUS disk_status(BYTE pdrv) {
     (void)pdrv;
     switch (g_mode) {
@@ -53,6 +66,8 @@ DSTATUS disk_status(BYTE pdrv) {
         return 0;
     case DISK_MODE_ATA:
         return ata_is_ready(g_ata_drive) ? 0 : STA_NOINIT;
+    case DISK_MODE_BLOCK:
+        return g_blk ? 0 : STA_NOINIT;
     default:
         return STA_NOINIT;
     }
@@ -85,6 +100,13 @@ DRESULT disk_read(BYTE pdrv, BYTE *buff, LBA_t sector, UINT count) {
         return RES_OK;
     }
 
+    if (g_mode == DISK_MODE_BLOCK) {
+        if (block_read(g_blk, sector + g_blk_base_lba, count, buff) < 0) {
+            return RES_ERROR;
+        }
+        return RES_OK;
+    }
+
     return RES_NOTRDY;
 }
 
@@ -111,6 +133,16 @@ DRESULT disk_write(BYTE pdrv, const BYTE *buff, LBA_t sector, UINT count) {
         return RES_OK;
     }
 
+    if (g_mode == DISK_MODE_BLOCK) {
+        if (g_blk->info.flags & BLOCK_FLAG_READONLY) {
+            return RES_WRPRT;
+        }
+        if (block_write(g_blk, sector + g_blk_base_lba, count, buff) < 0) {
+            return RES_ERROR;
+        }
+        return RES_OK;
+    }
+
     return RES_NOTRDY;
 }
 
@@ -156,5 +188,23 @@ DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void *buff) {
         }
     }
 
+    if (g_mode == DISK_MODE_BLOCK) {
+        switch (cmd) {
+        case CTRL_SYNC:
+            return block_flush(g_blk) < 0 ? RES_ERROR : RES_OK;
+        case GET_SECTOR_COUNT:
+            *(LBA_t *)buff = (LBA_t)(g_blk->info.sector_count - g_blk_base_lba);
+            return RES_OK;
+        case GET_SECTOR_SIZE:
+            *(WORD *)buff = (WORD)g_blk->info.sector_size;
+            return RES_OK;
+        case GET_BLOCK_SIZE:
+            *(DWORD *)buff = 1;
+            return RES_OK;
+        default:
+            return RES_PARERR;
+        }
+    }
+
     return RES_NOTRDY;
 }
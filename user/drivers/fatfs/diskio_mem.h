@@ -1,6 +1,6 @@
 /**
  * @file diskio_mem.h
- * @brief diskio 扩展接口: 内存/ATA 设备初始化
+ * @brief diskio 扩展接口: 内存/ATA/块设备初始化
  */
 
 #ifndef DISKIO_MEM_H
@@ -8,6 +8,8 @@
 
 #include <stdint.h>
 
+struct block_device;
+
 /**
  * 初始化内存设备
  * 设置后 FatFs 的 disk_* 调用将路由到此内存区域
@@ -20,4 +22,10 @@ void disk_init_memory(void *data, uint32_t size);
  */
 void disk_init_ata(int drive, uint32_t base_lba);
 
+/**
+ * 初始化 libblock 块设备 (带分区偏移)
+ * 设置后 FatFs 的 disk_* 调用经 libblock 缓存路由到 dev + base_lba 偏移
+ */
+void disk_init_block(struct block_device *dev, uint32_t base_lba);
+
 #endif /* DISKIO_MEM_H */
@@ -0,0 +1,422 @@
+/**
+ * @file fatfs_alloc.c
+ * @brief FAT 空闲簇位图与连续分配提示
+ *
+ * FatFs 分配新簇时从 fs->last_clst 之后逐项读 FAT 找空闲簇, 多个文件交替
+ * 增长时簇互相穿插. 这里在挂载时扫一遍 FAT 建位图 (1 位 = 1 簇, 置位 = 已用),
+ * 扩展写之前在位图里找一段够长的连续空闲区, 把 last_clst 指到它前面:
+ * FatFs 续接链尾失败时就从这里开始分配, 之后每簇都能紧接上一簇.
+ *
+ * 位图只是提示, 分配仍由 FatFs 读 FAT 决定, 位图与 FAT 不一致只影响碎片程度.
+ * 能精确推断的分配 (连续落在预期区间) 直接记入位图, 其余情况标记过期重扫.
+ *
+ * 预分配是内存里的预留: 预留区在位图中记为已用, 重扫后重新叠加上去,
+ * 别的文件的分配起点绕开它; 磁盘上的 FAT 不变, 掉电时没有无主的簇链.
+ */
+
+#include "fatfs_alloc.h"
+
+// clang-format off
+#include <ff.h>      // 必须先于 diskio.h,定义 BYTE/UINT/LBA_t 等类型
+#include <diskio.h>
+// clang-format on
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <xnix/errno.h>
+
+#define ALLOC_SCAN_SECTORS 8  /* 扫描 FAT 时每次读入的扇区数 */
+#define ALLOC_RESV_MAX     16 /* 同时存在的预留区数 */
+
+/* 预留区: [start, start + count) 还没被持有者用到 */
+struct alloc_resv {
+    DWORD start;
+    DWORD count;
+    bool  used;
+};
+
+static struct {
+    FATFS    *fs;
+    uint32_t *bits;
+    DWORD     n_fatent;
+    DWORD     cursor;       /* 下次找连续区的起点 */
+    DWORD     expect_first; /* prepare 预期的第一个新簇, 0=无 */
+    bool      stale;        /* 可能把已用簇当作空闲, 使用前必须重扫 */
+    bool      freed;        /* 有簇被释放, 找不到够长的连续区时值得重扫 */
+    struct alloc_resv resv[ALLOC_RESV_MAX];
+} g_alloc;
+
+static uint8_t g_scan_buf[ALLOC_SCAN_SECTORS * FF_MAX_SS];
+
+static inline bool alloc_test(DWORD c) {
+    return g_alloc.bits[c >> 5] & (1u << (c & 31));
+}
+
+static inline void alloc_set(DWORD c) {
+    g_alloc.bits[c >> 5] |= 1u << (c & 31);
+}
+
+static inline void alloc_clear(DWORD c) {
+    g_alloc.bits[c >> 5] &= ~(1u << (c & 31));
+}
+
+/* 字节数换算为簇数 (向上取整, 不溢出) */
+static inline DWORD alloc_clusters(FSIZE_t size, DWORD cs) {
+    return size / cs + (size % cs ? 1 : 0);
+}
+
+/* 按 FAT 一个扇区的表项更新位图, first 为该扇区第一项的簇号 */
+static void alloc_scan_sector(const uint8_t *sec, DWORD first) {
+    bool  fat32 = g_alloc.fs->fs_type == FS_FAT32;
+    DWORD per   = fat32 ? FF_MAX_SS / 4 : FF_MAX_SS / 2;
+
+    for (DWORD i = 0; i < per && first + i < g_alloc.n_fatent; i++) {
+        DWORD val;
+        if (fat32) {
+            val = ((DWORD)sec[i * 4] | ((DWORD)sec[i * 4 + 1] << 8) |
+                   ((DWORD)sec[i * 4 + 2] << 16) | ((DWORD)sec[i * 4 + 3] << 24)) &
+                  0x0FFFFFFF;
+        } else {
+            val = (DWORD)sec[i * 2] | ((DWORD)sec[i * 2 + 1] << 8);
+        }
+        if (val) {
+            alloc_set(first + i);
+        } else {
+            alloc_clear(first + i);
+        }
+    }
+}
+
+static inline DWORD alloc_fat_per_sector(void) {
+    return g_alloc.fs->fs_type == FS_FAT32 ? FF_MAX_SS / 4 : FF_MAX_SS / 2;
+}
+
+/*
+ * 按 FAT 第 [from, from + nsect) 扇区更新位图, 之后补上保留项和预留区.
+ * FatFs 窗口中的 FAT 扇区可能尚未写回, 以窗口内容为准.
+ */
+static int alloc_scan_range(DWORD from, DWORD nsect) {
+    FATFS *fs  = g_alloc.fs;
+    DWORD  per = alloc_fat_per_sector();
+
+    for (DWORD s = from; s < from + nsect; s += ALLOC_SCAN_SECTORS) {
+        UINT n = from + nsect - s < ALLOC_SCAN_SECTORS ? from + nsect - s : ALLOC_SCAN_SECTORS;
+        if (disk_read(fs->pdrv, g_scan_buf, fs->fatbase + s, n) != RES_OK) {
+            return -EIO;
+        }
+        for (UINT i = 0; i < n; i++) {
+            const uint8_t *sec = g_scan_buf + i * FF_MAX_SS;
+            if (fs->winsect == fs->fatbase + s + i) {
+                sec = fs->win;
+            }
+            alloc_scan_sector(sec, (s + i) * per);
+        }
+    }
+
+    /* 簇 0/1 是保留项 */
+    alloc_set(0);
+    alloc_set(1);
+    for (int i = 0; i < ALLOC_RESV_MAX; i++) {
+        struct alloc_resv *r = &g_alloc.resv[i];
+        for (DWORD c = r->start; r->used && c < r->start + r->count; c++) {
+            alloc_set(c);
+        }
+    }
+    return 0;
+}
+
+/* 扫描整个 FAT */
+static int alloc_scan(void) {
+    DWORD per   = alloc_fat_per_sector();
+    DWORD nsect = (g_alloc.n_fatent + per - 1) / per;
+
+    if (nsect > g_alloc.fs->fsize) {
+        nsect = g_alloc.fs->fsize;
+    }
+
+    int ret = alloc_scan_range(0, nsect);
+    if (ret < 0) {
+        return ret;
+    }
+    g_alloc.stale = false;
+    g_alloc.freed = false;
+    return 0;
+}
+
+static bool alloc_ready(FATFS *fs) {
+    if (!g_alloc.bits || g_alloc.fs != fs) {
+        return false;
+    }
+    if (g_alloc.stale && alloc_scan() < 0) {
+        return false;
+    }
+    return true;
+}
+
+/*
+ * 从 cursor 开始找第一段长度 >= want 的空闲区, 没有则返回最长的一段
+ * 全 1 的字整体跳过. 返回起始簇, 长度写入 *got (0 表示没有空闲簇).
+ */
+static DWORD alloc_find_run(DWORD want, DWORD *got) {
+    DWORD n         = g_alloc.n_fatent;
+    DWORD total     = n - 2;
+    DWORD c         = g_alloc.cursor;
+    DWORD run_start = 0, run_len = 0;
+    DWORD best      = 0, best_len = 0;
+
+    if (c < 2 || c >= n) {
+        c = 2;
+    }
+
+    for (DWORD scanned = 0; scanned < total;) {
+        if ((c & 31) == 0 && c + 32 <= n && g_alloc.bits[c >> 5] == 0xFFFFFFFFu) {
+            if (run_len > best_len) {
+                best     = run_start;
+                best_len = run_len;
+            }
+            run_len = 0;
+            c += 32;
+            scanned += 32;
+        } else {
+            if (!alloc_test(c)) {
+                if (run_len == 0) {
+                    run_start = c;
+                }
+                if (++run_len >= want) {
+                    *got = run_len;
+                    return run_start;
+                }
+            } else {
+                if (run_len > best_len) {
+                    best     = run_start;
+                    best_len = run_len;
+                }
+                run_len = 0;
+            }
+            c++;
+            scanned++;
+        }
+
+        /* 连续区不跨越卷尾 */
+        if (c >= n) {
+            if (run_len > best_len) {
+                best     = run_start;
+                best_len = run_len;
+            }
+            run_len = 0;
+            c       = 2;
+        }
+    }
+
+    if (run_len > best_len) {
+        best     = run_start;
+        best_len = run_len;
+    }
+    *got = best_len;
+    return best;
+}
+
+/* 找连续区; 位图里的已用位可能已被释放时, 不够长就重扫一次再找 */
+static DWORD alloc_find(DWORD want, DWORD *got) {
+    DWORD start = alloc_find_run(want, got);
+    if (*got < want && g_alloc.freed && alloc_scan() == 0) {
+        start = alloc_find_run(want, got);
+    }
+    return start;
+}
+
+/* [start, start + count) 在位图中全部空闲 */
+static bool alloc_range_free(DWORD start, DWORD count) {
+    if (start < 2 || start + count > g_alloc.n_fatent) {
+        return false;
+    }
+    for (DWORD c = start; c < start + count; c++) {
+        if (alloc_test(c)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* 让 FatFs 从 start 开始找空闲簇 */
+static void alloc_point_fatfs(FATFS *fs, DWORD start) {
+    fs->last_clst = start - 1;
+}
+
+static void alloc_mark(DWORD start, DWORD count) {
+    for (DWORD c = start; c < start + count && c < g_alloc.n_fatent; c++) {
+        alloc_set(c);
+    }
+}
+
+static struct alloc_resv *alloc_resv_get(int resv) {
+    if (resv <= 0 || resv > ALLOC_RESV_MAX || !g_alloc.resv[resv - 1].used) {
+        return NULL;
+    }
+    return &g_alloc.resv[resv - 1];
+}
+
+int fatfs_alloc_init(FATFS *fs) {
+    free(g_alloc.bits);
+    memset(&g_alloc, 0, sizeof(g_alloc));
+
+    if (fs->fs_type != FS_FAT16 && fs->fs_type != FS_FAT32) {
+        return -ENODEV;
+    }
+
+    g_alloc.bits = calloc((fs->n_fatent + 31) / 32, sizeof(uint32_t));
+    if (!g_alloc.bits) {
+        return -ENOMEM;
+    }
+    g_alloc.fs       = fs;
+    g_alloc.n_fatent = fs->n_fatent;
+    g_alloc.cursor   = 2;
+
+    int ret = alloc_scan();
+    if (ret < 0) {
+        free(g_alloc.bits);
+        g_alloc.bits = NULL;
+    }
+    return ret;
+}
+
+void fatfs_alloc_invalidate(void) {
+    g_alloc.stale = true;
+}
+
+void fatfs_alloc_note_free(void) {
+    g_alloc.freed = true;
+}
+
+void fatfs_alloc_prepare(FIL *fp, FSIZE_t end, int resv) {
+    FATFS *fs = fp->obj.fs;
+
+    g_alloc.expect_first = 0;
+    if (!alloc_ready(fs)) {
+        return;
+    }
+
+    DWORD cs     = (DWORD)fs->csize * FF_MAX_SS;
+    DWORD old_cl = alloc_clusters(f_size(fp), cs);
+    DWORD new_cl = alloc_clusters(end, cs);
+    if (new_cl <= old_cl) {
+        return;
+    }
+
+    DWORD need = new_cl - old_cl;
+
+    /* 文件指针在末尾时 fp->clust 就是链尾, FatFs 总是先尝试续接链尾 */
+    bool tail_known = old_cl > 0 && fp->fptr == f_size(fp);
+    bool tail_free  = tail_known && fp->clust + 1 < g_alloc.n_fatent && !alloc_test(fp->clust + 1);
+    if (tail_free && alloc_range_free(fp->clust + 1, need)) {
+        g_alloc.expect_first = fp->clust + 1;
+        return;
+    }
+
+    /* 有预留区就从区首取; 链尾紧挨区首时 FatFs 续接链尾也落在区里 */
+    struct alloc_resv *r = alloc_resv_get(resv);
+    DWORD              start;
+    if (r && r->count > 0) {
+        start = r->start;
+    } else {
+        DWORD got;
+        start = alloc_find(need, &got);
+        if (got == 0) {
+            return;
+        }
+    }
+    alloc_point_fatfs(fs, start);
+
+    /* 续接失败才会跳到 start; 链尾未知或后面还有零星空闲簇时无法预期起点 */
+    if (old_cl == 0 || (tail_known && !tail_free)) {
+        g_alloc.expect_first = start;
+    }
+}
+
+void fatfs_alloc_commit(FIL *fp, FSIZE_t old_size, int resv) {
+    FATFS *fs = fp->obj.fs;
+
+    if (!g_alloc.bits || g_alloc.fs != fs || g_alloc.stale) {
+        return;
+    }
+
+    DWORD cs     = (DWORD)fs->csize * FF_MAX_SS;
+    DWORD old_cl = alloc_clusters(old_size, cs);
+    DWORD new_cl = alloc_clusters(f_size(fp), cs);
+    if (new_cl <= old_cl) {
+        return;
+    }
+
+    /*
+     * FatFs 从起点单调向后找空闲簇: 分配了 n 簇且末簇恰为 first + n - 1,
+     * 说明这 n 簇正好占满 [first, first + n).
+     */
+    DWORD n     = new_cl - old_cl;
+    DWORD first = g_alloc.expect_first;
+    if (first && fp->fptr == f_size(fp) && fp->clust == first + n - 1) {
+        alloc_mark(first, n);
+        g_alloc.cursor = first + n;
+    } else {
+        g_alloc.stale = true;
+    }
+    g_alloc.expect_first = 0;
+
+    /* 预留区里链尾之前的簇已经用掉 */
+    struct alloc_resv *r = alloc_resv_get(resv);
+    if (r && fp->clust >= r->start && fp->clust < r->start + r->count) {
+        r->count -= fp->clust + 1 - r->start;
+        r->start  = fp->clust + 1;
+    }
+}
+
+int fatfs_alloc_reserve(FATFS *fs, DWORD clusters) {
+    if (!alloc_ready(fs)) {
+        return -ENODEV;
+    }
+
+    int slot = -1;
+    for (int i = 0; i < ALLOC_RESV_MAX; i++) {
+        if (!g_alloc.resv[i].used) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot < 0) {
+        return -EBUSY;
+    }
+
+    DWORD got;
+    DWORD start = alloc_find(clusters, &got);
+    if (got < clusters) {
+        return -ENOSPC;
+    }
+
+    g_alloc.resv[slot].start = start;
+    g_alloc.resv[slot].count = clusters;
+    g_alloc.resv[slot].used  = true;
+    alloc_mark(start, clusters);
+    g_alloc.cursor = start + clusters;
+    return slot + 1;
+}
+
+void fatfs_alloc_unreserve(int resv) {
+    struct alloc_resv *r = alloc_resv_get(resv);
+    if (!r) {
+        return;
+    }
+
+    DWORD start = r->start;
+    DWORD count = r->count;
+    r->used     = false;
+    if (count == 0 || g_alloc.stale) {
+        return;
+    }
+
+    /* 区里的簇可能已被别的文件续接链尾占用, 按 FAT 重读这一段再放开 */
+    DWORD per   = alloc_fat_per_sector();
+    DWORD first = start / per;
+    if (alloc_scan_range(first, (start + count - 1) / per - first + 1) < 0) {
+        g_alloc.stale = true;
+    }
+}
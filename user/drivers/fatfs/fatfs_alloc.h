@@ -0,0 +1,64 @@
+/**
+ * @file fatfs_alloc.h
+ * @brief FAT 空闲簇位图与连续分配提示
+ */
+
+#ifndef FATFS_ALLOC_H
+#define FATFS_ALLOC_H
+
+#include <ff.h>
+
+/**
+ * 扫描 FAT 建立空闲簇位图 (挂载后调用)
+ * 只支持 FAT16/FAT32, 其他类型不建位图, 分配完全交给 FatFs.
+ * @return 0 成功，负数错误码
+ */
+int fatfs_alloc_init(FATFS *fs);
+
+/**
+ * 簇经写文件以外的路径分配 (建目录等) 后调用
+ * 位图标记为过期, 下次使用前重新扫描.
+ */
+void fatfs_alloc_invalidate(void);
+
+/**
+ * 簇被释放 (删除, 截断) 后调用
+ * 位图偏保守仍可用, 找不到够长的连续区时才重新扫描.
+ */
+void fatfs_alloc_note_free(void);
+
+/**
+ * 扩展写之前调用: 为将要分配的簇挑选连续空闲区, 并设为 FatFs 的分配起点
+ *
+ * @param fp   已打开的文件
+ * @param end  写入结束后的文件大小
+ * @param resv 文件持有的预留编号, 0=无
+ */
+void fatfs_alloc_prepare(FIL *fp, FSIZE_t end, int resv);
+
+/**
+ * 扩展写之后调用: 把新分配的簇记入位图
+ *
+ * @param fp       已写入的文件 (文件指针在写入结束处)
+ * @param old_size 写入前的文件大小
+ * @param resv     文件持有的预留编号, 0=无
+ */
+void fatfs_alloc_commit(FIL *fp, FSIZE_t old_size, int resv);
+
+/**
+ * 为一个文件预留一段不短于 clusters 的连续空闲区
+ *
+ * 只在内存里预留: 位图中记为已用, 别的文件的分配绕开它, 磁盘上的 FAT
+ * 和目录项不变. 持有者的扩展写经 prepare/commit 依次从区首取簇.
+ *
+ * @return 预留编号 (>0)，-ENOSPC 没有足够长的连续区，-ENODEV 无位图，
+ *         -EBUSY 预留区已满
+ */
+int fatfs_alloc_reserve(FATFS *fs, DWORD clusters);
+
+/**
+ * 归还预留区中还没用到的簇 (文件关闭时调用)
+ */
+void fatfs_alloc_unreserve(int resv);
+
+#endif /* FATFS_ALLOC_H */
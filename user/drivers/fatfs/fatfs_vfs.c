@@ -3,16 +3,37 @@
  * @brief FatFs VFS 接口实现
  *
  * 将 VFS 操作映射到 FatFs API
+ *
+ * 大文件读取使用 FatFs fast seek: 首次读时按簇链建 CLMT (碎片列表),
+ * 之后 f_lseek/f_read 按表定位, 不再从文件头沿 FAT 链逐簇遍历.
+ * fast seek 模式下文件不能增长, 扩展写之前先拆掉 CLMT, 下次读时重建.
+ *
+ * 扩展写之前按空闲簇位图给 FatFs 指定连续的分配起点 (见 fatfs_alloc.c),
+ * 大文件顺序写入后簇链基本连续, CLMT 也只有一两项.
+ *
+ * 客户端可以给文件会话绑定一块共享内存窗口 (IO_WIN_*), f_read/f_write
+ * 直接读写窗口, 一次跨多个簇, IPC 只带偏移和完成字节数.
+ *
+ * 文件映射 (IO_MAP) 时另开一个只供内核取页/写回的缓页会话, 文件以首簇号标识.
+ * 读过的整页同时交给内核页缓存, 客户端会话登记后重复读直接命中内核缓存.
+ * 写入时按首簇号作废缓存. 删除和截断会释放簇, 首簇号可能被新文件复用,
+ * 这时递增全局版本, 之前的缓存和登记都不再匹配.
  */
 
+#include "fatfs_alloc.h"
 #include "fatfs_vfs.h"
 
+#include <stdbool.h>
+#include <stdlib.h>
 #include <string.h>
 #include <xnix/abi/io.h>
 #include <xnix/errno.h>
 #include <xnix/protocol/vfs.h>
 #include <xnix/syscall.h>
 
+/* 内容版本: 截断/删除 (簇被释放) 时递增, 见 IO_MAP 和内核页缓存 */
+static uint32_t g_fatfs_version = 1;
+
 /* FatFs 错误码转换为 errno */
 static int fresult_to_errno(FRESULT res) {
     switch (res) {
@@ -77,6 +98,37 @@ static struct fatfs_handle *fatfs_get_file_handle(struct fatfs_ctx *ctx, uint32_
     return handle;
 }
 
+/* 内核页缓存: 以 main_ep 为缓存 endpoint, 首簇号为文件标识 (与 IO_MAP 一致) */
+static void fatfs_cache_ctl(struct fatfs_ctx *ctx, struct abi_fcache_args *args) {
+    if (ctx->main_ep == HANDLE_INVALID || args->key == 0) {
+        return; /* 空文件没有首簇 */
+    }
+    args->cache_ep = ctx->main_ep;
+    sys_fcache_ctl(args);
+}
+
+/* 把读出的整页交给内核页缓存, 不覆盖整页 (也不到文件末尾) 的读不填 */
+static void fatfs_cache_fill(struct fatfs_ctx *ctx, struct fatfs_handle *handle, const void *buf,
+                             uint32_t offset, uint32_t size) {
+    uint32_t fsize = (uint32_t)f_size(&handle->obj.file);
+    uint32_t end   = offset + size;
+    uint32_t first = (offset + ABI_FCACHE_PAGE_SIZE - 1) & ~(ABI_FCACHE_PAGE_SIZE - 1);
+    if (handle->pager || first >= end || (end - first < ABI_FCACHE_PAGE_SIZE && end != fsize)) {
+        return;
+    }
+
+    struct abi_fcache_args args = {
+        .op        = ABI_FCACHE_FILL,
+        .key       = (uint32_t)handle->obj.file.obj.sclust,
+        .version   = g_fatfs_version,
+        .file_size = fsize,
+        .offset    = offset,
+        .len       = size,
+        .buf       = (uint32_t)(uintptr_t)buf,
+    };
+    fatfs_cache_ctl(ctx, &args);
+}
+
 /* 分配句柄 */
 static int alloc_handle(struct fatfs_ctx *ctx) {
     for (int i = 0; i < FATFS_MAX_HANDLES; i++) {
@@ -87,6 +139,7 @@ static int alloc_handle(struct fatfs_ctx *ctx) {
             }
             memset(&ctx->handles[i], 0, sizeof(ctx->handles[i]));
             ctx->handles[i].file_ep = HANDLE_INVALID;
+            ctx->handles[i].win_shm = HANDLE_INVALID;
             ctx->handles[i].generation = generation;
             ctx->handles[i].in_use = 1;
             return i;
@@ -95,9 +148,80 @@ static int alloc_handle(struct fatfs_ctx *ctx) {
     return -1;
 }
 
+/* 拆除 CLMT, 文件回到普通 (沿 FAT 链) 定位方式 */
+static void fatfs_clmt_drop(struct fatfs_handle *handle) {
+    handle->obj.file.cltbl = NULL;
+    free(handle->clmt);
+    handle->clmt      = NULL;
+    handle->clmt_skip = 0;
+}
+
+/*
+ * 为大文件建 CLMT
+ * 表长先按 32 项试, 不够时 FatFs 在 tbl[0] 返回所需项数, 按需扩大重建.
+ */
+static void fatfs_clmt_build(struct fatfs_handle *handle) {
+    FIL *fp = &handle->obj.file;
+
+    if (handle->clmt || handle->clmt_skip) {
+        return;
+    }
+
+    FSIZE_t cluster_bytes = (FSIZE_t)fp->obj.fs->csize * FF_MAX_SS;
+    if (f_size(fp) <= cluster_bytes * FATFS_CLMT_MIN_CLUSTERS) {
+        handle->clmt_skip = 1;
+        return;
+    }
+
+    DWORD len = 32;
+    while (len <= FATFS_CLMT_MAX_ITEMS) {
+        DWORD *tbl = malloc(len * sizeof(DWORD));
+        if (!tbl) {
+            break;
+        }
+        tbl[0]    = len;
+        fp->cltbl = tbl;
+
+        FRESULT res = f_lseek(fp, CREATE_LINKMAP);
+        if (res == FR_OK) {
+            handle->clmt = tbl;
+            return;
+        }
+
+        fp->cltbl = NULL;
+        DWORD need = tbl[0];
+        free(tbl);
+        if (res != FR_NOT_ENOUGH_CORE || need <= len) {
+            break;
+        }
+        len = need;
+    }
+
+    handle->clmt_skip = 1;
+}
+
+/* 解除会话上的客户端窗口 */
+static void fatfs_win_detach(struct fatfs_handle *handle) {
+    if (handle->win) {
+        sys_munmap(handle->win, handle->win_size);
+        handle->win = NULL;
+    }
+    if (handle->win_shm != HANDLE_INVALID) {
+        sys_handle_close(handle->win_shm);
+        handle->win_shm = HANDLE_INVALID;
+    }
+    handle->win_size = 0;
+}
+
 /* 释放句柄 */
 static void free_handle(struct fatfs_ctx *ctx, uint32_t h) {
     if (h < FATFS_MAX_HANDLES) {
+        if (ctx->handles[h].type == 0) {
+            fatfs_clmt_drop(&ctx->handles[h]);
+            fatfs_win_detach(&ctx->handles[h]);
+            fatfs_alloc_unreserve(ctx->handles[h].resv);
+            ctx->handles[h].resv = 0;
+        }
         ctx->handles[h].file_ep = HANDLE_INVALID;
         ctx->handles[h].in_use = 0;
     }
@@ -161,6 +285,10 @@ static int fatfs_open(void *ctx, const char *path, uint32_t flags, handle_t *out
         free_handle(fctx, h);
         return fresult_to_errno(res);
     }
+    if (mode & FA_CREATE_ALWAYS) {
+        fatfs_alloc_note_free(); /* 已有文件被截断 */
+        g_fatfs_version++;
+    }
 
     strncpy(handle->path, path, sizeof(handle->path) - 1);
     handle->type    = 0; /* file */
@@ -169,7 +297,18 @@ static int fatfs_open(void *ctx, const char *path, uint32_t flags, handle_t *out
     if (out_ep) {
         *out_ep = HANDLE_INVALID;
     }
-    return (int)fatfs_make_file_session(handle, (uint32_t)h);
+
+    /* 客户端之后的读先查内核页缓存 */
+    uint32_t               session = fatfs_make_file_session(handle, (uint32_t)h);
+    struct abi_fcache_args args    = {
+        .op      = ABI_FCACHE_BIND,
+        .key     = (uint32_t)handle->obj.file.obj.sclust,
+        .ep      = fctx->main_ep,
+        .session = session,
+        .version = g_fatfs_version,
+    };
+    fatfs_cache_ctl(fctx, &args);
+    return (int)session;
 }
 
 /* 关闭文件 */
@@ -183,6 +322,15 @@ static int fatfs_close(void *ctx, uint32_t h) {
 
     FRESULT res;
     if (handle->type == 0) {
+        if (!handle->pager) {
+            struct abi_fcache_args args = {
+                .op      = ABI_FCACHE_UNBIND,
+                .key     = (uint32_t)handle->obj.file.obj.sclust,
+                .ep      = fctx->main_ep,
+                .session = fatfs_make_file_session(handle, h),
+            };
+            fatfs_cache_ctl(fctx, &args);
+        }
         res = f_close(&handle->obj.file);
     } else {
         res = f_closedir(&handle->obj.dir);
@@ -201,6 +349,9 @@ static int fatfs_read(void *ctx, uint32_t h, void *buf, uint32_t offset, uint32_
         return -EBADF;
     }
 
+    /* 大文件走 fast seek, 定位与跨簇读都不再遍历 FAT 链 */
+    fatfs_clmt_build(handle);
+
     /* 移动到指定偏移 */
     FRESULT res = f_lseek(&handle->obj.file, offset);
     if (res != FR_OK) {
@@ -213,6 +364,7 @@ static int fatfs_read(void *ctx, uint32_t h, void *buf, uint32_t offset, uint32_
         return fresult_to_errno(res);
     }
 
+    fatfs_cache_fill(fctx, handle, buf, offset, br);
     return (int)br;
 }
 
@@ -230,6 +382,17 @@ static int fatfs_write(void *ctx, uint32_t h, const void *buf, uint32_t offset,
         offset = f_size(&handle->obj.file);
     }
 
+    /*
+     * 会扩展文件的写: fast seek 模式不能分配新簇, 先拆掉 CLMT;
+     * 再按位图选好连续区 (lseek 越过文件尾时也会分配, 所以在 lseek 之前)
+     */
+    FSIZE_t old_size = f_size(&handle->obj.file);
+    bool    extend   = (FSIZE_t)offset + size > old_size;
+    if (extend) {
+        fatfs_clmt_drop(handle);
+        fatfs_alloc_prepare(&handle->obj.file, (FSIZE_t)offset + size, handle->resv);
+    }
+
     /* 移动到指定偏移 */
     FRESULT res = f_lseek(&handle->obj.file, offset);
     if (res != FR_OK) {
@@ -238,6 +401,22 @@ static int fatfs_write(void *ctx, uint32_t h, const void *buf, uint32_t offset,
 
     UINT bw;
     res = f_write(&handle->obj.file, buf, size, &bw);
+    if (extend) {
+        fatfs_alloc_commit(&handle->obj.file, old_size, handle->resv);
+    }
+    /* 写成功时缓存页就地更新, 映射者随之看到; 写失败时内容不确定, 整份作废 */
+    if (!handle->pager && (bw > 0 || res != FR_OK)) {
+        struct abi_fcache_args args = {
+            .op        = res == FR_OK ? ABI_FCACHE_UPDATE : ABI_FCACHE_INVAL,
+            .key       = (uint32_t)handle->obj.file.obj.sclust,
+            .version   = g_fatfs_version,
+            .file_size = (uint32_t)f_size(&handle->obj.file),
+            .offset    = offset,
+            .len       = bw,
+            .buf       = (uint32_t)(uintptr_t)buf,
+        };
+        fatfs_cache_ctl(fctx, &args);
+    }
     if (res != FR_OK) {
         return fresult_to_errno(res);
     }
@@ -268,6 +447,29 @@ static int fatfs_info(void *ctx, const char *path, struct vfs_info *info) {
     return 0;
 }
 
+/* 一次读出文件开头: 临时打开, 读完即关, 不占用句柄槽位 */
+static int fatfs_readfile(void *ctx, const char *path, void *buf, uint32_t size,
+                          struct vfs_info *info) {
+    static FIL fil;
+    (void)ctx;
+
+    FRESULT res = f_open(&fil, path, FA_READ);
+    if (res != FR_OK) {
+        return fresult_to_errno(res);
+    }
+
+    UINT br    = 0;
+    res        = f_read(&fil, buf, size, &br);
+    info->type = VFS_TYPE_FILE;
+    info->size = (uint32_t)f_size(&fil);
+    f_close(&fil);
+
+    if (res != FR_OK) {
+        return fresult_to_errno(res);
+    }
+    return (int)br;
+}
+
 /* 打开目录 */
 static int fatfs_opendir(void *ctx, const char *path) {
     struct fatfs_ctx *fctx = (struct fatfs_ctx *)ctx;
@@ -291,21 +493,15 @@ static int fatfs_opendir(void *ctx, const char *path) {
     return h;
 }
 
-/* 读取目录项 */
-static int fatfs_readdir(void *ctx, uint32_t h, uint32_t index, struct vfs_dirent *entry) {
-    struct fatfs_ctx    *fctx   = (struct fatfs_ctx *)ctx;
-    struct fatfs_handle *handle = get_handle(fctx, h);
-
-    if (!handle || handle->type != 1) {
-        return -EBADF;
+/* 把目录读取位置移到第 index 项; 顺序读取时接着上次的位置, 不必从头跳过 */
+static int fatfs_dir_seek(struct fatfs_handle *handle, uint32_t index) {
+    if (handle->dir_index > index) {
+        f_rewinddir(&handle->obj.dir);
+        handle->dir_index = 0;
     }
 
-    /* 重置目录读取位置 */
-    f_rewinddir(&handle->obj.dir);
-
-    /* 跳过前 index 项 */
     FILINFO fno = {0};
-    for (uint32_t i = 0; i <= index; i++) {
+    while (handle->dir_index < index) {
         FRESULT res = f_readdir(&handle->obj.dir, &fno);
         if (res != FR_OK) {
             return fresult_to_errno(res);
@@ -313,21 +509,80 @@ static int fatfs_readdir(void *ctx, uint32_t h, uint32_t index, struct vfs_diren
         if (fno.fname[0] == '\0') {
             return -ENOENT; /* 没有更多项 */
         }
+        handle->dir_index++;
+    }
+    return 0;
+}
+
+/* 读取当前位置的一项 */
+static int fatfs_dir_next(struct fatfs_handle *handle, struct vfs_dirent *entry) {
+    FILINFO fno = {0};
+    FRESULT res = f_readdir(&handle->obj.dir, &fno);
+    if (res != FR_OK) {
+        return fresult_to_errno(res);
+    }
+    if (fno.fname[0] == '\0') {
+        return -ENOENT;
     }
+    handle->dir_index++;
 
     entry->type = (fno.fattrib & AM_DIR) ? VFS_TYPE_DIR : VFS_TYPE_FILE;
     entry->size = fno.fsize;
     strncpy(entry->name, fno.fname, VFS_NAME_MAX - 1);
     entry->name[VFS_NAME_MAX - 1] = '\0';
-
     return 0;
 }
 
+/* 读取目录项 */
+static int fatfs_readdir(void *ctx, uint32_t h, uint32_t index, struct vfs_dirent *entry) {
+    struct fatfs_ctx    *fctx   = (struct fatfs_ctx *)ctx;
+    struct fatfs_handle *handle = get_handle(fctx, h);
+
+    if (!handle || handle->type != 1) {
+        return -EBADF;
+    }
+
+    int ret = fatfs_dir_seek(handle, index);
+    if (ret < 0) {
+        return ret;
+    }
+    return fatfs_dir_next(handle, entry);
+}
+
+/* 批量读取目录项 */
+static int fatfs_getdents(void *ctx, uint32_t h, uint32_t index, struct vfs_dirent *entries,
+                          uint32_t max) {
+    struct fatfs_ctx    *fctx   = (struct fatfs_ctx *)ctx;
+    struct fatfs_handle *handle = get_handle(fctx, h);
+
+    if (!handle || handle->type != 1) {
+        return -EBADF;
+    }
+
+    int ret = fatfs_dir_seek(handle, index);
+    if (ret < 0) {
+        return ret == -ENOENT ? 0 : ret;
+    }
+
+    uint32_t n = 0;
+    while (n < max) {
+        ret = fatfs_dir_next(handle, &entries[n]);
+        if (ret < 0) {
+            break;
+        }
+        n++;
+    }
+    return n > 0 || ret == -ENOENT ? (int)n : ret;
+}
+
 /* 创建目录 */
 static int fatfs_mkdir(void *ctx, const char *path) {
     (void)ctx;
 
     FRESULT res = f_mkdir(path);
+    if (res == FR_OK) {
+        fatfs_alloc_invalidate(); /* 目录簇不经位图分配 */
+    }
     return fresult_to_errno(res);
 }
 
@@ -336,6 +591,10 @@ static int fatfs_del(void *ctx, const char *path) {
     (void)ctx;
 
     FRESULT res = f_unlink(path);
+    if (res == FR_OK) {
+        fatfs_alloc_note_free();
+        g_fatfs_version++; /* 首簇号可能被新文件复用 */
+    }
     return fresult_to_errno(res);
 }
 
@@ -347,20 +606,86 @@ static int fatfs_rename(void *ctx, const char *old_path, const char *new_path) {
     return fresult_to_errno(res);
 }
 
+/* 服务端复制的中转缓冲区, 比 IPC 一次能带的数据大, 读写都按簇连续进行 */
+#define FATFS_COPY_BUF_SIZE (32 * 1024)
+static uint8_t g_copy_buf[FATFS_COPY_BUF_SIZE];
+
+/* 复制文件: 会话层读写, 沿用页缓存, 位图分配和预分配 */
+static int fatfs_copy(void *ctx, const char *src_path, const char *dst_path) {
+    struct fatfs_ctx *fctx = (struct fatfs_ctx *)ctx;
+
+    int src = fatfs_open(ctx, src_path, VFS_O_RDONLY, NULL);
+    if (src < 0) {
+        return src;
+    }
+    FIL *sf = &fatfs_get_file_handle(fctx, (uint32_t)src, NULL)->obj.file;
+
+    /* 目标就是源文件时截断会先清掉源, 按目录项位置判断 */
+    int ret = fatfs_open(ctx, dst_path, VFS_O_RDONLY, NULL);
+    if (ret >= 0) {
+        FIL *df   = &fatfs_get_file_handle(fctx, (uint32_t)ret, NULL)->obj.file;
+        bool same = df->dir_sect == sf->dir_sect && df->dir_ptr == sf->dir_ptr;
+        fatfs_close(ctx, (uint32_t)ret & FATFS_FILE_SESSION_SLOT_MASK);
+        if (same) {
+            fatfs_close(ctx, (uint32_t)src & FATFS_FILE_SESSION_SLOT_MASK);
+            return -EINVAL;
+        }
+    }
+
+    int dst = fatfs_open(ctx, dst_path, VFS_O_WRONLY | VFS_O_CREAT | VFS_O_TRUNC, NULL);
+    if (dst < 0) {
+        fatfs_close(ctx, (uint32_t)src & FATFS_FILE_SESSION_SLOT_MASK);
+        return dst;
+    }
+
+    uint32_t size = (uint32_t)f_size(sf);
+    if (size > 0) {
+        fatfs_prealloc(fctx, (uint32_t)dst, size);
+    }
+
+    uint32_t off = 0;
+    ret          = 0;
+    while (1) {
+        int n = fatfs_read(ctx, (uint32_t)src, g_copy_buf, off, FATFS_COPY_BUF_SIZE);
+        if (n <= 0) {
+            ret = n;
+            break;
+        }
+        int w = fatfs_write(ctx, (uint32_t)dst, g_copy_buf, off, (uint32_t)n);
+        if (w != n) {
+            ret = w < 0 ? w : -ENOSPC;
+            break;
+        }
+        off += (uint32_t)n;
+    }
+
+    /* 目标关闭时才刷目录项, 失败要报给调用者 */
+    int cret = fatfs_close(ctx, (uint32_t)dst & FATFS_FILE_SESSION_SLOT_MASK);
+    fatfs_close(ctx, (uint32_t)src & FATFS_FILE_SESSION_SLOT_MASK);
+    if (ret == 0 && cret < 0) {
+        ret = cret;
+    }
+    return ret < 0 ? ret : (int)off;
+}
+
 /* VFS 操作表(命名空间 + 目录 close,文件 IO 通过 file_ep 处理) */
 static struct vfs_operations g_fatfs_ops = {
-    .open    = fatfs_open,
-    .close   = fatfs_close,
-    .info    = fatfs_info,
-    .opendir = fatfs_opendir,
-    .readdir = fatfs_readdir,
-    .mkdir   = fatfs_mkdir,
-    .del     = fatfs_del,
-    .rename  = fatfs_rename,
+    .open     = fatfs_open,
+    .close    = fatfs_close,
+    .info     = fatfs_info,
+    .opendir  = fatfs_opendir,
+    .readdir  = fatfs_readdir,
+    .getdents = fatfs_getdents,
+    .mkdir    = fatfs_mkdir,
+    .del      = fatfs_del,
+    .rename   = fatfs_rename,
+    .readfile = fatfs_readfile,
+    .copy     = fatfs_copy,
 };
 
 int fatfs_init(struct fatfs_ctx *ctx) {
     memset(ctx, 0, sizeof(*ctx));
+    ctx->main_ep = HANDLE_INVALID;
 
     /* 挂载文件系统 (volume "0:", FF_VOLUMES=1) */
     FRESULT res = f_mount(&ctx->fs, "", 1);
@@ -369,9 +694,49 @@ int fatfs_init(struct fatfs_ctx *ctx) {
     }
 
     ctx->mounted = 1;
+
+    /* 位图建不起来 (FAT12, 内存不足) 时分配完全交给 FatFs */
+    fatfs_alloc_init(&ctx->fs);
     return 0;
 }
 
+int fatfs_prealloc(struct fatfs_ctx *ctx, uint32_t session, uint32_t size) {
+    struct fatfs_handle *handle = fatfs_get_file_handle(ctx, session, NULL);
+    if (!handle) {
+        return -EBADF;
+    }
+
+    FIL *fp = &handle->obj.file;
+    if (!(fp->flag & FA_WRITE)) {
+        return -EBADF;
+    }
+    if (size == 0) {
+        return -EINVAL;
+    }
+
+    DWORD cs   = (DWORD)fp->obj.fs->csize * FF_MAX_SS;
+    DWORD have = (DWORD)(f_size(fp) / cs + (f_size(fp) % cs ? 1 : 0));
+    DWORD want = size / cs + (size % cs ? 1 : 0);
+    if (want <= have) {
+        return 0;
+    }
+
+    /*
+     * 只在内存里预留 (见 fatfs_alloc_reserve): 不往磁盘写簇链, 文件大小始终是
+     * 实际写入的长度, 中途掉电也不会留下无主的簇. 没有够长的连续区时不预留,
+     * 扩展写按各自的长度找连续区.
+     */
+    fatfs_alloc_unreserve(handle->resv);
+    handle->resv = 0;
+
+    int resv = fatfs_alloc_reserve(fp->obj.fs, want - have);
+    if (resv < 0) {
+        return 0;
+    }
+    handle->resv = resv;
+    return 1;
+}
+
 struct vfs_operations *fatfs_get_ops(void) {
     return &g_fatfs_ops;
 }
@@ -386,6 +751,171 @@ handle_t fatfs_get_file_ep(struct fatfs_ctx *ctx, int slot) {
 #define FILE_EP_BUF_SIZE 4096
 static char g_file_ep_buf[FILE_EP_BUF_SIZE];
 
+/*
+ * 文件 -> 管道
+ * 读出的数据若没能全部写进管道, 只计已写入部分; 剩余部分下次按偏移重读.
+ */
+static int fatfs_splice_out(struct fatfs_ctx *ctx, uint32_t session, handle_t pipe_h,
+                            uint32_t offset, uint32_t size) {
+    uint32_t total = 0;
+
+    while (total < size) {
+        uint32_t chunk = size - total;
+        if (chunk > FILE_EP_BUF_SIZE) chunk = FILE_EP_BUF_SIZE;
+
+        int n = fatfs_read(ctx, session, g_file_ep_buf, offset + total, chunk);
+        if (n <= 0) {
+            if (total > 0) break;
+            return n;
+        }
+
+        int w = sys_pipe_write_flags(pipe_h, g_file_ep_buf, (uint32_t)n, ABI_PIPE_NONBLOCK);
+        if (w < 0) {
+            return total > 0 ? (int)total : -errno;
+        }
+        total += (uint32_t)w;
+        if (w < n) break;
+    }
+
+    return (int)total;
+}
+
+/* 管道 -> 文件: 管道读空即返回 */
+static int fatfs_splice_in(struct fatfs_ctx *ctx, uint32_t session, handle_t pipe_h,
+                           uint32_t offset, uint32_t size) {
+    uint32_t total = 0;
+
+    while (total < size) {
+        uint32_t chunk = size - total;
+        if (chunk > FILE_EP_BUF_SIZE) chunk = FILE_EP_BUF_SIZE;
+
+        int n = sys_pipe_read_flags(pipe_h, g_file_ep_buf, chunk, ABI_PIPE_NONBLOCK);
+        if (n <= 0) {
+            if (total > 0) break;
+            return n < 0 ? -errno : 0;
+        }
+
+        int w = fatfs_write(ctx, session, g_file_ep_buf, offset + total, (uint32_t)n);
+        if (w < 0) {
+            return total > 0 ? (int)total : w;
+        }
+        total += (uint32_t)w;
+        if (w < n) break;
+    }
+
+    return (int)total;
+}
+
+/* 把客户端窗口映射进来并绑定到会话, 已有窗口先解除 */
+static int fatfs_win_attach(struct fatfs_ctx *ctx, uint32_t session, handle_t shm,
+                            uint32_t size) {
+    struct fatfs_handle *handle = fatfs_get_file_handle(ctx, session, NULL);
+    if (!handle) {
+        sys_handle_close(shm);
+        return -EBADF;
+    }
+    if (size == 0 || size > FATFS_WIN_MAX) {
+        sys_handle_close(shm);
+        return -EINVAL;
+    }
+
+    fatfs_win_detach(handle);
+
+    uint32_t mapped = 0;
+    void    *addr   = sys_mmap_phys(shm, 0, size, 0x03, &mapped);
+    if (addr == (void *)-1) {
+        int err = -errno;
+        sys_handle_close(shm);
+        return err;
+    }
+    if (mapped < size) {
+        sys_munmap(addr, mapped);
+        sys_handle_close(shm);
+        return -EINVAL;
+    }
+
+    handle->win      = addr;
+    handle->win_shm  = shm;
+    handle->win_size = size;
+    return 0;
+}
+
+/* IO_MAP: 在同一文件上另开一个缓页会话 */
+static int fatfs_map(struct fatfs_ctx *ctx, const struct ipc_message *msg,
+                     struct ipc_message *reply) {
+    if (!(msg->flags & ABI_IPC_FLAG_KERNEL)) {
+        return -EPERM;
+    }
+    struct fatfs_handle *handle = fatfs_get_file_handle(ctx, msg->regs.data[1], NULL);
+    if (!handle) {
+        return -EBADF;
+    }
+    if (handle->obj.file.obj.sclust == 0) {
+        return -ENXIO; /* 空文件没有可映射的内容 */
+    }
+
+    int p = alloc_handle(ctx);
+    if (p < 0) {
+        return -EMFILE;
+    }
+    struct fatfs_handle *pager = &ctx->handles[p];
+    BYTE mode = (handle->flags & 0x03) == VFS_O_RDONLY ? FA_READ : FA_READ | FA_WRITE;
+
+    FRESULT res = f_open(&pager->obj.file, handle->path, mode);
+    if (res != FR_OK) {
+        free_handle(ctx, (uint32_t)p);
+        return fresult_to_errno(res);
+    }
+    memcpy(pager->path, handle->path, sizeof(pager->path));
+    pager->type  = 0;
+    pager->flags = handle->flags & 0x03;
+    pager->pager = 1;
+
+    reply->regs.data[1] = fatfs_make_file_session(pager, (uint32_t)p);
+    reply->regs.data[2] = (uint32_t)pager->obj.file.obj.sclust;
+    reply->regs.data[3] = (uint32_t)f_size(&pager->obj.file);
+    reply->regs.data[4] = g_fatfs_version;
+    return 0;
+}
+
+/* IO_PAGE_IN/IO_PAGE_OUT: 只接受内核在缓页会话上发来的请求 */
+static int fatfs_page_io(struct fatfs_ctx *ctx, uint32_t op, const struct ipc_message *msg,
+                         struct ipc_message *reply) {
+    uint32_t session = msg->regs.data[1];
+    uint32_t offset  = msg->regs.data[2];
+    uint32_t size    = msg->regs.data[3];
+
+    if (!(msg->flags & ABI_IPC_FLAG_KERNEL)) {
+        return -EPERM;
+    }
+    struct fatfs_handle *handle = fatfs_get_file_handle(ctx, session, NULL);
+    if (!handle || !handle->pager) {
+        return -EBADF;
+    }
+    if (size > FILE_EP_BUF_SIZE) size = FILE_EP_BUF_SIZE;
+
+    if (op == IO_PAGE_IN) {
+        int n = fatfs_read(ctx, session, g_file_ep_buf, offset, size);
+        if (n > 0) {
+            reply->buffer.data = (uint64_t)(uintptr_t)g_file_ep_buf;
+            reply->buffer.size = (uint32_t)n;
+        }
+        return n;
+    }
+
+    /* 写回不扩展文件 */
+    uint32_t fsize = (uint32_t)f_size(&handle->obj.file);
+    if (!msg->buffer.data || size > msg->buffer.size) {
+        return -EINVAL;
+    }
+    if (offset >= fsize) {
+        return 0;
+    }
+    if (size > fsize - offset) size = fsize - offset;
+    memcpy(g_file_ep_buf, (const void *)(uintptr_t)msg->buffer.data, size);
+    return fatfs_write(ctx, session, g_file_ep_buf, offset, size);
+}
+
 int fatfs_file_ep_dispatch(struct fatfs_ctx *ctx, int slot, struct ipc_message *msg) {
     (void)slot;
     uint32_t op = msg->regs.data[0];
@@ -412,18 +942,38 @@ int fatfs_file_ep_dispatch(struct fatfs_ctx *ctx, int slot, struct ipc_message *
     }
     case IO_WRITE: {
         uint32_t session = msg->regs.data[1];
-        uint32_t offset = msg->regs.data[2];
-        uint32_t size   = msg->regs.data[3];
+        uint32_t offset  = msg->regs.data[2];
+        uint32_t size    = msg->regs.data[3];
+        /* 数据已由内核直接拷进接收缓冲区 (IOV 接收), 就地写入, 只写实际收到的部分 */
         if (msg->buffer.data && msg->buffer.size > 0) {
             if (size > msg->buffer.size) size = msg->buffer.size;
-            if (size > FILE_EP_BUF_SIZE) size = FILE_EP_BUF_SIZE;
-            memcpy(g_file_ep_buf, (const void *)(uintptr_t)msg->buffer.data, size);
-            result = fatfs_write(ctx, session, g_file_ep_buf, offset, size);
+            result = fatfs_write(ctx, session, (const void *)(uintptr_t)msg->buffer.data, offset,
+                                 size);
         } else {
             result = -EINVAL;
         }
         break;
     }
+    case IO_SPLICE_OUT:
+    case IO_SPLICE_IN: {
+        if (msg->handles.count < 1) {
+            result = -EBADF;
+            break;
+        }
+        handle_t pipe_h  = msg->handles.handles[0];
+        uint32_t session = msg->regs.data[1];
+        uint32_t offset  = msg->regs.data[2];
+        uint32_t size    = msg->regs.data[3];
+        if (!fatfs_get_file_handle(ctx, session, NULL)) {
+            result = -EBADF;
+        } else if (op == IO_SPLICE_OUT) {
+            result = fatfs_splice_out(ctx, session, pipe_h, offset, size);
+        } else {
+            result = fatfs_splice_in(ctx, session, pipe_h, offset, size);
+        }
+        sys_handle_close(pipe_h);
+        break;
+    }
     case IO_CLOSE: {
         uint32_t session = msg->regs.data[1];
         uint32_t resolved_slot = 0;
@@ -437,6 +987,58 @@ int fatfs_file_ep_dispatch(struct fatfs_ctx *ctx, int slot, struct ipc_message *
         sys_ipc_reply_to(msg->sender_tid, &reply);
         return -1; /* 通知调用者: slot 已关闭 */
     }
+    case IO_WIN_ATTACH: {
+        if (msg->handles.count < 1) {
+            result = -EBADF;
+            break;
+        }
+        result = fatfs_win_attach(ctx, msg->regs.data[1], msg->handles.handles[0],
+                                  msg->regs.data[2]);
+        break;
+    }
+    case IO_WIN_READ:
+    case IO_WIN_WRITE: {
+        uint32_t session = msg->regs.data[1];
+        uint32_t offset  = msg->regs.data[2];
+        uint32_t size    = msg->regs.data[3];
+        struct fatfs_handle *handle = fatfs_get_file_handle(ctx, session, NULL);
+        if (!handle) {
+            result = -EBADF;
+            break;
+        }
+        if (!handle->win) {
+            result = -ENOENT;
+            break;
+        }
+        if (size > handle->win_size) size = handle->win_size;
+        if (op == IO_WIN_READ) {
+            result = fatfs_read(ctx, session, handle->win, offset, size);
+        } else {
+            result = fatfs_write(ctx, session, handle->win, offset, size);
+        }
+        break;
+    }
+    case IO_IOCTL: {
+        uint32_t session = msg->regs.data[1];
+        uint32_t cmd     = msg->regs.data[2];
+        if (cmd == VFS_IOCTL_PREALLOC) {
+            result = fatfs_prealloc(ctx, session, msg->regs.data[3]);
+        } else if (cmd == VFS_IOCTL_GETSIZE) {
+            struct fatfs_handle *handle = fatfs_get_file_handle(ctx, session, NULL);
+            result                      = handle ? 0 : -EBADF;
+            if (handle) {
+                reply.regs.data[1] = (uint32_t)f_size(&handle->obj.file);
+            }
+        }
+        break;
+    }
+    case IO_MAP:
+        result = fatfs_map(ctx, msg, &reply);
+        break;
+    case IO_PAGE_IN:
+    case IO_PAGE_OUT:
+        result = fatfs_page_io(ctx, op, msg, &reply);
+        break;
     /* TODO: IO_IOCTL for finfo/truncate/sync when needed */
     default:
         break;
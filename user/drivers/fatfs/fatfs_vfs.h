@@ -12,6 +12,14 @@
 
 #define FATFS_MAX_HANDLES 32
 
+/* 文件簇数超过该值才建 CLMT (fast seek 簇链映射表) */
+#define FATFS_CLMT_MIN_CLUSTERS 4
+/* CLMT 最大项数, 碎片过多的文件退回逐簇遍历 */
+#define FATFS_CLMT_MAX_ITEMS 1024
+
+/* 客户端借出的共享内存窗口上限 (IO_WIN_ATTACH) */
+#define FATFS_WIN_MAX (256 * 1024)
+
 /* 打开的文件/目录句柄 */
 struct fatfs_handle {
     union {
@@ -21,15 +29,24 @@ struct fatfs_handle {
     char     path[VFS_PATH_MAX];
     uint32_t flags;
     handle_t file_ep; /* 兼容字段: fatfs 现改为 main_ep + session 模型 */
+    DWORD   *clmt;    /* 簇链映射表, 非 NULL 时 obj.file.cltbl 指向它 */
+    int      resv;    /* 预分配的内存预留编号 (fatfs_alloc_reserve), 0=无 */
+    uint8_t *win;      /* 客户端窗口在本进程的映射, NULL=未绑定 */
+    handle_t win_shm;
+    uint32_t win_size;
+    uint32_t dir_index; /* 目录: 下一次 f_readdir 读到的项序号 */
     uint16_t generation;
     uint8_t  type;    /* 0=file, 1=dir */
     uint8_t  in_use;
+    uint8_t  clmt_skip; /* 已判定不建 CLMT (文件过小或碎片过多), 大小变化时清除 */
+    uint8_t  pager;     /* 内核文件映射的缓页会话 (IO_MAP) */
 };
 
 /* FatFs 上下文 */
 struct fatfs_ctx {
     FATFS               fs;
     struct fatfs_handle handles[FATFS_MAX_HANDLES];
+    handle_t            main_ep; /* 服务 endpoint, 内核页缓存以它为缓存 endpoint */
     uint8_t             mounted;
 };
 
@@ -48,6 +65,16 @@ struct vfs_operations *fatfs_get_ops(void);
  */
 int fatfs_file_ep_dispatch(struct fatfs_ctx *ctx, int slot, struct ipc_message *msg);
 
+/**
+ * 为文件预分配连续空间 (VFS_IOCTL_PREALLOC)
+ *
+ * 在内存里为之后的扩展写预留一段连续空闲区, 磁盘上的 FAT 和目录项不变,
+ * 文件大小始终是实际写入的长度; 关闭时没用到的部分归还.
+ *
+ * @return 1 已预留，0 没有够长的连续区 (不预留)，负数错误码
+ */
+int fatfs_prealloc(struct fatfs_ctx *ctx, uint32_t session, uint32_t size);
+
 /**
  * 获取指定 slot 的 file_ep handle
  */
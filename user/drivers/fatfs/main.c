@@ -2,14 +2,16 @@
  * @file main.c
  * @brief fatfsd 驱动程序入口
  *
- * FAT 文件系统用户态驱动, 支持两种后端:
+ * FAT 文件系统用户态驱动, 支持三种后端:
  * - 内存模式: boot.system handle 存在时, mmap 该模块
  * - ATA 模式: 否则初始化 ATA, 读 MBR 分区表, 挂载第一个分区
+ * - VirtIO 模式: --virtio, 经 pcid 取得 virtio-blk 设备, 同样挂载第一个分区
  */
 
 #include "ata.h"
 #include "diskio_mem.h"
 #include "fatfs_vfs.h"
+#include "virtio_blk.h"
 
 #include <block.h>
 #include <pthread.h>
@@ -85,6 +87,7 @@ static int block_ata_get_info(void *ctx, struct block_info *info) {
     struct ata_block_ctx *actx = (struct ata_block_ctx *)ctx;
     info->sector_count = actx->sector_count;
     info->sector_size = 512;
+    info->max_sectors = 128;
     info->type = BLOCK_DEV_ATA;
     strncpy(info->model, "ATA Disk", sizeof(info->model) - 1);
     info->serial[0] = '\0';
@@ -139,6 +142,65 @@ static void register_ata_block_device(int drive) {
     }
 }
 
+/* virtio-blk 块设备操作 (驱动内部已串行化, ctx 未使用) */
+static int block_virtio_read(void *ctx, uint64_t lba, uint32_t count, void *buffer) {
+    (void)ctx;
+    return virtio_blk_read(lba, count, buffer);
+}
+
+static int block_virtio_write(void *ctx, uint64_t lba, uint32_t count, const void *buffer) {
+    (void)ctx;
+    return virtio_blk_write(lba, count, buffer);
+}
+
+static int block_virtio_flush(void *ctx) {
+    (void)ctx;
+    return virtio_blk_flush();
+}
+
+static int block_virtio_get_info(void *ctx, struct block_info *info) {
+    (void)ctx;
+    info->sector_count = virtio_blk_get_sector_count();
+    info->sector_size  = VIRTIO_BLK_SECTOR_SIZE;
+    info->max_sectors  = VIRTIO_BLK_MAX_SECTORS;
+    info->flags        = virtio_blk_is_readonly() ? BLOCK_FLAG_READONLY : 0;
+    info->type         = BLOCK_DEV_VIRTIO;
+    strncpy(info->model, "VirtIO Block Device", sizeof(info->model) - 1);
+    info->serial[0] = '\0';
+    return 0;
+}
+
+static struct block_ops virtio_block_ops = {
+    .read     = block_virtio_read,
+    .write    = block_virtio_write,
+    .flush    = block_virtio_flush,
+    .get_info = block_virtio_get_info,
+};
+
+/**
+ * 注册 virtio-blk 块设备
+ * @param index 设备序号, 决定名称 (0 → vda, 1 → vdb, ...)
+ * @return 注册后的设备, 失败返回 NULL
+ */
+static struct block_device *register_virtio_block_device(int index) {
+    struct block_device dev;
+
+    memset(&dev, 0, sizeof(dev));
+    snprintf(dev.name, sizeof(dev.name), "vd%c", 'a' + index);
+    dev.type = BLOCK_DEV_VIRTIO;
+    dev.ops  = &virtio_block_ops;
+
+    if (block_register(&dev) < 0) {
+        return NULL;
+    }
+
+    struct block_device *reg = block_find(dev.name);
+    ulog_tagf(stdout, TERM_COLOR_LIGHT_GREEN, "[fatfsd]",
+              " registered block device: %s (%u MB)\n", reg->name,
+              (uint32_t)(reg->info.sector_count / 2048));
+    return reg;
+}
+
 /**
  * 从 MBR 解析第一个有效分区的起始 LBA
  */
@@ -162,8 +224,8 @@ static int parse_mbr_first_partition(const uint8_t *mbr, uint32_t *out_lba) {
 
 /* ============== BLK IPC 处理 ============== */
 
-static int  g_blk_ata_drive = -1; /* ATA 模式时保存的驱动器号 */
-static char g_blk_dev_name[16];   /* 块设备名 (e.g., "sda") */
+static struct block_device *g_blk_dev; /* 磁盘模式时的块设备, 内存模式为 NULL */
+static char g_blk_dev_name[16];        /* 块设备名 (e.g., "sda") */
 static uint32_t g_blk_sector_count;
 static uint8_t g_saved_mbr[512];  /* main() 阶段读取的 MBR, 注册时复用 */
 
@@ -172,7 +234,7 @@ static char g_blk_io_buf[BLK_IO_BUF_SIZE];
 static int blk_handler(struct ipc_message *msg) {
     uint32_t op = UDM_MSG_OPCODE(msg);
 
-    if (g_blk_ata_drive < 0) {
+    if (!g_blk_dev) {
         msg->regs.data[1] = (uint32_t)-6; /* EIO */
         return 0;
     }
@@ -183,7 +245,7 @@ static int blk_handler(struct ipc_message *msg) {
         uint32_t count = msg->regs.data[3];
         if (count > BLK_IO_MAX_SECTORS) count = BLK_IO_MAX_SECTORS;
 
-        int ret = ata_read(g_blk_ata_drive, (uint32_t)lba, count, g_blk_io_buf);
+        int ret = block_read(g_blk_dev, lba, count, g_blk_io_buf);
         if (ret < 0) {
             msg->regs.data[1] = (uint32_t)-6;
             return 0;
@@ -207,7 +269,7 @@ static int blk_handler(struct ipc_message *msg) {
         }
 
         memcpy(g_blk_io_buf, (const void *)(uintptr_t)msg->buffer.data, count * 512);
-        int ret = ata_write(g_blk_ata_drive, (uint32_t)lba, count, g_blk_io_buf);
+        int ret = block_write(g_blk_dev, lba, count, g_blk_io_buf);
         if (ret < 0) {
             msg->regs.data[1] = (uint32_t)-6;
             return 0;
@@ -227,6 +289,22 @@ static int blk_handler(struct ipc_message *msg) {
         return 0;
     }
 
+    case UDM_BLK_STATS: {
+        struct block_cache_stats st;
+        if (block_cache_get_stats(g_blk_dev, &st) < 0) {
+            msg->regs.data[1] = (uint32_t)-38; /* ENOSYS: 无缓存 */
+            return 0;
+        }
+        msg->regs.data[1] = 0;
+        msg->regs.data[2] = st.hits;
+        msg->regs.data[3] = st.misses;
+        msg->regs.data[4] = st.readahead;
+        msg->regs.data[5] = st.writebacks;
+        msg->regs.data[6] = st.cached;
+        msg->regs.data[7] = st.dirty;
+        return 0;
+    }
+
     default:
         msg->regs.data[1] = (uint32_t)-38; /* ENOSYS */
         return 0;
@@ -237,7 +315,9 @@ static int blk_handler(struct ipc_message *msg) {
 static int combined_handler(struct ipc_message *msg) {
     uint32_t op = UDM_MSG_OPCODE(msg);
     /* BLK 协议: 100-199, IO 协议: 0x100+ (256+), VFS 协议: 0-99 */
-    if (op >= IO_READ && op <= IO_CLOSE) {
+    if ((op >= IO_READ && op <= IO_CLOSE) || (op >= IO_SPLICE_OUT && op <= IO_PAGE_OUT) ||
+        (op == IO_IOCTL && (msg->regs.data[2] == VFS_IOCTL_PREALLOC ||
+                            msg->regs.data[2] == VFS_IOCTL_GETSIZE))) {
         uint32_t slot = msg->regs.data[1];
         return fatfs_file_ep_dispatch(&g_fatfs, (int)slot, msg);
     }
@@ -250,7 +330,7 @@ static int combined_handler(struct ipc_message *msg) {
 static char g_reg_buf[16 + 1 + 512];
 
 static void register_blkdev_to_devfsd(handle_t self_ep) {
-    if (g_blk_ata_drive < 0 || g_blk_dev_name[0] == '\0') return;
+    if (!g_blk_dev || g_blk_dev_name[0] == '\0') return;
 
     /* 重试查找 devfs_ep */
     handle_t devfs = HANDLE_INVALID;
@@ -283,22 +363,34 @@ static void register_blkdev_to_devfsd(handle_t self_ep) {
     sys_ipc_call(devfs, &reg, &reply, 5000);
 }
 
-/* fatfs 主事件循环: 统一处理命名空间和文件会话 IO。 */
-#define FATFS_RECV_BUF_SIZE 4096
+/*
+ * fatfs 主事件循环: 统一处理命名空间和文件会话 IO。
+ *
+ * 以单段 IOV 接收: 内核会合时把写入数据直接从客户端拷进接收缓冲区,
+ * 不经过内核中转, 也不受 CFG_IPC_MAX_BUF 限制. 收到后按普通 buffer 交给处理函数.
+ */
+#define FATFS_RECV_BUF_SIZE (64 * 1024)
 static char g_fatfs_recv_buf[FATFS_RECV_BUF_SIZE];
 
 static void fatfs_main_loop(handle_t main_ep) {
-    struct ipc_message msg;
+    struct ipc_message   msg;
+    struct abi_ipc_iovec iov = {.data = (uint64_t)(uintptr_t)g_fatfs_recv_buf,
+                                .size = FATFS_RECV_BUF_SIZE};
 
     while (1) {
         memset(&msg, 0, sizeof(msg));
-        msg.buffer.data = (uint64_t)(uintptr_t)g_fatfs_recv_buf;
-        msg.buffer.size = FATFS_RECV_BUF_SIZE;
+        msg.buffer.data = (uint64_t)(uintptr_t)&iov;
+        msg.buffer.size = 1;
+        msg.flags       = ABI_IPC_FLAG_IOV;
 
         if (sys_ipc_receive(main_ep, &msg, 0) < 0) {
             continue;
         }
 
+        /* buffer.size 已是实际收到的字节数, 数据从缓冲区开头连续存放 */
+        msg.buffer.data = (uint64_t)(uintptr_t)g_fatfs_recv_buf;
+        msg.flags &= ~ABI_IPC_FLAG_IOV;
+
         combined_handler(&msg);
     }
 }
@@ -309,15 +401,25 @@ static void *srv_thread_entry(void *arg) {
 }
 
 int main(int argc, char **argv) {
-    /* 解析参数: --ata 强制 ATA 模式，--drive N 指定 ATA 驱动器号 */
-    bool force_ata = false;
-    int  ata_drive = 0;
+    /*
+     * 解析参数: --ata 强制 ATA 模式, --virtio 使用 virtio-blk,
+     * --drive N 指定驱动器号 (virtio 下为第 N 个设备), --bench N 测读速
+     */
+    bool     force_ata     = false;
+    bool     use_virtio    = false;
+    int      ata_drive     = 0;
+    uint32_t bench_sectors = 0;
     for (int i = 0; i < argc; i++) {
         if (strcmp(argv[i], "--ata") == 0) {
             force_ata = true;
+        } else if (strcmp(argv[i], "--virtio") == 0) {
+            use_virtio = true;
         } else if (strcmp(argv[i], "--drive") == 0 && i + 1 < argc) {
             ata_drive = (int)strtol(argv[i + 1], NULL, 10);
             i++;
+        } else if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc) {
+            bench_sectors = (uint32_t)strtoul(argv[i + 1], NULL, 10);
+            i++;
         }
     }
 
@@ -326,7 +428,17 @@ int main(int argc, char **argv) {
     char svc_name_buf[32];
     const char *ep_name;
     const char *svc_name;
-    if (force_ata) {
+    if (use_virtio) {
+        if (ata_drive == 0) {
+            ep_name  = "fatfs_virtio_ep";
+            svc_name = "fatfs_virtio";
+        } else {
+            snprintf(ep_name_buf, sizeof(ep_name_buf), "fatfs_virtio%d_ep", ata_drive);
+            snprintf(svc_name_buf, sizeof(svc_name_buf), "fatfs_virtio%d", ata_drive);
+            ep_name  = ep_name_buf;
+            svc_name = svc_name_buf;
+        }
+    } else if (force_ata) {
         if (ata_drive == 0) {
             ep_name  = "fatfs_ata_ep";
             svc_name = "fatfs_ata";
@@ -348,7 +460,38 @@ int main(int argc, char **argv) {
 
     bool use_ata = force_ata;
 
-    if (!force_ata) {
+    /* virtio-blk 和 IDE 控制器都经 pcid claim, 内存模式不需要 */
+    handle_t pci_ep = env_get_handle("pci_ep");
+    if (pci_ep == HANDLE_INVALID) {
+        pci_ep = sys_handle_find("pci_ep");
+    }
+
+    if (use_virtio) {
+        if (virtio_blk_init(pci_ep, ata_drive) < 0) {
+            ulog_tagf(stdout, TERM_COLOR_LIGHT_RED, "[fatfs]", " virtio-blk %d init failed\n",
+                      ata_drive);
+            return 1;
+        }
+
+        g_blk_dev = register_virtio_block_device(ata_drive);
+        if (!g_blk_dev || block_read(g_blk_dev, 0, 1, g_saved_mbr) < 0) {
+            ulog_tagf(stdout, TERM_COLOR_LIGHT_RED, "[fatfs]", " failed to read MBR (vd%c)\n",
+                      'a' + ata_drive);
+            return 1;
+        }
+
+        uint32_t base_lba = 0;
+        if (parse_mbr_first_partition(g_saved_mbr, &base_lba) < 0) {
+            base_lba = 0;
+        }
+
+        disk_init_block(g_blk_dev, base_lba);
+        ulog_tagf(stdout, TERM_COLOR_LIGHT_GREEN, "[fatfs]", " VirtIO mode (%s, base_lba=%u)\n",
+                  g_blk_dev->name, base_lba);
+
+        g_blk_sector_count = (uint32_t)g_blk_dev->info.sector_count;
+        strncpy(g_blk_dev_name, g_blk_dev->name, sizeof(g_blk_dev_name) - 1);
+    } else if (!force_ata) {
         /* 自动检测: boot.system 存在则为内存模式 */
         handle_t system_h = sys_handle_find("boot.system");
         if (system_h != HANDLE_INVALID) {
@@ -369,11 +512,15 @@ int main(int argc, char **argv) {
     }
 
     if (use_ata) {
-        if (ata_init() < 0) {
+        if (ata_init((uint8_t)ata_drive, pci_ep) < 0) {
             ulog_tagf(stdout, TERM_COLOR_LIGHT_RED, "[fatfs]", " ata init failed\n");
             return 1;
         }
 
+        if (bench_sectors) {
+            ata_bench(ata_drive, bench_sectors);
+        }
+
         if (ata_read(ata_drive, 0, 1, g_saved_mbr) < 0) {
             ulog_tagf(stdout, TERM_COLOR_LIGHT_RED, "[fatfs]", " failed to read MBR (drive=%d)\n",
                       ata_drive);
@@ -387,15 +534,19 @@ int main(int argc, char **argv) {
             base_lba = 0;
         }
 
-        disk_init_ata(ata_drive, base_lba);
+        /* 注册当前驱动器的块设备, 经其缓存访问; 注册失败时直接走 ATA */
+        register_ata_block_device(ata_drive);
+        if (g_block_dev_registered[ata_drive]) {
+            g_blk_dev = block_find(g_block_dev[ata_drive].name);
+            disk_init_block(g_blk_dev, base_lba);
+        } else {
+            g_blk_dev = g_block_dev[ata_drive].ops ? &g_block_dev[ata_drive] : NULL;
+            disk_init_ata(ata_drive, base_lba);
+        }
         ulog_tagf(stdout, TERM_COLOR_LIGHT_GREEN, "[fatfs]",
                   " ATA mode (drive=%d, base_lba=%u)\n", ata_drive, base_lba);
 
-        /* 记录 ATA 信息供 BLK 协议使用 */
-        g_blk_ata_drive = ata_drive;
         g_blk_sector_count = ata_get_sector_count(ata_drive);
-        /* 注册当前驱动器的块设备 */
-        register_ata_block_device(ata_drive);
         /* 设备名: drive 0 → sda, drive 1 → sdb, ... */
         snprintf(g_blk_dev_name, sizeof(g_blk_dev_name), "sd%c",
                  'a' + ata_drive);
@@ -407,11 +558,13 @@ int main(int argc, char **argv) {
         return 1;
     }
 
+    g_fatfs.main_ep = ep;
+
     svc_notify_ready(svc_name);
     ulog_tagf(stdout, TERM_COLOR_LIGHT_GREEN, "[fatfs]", " %s started\n", svc_name);
 
-    /* ATA 模式: 先启动服务线程, 再注册到 devfsd */
-    if (use_ata) {
+    /* 磁盘模式: 先启动服务线程, 再注册到 devfsd */
+    if (g_blk_dev) {
         pthread_t srv_thread;
         pthread_create(&srv_thread, NULL, srv_thread_entry, &ep);
         sys_sleep(50); /* 等待服务线程进入 receive 循环 */
@@ -0,0 +1,523 @@
+/**
+ * @file virtio_blk.c
+ * @brief virtio-blk 驱动 (legacy PCI 传输)
+ *
+ * QEMU 的 if=virtio 磁盘是 transitional 设备, BAR0 提供 legacy IO 寄存器.
+ * 设备由 pcid 分配: claim 后取得 BAR0 端口和解析好的 IRQ.
+ *
+ * 内存布局: 一块物理连续的 DMA 缓冲区, 依次放 vring, 请求头/状态页和数据区.
+ * 数据区按 VBLK_SEG_SECTORS 切成若干槽, 每个槽对应一条固定的三段描述符链
+ * (请求头 -> 数据 -> 状态). 一次读写把所有槽同时挂到 avail 环上再敲一次门铃,
+ * 设备并行处理, 完成后由 IRQ 经 event 唤醒.
+ */
+
+#include "virtio_blk.h"
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <xnix/abi/ipc.h>
+#include <xnix/driver/ioport.h>
+#include <xnix/ipc.h>
+#include <xnix/protocol/pci.h>
+#include <xnix/syscall.h>
+
+#define VIRTIO_PCI_VENDOR  0x1AF4
+#define VIRTIO_PCI_DEV_BLK 0x1001 /* transitional virtio-blk */
+
+/* legacy 寄存器 (BAR0 IO 空间) */
+#define VIRTIO_REG_DEVICE_FEATURES 0x00
+#define VIRTIO_REG_GUEST_FEATURES  0x04
+#define VIRTIO_REG_QUEUE_PFN       0x08
+#define VIRTIO_REG_QUEUE_SIZE      0x0C
+#define VIRTIO_REG_QUEUE_SEL       0x0E
+#define VIRTIO_REG_QUEUE_NOTIFY    0x10
+#define VIRTIO_REG_STATUS          0x12
+#define VIRTIO_REG_ISR             0x13
+#define VIRTIO_REG_CONFIG          0x14 /* 未启用 MSI-X 时的设备配置区 */
+
+#define VIRTIO_STATUS_ACK       0x01
+#define VIRTIO_STATUS_DRIVER    0x02
+#define VIRTIO_STATUS_DRIVER_OK 0x04
+#define VIRTIO_STATUS_FAILED    0x80
+
+#define VIRTIO_BLK_F_RO    (1u << 5)
+#define VIRTIO_BLK_F_FLUSH (1u << 9)
+
+#define VIRTIO_BLK_T_IN    0
+#define VIRTIO_BLK_T_OUT   1
+#define VIRTIO_BLK_T_FLUSH 4
+#define VIRTIO_BLK_S_OK    0
+
+#define VRING_DESC_F_NEXT  1
+#define VRING_DESC_F_WRITE 2
+#define VRING_ALIGN        4096
+
+#define VBLK_QUEUE_MAX   1024 /* 超过则 vring 放不进 DMA 缓冲区 */
+#define VBLK_MAX_REQS    16   /* 同时在队列上的请求数 */
+#define VBLK_SEG_SECTORS 16   /* 每个请求的扇区数 (8KB) */
+#define VBLK_SEG_SIZE    (VBLK_SEG_SECTORS * VIRTIO_BLK_SECTOR_SIZE)
+#define VBLK_DATA_SIZE   (VBLK_MAX_REQS * VBLK_SEG_SIZE)
+
+_Static_assert(VBLK_DATA_SIZE == VIRTIO_BLK_MAX_SECTORS * VIRTIO_BLK_SECTOR_SIZE,
+               "data area must hold one full batch");
+#define VBLK_HDR_SIZE    4096
+
+#define VBLK_IRQ_BIT   (1u << 0)
+#define VBLK_PROBE_BIT (1u << 31)
+
+/* 等待完成的上限: 单次等 IRQ 的毫秒数, 以及唤醒/轮询的总圈数 */
+#define VBLK_TIMEOUT_MS 2000
+#define VBLK_WAIT_LOOPS 2000000
+
+struct vring_desc {
+    uint64_t addr;
+    uint32_t len;
+    uint16_t flags;
+    uint16_t next;
+};
+
+struct vring_avail {
+    uint16_t flags;
+    uint16_t idx;
+    uint16_t ring[];
+};
+
+struct vring_used_elem {
+    uint32_t id;
+    uint32_t len;
+};
+
+struct vring_used {
+    uint16_t               flags;
+    uint16_t               idx;
+    struct vring_used_elem ring[];
+};
+
+struct virtio_blk_req_hdr {
+    uint32_t type;
+    uint32_t reserved;
+    uint64_t sector;
+};
+
+/* 每个请求槽在请求头页中的布局 */
+struct vblk_slot_hdr {
+    struct virtio_blk_req_hdr hdr;
+    volatile uint8_t          status;
+    uint8_t                   _pad[15];
+};
+
+static struct {
+    bool      ready;
+    bool      failed; /* 请求超时后设备已复位, 不再使用 */
+    uint16_t  iobase;
+    int       irq; /* -1 表示轮询 */
+    handle_t  irq_event;
+    uint32_t  features;
+    uint64_t  capacity;
+    uint16_t  qsize;
+    uint16_t  nreqs;
+    uint16_t  last_used;
+
+    volatile struct vring_desc  *desc;
+    volatile struct vring_avail *avail;
+    volatile struct vring_used  *used;
+    struct vblk_slot_hdr        *slots;
+    uint32_t                     slots_phys;
+    uint8_t                     *data;
+    uint32_t                     data_phys;
+
+    pthread_mutex_t lock;
+} g_vblk;
+
+static inline uint32_t vring_align(uint32_t x) {
+    return (x + VRING_ALIGN - 1) & ~(uint32_t)(VRING_ALIGN - 1);
+}
+
+/* ============== pcid 交互 ============== */
+
+static int vblk_claim(handle_t pci_ep, int index, struct pci_dev_info *info) {
+    uint32_t start = 0;
+    int      dev   = -1;
+
+    for (int n = 0; n <= index; n++) {
+        struct ipc_message msg   = {0};
+        struct ipc_message reply = {0};
+
+        msg.regs.data[0]  = UDM_PCI_FIND;
+        msg.regs.data[1]  = VIRTIO_PCI_VENDOR | ((uint32_t)VIRTIO_PCI_DEV_BLK << 16);
+        msg.regs.data[2]  = PCI_ANY_ID;
+        msg.regs.data[3]  = start;
+        reply.buffer.data = (uint64_t)(uintptr_t)info;
+        reply.buffer.size = sizeof(*info);
+
+        if (sys_ipc_call(pci_ep, &msg, &reply, 1000) < 0) {
+            return -1;
+        }
+        dev = (int32_t)reply.regs.data[1];
+        if (dev < 0) {
+            return -1;
+        }
+        start = (uint32_t)dev + 1;
+    }
+
+    struct ipc_message msg   = {0};
+    struct ipc_message reply = {0};
+
+    msg.regs.data[0]  = UDM_PCI_CLAIM;
+    msg.regs.data[1]  = (uint32_t)dev;
+    reply.buffer.data = (uint64_t)(uintptr_t)info;
+    reply.buffer.size = sizeof(*info);
+
+    if (sys_ipc_call(pci_ep, &msg, &reply, 1000) < 0 || (int32_t)reply.regs.data[1] < 0) {
+        return -1;
+    }
+
+    /* legacy 传输只用 IO BAR0, 不需要内存 BAR 的 handle */
+    for (uint32_t i = 0; i < reply.handles.count; i++) {
+        sys_handle_close(reply.handles.handles[i]);
+    }
+
+    if (!(info->bar_flags[0] & PCI_BAR_IO) || info->bar_size[0] == 0) {
+        return -1;
+    }
+    g_vblk.iobase = (uint16_t)info->bar_base[0];
+    g_vblk.irq    = (int32_t)reply.regs.data[2];
+    return 0;
+}
+
+/* ============== 队列操作 ============== */
+
+/**
+ * 等待 used 环推进到 target
+ *
+ * 先查 used 再等 event: 检查与等待之间到达的中断会留在 pending 位里.
+ * 每次唤醒都读 ISR 清除设备中断, 再 ack 让内核重新打开电平触发线.
+ * event_wait 没有超时, 用 wait_any 带超时等它就绪, 再取走 pending 位.
+ *
+ * @return 0 完成, -1 超时
+ */
+static int vblk_wait_used(uint16_t target, bool polled) {
+    struct abi_ipc_wait_set set = {0};
+    set.handles[0]              = g_vblk.irq_event;
+    set.count                   = 1;
+
+    int ret = 0;
+    for (uint32_t loops = 0; g_vblk.used->idx != target; loops++) {
+        if (loops >= VBLK_WAIT_LOOPS) {
+            ret = -1;
+            break;
+        }
+        if (polled || g_vblk.irq < 0) {
+            pthread_yield();
+            continue;
+        }
+        if (sys_ipc_wait_any(&set, VBLK_TIMEOUT_MS) == HANDLE_INVALID) {
+            ret = -1;
+            break;
+        }
+        sys_event_wait(g_vblk.irq_event);
+        (void)ioport_native_inb(g_vblk.iobase + VIRTIO_REG_ISR);
+        sys_irq_ack((uint8_t)g_vblk.irq);
+    }
+
+    if (g_vblk.irq >= 0) {
+        (void)ioport_native_inb(g_vblk.iobase + VIRTIO_REG_ISR);
+        sys_irq_ack((uint8_t)g_vblk.irq);
+    }
+    return ret;
+}
+
+/**
+ * 请求超时: 复位设备让它停止访问 vring 和缓冲区, 标记失败
+ *
+ * 复位后队列配置已丢失, 之后的读写直接返回错误.
+ */
+static void vblk_fail(void) {
+    printf("[virtio-blk] request timed out, resetting device\n");
+    ioport_native_outb(g_vblk.iobase + VIRTIO_REG_STATUS, 0);
+    ioport_native_outb(g_vblk.iobase + VIRTIO_REG_STATUS, VIRTIO_STATUS_FAILED);
+    g_vblk.failed = true;
+    g_vblk.ready  = false;
+}
+
+/**
+ * 填写槽 i 的描述符链并放入 avail 环(不更新 avail->idx)
+ */
+static void vblk_queue_slot(uint16_t i, uint16_t pos, uint32_t type, uint64_t lba,
+                            uint32_t bytes) {
+    struct vblk_slot_hdr *s = &g_vblk.slots[i];
+    uint16_t              d = (uint16_t)(i * 3);
+
+    s->hdr.type     = type;
+    s->hdr.reserved = 0;
+    s->hdr.sector   = lba;
+    s->status       = 0xFF;
+
+    if (type == VIRTIO_BLK_T_FLUSH) {
+        g_vblk.desc[d].next = d + 2; /* 跳过数据段 */
+    } else {
+        g_vblk.desc[d].next      = d + 1;
+        g_vblk.desc[d + 1].len   = bytes;
+        g_vblk.desc[d + 1].flags = VRING_DESC_F_NEXT |
+                                   (type == VIRTIO_BLK_T_IN ? VRING_DESC_F_WRITE : 0);
+    }
+
+    g_vblk.avail->ring[pos % g_vblk.qsize] = d;
+}
+
+/**
+ * 提交 n 个已填好的槽并等待全部完成
+ *
+ * @return 0 全部成功, -1 任一请求失败或超时
+ */
+static int vblk_submit(uint16_t n, bool polled) {
+    uint16_t target = (uint16_t)(g_vblk.last_used + n);
+
+    if (g_vblk.failed) {
+        return -1;
+    }
+
+    __sync_synchronize(); /* 描述符和 ring 项先于 idx 可见 */
+    g_vblk.avail->idx = (uint16_t)(g_vblk.avail->idx + n);
+    __sync_synchronize();
+    ioport_native_outw(g_vblk.iobase + VIRTIO_REG_QUEUE_NOTIFY, 0);
+
+    if (vblk_wait_used(target, polled) < 0) {
+        vblk_fail();
+        return -1;
+    }
+    __sync_synchronize();
+
+    int ret = 0;
+    for (uint16_t u = g_vblk.last_used; u != target; u++) {
+        uint32_t id = g_vblk.used->ring[u % g_vblk.qsize].id;
+        if (id / 3 >= g_vblk.nreqs || g_vblk.slots[id / 3].status != VIRTIO_BLK_S_OK) {
+            ret = -1;
+        }
+    }
+    g_vblk.last_used = target;
+    return ret;
+}
+
+/**
+ * 读写一批扇区: 最多 nreqs 个段同时在队列上
+ */
+static int vblk_rw(uint64_t lba, uint32_t count, uint8_t *buf, bool write, bool polled) {
+    uint32_t type = write ? VIRTIO_BLK_T_OUT : VIRTIO_BLK_T_IN;
+
+    while (count > 0) {
+        uint16_t n     = 0;
+        uint16_t pos   = g_vblk.avail->idx;
+        uint32_t total = 0;
+
+        while (count > 0 && n < g_vblk.nreqs) {
+            uint32_t secs  = count < VBLK_SEG_SECTORS ? count : VBLK_SEG_SECTORS;
+            uint32_t bytes = secs * VIRTIO_BLK_SECTOR_SIZE;
+            if (write) {
+                memcpy(g_vblk.data + n * VBLK_SEG_SIZE, buf + total, bytes);
+            }
+            vblk_queue_slot(n, (uint16_t)(pos + n), type, lba, bytes);
+            lba += secs;
+            count -= secs;
+            total += bytes;
+            n++;
+        }
+
+        if (vblk_submit(n, polled) < 0) {
+            return -1;
+        }
+
+        if (!write) {
+            /* 各槽数据连续排列, 与请求顺序一致 */
+            memcpy(buf, g_vblk.data, total);
+        }
+        buf += total;
+    }
+    return 0;
+}
+
+/* ============== 初始化 ============== */
+
+static int vblk_setup_queue(void) {
+    uint16_t io = g_vblk.iobase;
+
+    ioport_native_outw(io + VIRTIO_REG_QUEUE_SEL, 0);
+    uint16_t qsize = ioport_native_inw(io + VIRTIO_REG_QUEUE_SIZE);
+    if (qsize == 0 || qsize > VBLK_QUEUE_MAX || ioport_native_inl(io + VIRTIO_REG_QUEUE_PFN)) {
+        return -1;
+    }
+
+    uint32_t avail_off = 16u * qsize;
+    uint32_t used_off  = vring_align(avail_off + 6 + 2u * qsize);
+    uint32_t vring_sz  = used_off + vring_align(6 + 8u * qsize);
+    uint32_t total     = vring_sz + VBLK_HDR_SIZE + VBLK_DATA_SIZE;
+
+    handle_t h = sys_dma_create(total);
+    if (h == HANDLE_INVALID) {
+        return -1;
+    }
+    uint8_t            *va = sys_mmap_phys(h, 0, 0, 0x03, NULL);
+    struct physmem_info info;
+    if (va == (void *)-1 || sys_physmem_info(h, &info) < 0) {
+        sys_handle_close(h);
+        return -1;
+    }
+
+    g_vblk.qsize      = qsize;
+    g_vblk.desc       = (volatile struct vring_desc *)va;
+    g_vblk.avail      = (volatile struct vring_avail *)(va + avail_off);
+    g_vblk.used       = (volatile struct vring_used *)(va + used_off);
+    g_vblk.slots      = (struct vblk_slot_hdr *)(va + vring_sz);
+    g_vblk.slots_phys = info.phys_addr + vring_sz;
+    g_vblk.data       = va + vring_sz + VBLK_HDR_SIZE;
+    g_vblk.data_phys  = info.phys_addr + vring_sz + VBLK_HDR_SIZE;
+
+    g_vblk.nreqs = qsize / 3 < VBLK_MAX_REQS ? qsize / 3 : VBLK_MAX_REQS;
+
+    /* 预先串好每个槽的三段描述符, 之后只改长度和方向 */
+    for (uint16_t i = 0; i < g_vblk.nreqs; i++) {
+        uint16_t d    = (uint16_t)(i * 3);
+        uint32_t slot = g_vblk.slots_phys + i * sizeof(struct vblk_slot_hdr);
+
+        g_vblk.desc[d].addr  = slot;
+        g_vblk.desc[d].len   = sizeof(struct virtio_blk_req_hdr);
+        g_vblk.desc[d].flags = VRING_DESC_F_NEXT;
+        g_vblk.desc[d].next  = d + 1;
+
+        g_vblk.desc[d + 1].addr  = g_vblk.data_phys + i * VBLK_SEG_SIZE;
+        g_vblk.desc[d + 1].flags = VRING_DESC_F_NEXT;
+        g_vblk.desc[d + 1].next  = d + 2;
+
+        g_vblk.desc[d + 2].addr  = slot + offsetof(struct vblk_slot_hdr, status);
+        g_vblk.desc[d + 2].len   = 1;
+        g_vblk.desc[d + 2].flags = VRING_DESC_F_WRITE;
+    }
+
+    ioport_native_outl(io + VIRTIO_REG_QUEUE_PFN, info.phys_addr / VRING_ALIGN);
+    return 0;
+}
+
+/**
+ * 绑定 IRQ 并验证投递: 轮询完成一次读, 再用 probe 位自唤醒,
+ * 若 event 中没有 IRQ 位说明中断没送到, 退回轮询.
+ */
+static void vblk_setup_irq(void) {
+    int ev = sys_event_create();
+    if (ev < 0 || g_vblk.irq < 0 ||
+        sys_irq_bind((uint8_t)g_vblk.irq, (uint32_t)ev, VBLK_IRQ_BIT) < 0) {
+        if (ev >= 0) {
+            sys_handle_close((handle_t)ev);
+        }
+        g_vblk.irq = -1;
+        return;
+    }
+    g_vblk.irq_event = (handle_t)ev;
+
+    uint8_t probe[VIRTIO_BLK_SECTOR_SIZE];
+    int     saved_irq = g_vblk.irq;
+    if (vblk_rw(0, 1, probe, false, true) == 0) {
+        sys_sleep(10);
+        sys_event_signal(g_vblk.irq_event, VBLK_PROBE_BIT);
+        if (sys_event_wait(g_vblk.irq_event) & VBLK_IRQ_BIT) {
+            (void)ioport_native_inb(g_vblk.iobase + VIRTIO_REG_ISR);
+            sys_irq_ack((uint8_t)saved_irq);
+            return;
+        }
+    }
+
+    printf("[virtio-blk] irq %d not delivered, polling\n", saved_irq);
+    sys_irq_unbind((uint8_t)saved_irq);
+    g_vblk.irq = -1;
+}
+
+int virtio_blk_init(handle_t pci_ep, int index) {
+    struct pci_dev_info info;
+
+    if (g_vblk.ready) {
+        return 0;
+    }
+    if (pci_ep == HANDLE_INVALID || index < 0 || vblk_claim(pci_ep, index, &info) < 0) {
+        return -1;
+    }
+
+    uint16_t io = g_vblk.iobase;
+
+    /* 复位 -> ACK -> DRIVER -> 协商特性 -> 建队列 -> DRIVER_OK */
+    ioport_native_outb(io + VIRTIO_REG_STATUS, 0);
+    ioport_native_outb(io + VIRTIO_REG_STATUS, VIRTIO_STATUS_ACK);
+    ioport_native_outb(io + VIRTIO_REG_STATUS, VIRTIO_STATUS_ACK | VIRTIO_STATUS_DRIVER);
+
+    uint32_t features = ioport_native_inl(io + VIRTIO_REG_DEVICE_FEATURES);
+    g_vblk.features   = features & (VIRTIO_BLK_F_RO | VIRTIO_BLK_F_FLUSH);
+    ioport_native_outl(io + VIRTIO_REG_GUEST_FEATURES, g_vblk.features);
+
+    g_vblk.capacity = (uint64_t)ioport_native_inl(io + VIRTIO_REG_CONFIG + 4) << 32 |
+                      ioport_native_inl(io + VIRTIO_REG_CONFIG);
+
+    if (vblk_setup_queue() < 0) {
+        ioport_native_outb(io + VIRTIO_REG_STATUS, VIRTIO_STATUS_FAILED);
+        return -1;
+    }
+
+    ioport_native_outb(io + VIRTIO_REG_STATUS,
+                       VIRTIO_STATUS_ACK | VIRTIO_STATUS_DRIVER | VIRTIO_STATUS_DRIVER_OK);
+
+    pthread_mutex_init(&g_vblk.lock, NULL);
+    vblk_setup_irq();
+    if (g_vblk.failed) {
+        return -1;
+    }
+    g_vblk.ready = true;
+
+    printf("[virtio-blk] %02x:%02x.%x io 0x%x irq %d, %u sectors, queue %u x%u\n", info.bus,
+           info.dev, info.fn, io, g_vblk.irq, (uint32_t)g_vblk.capacity, g_vblk.qsize,
+           g_vblk.nreqs);
+    return 0;
+}
+
+int virtio_blk_read(uint64_t lba, uint32_t count, void *buffer) {
+    if (!g_vblk.ready || lba + count > g_vblk.capacity) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&g_vblk.lock);
+    int ret = vblk_rw(lba, count, (uint8_t *)buffer, false, false);
+    pthread_mutex_unlock(&g_vblk.lock);
+    return ret;
+}
+
+int virtio_blk_write(uint64_t lba, uint32_t count, const void *buffer) {
+    if (!g_vblk.ready || lba + count > g_vblk.capacity || (g_vblk.features & VIRTIO_BLK_F_RO)) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&g_vblk.lock);
+    int ret = vblk_rw(lba, count, (uint8_t *)buffer, true, false);
+    pthread_mutex_unlock(&g_vblk.lock);
+    return ret;
+}
+
+int virtio_blk_flush(void) {
+    if (!g_vblk.ready) {
+        return -1;
+    }
+    if (!(g_vblk.features & VIRTIO_BLK_F_FLUSH)) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&g_vblk.lock);
+    vblk_queue_slot(0, g_vblk.avail->idx, VIRTIO_BLK_T_FLUSH, 0, 0);
+    int ret = vblk_submit(1, false);
+    pthread_mutex_unlock(&g_vblk.lock);
+    return ret;
+}
+
+uint64_t virtio_blk_get_sector_count(void) {
+    return g_vblk.ready ? g_vblk.capacity : 0;
+}
+
+bool virtio_blk_is_readonly(void) {
+    return (g_vblk.features & VIRTIO_BLK_F_RO) != 0;
+}
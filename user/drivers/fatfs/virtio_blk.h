@@ -0,0 +1,58 @@
+/**
+ * @file virtio_blk.h
+ * @brief virtio-blk 驱动接口 (legacy PCI 传输)
+ */
+
+#ifndef VIRTIO_BLK_H
+#define VIRTIO_BLK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <xnix/abi/handle.h>
+
+#define VIRTIO_BLK_SECTOR_SIZE 512
+#define VIRTIO_BLK_MAX_SECTORS 256 /* 一批请求能同时挂上队列的扇区数 */
+
+/**
+ * 初始化 virtio-blk 设备
+ *
+ * 通过 pcid 查找并 claim 第 index 个 virtio-blk 设备, 建立请求队列.
+ *
+ * @param pci_ep pcid endpoint
+ * @param index  同类设备序号 (0=第一块)
+ * @return 0 成功,负数失败
+ */
+int virtio_blk_init(handle_t pci_ep, int index);
+
+/**
+ * 读取扇区
+ *
+ * 大请求被切成多个段同时挂在队列上, 全部完成后返回.
+ *
+ * @return 0 成功,负数失败
+ */
+int virtio_blk_read(uint64_t lba, uint32_t count, void *buffer);
+
+/**
+ * 写入扇区
+ *
+ * @return 0 成功,负数失败
+ */
+int virtio_blk_write(uint64_t lba, uint32_t count, const void *buffer);
+
+/**
+ * 刷新设备写缓存 (设备不支持 FLUSH 时直接返回 0)
+ */
+int virtio_blk_flush(void);
+
+/**
+ * 获取磁盘扇区总数, 0 表示设备未初始化
+ */
+uint64_t virtio_blk_get_sector_count(void);
+
+/**
+ * 设备是否只读
+ */
+bool virtio_blk_is_readonly(void);
+
+#endif /* VIRTIO_BLK_H */
@@ -0,0 +1,687 @@
+/**
+ * @file main.c
+ * @brief pci - PCI 总线枚举服务 (pcid)
+ *
+ * 启动时通过配置机制 #1 扫描所有总线/设备/功能, 记录 ID, 类别, BAR 和
+ * 中断引脚. 之后:
+ *   - 每个功能注册为 /dev/pciBB:DD.F, 读取得到文本描述
+ *   - 驱动通过 pci_ep 查找设备并 claim, pcid 打开解码/总线主控,
+ *     把内存 BAR 包装成 physmem handle 交给驱动, 把 IO BAR 端口和
+ *     解析后的 IRQ (MP Table 路由, 否则 legacy 线) 授予驱动进程
+ *   - 属主 release 或退出后, 关闭设备的解码和总线主控, 设备回到空闲
+ *
+ * 两个 endpoint: pci_ep 只由 sys.conf 交给驱动服务, 可以 claim;
+ * pci_dev_ep 注册到 devfs, 打开 /dev/pci* 的任何进程都能拿到, 只能查询.
+ *
+ * 配置空间只由 pcid 访问, 驱动之间不会在 0xCF8/0xCFC 上互相踩.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <xnix/abi/io.h>
+#include <xnix/driver/ioport.h>
+#include <xnix/env.h>
+#include <xnix/ipc.h>
+#include <xnix/protocol/devfs.h>
+#include <xnix/protocol/pci.h>
+#include <xnix/svc.h>
+#include <xnix/sys/server.h>
+#include <xnix/syscall.h>
+
+#define PCI_CONFIG_ADDR 0xCF8
+#define PCI_CONFIG_DATA 0xCFC
+
+#define PCI_MAX_DEVS     64
+#define PCI_MAX_MMIO     4 /* 一条 IPC 消息最多携带的 handle 数 */
+#define PCI_DESC_BUF_MAX 512
+#define PCI_MAX_OWNERS   32 /* 每个属主进程占用退出事件的一位 */
+
+struct pci_device {
+    struct pci_dev_info info;
+    int                 irq;      /* 解析后的 IRQ, -2=尚未解析, -1=无 */
+    pid_t               owner;    /* claim 的进程, 0=空闲 */
+    handle_t            mmio[PCI_BAR_COUNT]; /* 内存 BAR 的 physmem handle (懒创建) */
+};
+
+/*
+ * 属主进程
+ *
+ * 进程第一次 claim 时登记并 watch 它的退出, 槽位保留到进程退出为止,
+ * 期间 release 不回收槽位, 避免已触发的退出位落到新属主头上.
+ */
+struct pci_owner {
+    pid_t    pid;   /* 0=空闲 */
+    handle_t watch; /* sys_proc_watch 返回的 handle */
+};
+
+static struct pci_device g_devs[PCI_MAX_DEVS];
+static int               g_dev_count;
+static struct pci_owner  g_owners[PCI_MAX_OWNERS];
+static handle_t          g_exit_event = HANDLE_INVALID;
+
+/* 驱动 endpoint, 查询 endpoint 和退出监视各一个线程, 共享状态由 g_lock 保护 */
+static pthread_mutex_t g_lock;
+
+/* IO_READ 回复指向的缓冲区, 每个服务线程一份 (回复在放锁之后才拷贝) */
+static char g_desc_buf[2][PCI_DESC_BUF_MAX];
+
+/* ============== 配置空间访问 ============== */
+
+static uint32_t pci_cfg_addr(uint8_t bus, uint8_t dev, uint8_t fn, uint8_t off) {
+    return 0x80000000u | ((uint32_t)bus << 16) | ((uint32_t)dev << 11) | ((uint32_t)fn << 8) |
+           (off & 0xFC);
+}
+
+static uint32_t pci_cfg_read32(uint8_t bus, uint8_t dev, uint8_t fn, uint8_t off) {
+    ioport_native_outl(PCI_CONFIG_ADDR, pci_cfg_addr(bus, dev, fn, off));
+    return ioport_native_inl(PCI_CONFIG_DATA);
+}
+
+static void pci_cfg_write32(uint8_t bus, uint8_t dev, uint8_t fn, uint8_t off, uint32_t val) {
+    ioport_native_outl(PCI_CONFIG_ADDR, pci_cfg_addr(bus, dev, fn, off));
+    ioport_native_outl(PCI_CONFIG_DATA, val);
+}
+
+/* 按宽度读写, 非 32 位访问通过读-改-写完成 */
+static uint32_t pci_cfg_read(const struct pci_dev_info *d, uint8_t off, uint32_t width) {
+    uint32_t v     = pci_cfg_read32(d->bus, d->dev, d->fn, off);
+    uint32_t shift = (off & 3) * 8;
+    if (width == 4) {
+        return v;
+    }
+    return (v >> shift) & (width == 2 ? 0xFFFF : 0xFF);
+}
+
+static void pci_cfg_write(const struct pci_dev_info *d, uint8_t off, uint32_t width,
+                          uint32_t val) {
+    if (width != 4) {
+        uint32_t shift = (off & 3) * 8;
+        uint32_t mask  = (width == 2 ? 0xFFFFu : 0xFFu) << shift;
+        uint32_t old   = pci_cfg_read32(d->bus, d->dev, d->fn, off);
+        val            = (old & ~mask) | ((val << shift) & mask);
+    }
+    pci_cfg_write32(d->bus, d->dev, d->fn, off, val);
+}
+
+/* ============== 枚举 ============== */
+
+/*
+ * 设备是否响应不经 BAR 的固定地址: 兼容模式的 IDE 通道 (0x1F0/0x170)
+ * 和显示设备 (0xA0000, 0x3C0). 这些地址还有不经 pcid 的使用者
+ * (内核控制台, 走 PIO 的从盘实例), 不能随 claim/release 关掉解码.
+ */
+static bool pci_legacy_decode(const struct pci_dev_info *d) {
+    if (d->class_code == 0x01 && d->subclass == 0x01) {
+        return (d->prog_if & 0x05) != 0x05; /* 任一通道不在 native 模式 */
+    }
+    return d->class_code == 0x03 || (d->class_code == 0x00 && d->subclass == 0x01);
+}
+
+/**
+ * 探测 BAR 大小: 写全 1 读回掩码, 期间关闭解码避免设备响应错误地址
+ *
+ * 磁盘驱动在 pcid 就绪后才启动, 此时只有内核控制台在用显示设备;
+ * 已打开解码的显示设备不探测, BAR 信息留空.
+ */
+static void pci_probe_bars(struct pci_dev_info *d) {
+    uint32_t cmd = pci_cfg_read32(d->bus, d->dev, d->fn, PCI_CFG_COMMAND);
+    if (d->class_code == 0x03 && (cmd & (PCI_CMD_IO | PCI_CMD_MEM))) {
+        return;
+    }
+    pci_cfg_write32(d->bus, d->dev, d->fn, PCI_CFG_COMMAND,
+                    cmd & ~(uint32_t)(PCI_CMD_IO | PCI_CMD_MEM));
+
+    for (int i = 0; i < PCI_BAR_COUNT; i++) {
+        uint8_t  off  = PCI_CFG_BAR0 + i * 4;
+        uint32_t orig = pci_cfg_read32(d->bus, d->dev, d->fn, off);
+
+        pci_cfg_write32(d->bus, d->dev, d->fn, off, 0xFFFFFFFF);
+        uint32_t mask = pci_cfg_read32(d->bus, d->dev, d->fn, off);
+        pci_cfg_write32(d->bus, d->dev, d->fn, off, orig);
+
+        if (mask == 0 || mask == 0xFFFFFFFF) {
+            continue;
+        }
+
+        if (orig & 1) {
+            /* IO BAR: 高 16 位可能读回 0, 只看端口空间 */
+            uint32_t size = (~(mask & 0xFFFFFFFC) + 1) & 0xFFFF;
+            d->bar_flags[i] = PCI_BAR_IO;
+            d->bar_base[i]  = orig & 0xFFFC;
+            d->bar_size[i]  = size;
+            continue;
+        }
+
+        d->bar_base[i] = orig & 0xFFFFFFF0;
+        d->bar_size[i] = ~(mask & 0xFFFFFFF0) + 1;
+        if (orig & 0x08) {
+            d->bar_flags[i] |= PCI_BAR_PREFETCH;
+        }
+        if (((orig >> 1) & 3) == 2 && i + 1 < PCI_BAR_COUNT) {
+            /* 64 位 BAR: 高半部分在下一个槽, 4GB 以上无法映射 */
+            uint32_t hi = pci_cfg_read32(d->bus, d->dev, d->fn, off + 4);
+            d->bar_flags[i] |= PCI_BAR_MEM64;
+            if (hi != 0) {
+                printf("[pci] %02x:%02x.%x BAR%d above 4GB, ignored\n", d->bus, d->dev, d->fn,
+                       i);
+                d->bar_size[i] = 0;
+            }
+            i++;
+        }
+    }
+
+    pci_cfg_write32(d->bus, d->dev, d->fn, PCI_CFG_COMMAND, cmd);
+}
+
+static void pci_add_function(uint8_t bus, uint8_t dev, uint8_t fn, uint32_t id) {
+    if (g_dev_count >= PCI_MAX_DEVS) {
+        return;
+    }
+
+    struct pci_device *p = &g_devs[g_dev_count++];
+    memset(p, 0, sizeof(*p));
+    p->irq = -2;
+
+    struct pci_dev_info *d = &p->info;
+    d->bus                 = bus;
+    d->dev                 = dev;
+    d->fn                  = fn;
+    d->vendor              = id & 0xFFFF;
+    d->device              = id >> 16;
+
+    uint32_t class = pci_cfg_read32(bus, dev, fn, PCI_CFG_CLASS);
+    d->revision    = class & 0xFF;
+    d->prog_if     = (class >> 8) & 0xFF;
+    d->subclass    = (class >> 16) & 0xFF;
+    d->class_code  = class >> 24;
+
+    uint32_t irq = pci_cfg_read32(bus, dev, fn, PCI_CFG_IRQ);
+    d->irq_line  = irq & 0xFF;
+    d->irq_pin   = (irq >> 8) & 0xFF;
+
+    /* 只有普通设备(header type 0)有 6 个 BAR 和子系统 ID */
+    uint32_t hdr = pci_cfg_read32(bus, dev, fn, PCI_CFG_HEADER);
+    if (((hdr >> 16) & 0x7F) == 0) {
+        uint32_t subsys  = pci_cfg_read32(bus, dev, fn, PCI_CFG_SUBSYS);
+        d->subsys_vendor = subsys & 0xFFFF;
+        d->subsys_id     = subsys >> 16;
+        pci_probe_bars(d);
+    }
+
+    for (int i = 0; i < PCI_BAR_COUNT; i++) {
+        p->mmio[i] = HANDLE_INVALID;
+    }
+}
+
+static void pci_scan(void) {
+    for (uint32_t bus = 0; bus < 256; bus++) {
+        for (uint8_t dev = 0; dev < 32; dev++) {
+            for (uint8_t fn = 0; fn < 8; fn++) {
+                uint32_t id = pci_cfg_read32(bus, dev, fn, PCI_CFG_VENDOR);
+                if ((id & 0xFFFF) == 0xFFFF) {
+                    if (fn == 0) {
+                        break;
+                    }
+                    continue;
+                }
+                pci_add_function(bus, dev, fn, id);
+
+                /* 单功能设备的 1-7 号功能可能镜像 0 号, 不再继续 */
+                if (fn == 0 && !(pci_cfg_read32(bus, dev, 0, PCI_CFG_HEADER) & (0x80 << 16))) {
+                    break;
+                }
+            }
+        }
+    }
+}
+
+/* ============== 资源分配 ============== */
+
+static int pci_resolve_irq(struct pci_device *p) {
+    if (p->irq != -2) {
+        return p->irq;
+    }
+
+    p->irq = -1;
+    if (p->info.irq_pin >= 1 && p->info.irq_pin <= 4) {
+        int irq = sys_irq_route(p->info.bus, p->info.dev, p->info.irq_pin - 1, p->info.irq_line);
+        if (irq >= 0) {
+            p->irq = irq;
+        }
+    }
+    return p->irq;
+}
+
+/**
+ * 登记属主并监视其退出
+ * @return 0 成功, -ESRCH 进程已不存在, -ENOSPC 属主槽位已满
+ */
+static int pci_owner_watch(pid_t pid) {
+    int slot = -1;
+    for (int i = 0; i < PCI_MAX_OWNERS; i++) {
+        if (g_owners[i].pid == pid) {
+            return 0;
+        }
+        if (g_owners[i].pid == 0 && slot < 0) {
+            slot = i;
+        }
+    }
+    if (slot < 0) {
+        return -ENOSPC;
+    }
+
+    int watch = sys_proc_watch(pid, g_exit_event, 1u << slot);
+    if (watch < 0) {
+        return -ESRCH;
+    }
+    g_owners[slot].pid   = pid;
+    g_owners[slot].watch = (handle_t)watch;
+    return 0;
+}
+
+/*
+ * 关闭总线主控和解码, 设备回到空闲. IO 端口和 IRQ 授权由内核随进程回收.
+ * legacy 设备只关总线主控, 固定端口还有别的使用者.
+ */
+static void pci_release(struct pci_device *p) {
+    struct pci_dev_info *d   = &p->info;
+    uint32_t             off = PCI_CMD_BUSMASTER;
+    if (!pci_legacy_decode(d)) {
+        off |= PCI_CMD_IO | PCI_CMD_MEM;
+    }
+    uint32_t cmd = pci_cfg_read(d, PCI_CFG_COMMAND, 2);
+    pci_cfg_write(d, PCI_CFG_COMMAND, 2, cmd & ~off);
+    p->owner = 0;
+}
+
+/* 属主退出: 释放它 claim 的所有设备 */
+static void pci_owner_exit(int slot) {
+    pid_t pid = g_owners[slot].pid;
+
+    for (int i = 0; i < g_dev_count; i++) {
+        if (g_devs[i].owner == pid) {
+            const struct pci_dev_info *d = &g_devs[i].info;
+            printf("[pci] %02x:%02x.%x released, owner pid %d exited\n", d->bus, d->dev, d->fn,
+                   pid);
+            pci_release(&g_devs[i]);
+        }
+    }
+    sys_handle_close(g_owners[slot].watch);
+    g_owners[slot].pid   = 0;
+    g_owners[slot].watch = HANDLE_INVALID;
+}
+
+static void *pci_exit_thread(void *arg) {
+    (void)arg;
+
+    while (1) {
+        uint32_t bits = (uint32_t)sys_event_wait(g_exit_event);
+
+        pthread_mutex_lock(&g_lock);
+        for (int i = 0; i < PCI_MAX_OWNERS; i++) {
+            if ((bits & (1u << i)) && g_owners[i].pid != 0) {
+                pci_owner_exit(i);
+            }
+        }
+        pthread_mutex_unlock(&g_lock);
+    }
+    return NULL;
+}
+
+/**
+ * claim: 授予资源, 打开解码, 在 msg 中填好回复
+ */
+static int pci_claim(struct pci_device *p, pid_t pid, struct ipc_message *msg) {
+    if (p->owner != 0 && p->owner != pid) {
+        return -EBUSY;
+    }
+
+    /* 先登记退出监视, 之后才授予资源, 属主退出时一定能收回设备 */
+    int ret = pci_owner_watch(pid);
+    if (ret < 0) {
+        return ret;
+    }
+
+    struct pci_dev_info *d       = &p->info;
+    uint32_t             cmd_set = PCI_CMD_BUSMASTER;
+    uint32_t             bar_map = 0;
+    uint32_t             nh      = 0;
+
+    for (int i = 0; i < PCI_BAR_COUNT; i++) {
+        if (d->bar_size[i] == 0) {
+            continue;
+        }
+
+        if (d->bar_flags[i] & PCI_BAR_IO) {
+            uint32_t end = d->bar_base[i] + d->bar_size[i] - 1;
+            if (sys_ioport_grant(pid, (uint16_t)d->bar_base[i], (uint16_t)end) < 0) {
+                return -errno;
+            }
+            cmd_set |= PCI_CMD_IO;
+            continue;
+        }
+
+        cmd_set |= PCI_CMD_MEM;
+        if (nh >= PCI_MAX_MMIO) {
+            continue;
+        }
+        if (p->mmio[i] == HANDLE_INVALID) {
+            p->mmio[i] = sys_mmio_create(d->bar_base[i], d->bar_size[i]);
+            if (p->mmio[i] == HANDLE_INVALID) {
+                printf("[pci] %02x:%02x.%x BAR%d mmio 0x%x failed\n", d->bus, d->dev, d->fn, i,
+                       d->bar_base[i]);
+                continue;
+            }
+        }
+        msg->handles.handles[nh++] = p->mmio[i];
+        bar_map |= 1u << i;
+    }
+
+    int irq = pci_resolve_irq(p);
+    if (irq >= 0 && sys_irq_grant(pid, (uint8_t)irq) < 0) {
+        return -errno;
+    }
+
+    uint32_t cmd = pci_cfg_read(d, PCI_CFG_COMMAND, 2);
+    pci_cfg_write(d, PCI_CFG_COMMAND, 2, (cmd | cmd_set) & ~(uint32_t)PCI_CMD_INTX_DISABLE);
+
+    p->owner           = pid;
+    msg->regs.data[2]  = (uint32_t)irq;
+    msg->regs.data[3]  = bar_map;
+    msg->handles.count = nh;
+    return 0;
+}
+
+/* ============== 设备描述 (/dev/pci*) ============== */
+
+static int pci_describe(const struct pci_device *p, char *buf, size_t size) {
+    const struct pci_dev_info *d = &p->info;
+    int n = snprintf(buf, size, "%02x:%02x.%x %04x:%04x class %02x.%02x.%02x rev %02x\n", d->bus,
+                     d->dev, d->fn, d->vendor, d->device, d->class_code, d->subclass, d->prog_if,
+                     d->revision);
+
+    for (int i = 0; i < PCI_BAR_COUNT && n < (int)size; i++) {
+        if (d->bar_size[i] == 0) {
+            continue;
+        }
+        n += snprintf(buf + n, size - n, "  BAR%d %s 0x%x size 0x%x%s\n", i,
+                      (d->bar_flags[i] & PCI_BAR_IO) ? "io" : "mem", d->bar_base[i],
+                      d->bar_size[i], (d->bar_flags[i] & PCI_BAR_PREFETCH) ? " prefetch" : "");
+    }
+    if (d->irq_pin && n < (int)size) {
+        n += snprintf(buf + n, size - n, "  irq INT%c# line %u\n", 'A' + d->irq_pin - 1,
+                      d->irq_line);
+    }
+    if (p->owner && n < (int)size) {
+        n += snprintf(buf + n, size - n, "  owner pid %d\n", p->owner);
+    }
+    return n < (int)size ? n : (int)size - 1;
+}
+
+static void pci_register_devfs(handle_t devfs_ep, handle_t pci_ep) {
+    for (int i = 0; i < g_dev_count; i++) {
+        const struct pci_dev_info *d = &g_devs[i].info;
+        struct ipc_message         reg   = {0};
+        struct ipc_message         reply = {0};
+        char                       name[16];
+
+        snprintf(name, sizeof(name), "pci%02x:%02x.%x", d->bus, d->dev, d->fn);
+        reg.regs.data[0]       = UDM_DEVFS_REGISTER_DEV;
+        reg.regs.data[1]       = (uint32_t)i;
+        reg.handles.handles[0] = pci_ep;
+        reg.handles.count      = 1;
+        reg.buffer.data        = (uint64_t)(uintptr_t)name;
+        reg.buffer.size        = strlen(name);
+
+        if (sys_ipc_call(devfs_ep, &reg, &reply, 1000) < 0 || (int32_t)reply.regs.data[1] < 0) {
+            printf("[pci] register /dev/%s failed\n", name);
+        }
+    }
+}
+
+/* ============== 消息处理 ============== */
+
+static bool pci_id_match(const struct pci_dev_info *d, uint32_t ids, uint32_t cls) {
+    uint16_t vendor = ids & 0xFFFF;
+    uint16_t device = ids >> 16;
+    if (vendor != PCI_ANY_ID && vendor != d->vendor) {
+        return false;
+    }
+    if (device != PCI_ANY_ID && device != d->device) {
+        return false;
+    }
+    if ((cls & 0xFFFF) != PCI_ANY_ID &&
+        (cls & 0xFFFF) != (((uint32_t)d->class_code << 8) | d->subclass)) {
+        return false;
+    }
+    return true;
+}
+
+static bool pci_cfg_args_ok(uint32_t off, uint32_t width) {
+    return (width == 1 || width == 2 || width == 4) && off < 256 && (off & (width - 1)) == 0;
+}
+
+/**
+ * @param driver 请求来自 pci_ep (驱动), 否则来自 pci_dev_ep, 只允许查询
+ */
+static int pci_dispatch(struct ipc_message *msg, bool driver) {
+    uint32_t op    = msg->regs.data[0];
+    uint32_t index = msg->regs.data[1];
+    int      ret   = 0;
+
+    /* 请求里不应带 handle, 有则释放 */
+    for (uint32_t i = 0; i < msg->handles.count; i++) {
+        sys_handle_close(msg->handles.handles[i]);
+    }
+    msg->handles.count = 0;
+
+    if (!driver && (op == UDM_PCI_CLAIM || op == UDM_PCI_RELEASE || op == UDM_PCI_CFG_WRITE)) {
+        msg->buffer.data  = 0;
+        msg->buffer.size  = 0;
+        msg->regs.data[0] = op;
+        msg->regs.data[1] = (uint32_t)-EPERM;
+        return 0;
+    }
+
+    switch (op) {
+    case UDM_PCI_FIND: {
+        uint32_t ids   = msg->regs.data[1];
+        uint32_t cls   = msg->regs.data[2];
+        uint32_t start = msg->regs.data[3];
+
+        msg->buffer.data = 0;
+        msg->buffer.size = 0;
+        ret              = -ENOENT;
+        for (uint32_t i = start; i < (uint32_t)g_dev_count; i++) {
+            if (pci_id_match(&g_devs[i].info, ids, cls)) {
+                msg->buffer.data = (uint64_t)(uintptr_t)&g_devs[i].info;
+                msg->buffer.size = sizeof(struct pci_dev_info);
+                ret              = (int)i;
+                break;
+            }
+        }
+        msg->regs.data[0] = op;
+        msg->regs.data[1] = (uint32_t)ret;
+        return 0;
+    }
+
+    case UDM_PCI_CLAIM:
+        msg->buffer.data = 0;
+        msg->buffer.size = 0;
+        if (index >= (uint32_t)g_dev_count) {
+            ret = -ENODEV;
+        } else {
+            ret = pci_claim(&g_devs[index], (pid_t)msg->sender_pid, msg);
+            if (ret == 0) {
+                msg->buffer.data = (uint64_t)(uintptr_t)&g_devs[index].info;
+                msg->buffer.size = sizeof(struct pci_dev_info);
+            } else {
+                msg->handles.count = 0;
+            }
+        }
+        msg->regs.data[0] = op;
+        msg->regs.data[1] = (uint32_t)ret;
+        return 0;
+
+    case UDM_PCI_RELEASE:
+        msg->buffer.data = 0;
+        msg->buffer.size = 0;
+        if (index >= (uint32_t)g_dev_count) {
+            ret = -ENODEV;
+        } else if (g_devs[index].owner != (pid_t)msg->sender_pid) {
+            ret = -EPERM;
+        } else {
+            pci_release(&g_devs[index]);
+        }
+        msg->regs.data[0] = op;
+        msg->regs.data[1] = (uint32_t)ret;
+        return 0;
+
+    case UDM_PCI_CFG_READ:
+    case UDM_PCI_CFG_WRITE: {
+        uint32_t off   = msg->regs.data[2];
+        uint32_t width = msg->regs.data[3];
+        uint32_t val   = msg->regs.data[4];
+
+        msg->buffer.data = 0;
+        msg->buffer.size = 0;
+        if (index >= (uint32_t)g_dev_count) {
+            ret = -ENODEV;
+        } else if (!pci_cfg_args_ok(off, width)) {
+            ret = -EINVAL;
+        } else if (op == UDM_PCI_CFG_WRITE) {
+            if (g_devs[index].owner != (pid_t)msg->sender_pid) {
+                ret = -EPERM;
+            } else {
+                pci_cfg_write(&g_devs[index].info, (uint8_t)off, width, val);
+            }
+        } else {
+            msg->regs.data[2] = pci_cfg_read(&g_devs[index].info, (uint8_t)off, width);
+        }
+        msg->regs.data[0] = op;
+        msg->regs.data[1] = (uint32_t)ret;
+        return 0;
+    }
+
+    case IO_READ: {
+        uint32_t offset = msg->regs.data[2];
+        uint32_t max    = msg->regs.data[3];
+
+        msg->buffer.data = 0;
+        msg->buffer.size = 0;
+        if (index >= (uint32_t)g_dev_count) {
+            msg->regs.data[0] = (uint32_t)-ENODEV;
+            return 0;
+        }
+
+        char    *desc = g_desc_buf[driver ? 1 : 0];
+        uint32_t len  = (uint32_t)pci_describe(&g_devs[index], desc, PCI_DESC_BUF_MAX);
+        uint32_t n    = offset < len ? len - offset : 0;
+        if (n > max) {
+            n = max;
+        }
+        msg->regs.data[0] = n;
+        msg->buffer.data  = (uint64_t)(uintptr_t)(desc + offset);
+        msg->buffer.size  = n;
+        return 0;
+    }
+
+    case IO_CLOSE:
+        msg->regs.data[0] = 0;
+        msg->buffer.data  = 0;
+        msg->buffer.size  = 0;
+        return 0;
+
+    default:
+        msg->regs.data[0] = (uint32_t)-ENOSYS;
+        msg->buffer.data  = 0;
+        msg->buffer.size  = 0;
+        return 0;
+    }
+}
+
+static int pci_driver_handler(struct ipc_message *msg) {
+    pthread_mutex_lock(&g_lock);
+    int ret = pci_dispatch(msg, true);
+    pthread_mutex_unlock(&g_lock);
+    return ret;
+}
+
+static int pci_public_handler(struct ipc_message *msg) {
+    pthread_mutex_lock(&g_lock);
+    int ret = pci_dispatch(msg, false);
+    pthread_mutex_unlock(&g_lock);
+    return ret;
+}
+
+static void *pci_public_thread(void *arg) {
+    struct sys_server srv = {
+        .endpoint = *(handle_t *)arg,
+        .handler  = pci_public_handler,
+        .name     = "pci_dev",
+    };
+
+    sys_server_init(&srv);
+    sys_server_run(&srv);
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+
+    handle_t ep = env_require("pci_ep");
+    if (ep == HANDLE_INVALID) {
+        printf("[pci] FATAL: pci_ep not found\n");
+        return 1;
+    }
+    handle_t dev_ep = env_require("pci_dev_ep");
+    if (dev_ep == HANDLE_INVALID) {
+        printf("[pci] FATAL: pci_dev_ep not found\n");
+        return 1;
+    }
+
+    int ev = sys_event_create();
+    if (ev < 0) {
+        printf("[pci] FATAL: cannot create exit event\n");
+        return 1;
+    }
+    g_exit_event = (handle_t)ev;
+    pthread_mutex_init(&g_lock, NULL);
+
+    pci_scan();
+    printf("[pci] found %d function(s)\n", g_dev_count);
+    for (int i = 0; i < g_dev_count; i++) {
+        const struct pci_dev_info *d = &g_devs[i].info;
+        printf("[pci]   %02x:%02x.%x %04x:%04x class %02x.%02x\n", d->bus, d->dev, d->fn,
+               d->vendor, d->device, d->class_code, d->subclass);
+    }
+
+    handle_t devfs_ep = env_get_handle("devfs_ep");
+    if (devfs_ep != HANDLE_INVALID) {
+        pci_register_devfs(devfs_ep, dev_ep);
+    }
+
+    pthread_t tid;
+    if (pthread_create(&tid, NULL, pci_exit_thread, NULL) != 0 ||
+        pthread_create(&tid, NULL, pci_public_thread, &dev_ep) != 0) {
+        printf("[pci] FATAL: failed to create thread\n");
+        return 1;
+    }
+
+    svc_notify_ready("pci");
+
+    struct sys_server srv = {
+        .endpoint = ep,
+        .handler  = pci_driver_handler,
+        .name     = "pci",
+    };
+
+    sys_server_init(&srv);
+    sys_server_run(&srv);
+
+    return 0;
+}
@@ -7,7 +7,7 @@
  *
  * 架构:
  *   chardev 服务线程 ←─ CHARDEV_WRITE ─── termd
- *                    ──→ serial_putc_port()
+ *                    ──→ serial_write_port()
  *
  *   IRQ 监听线程 ──→ rx_buf ring buffer
  *   chardev 服务线程 ←─ CHARDEV_READ ──── termd
@@ -137,9 +137,7 @@ static int com_write(struct char_device *dev, const void *buf, size_t len) {
     const char *data = (const char *)buf;
 
     pthread_mutex_lock(&ctx->tx_lock);
-    for (size_t i = 0; i < len; i++) {
-        serial_putc_port(ctx->base, data[i]);
-    }
+    serial_write_port(ctx->base, data, len);
     pthread_mutex_unlock(&ctx->tx_lock);
 
     return (int)len;
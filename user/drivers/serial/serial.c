@@ -18,6 +18,7 @@
 #define REG_SCRATCH     7
 #define LSR_DATA_READY  0x01
 #define LSR_TX_EMPTY    0x20
+#define UART_FIFO_SIZE  16 /* 16550 发送 FIFO 深度 */
 
 int serial_probe(uint16_t port) {
     /* 写 scratch register 然后读回,匹配则端口存在 */
@@ -48,19 +49,52 @@ void serial_enable_irq(uint16_t port) {
     sys_ioport_outb(port + REG_INTR_ENABLE, 0x01);
 }
 
-void serial_putc_port(uint16_t port, char c) {
-    if (c == '\n') {
-        serial_putc_port(port, '\r');
-    }
+static void serial_wait_tx_empty(uint16_t port) {
     while (1) {
         int lsr = sys_ioport_inb(port + REG_LINE_STATUS);
         if (lsr >= 0 && (lsr & LSR_TX_EMPTY)) {
             break;
         }
     }
+}
+
+void serial_putc_port(uint16_t port, char c) {
+    if (c == '\n') {
+        serial_putc_port(port, '\r');
+    }
+    serial_wait_tx_empty(port);
     sys_ioport_outb(port + REG_DATA, (uint8_t)c);
 }
 
+/* THRE 置位时 FIFO 已空, 可一次 rep outsb 写满整个 FIFO */
+static void serial_tx_burst(uint16_t port, const char *burst, size_t n) {
+    serial_wait_tx_empty(port);
+    sys_ioport_outsb(port + REG_DATA, burst, n);
+}
+
+void serial_write_port(uint16_t port, const char *buf, size_t len) {
+    char   burst[UART_FIFO_SIZE];
+    size_t n = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        if (buf[i] == '\n') {
+            burst[n++] = '\r';
+            if (n == UART_FIFO_SIZE) {
+                serial_tx_burst(port, burst, n);
+                n = 0;
+            }
+        }
+        burst[n++] = buf[i];
+        if (n == UART_FIFO_SIZE) {
+            serial_tx_burst(port, burst, n);
+            n = 0;
+        }
+    }
+    if (n) {
+        serial_tx_burst(port, burst, n);
+    }
+}
+
 void serial_puts_port(uint16_t port, const char *s) {
     while (s && *s) {
         serial_putc_port(port, *s++);
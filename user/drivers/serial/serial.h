@@ -6,6 +6,7 @@
 #ifndef SERIALD_SERIAL_H
 #define SERIALD_SERIAL_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 /* 标准 COM 端口基地址 */
@@ -43,6 +44,11 @@ void serial_enable_irq(uint16_t port);
  */
 void serial_putc_port(uint16_t port, char c);
 
+/**
+ * 输出一段数据 (按 FIFO 深度成批写入, '\n' 转换为 "\r\n")
+ */
+void serial_write_port(uint16_t port, const char *buf, size_t len);
+
 /**
  * 输出字符串
  */
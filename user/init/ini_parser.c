@@ -133,16 +133,9 @@ int ini_parse_file(const char *path, ini_handler_t handler, void *ctx) {
         return -1;
     }
 
-    /* 打开文件 */
-    int fd = vfs_open(path, 0); /* VFS_O_RDONLY */
-    if (fd < 0) {
-        return fd;
-    }
-
-    /* 读取文件内容 (最大 4KB) */
+    /* 读取文件内容 (最大 4KB, 一次往返) */
     static char file_buf[4 * 1024];
-    int         bytes_read = vfs_read(fd, file_buf, sizeof(file_buf));
-    vfs_close(fd);
+    int         bytes_read = vfs_read_file(path, file_buf, sizeof(file_buf));
 
     if (bytes_read < 0) {
         return bytes_read;
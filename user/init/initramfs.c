@@ -2,7 +2,7 @@
  * @file initramfs.c
  * @brief Initramfs 提取器实现
  *
- * 从 FAT12 镜像提取文件到内存文件系统.
+ * 从 FAT12 镜像提取文件到内存文件系统. 簇链连续的文件就地引用镜像, 不复制.
  * 目前实现简化的 FAT12 读取,只支持根目录和一级子目录.
  */
 
@@ -109,6 +109,28 @@ static void fat_name_to_string(const char *name, const char *ext, char *out, siz
 static int fat12_read_file(struct ramfs_ctx *ctx, const char *path, const uint8_t *img,
                            const struct fat12_boot_sector *bs, const uint8_t *fat,
                            uint16_t first_cluster, uint32_t file_size) {
+    /* 计算数据区起始位置 */
+    uint32_t root_dir_sectors =
+        ((bs->root_entries * 32) + (bs->bytes_per_sector - 1)) / bs->bytes_per_sector;
+    uint32_t first_data_sector =
+        bs->reserved_sectors + (bs->num_fats * bs->sectors_per_fat) + root_dir_sectors;
+    uint32_t cluster_size = bs->sectors_per_cluster * bs->bytes_per_sector;
+
+    /* 簇链连续时直接引用镜像, 不复制 */
+    uint16_t c      = first_cluster;
+    uint32_t length = cluster_size;
+    while (length < file_size && !fat12_is_eof(c) && fat12_get_next_cluster(fat, c) == c + 1) {
+        c++;
+        length += cluster_size;
+    }
+    if (file_size == 0) {
+        return ramfs_add_image_file(ctx, path, NULL, 0);
+    }
+    if (length >= file_size) {
+        uint32_t sector = first_data_sector + (first_cluster - 2) * bs->sectors_per_cluster;
+        return ramfs_add_image_file(ctx, path, img + sector * bs->bytes_per_sector, file_size);
+    }
+
     /* 创建文件 */
     int fd = ramfs_open(ctx, path, VFS_O_CREAT | VFS_O_WRONLY);
     if (fd < 0) {
@@ -116,12 +138,6 @@ static int fat12_read_file(struct ramfs_ctx *ctx, const char *path, const uint8_
         return fd;
     }
 
-    /* 计算数据区起始位置 */
-    uint32_t root_dir_sectors =
-        ((bs->root_entries * 32) + (bs->bytes_per_sector - 1)) / bs->bytes_per_sector;
-    uint32_t first_data_sector =
-        bs->reserved_sectors + (bs->num_fats * bs->sectors_per_fat) + root_dir_sectors;
-
     /* 读取文件数据 */
     uint32_t offset  = 0;
     uint16_t cluster = first_cluster;
@@ -133,7 +149,7 @@ static int fat12_read_file(struct ramfs_ctx *ctx, const char *path, const uint8_
         const uint8_t *data   = img + sector * bs->bytes_per_sector;
 
         /* 计算本次读取大小 */
-        uint32_t chunk_size = bs->sectors_per_cluster * bs->bytes_per_sector;
+        uint32_t chunk_size = cluster_size;
         if (offset + chunk_size > file_size) {
             chunk_size = file_size - offset;
         }
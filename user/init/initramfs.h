@@ -2,7 +2,7 @@
  * @file initramfs.h
  * @brief Initramfs 提取器
  *
- * 负责从 initramfs.img (FAT12 镜像) 提取文件到内存文件系统.
+ * 负责把 initramfs 镜像中的目录和文件登记到内存文件系统.
  */
 
 #ifndef INITRAMFS_H
@@ -11,7 +11,9 @@
 #include "ramfs.h"
 
 /**
- * 从 initramfs.img 提取文件到 ramfs
+ * 从 initramfs 镜像建立 ramfs 目录树
+ *
+ * TAR 格式的文件内容就地引用镜像 (不复制), 镜像映射须一直保持.
  *
  * @param ctx       ramfs 上下文
  * @param img_addr  镜像起始地址
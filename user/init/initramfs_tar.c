@@ -1,6 +1,10 @@
 /**
  * @file initramfs_tar.c
- * @brief Initramfs TAR 格式提取器
+ * @brief Initramfs TAR 格式索引
+ *
+ * 只在 ramfs 中建目录和文件节点, 文件内容不复制: 节点直接引用 TAR 中的
+ * 数据块 (ramfs_add_image_file), 读取从启动模块页面直接拷出, 写入时才复制.
+ * 启动模块映射因此须在 init 整个生命周期内保持.
  */
 
 #include "initramfs.h"
@@ -49,7 +53,7 @@ int initramfs_extract(struct ramfs_ctx *ctx, const void *img_addr, uint32_t img_
     const uint8_t *img    = img_addr;
     uint32_t       offset = 0;
 
-    printf("[initramfs] Extracting from TAR archive (%u bytes)\n", img_size);
+    printf("[initramfs] Indexing TAR archive in place (%u bytes)\n", img_size);
 
     while (offset + TAR_BLOCK_SIZE <= img_size) {
         const struct tar_header *hdr = (const struct tar_header *)(img + offset);
@@ -111,28 +115,22 @@ int initramfs_extract(struct ramfs_ctx *ctx, const void *img_addr, uint32_t img_
 
         /* 处理普通文件 */
         if (hdr->typeflag == TAR_TYPE_FILE || hdr->typeflag == '\0') {
-            printf("[initramfs] Extracting file: %s (%u bytes)\n", fullpath, file_size);
+            printf("[initramfs] Adding file: %s (%u bytes)\n", fullpath, file_size);
 
-            /* 创建文件 */
-            int fd = ramfs_open(ctx, fullpath, VFS_O_CREAT | VFS_O_WRONLY);
-            if (fd < 0) {
-                printf("[initramfs] Failed to create file %s: %s\n", fullpath, strerror(-fd));
-                return fd;
+            /* 数据不得越过镜像末尾 */
+            const uint8_t *data = img + offset + TAR_BLOCK_SIZE;
+            if (file_size > img_size - offset - TAR_BLOCK_SIZE) {
+                printf("[initramfs] Truncated TAR entry: %s\n", fullpath);
+                return -EINVAL;
             }
 
-            /* 写入数据 */
-            if (file_size > 0) {
-                const uint8_t *data = img + offset + TAR_BLOCK_SIZE;
-                int            ret  = ramfs_write(ctx, fd, data, 0, file_size);
-                if (ret < 0) {
-                    printf("[initramfs] Write failed for %s: %s\n", fullpath, strerror(-ret));
-                    ramfs_close(ctx, fd);
-                    return ret;
-                }
+            /* 引用镜像中的数据, 不复制 */
+            int ret = ramfs_add_image_file(ctx, fullpath, data, file_size);
+            if (ret < 0) {
+                printf("[initramfs] Failed to create file %s: %s\n", fullpath, strerror(-ret));
+                return ret;
             }
 
-            ramfs_close(ctx, fd);
-
             /* 跳过文件数据(向上取整到 512 字节) */
             uint32_t data_blocks = (file_size + TAR_BLOCK_SIZE - 1) / TAR_BLOCK_SIZE;
             offset += TAR_BLOCK_SIZE + data_blocks * TAR_BLOCK_SIZE;
@@ -144,6 +142,6 @@ int initramfs_extract(struct ramfs_ctx *ctx, const void *img_addr, uint32_t img_
         }
     }
 
-    printf("[initramfs] Extraction complete\n");
+    printf("[initramfs] Indexing complete\n");
     return 0;
 }
@@ -0,0 +1,262 @@
+/**
+ * @file lz4.c
+ * @brief LZ4 帧格式解压
+ *
+ * 只实现解压, 对应 lz4 命令行工具的默认输出: 帧头 + 若干数据块 + 结束标记.
+ * 块可以是压缩块或原样存放的块, 块间可以互相引用 (linked blocks),
+ * 因为整个帧解到同一块连续缓冲区, 两种模式不需要区别处理.
+ *
+ * 帧头/块/内容校验和 (xxHash32) 只跳过不验证: 启动模块由引导器原样装入,
+ * 这里只保证错误数据不会让解压越界.
+ */
+
+#include "lz4.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <xnix/errno.h>
+
+#define LZ4_FLG_VERSION_MASK 0xC0
+#define LZ4_FLG_VERSION      0x40
+#define LZ4_FLG_BLOCK_CSUM   0x10
+#define LZ4_FLG_CONTENT_SIZE 0x08
+#define LZ4_FLG_RESERVED     0x02
+#define LZ4_FLG_DICT_ID      0x01
+#define LZ4_BD_RESERVED      0x8F
+#define LZ4_BLOCK_RAW        0x80000000u
+#define LZ4_MIN_MATCH        4
+
+static inline uint32_t lz4_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+           ((uint32_t)p[3] << 24);
+}
+
+/* 读扩展长度: 逐字节累加, 字节为 255 时继续 */
+static int lz4_ext_len(const uint8_t **ip, const uint8_t *iend, uint32_t *len) {
+    uint8_t b;
+    do {
+        if (*ip >= iend || *len > 0x7FFFFFFFu) {
+            return -EINVAL;
+        }
+        b = *(*ip)++;
+        *len += b;
+    } while (b == 255);
+    return 0;
+}
+
+/*
+ * 解一个压缩块, 写到 [op, oend)
+ * base 为整个帧输出的起点, 匹配可以引用之前各块解出的数据.
+ * @return 解出的字节数，负数错误码
+ */
+static int lz4_block(const uint8_t *ip, uint32_t size, const uint8_t *base, uint8_t *op,
+                     uint8_t *oend) {
+    const uint8_t *iend   = ip + size;
+    uint8_t       *ostart = op;
+
+    while (ip < iend) {
+        uint8_t  token = *ip++;
+        uint32_t lit   = token >> 4;
+
+        if (lit == 15 && lz4_ext_len(&ip, iend, &lit) < 0) {
+            return -EINVAL;
+        }
+        if (lit > (uint32_t)(iend - ip) || lit > (uint32_t)(oend - op)) {
+            return -EINVAL;
+        }
+        memcpy(op, ip, lit);
+        op += lit;
+        ip += lit;
+
+        /* 最后一个序列只有字面量 */
+        if (ip == iend) {
+            break;
+        }
+
+        if (iend - ip < 2) {
+            return -EINVAL;
+        }
+        uint32_t offset = (uint32_t)ip[0] | ((uint32_t)ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (uint32_t)(op - base)) {
+            return -EINVAL;
+        }
+
+        uint32_t len = token & 15;
+        if (len == 15 && lz4_ext_len(&ip, iend, &len) < 0) {
+            return -EINVAL;
+        }
+        if ((uint32_t)(oend - op) < LZ4_MIN_MATCH || len > (uint32_t)(oend - op) - LZ4_MIN_MATCH) {
+            return -EINVAL;
+        }
+        len += LZ4_MIN_MATCH;
+
+        /*
+         * 源区间可能与目标重叠 (offset < len, 重复模式).
+         * [match, op) 始终是模式的整数倍, 每轮可复制的长度翻倍.
+         */
+        const uint8_t *match = op - offset;
+        while (len > 0) {
+            uint32_t n = (uint32_t)(op - match);
+            if (n > len) {
+                n = len;
+            }
+            memcpy(op, match, n);
+            op += n;
+            len -= n;
+        }
+    }
+
+    return (int)(op - ostart);
+}
+
+bool lz4_is_frame(const void *src, uint32_t size) {
+    return size >= 4 && lz4_le32(src) == LZ4_FRAME_MAGIC;
+}
+
+int lz4_frame_open(struct lz4_frame *f, const void *src, uint32_t size) {
+    const uint8_t *p = src;
+
+    memset(f, 0, sizeof(*f));
+    if (size < 7 || lz4_le32(p) != LZ4_FRAME_MAGIC) {
+        return -EINVAL;
+    }
+
+    uint8_t flg = p[4];
+    uint8_t bd  = p[5];
+    if ((flg & LZ4_FLG_VERSION_MASK) != LZ4_FLG_VERSION || (flg & LZ4_FLG_RESERVED) ||
+        (bd & LZ4_BD_RESERVED)) {
+        return -EINVAL;
+    }
+    if (flg & LZ4_FLG_DICT_ID) {
+        return -ENOSYS;
+    }
+
+    /* 块大小编号 4..7 对应 64KB/256KB/1MB/4MB */
+    uint32_t bsid = (bd >> 4) & 7;
+    if (bsid < 4) {
+        return -EINVAL;
+    }
+
+    uint32_t pos = 6;
+    if (flg & LZ4_FLG_CONTENT_SIZE) {
+        if (size < pos + 8 + 1) {
+            return -EINVAL;
+        }
+        /* 64 位原始大小, 超过 4GB 的模块不可能装进 32 位地址空间 */
+        if (lz4_le32(p + pos + 4) != 0) {
+            return -EFBIG;
+        }
+        f->content_size = lz4_le32(p + pos);
+        pos += 8;
+    }
+    pos++; /* 帧头校验和 */
+
+    f->src       = p;
+    f->src_size  = size;
+    f->pos       = pos;
+    f->block_max = 1u << (8 + 2 * bsid);
+    f->flags     = flg;
+    return 0;
+}
+
+int lz4_frame_next(struct lz4_frame *f, uint8_t *dst, uint32_t *dst_len, uint32_t dst_cap) {
+    if (f->done) {
+        return 0;
+    }
+    if (f->src_size - f->pos < 4) {
+        return -EINVAL;
+    }
+
+    uint32_t bsize = lz4_le32(f->src + f->pos);
+    f->pos += 4;
+
+    /* 结束标记, 其后可能的内容校验和不验证 */
+    if (bsize == 0) {
+        f->done = true;
+        return 0;
+    }
+
+    bool raw = bsize & LZ4_BLOCK_RAW;
+    bsize &= ~LZ4_BLOCK_RAW;
+    if (bsize == 0 || bsize > f->block_max || bsize > f->src_size - f->pos) {
+        return -EINVAL;
+    }
+
+    uint32_t room = dst_cap - *dst_len;
+    if (room > f->block_max) {
+        room = f->block_max;
+    }
+
+    const uint8_t *ip = f->src + f->pos;
+    uint8_t       *op = dst + *dst_len;
+    int            n;
+    if (raw) {
+        if (bsize > room) {
+            return -EINVAL;
+        }
+        memcpy(op, ip, bsize);
+        n = (int)bsize;
+    } else {
+        n = lz4_block(ip, bsize, dst, op, op + room);
+        if (n <= 0) {
+            return -EINVAL;
+        }
+    }
+
+    f->pos += bsize;
+    if (f->flags & LZ4_FLG_BLOCK_CSUM) {
+        if (f->src_size - f->pos < 4) {
+            return -EINVAL;
+        }
+        f->pos += 4;
+    }
+
+    *dst_len += (uint32_t)n;
+    return n;
+}
+
+void *lz4_decompress(const void *src, uint32_t size, uint32_t *out_size) {
+    struct lz4_frame f;
+    if (lz4_frame_open(&f, src, size) < 0) {
+        return NULL;
+    }
+
+    /* 原始大小未知时先按 4 倍压缩比估计, 不够再扩大 */
+    uint32_t cap = f.content_size ? f.content_size : size * 4;
+    uint32_t len = 0;
+    uint8_t *buf = malloc(cap ? cap : 1);
+    if (!buf) {
+        return NULL;
+    }
+
+    while (1) {
+        if (!f.content_size && cap - len < f.block_max) {
+            uint32_t new_cap = cap * 2 + f.block_max;
+            uint8_t *grown   = realloc(buf, new_cap);
+            if (!grown) {
+                free(buf);
+                return NULL;
+            }
+            buf = grown;
+            cap = new_cap;
+        }
+
+        int n = lz4_frame_next(&f, buf, &len, cap);
+        if (n < 0) {
+            free(buf);
+            return NULL;
+        }
+        if (n == 0) {
+            break;
+        }
+    }
+
+    if (f.content_size && len != f.content_size) {
+        free(buf);
+        return NULL;
+    }
+
+    *out_size = len;
+    return buf;
+}
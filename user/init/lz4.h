@@ -0,0 +1,59 @@
+/**
+ * @file lz4.h
+ * @brief LZ4 帧格式解压
+ *
+ * 用于解开构建时用 lz4 压缩的启动模块. 按块流式解压: 每次解出一个数据块,
+ * 追加到调用者的输出缓冲区, 块间引用 (linked blocks) 直接落在已解出的数据上.
+ */
+
+#ifndef LZ4_H
+#define LZ4_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define LZ4_FRAME_MAGIC 0x184D2204u
+
+/* 帧解压状态 */
+struct lz4_frame {
+    const uint8_t *src;
+    uint32_t       src_size;
+    uint32_t       pos;          /* 下一个块头在 src 中的偏移 */
+    uint32_t       content_size; /* 帧头记录的原始大小, 0 表示未记录 */
+    uint32_t       block_max;    /* 单块解压后的最大字节数 */
+    uint8_t        flags;        /* 帧头 FLG 字节 */
+    bool           done;         /* 已读到结束标记 */
+};
+
+/**
+ * 判断数据是否以 LZ4 帧魔数开头
+ */
+bool lz4_is_frame(const void *src, uint32_t size);
+
+/**
+ * 解析帧头
+ * @return 0 成功，-EINVAL 格式错误，-ENOSYS 不支持的特性 (预置字典)，-EFBIG 超过 4GB
+ */
+int lz4_frame_open(struct lz4_frame *f, const void *src, uint32_t size);
+
+/**
+ * 解出下一个块, 追加到 dst[*dst_len, dst_cap)
+ *
+ * dst 须从帧的第一个字节开始连续存放 (块间引用依赖之前解出的数据).
+ * 调用前应保证剩余空间不少于 f->block_max.
+ *
+ * @return 本次解出的字节数, 0 表示帧结束, 负数错误码
+ */
+int lz4_frame_next(struct lz4_frame *f, uint8_t *dst, uint32_t *dst_len, uint32_t dst_cap);
+
+/**
+ * 把整个帧解压到新分配的缓冲区
+ *
+ * 帧头记录了原始大小时一次分配到位, 否则随解压进度按需扩大.
+ *
+ * @param out_size 输出解压后的大小
+ * @return 缓冲区 (调用者 free), 失败返回 NULL
+ */
+void *lz4_decompress(const void *src, uint32_t size, uint32_t *out_size);
+
+#endif /* LZ4_H */
@@ -12,37 +12,234 @@
 #include <xnix/ipc.h>
 #include <xnix/syscall.h>
 
-/* 分配节点 */
-static struct ramfs_node *alloc_node(struct ramfs_ctx *ctx) {
-    for (int i = 0; i < RAMFS_MAX_NODES; i++) {
-        if (!ctx->nodes[i].in_use) {
-            memset(&ctx->nodes[i], 0, sizeof(struct ramfs_node));
-            ctx->nodes[i].in_use = true;
-            return &ctx->nodes[i];
+/* ============== 节点与目录项哈希 ============== */
+
+static uint32_t ramfs_hash(const struct ramfs_node *parent, const char *name, size_t len) {
+    uint32_t h = 2166136261u ^ (uint32_t)(uintptr_t)parent;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (uint8_t)name[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/* 节点数超过桶数时桶数翻倍; 分配失败就沿用旧表, 只是链变长 */
+static void ramfs_hash_grow(struct ramfs_ctx *ctx) {
+    uint32_t            nbuckets = (ctx->hmask + 1) * 2;
+    struct ramfs_node **tab      = calloc(nbuckets, sizeof(*tab));
+    if (!tab) {
+        return;
+    }
+
+    for (uint32_t i = 0; i <= ctx->hmask; i++) {
+        struct ramfs_node *node = ctx->htab[i];
+        while (node) {
+            struct ramfs_node *next = node->hash_next;
+            uint32_t           b    = node->hash & (nbuckets - 1);
+            node->hash_next         = tab[b];
+            tab[b]                  = node;
+            node                    = next;
+        }
+    }
+
+    free(ctx->htab);
+    ctx->htab  = tab;
+    ctx->hmask = nbuckets - 1;
+}
+
+static void ramfs_hash_insert(struct ramfs_ctx *ctx, struct ramfs_node *node) {
+    if (ctx->nnodes > ctx->hmask) {
+        ramfs_hash_grow(ctx);
+    }
+
+    uint32_t b      = node->hash & ctx->hmask;
+    node->hash_next = ctx->htab[b];
+    ctx->htab[b]    = node;
+    ctx->nnodes++;
+}
+
+static void ramfs_hash_remove(struct ramfs_ctx *ctx, struct ramfs_node *node) {
+    struct ramfs_node **pp = &ctx->htab[node->hash & ctx->hmask];
+    while (*pp && *pp != node) {
+        pp = &(*pp)->hash_next;
+    }
+    if (*pp) {
+        *pp = node->hash_next;
+        ctx->nnodes--;
+    }
+    node->hash_next = NULL;
+}
+
+/* 在 parent 下按名字查找子节点 */
+static struct ramfs_node *ramfs_hash_find(struct ramfs_ctx *ctx, const struct ramfs_node *parent,
+                                          const char *name, size_t len) {
+    uint32_t h = ramfs_hash(parent, name, len);
+    for (struct ramfs_node *node = ctx->htab[h & ctx->hmask]; node; node = node->hash_next) {
+        if (node->hash == h && node->parent == parent && node->name_len == len &&
+            memcmp(node->name, name, len) == 0) {
+            return node;
         }
     }
     return NULL;
 }
 
+static char *ramfs_strndup(const char *name, size_t len) {
+    char *copy = malloc(len + 1);
+    if (copy) {
+        memcpy(copy, name, len);
+        copy[len] = '\0';
+    }
+    return copy;
+}
+
+/* 以 name (接管所有权) 挂到 parent 下: 兄弟链表头 + 哈希表 */
+static void ramfs_link(struct ramfs_ctx *ctx, struct ramfs_node *parent, struct ramfs_node *node,
+                       char *name, size_t len) {
+    if (node->name != name) {
+        free(node->name);
+    }
+    node->name     = name;
+    node->name_len = (uint32_t)len;
+    node->parent   = parent;
+    node->hash     = ramfs_hash(parent, name, len);
+
+    node->prev = NULL;
+    node->next = parent->children;
+    if (parent->children) {
+        parent->children->prev = node;
+    }
+    parent->children = node;
+
+    ramfs_hash_insert(ctx, node);
+    ctx->dir_gen++;
+}
+
+/* 从父目录摘下 (名字保留) */
+static void ramfs_unlink(struct ramfs_ctx *ctx, struct ramfs_node *node) {
+    ramfs_hash_remove(ctx, node);
+
+    if (node->prev) {
+        node->prev->next = node->next;
+    } else {
+        node->parent->children = node->next;
+    }
+    if (node->next) {
+        node->next->prev = node->prev;
+    }
+    node->next = NULL;
+    node->prev = NULL;
+    ctx->dir_gen++;
+}
+
+/* 分配节点 */
+/* 内容版本计数: 新节点和每次修改都取新值, 释放后同地址的新节点也不会撞上旧版本 */
+static uint32_t g_ramfs_version;
+
+static struct ramfs_node *alloc_node(uint32_t type) {
+    struct ramfs_node *node = calloc(1, sizeof(*node));
+    if (node) {
+        node->type    = type;
+        node->version = ++g_ramfs_version;
+    }
+    return node;
+}
+
+/*
+ * 文件内容改变: 换新版本, 作废内核中的文件页缓存
+ * 页缓存以 main_ep 为缓存 endpoint, 节点地址为文件标识 (与 IO_MAP 一致).
+ * 内核里没有这个节点的缓存时不发系统调用, 连续写只在第一次作废.
+ */
+static void ramfs_node_changed(struct ramfs_ctx *ctx, struct ramfs_node *node) {
+    node->version = ++g_ramfs_version;
+    if (node->cached && ctx->main_ep != HANDLE_INVALID) {
+        node->cached = false;
+        struct abi_fcache_args args = {
+            .op       = ABI_FCACHE_INVAL,
+            .cache_ep = ctx->main_ep,
+            .key      = (uint32_t)(uintptr_t)node,
+        };
+        sys_fcache_ctl(&args);
+    }
+}
+
+/* 写入后换新版本; 内核有这个节点的缓存时把写入的数据交给它就地更新, 映射者随之看到 */
+static void ramfs_node_written(struct ramfs_ctx *ctx, struct ramfs_node *node, const void *buf,
+                               uint32_t offset, uint32_t size) {
+    node->version = ++g_ramfs_version;
+    if (node->cached && ctx->main_ep != HANDLE_INVALID) {
+        struct abi_fcache_args args = {
+            .op        = ABI_FCACHE_UPDATE,
+            .cache_ep  = ctx->main_ep,
+            .key       = (uint32_t)(uintptr_t)node,
+            .version   = node->version,
+            .file_size = node->size,
+            .offset    = offset,
+            .len       = size,
+            .buf       = (uint32_t)(uintptr_t)buf,
+        };
+        sys_fcache_ctl(&args);
+    }
+}
+
+/* 把读出的整页交给内核页缓存, 不覆盖整页 (也不到文件末尾) 的读不填 */
+static void ramfs_cache_fill(struct ramfs_ctx *ctx, struct ramfs_node *node, const void *buf,
+                             uint32_t offset, uint32_t size) {
+    uint32_t end   = offset + size;
+    uint32_t first = (offset + ABI_FCACHE_PAGE_SIZE - 1) & ~(ABI_FCACHE_PAGE_SIZE - 1);
+    if (ctx->main_ep == HANDLE_INVALID || first >= end ||
+        (end - first < ABI_FCACHE_PAGE_SIZE && end != node->size)) {
+        return;
+    }
+
+    node->cached = true;
+
+    struct abi_fcache_args args = {
+        .op        = ABI_FCACHE_FILL,
+        .cache_ep  = ctx->main_ep,
+        .key       = (uint32_t)(uintptr_t)node,
+        .version   = node->version,
+        .file_size = node->size,
+        .offset    = offset,
+        .len       = size,
+        .buf       = (uint32_t)(uintptr_t)buf,
+    };
+    sys_fcache_ctl(&args);
+}
+
+/* 释放文件内容 */
+static void ramfs_free_data(struct ramfs_ctx *ctx, struct ramfs_node *node) {
+    for (uint32_t i = 0; i < node->nchunks; i++) {
+        free(node->chunks[i]);
+    }
+    free(node->chunks);
+    node->chunks  = NULL;
+    node->nchunks = 0;
+    node->image   = NULL;
+    node->size    = 0;
+    ramfs_node_changed(ctx, node);
+}
+
 /* 释放节点 */
-static void free_node(struct ramfs_node *node) {
+static void free_node(struct ramfs_ctx *ctx, struct ramfs_node *node) {
     if (!node) {
         return;
     }
-    if (node->data) {
-        free(node->data);
-        node->data = NULL;
-    }
-    node->in_use = false;
+    ramfs_free_data(ctx, node);
+    free(node->name);
+    free(node);
 }
 
 /* 分配句柄 */
 static int alloc_handle(struct ramfs_ctx *ctx, struct ramfs_node *node, uint32_t flags) {
     for (int i = 0; i < RAMFS_MAX_HANDLES; i++) {
         if (!ctx->handles[i].in_use) {
-            ctx->handles[i].node   = node;
-            ctx->handles[i].flags  = flags;
-            ctx->handles[i].in_use = true;
+            ctx->handles[i].node    = node;
+            ctx->handles[i].flags   = flags;
+            ctx->handles[i].in_use  = true;
+            ctx->handles[i].pager   = false;
+            ctx->handles[i].file_ep = HANDLE_INVALID;
+            ctx->handles[i].dir_pos = NULL;
+            node->nopen++;
             return i;
         }
     }
@@ -57,16 +254,23 @@ static struct ramfs_handle *get_handle(struct ramfs_ctx *ctx, uint32_t h) {
     return &ctx->handles[h];
 }
 
-/* 释放句柄 */
+/* 释放句柄, 已删除的节点随最后一个句柄释放 */
 static void free_handle(struct ramfs_ctx *ctx, uint32_t h) {
-    if (h < RAMFS_MAX_HANDLES) {
-        ctx->handles[h].in_use = false;
+    if (h >= RAMFS_MAX_HANDLES || !ctx->handles[h].in_use) {
+        return;
+    }
+
+    struct ramfs_node *node = ctx->handles[h].node;
+    ctx->handles[h].in_use  = false;
+    ctx->handles[h].node    = NULL;
+    if (node && --node->nopen == 0 && node->unlinked) {
+        free_node(ctx, node);
     }
 }
 
 /* 路径解析: 找到路径指向的节点 */
 static struct ramfs_node *lookup_path(struct ramfs_ctx *ctx, const char *path) {
-    if (!path || path[0] != '/') {
+    if (!path || path[0] != '/' || !ctx->root) {
         return NULL;
     }
 
@@ -96,22 +300,12 @@ static struct ramfs_node *lookup_path(struct ramfs_ctx *ctx, const char *path) {
             return NULL;
         }
 
-        struct ramfs_node *child = node->children;
-        struct ramfs_node *found = NULL;
-        while (child) {
-            if (strlen(child->name) == len && strncmp(child->name, p, len) == 0) {
-                found = child;
-                break;
-            }
-            child = child->next;
-        }
-
-        if (!found) {
+        node = ramfs_hash_find(ctx, node, p, len);
+        if (!node) {
             return NULL;
         }
 
-        node = found;
-        p    = (*end == '/') ? end + 1 : end;
+        p = (*end == '/') ? end + 1 : end;
     }
 
     return node;
@@ -173,21 +367,14 @@ int ramfs_open(void *vctx, const char *path, uint32_t flags) {
             return -ENAMETOOLONG;
         }
 
-        node = alloc_node(ctx);
-        if (!node) {
-            return -ENOSPC;
-        }
-
-        memcpy(node->name, name, name_len);
-        node->name[name_len] = '\0';
-        node->type           = RAMFS_TYPE_FILE;
-        node->size           = 0;
-        node->data           = NULL;
-        node->capacity       = 0;
-        node->parent         = parent;
-        node->children       = NULL;
-        node->next           = parent->children;
-        parent->children     = node;
+        node            = alloc_node(RAMFS_TYPE_FILE);
+        char *name_copy = ramfs_strndup(name, name_len);
+        if (!node || !name_copy) {
+            free(node);
+            free(name_copy);
+            return -ENOMEM;
+        }
+        ramfs_link(ctx, parent, node, name_copy, name_len);
     } else {
         if (node->type == RAMFS_TYPE_DIR) {
             return -EISDIR;
@@ -196,7 +383,7 @@ int ramfs_open(void *vctx, const char *path, uint32_t flags) {
             return -EEXIST;
         }
         if (flags & VFS_O_TRUNC) {
-            node->size = 0;
+            ramfs_free_data(ctx, node);
         }
     }
 
@@ -209,14 +396,101 @@ int ramfs_open(void *vctx, const char *path, uint32_t flags) {
 }
 
 int ramfs_close(void *vctx, uint32_t handle) {
-    struct ramfs_ctx *ctx = vctx;
-    if (!get_handle(ctx, handle)) {
+    struct ramfs_ctx    *ctx = vctx;
+    struct ramfs_handle *h   = get_handle(ctx, handle);
+    if (!h) {
         return -EBADF;
     }
+    if (h->file_ep != HANDLE_INVALID && ctx->main_ep != HANDLE_INVALID) {
+        struct abi_fcache_args args = {
+            .op       = ABI_FCACHE_UNBIND,
+            .cache_ep = ctx->main_ep,
+            .ep       = h->file_ep,
+        };
+        sys_fcache_ctl(&args);
+    }
     free_handle(ctx, handle);
     return 0;
 }
 
+/* 从 offset 拷出 size 字节 (调用者保证不越过文件末尾), 空块读出零 */
+static void ramfs_copy_out(const struct ramfs_node *node, void *buf, uint32_t offset,
+                           uint32_t size) {
+    uint8_t *dst = buf;
+
+    if (node->image) {
+        memcpy(dst, node->image + offset, size);
+        return;
+    }
+
+    while (size > 0) {
+        uint32_t idx = offset >> RAMFS_CHUNK_SHIFT;
+        uint32_t in  = offset & (RAMFS_CHUNK_SIZE - 1);
+        uint32_t n   = RAMFS_CHUNK_SIZE - in;
+        if (n > size) {
+            n = size;
+        }
+
+        const char *chunk = idx < node->nchunks ? node->chunks[idx] : NULL;
+        if (chunk) {
+            memcpy(dst, chunk + in, n);
+        } else {
+            memset(dst, 0, n);
+        }
+        dst += n;
+        offset += n;
+        size -= n;
+    }
+}
+
+/* 确保 chunks 数组至少容纳 count 块, 容量按倍数增长 */
+static int ramfs_reserve(struct ramfs_node *node, uint32_t count) {
+    if (count <= node->nchunks) {
+        return 0;
+    }
+
+    uint32_t cap = node->nchunks ? node->nchunks * 2 : 4;
+    while (cap < count) {
+        cap *= 2;
+    }
+
+    char **chunks = realloc(node->chunks, cap * sizeof(*chunks));
+    if (!chunks) {
+        return -ENOMEM;
+    }
+    memset(chunks + node->nchunks, 0, (cap - node->nchunks) * sizeof(*chunks));
+    node->chunks  = chunks;
+    node->nchunks = cap;
+    return 0;
+}
+
+/* 写时复制: 把镜像数据复制成分块, 之后按普通文件处理 */
+static int ramfs_unshare(struct ramfs_node *node) {
+    uint32_t count = (node->size + RAMFS_CHUNK_SIZE - 1) >> RAMFS_CHUNK_SHIFT;
+    if (ramfs_reserve(node, count) < 0) {
+        return -ENOMEM;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t off = i << RAMFS_CHUNK_SHIFT;
+        uint32_t n   = node->size - off < RAMFS_CHUNK_SIZE ? node->size - off : RAMFS_CHUNK_SIZE;
+
+        node->chunks[i] = calloc(1, RAMFS_CHUNK_SIZE);
+        if (!node->chunks[i]) {
+            /* 保持 "有 image 时没有分块" */
+            for (uint32_t j = 0; j < i; j++) {
+                free(node->chunks[j]);
+                node->chunks[j] = NULL;
+            }
+            return -ENOMEM;
+        }
+        memcpy(node->chunks[i], node->image + off, n);
+    }
+
+    node->image = NULL;
+    return 0;
+}
+
 int ramfs_read(void *vctx, uint32_t handle, void *buf, uint32_t offset, uint32_t size) {
     struct ramfs_ctx    *ctx = vctx;
     struct ramfs_handle *h   = get_handle(ctx, handle);
@@ -238,42 +512,60 @@ int ramfs_read(void *vctx, uint32_t handle, void *buf, uint32_t offset, uint32_t
         size = avail;
     }
 
-    if (size > 0 && node->data) {
-        memcpy(buf, node->data + offset, size);
-    }
-
+    ramfs_copy_out(node, buf, offset, size);
+    ramfs_cache_fill(ctx, node, buf, offset, size);
     return (int)size;
 }
 
-int ramfs_write(void *vctx, uint32_t handle, const void *buf, uint32_t offset, uint32_t size) {
-    struct ramfs_ctx    *ctx = vctx;
-    struct ramfs_handle *h   = get_handle(ctx, handle);
-    if (!h) {
-        return -EBADF;
-    }
-
-    struct ramfs_node *node = h->node;
+/*
+ * 按块写入: 只为写到的块分配内存 (清零), 已有数据不搬动, 追加是 O(写入量).
+ * 截断总是释放全部块, 因此块内超出文件大小的部分始终为零.
+ */
+static int ramfs_node_write(struct ramfs_node *node, const void *buf, uint32_t offset,
+                            uint32_t size) {
     if (node->type == RAMFS_TYPE_DIR) {
         return -EISDIR;
     }
+    if (size == 0) {
+        return 0;
+    }
 
     uint32_t end = offset + size;
-    if (end > node->capacity) {
-        /* 扩展容量 */
-        uint32_t new_cap = (end + 4095) & ~4095;
-        char    *new_buf = realloc(node->data, new_cap);
-        if (!new_buf) {
-            return -ENOMEM;
+    if (end < offset) {
+        return -EFBIG;
+    }
+
+    if (node->image && ramfs_unshare(node) < 0) {
+        return -ENOMEM;
+    }
+
+    uint32_t first = offset >> RAMFS_CHUNK_SHIFT;
+    uint32_t last  = (end - 1) >> RAMFS_CHUNK_SHIFT;
+    if (ramfs_reserve(node, last + 1) < 0) {
+        return -ENOMEM;
+    }
+    for (uint32_t i = first; i <= last; i++) {
+        if (!node->chunks[i]) {
+            node->chunks[i] = calloc(1, RAMFS_CHUNK_SIZE);
+            if (!node->chunks[i]) {
+                return -ENOMEM;
+            }
         }
-        /* 清零新分配的空间 */
-        if (new_cap > node->capacity) {
-            memset(new_buf + node->capacity, 0, new_cap - node->capacity);
+    }
+
+    const uint8_t *src = buf;
+    uint32_t       pos = offset;
+    while (pos < end) {
+        uint32_t in = pos & (RAMFS_CHUNK_SIZE - 1);
+        uint32_t n  = RAMFS_CHUNK_SIZE - in;
+        if (n > end - pos) {
+            n = end - pos;
         }
-        node->data     = new_buf;
-        node->capacity = new_cap;
+        memcpy(node->chunks[pos >> RAMFS_CHUNK_SHIFT] + in, src, n);
+        src += n;
+        pos += n;
     }
 
-    memcpy(node->data + offset, buf, size);
     if (end > node->size) {
         node->size = end;
     }
@@ -281,6 +573,20 @@ int ramfs_write(void *vctx, uint32_t handle, const void *buf, uint32_t offset, u
     return (int)size;
 }
 
+int ramfs_write(void *vctx, uint32_t handle, const void *buf, uint32_t offset, uint32_t size) {
+    struct ramfs_ctx    *ctx = vctx;
+    struct ramfs_handle *h   = get_handle(ctx, handle);
+    if (!h) {
+        return -EBADF;
+    }
+
+    int ret = ramfs_node_write(h->node, buf, offset, size);
+    if (ret > 0) {
+        ramfs_node_written(ctx, h->node, buf, offset, (uint32_t)ret);
+    }
+    return ret;
+}
+
 static int ramfs_info(void *vctx, const char *path, struct vfs_info *info) {
     struct ramfs_ctx  *ctx  = vctx;
     struct ramfs_node *node = lookup_path(ctx, path);
@@ -295,6 +601,55 @@ static int ramfs_info(void *vctx, const char *path, struct vfs_info *info) {
     return 0;
 }
 
+/* 不建句柄, 直接从节点数据拷出文件开头 */
+static int ramfs_readfile(void *vctx, const char *path, void *buf, uint32_t size,
+                          struct vfs_info *info) {
+    struct ramfs_ctx  *ctx  = vctx;
+    struct ramfs_node *node = lookup_path(ctx, path);
+    if (!node) {
+        return -ENOENT;
+    }
+    if (node->type == RAMFS_TYPE_DIR) {
+        return -EISDIR;
+    }
+
+    memset(info, 0, sizeof(*info));
+    info->size = node->size;
+    info->type = VFS_TYPE_FILE;
+
+    if (size > node->size) {
+        size = node->size;
+    }
+    ramfs_copy_out(node, buf, 0, size);
+    return (int)size;
+}
+
+int ramfs_add_image_file(void *vctx, const char *path, const void *data, uint32_t size) {
+    struct ramfs_ctx *ctx = vctx;
+
+    int h = ramfs_open(ctx, path, VFS_O_CREAT | VFS_O_TRUNC | VFS_O_WRONLY);
+    if (h < 0) {
+        return h;
+    }
+
+    struct ramfs_node *node = ctx->handles[h].node;
+    node->image             = data;
+    node->size              = size;
+    ramfs_close(ctx, (uint32_t)h);
+    return 0;
+}
+
+const void *ramfs_file_data(void *vctx, uint32_t handle, uint32_t *size) {
+    struct ramfs_ctx    *ctx = vctx;
+    struct ramfs_handle *h   = get_handle(ctx, handle);
+    if (!h || !h->node->image) {
+        return NULL;
+    }
+
+    *size = h->node->size;
+    return h->node->image;
+}
+
 int ramfs_finfo(void *vctx, uint32_t handle, struct vfs_info *info) {
     struct ramfs_ctx    *ctx = vctx;
     struct ramfs_handle *h   = get_handle(ctx, handle);
@@ -328,36 +683,81 @@ static int ramfs_opendir(void *vctx, const char *path) {
     return h;
 }
 
-static int ramfs_readdir(void *vctx, uint32_t handle, uint32_t index, struct vfs_dirent *entry) {
-    struct ramfs_ctx    *ctx = vctx;
-    struct ramfs_handle *h   = get_handle(ctx, handle);
+static void ramfs_fill_dirent(struct vfs_dirent *entry, const struct ramfs_node *child) {
+    memset(entry, 0, sizeof(*entry));
+    strncpy(entry->name, child->name, VFS_NAME_MAX - 1);
+    entry->type = (child->type == RAMFS_TYPE_DIR) ? VFS_TYPE_DIR : VFS_TYPE_FILE;
+    entry->size = (child->type == RAMFS_TYPE_FILE) ? child->size : 0;
+}
+
+/* 第 index 个子节点, 不存在时返回 NULL */
+static struct ramfs_node *ramfs_dir_child(struct ramfs_ctx *ctx, uint32_t handle, uint32_t index,
+                                          int *err) {
+    struct ramfs_handle *h = get_handle(ctx, handle);
     if (!h) {
-        return -EBADF;
+        *err = -EBADF;
+        return NULL;
     }
 
     struct ramfs_node *node = h->node;
     if (node->type != RAMFS_TYPE_DIR) {
-        return -ENOTDIR;
+        *err = -ENOTDIR;
+        return NULL;
     }
 
-    /* 遍历到第 index 个子节点 */
+    /* 顺序读目录时从上次的位置接着走, 不必每次从头数 */
     struct ramfs_node *child = node->children;
-    for (uint32_t i = 0; i < index && child; i++) {
+    uint32_t           i     = 0;
+    if (h->dir_pos && h->dir_gen == ctx->dir_gen && h->dir_index <= index) {
+        child = h->dir_pos;
+        i     = h->dir_index;
+    }
+    for (; i < index && child; i++) {
         child = child->next;
     }
 
-    if (!child) {
-        return -ENOENT;
+    if (child) {
+        h->dir_pos   = child;
+        h->dir_index = index;
+        h->dir_gen   = ctx->dir_gen;
     }
+    *err = child ? 0 : -ENOENT;
+    return child;
+}
 
-    memset(entry, 0, sizeof(*entry));
-    strncpy(entry->name, child->name, VFS_NAME_MAX - 1);
-    entry->type = (child->type == RAMFS_TYPE_DIR) ? VFS_TYPE_DIR : VFS_TYPE_FILE;
-    entry->size = (child->type == RAMFS_TYPE_FILE) ? child->size : 0;
+static int ramfs_readdir(void *vctx, uint32_t handle, uint32_t index, struct vfs_dirent *entry) {
+    int                err;
+    struct ramfs_node *child = ramfs_dir_child(vctx, handle, index, &err);
+    if (!child) {
+        return err;
+    }
 
+    ramfs_fill_dirent(entry, child);
     return 0;
 }
 
+static int ramfs_getdents(void *vctx, uint32_t handle, uint32_t index, struct vfs_dirent *entries,
+                          uint32_t max) {
+    int                err;
+    struct ramfs_node *child = ramfs_dir_child(vctx, handle, index, &err);
+    if (!child) {
+        return err == -ENOENT ? 0 : err;
+    }
+
+    uint32_t n = 0;
+    for (; child && n < max; child = child->next) {
+        ramfs_fill_dirent(&entries[n++], child);
+    }
+
+    /* 游标停在下一批的第一项 */
+    if (child) {
+        struct ramfs_handle *h = get_handle(vctx, handle);
+        h->dir_pos             = child;
+        h->dir_index           = index + n;
+    }
+    return (int)n;
+}
+
 int ramfs_mkdir(void *vctx, const char *path) {
     struct ramfs_ctx *ctx = vctx;
 
@@ -376,19 +776,15 @@ int ramfs_mkdir(void *vctx, const char *path) {
         return -ENAMETOOLONG;
     }
 
-    struct ramfs_node *node = alloc_node(ctx);
-    if (!node) {
-        return -ENOSPC;
+    struct ramfs_node *node      = alloc_node(RAMFS_TYPE_DIR);
+    char              *name_copy = ramfs_strndup(name, name_len);
+    if (!node || !name_copy) {
+        free(node);
+        free(name_copy);
+        return -ENOMEM;
     }
 
-    memcpy(node->name, name, name_len);
-    node->name[name_len] = '\0';
-    node->type           = RAMFS_TYPE_DIR;
-    node->parent         = parent;
-    node->children       = NULL;
-    node->next           = parent->children;
-    parent->children     = node;
-
+    ramfs_link(ctx, parent, node, name_copy, name_len);
     return 0;
 }
 
@@ -405,19 +801,13 @@ static int ramfs_del(void *vctx, const char *path) {
         return -ENOTEMPTY;
     }
 
-    /* 从父目录链表移除 */
-    struct ramfs_node *parent = node->parent;
-    if (parent) {
-        struct ramfs_node **pp = &parent->children;
-        while (*pp && *pp != node) {
-            pp = &(*pp)->next;
-        }
-        if (*pp) {
-            *pp = node->next;
-        }
+    /* 仍有句柄打开时推迟到最后一个句柄关闭再释放 */
+    ramfs_unlink(ctx, node);
+    if (node->nopen > 0) {
+        node->unlinked = true;
+    } else {
+        free_node(ctx, node);
     }
-
-    free_node(node);
     return 0;
 }
 
@@ -446,28 +836,84 @@ static int ramfs_rename(void *vctx, const char *old_path, const char *new_path)
         return -ENAMETOOLONG;
     }
 
-    /* 从旧父目录移除 */
-    struct ramfs_node *old_parent = node->parent;
-    if (old_parent) {
-        struct ramfs_node **pp = &old_parent->children;
-        while (*pp && *pp != node) {
-            pp = &(*pp)->next;
-        }
-        if (*pp) {
-            *pp = node->next;
+    /* 目录不能移到自己下面 */
+    for (struct ramfs_node *p = new_parent; p; p = p->parent) {
+        if (p == node) {
+            return -EINVAL;
         }
     }
 
-    /* 更新名称和父目录 */
-    memcpy(node->name, new_name, new_name_len);
-    node->name[new_name_len] = '\0';
-    node->parent             = new_parent;
-    node->next               = new_parent->children;
-    new_parent->children     = node;
+    char *name_copy = ramfs_strndup(new_name, new_name_len);
+    if (!name_copy) {
+        return -ENOMEM;
+    }
+
+    ramfs_unlink(ctx, node);
+    ramfs_link(ctx, new_parent, node, name_copy, new_name_len);
+    return 0;
+}
+
+/* 复制文件内容: 镜像数据直接共享 (写入时各自复制), 分块逐块复制, 空块保持为空 */
+static int ramfs_copy_data(struct ramfs_node *dst, const struct ramfs_node *src) {
+    if (src->image) {
+        dst->image = src->image;
+        dst->size  = src->size;
+        return 0;
+    }
+
+    uint32_t count = (src->size + RAMFS_CHUNK_SIZE - 1) >> RAMFS_CHUNK_SHIFT;
+    if (count > src->nchunks) {
+        count = src->nchunks;
+    }
+    if (ramfs_reserve(dst, count) < 0) {
+        return -ENOMEM;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        if (!src->chunks[i]) {
+            continue;
+        }
+        dst->chunks[i] = malloc(RAMFS_CHUNK_SIZE);
+        if (!dst->chunks[i]) {
+            return -ENOMEM;
+        }
+        memcpy(dst->chunks[i], src->chunks[i], RAMFS_CHUNK_SIZE);
+    }
 
+    dst->size = src->size;
     return 0;
 }
 
+/* 服务端复制: 节点间直接搬数据, 不经 IPC 缓冲区 */
+static int ramfs_copy(void *vctx, const char *src_path, const char *dst_path) {
+    struct ramfs_ctx  *ctx = vctx;
+    struct ramfs_node *src = lookup_path(ctx, src_path);
+    if (!src) {
+        return -ENOENT;
+    }
+    if (src->type == RAMFS_TYPE_DIR) {
+        return -EISDIR;
+    }
+    if (lookup_path(ctx, dst_path) == src) {
+        return -EINVAL; /* 截断目标会先清掉源 */
+    }
+
+    int h = ramfs_open(ctx, dst_path, VFS_O_WRONLY | VFS_O_CREAT | VFS_O_TRUNC);
+    if (h < 0) {
+        return h;
+    }
+
+    struct ramfs_node *dst = ctx->handles[h].node;
+    int                ret = ramfs_copy_data(dst, src);
+    if (ret < 0) {
+        ramfs_free_data(ctx, dst);
+    } else {
+        ramfs_node_changed(ctx, dst);
+        ret = (int)dst->size;
+    }
+    ramfs_close(ctx, (uint32_t)h);
+    return ret;
+}
+
 /* VFS open wrapper (新签名: 创建 per-file ep) */
 static int ramfs_open_vfs(void *vctx, const char *path, uint32_t flags, handle_t *out_ep) {
     int h = ramfs_open(vctx, path, flags);
@@ -482,33 +928,56 @@ static int ramfs_open_vfs(void *vctx, const char *path, uint32_t flags, handle_t
 
     ctx->handles[h].file_ep = ep;
     *out_ep = ep;
+
+    /* 客户端之后的读先查内核页缓存 (会话号总是 0) */
+    if (ctx->main_ep != HANDLE_INVALID) {
+        struct abi_fcache_args args = {
+            .op       = ABI_FCACHE_BIND,
+            .cache_ep = ctx->main_ep,
+            .key      = (uint32_t)(uintptr_t)ctx->handles[h].node,
+            .ep       = ep,
+            .version  = ctx->handles[h].node->version,
+        };
+        sys_fcache_ctl(&args);
+    }
     return 0;
 }
 
 /* 操作接口(命名空间 + 目录 close,文件 IO 通过 file_ep 处理) */
 static struct vfs_operations ramfs_ops = {
-    .open    = ramfs_open_vfs,
-    .close   = ramfs_close,
-    .info    = ramfs_info,
-    .opendir = ramfs_opendir,
-    .readdir = ramfs_readdir,
-    .mkdir   = ramfs_mkdir,
-    .del     = ramfs_del,
-    .rename  = ramfs_rename,
+    .open     = ramfs_open_vfs,
+    .close    = ramfs_close,
+    .info     = ramfs_info,
+    .opendir  = ramfs_opendir,
+    .readdir  = ramfs_readdir,
+    .getdents = ramfs_getdents,
+    .mkdir    = ramfs_mkdir,
+    .del      = ramfs_del,
+    .rename   = ramfs_rename,
+    .readfile = ramfs_readfile,
+    .copy     = ramfs_copy,
 };
 
 void ramfs_init(struct ramfs_ctx *ctx) {
     memset(ctx, 0, sizeof(*ctx));
+    ctx->main_ep = HANDLE_INVALID;
+
+    /* 创建根目录 (不在哈希表中) 和目录项哈希表; 失败时所有查找返回 ENOENT */
+    struct ramfs_node  *root = alloc_node(RAMFS_TYPE_DIR);
+    struct ramfs_node **htab = calloc(RAMFS_HASH_MIN, sizeof(*htab));
+    char               *name = ramfs_strndup("/", 1);
+    if (!root || !htab || !name) {
+        free(root);
+        free(htab);
+        free(name);
+        return;
+    }
 
-    /* 创建根目录 */
-    ctx->root           = &ctx->nodes[0];
-    ctx->root->in_use   = true;
-    ctx->root->name[0]  = '/';
-    ctx->root->name[1]  = '\0';
-    ctx->root->type     = RAMFS_TYPE_DIR;
-    ctx->root->parent   = NULL;
-    ctx->root->children = NULL;
-    ctx->root->next     = NULL;
+    root->name     = name;
+    root->name_len = 1;
+    ctx->root      = root;
+    ctx->htab      = htab;
+    ctx->hmask     = RAMFS_HASH_MIN - 1;
 }
 
 struct vfs_operations *ramfs_get_ops(void) {
@@ -525,6 +994,185 @@ handle_t ramfs_get_file_ep(struct ramfs_ctx *ctx, int slot) {
 #define RAMFS_FILE_EP_BUF_SIZE 4096
 static char g_ramfs_file_buf[RAMFS_FILE_EP_BUF_SIZE];
 
+/* 文件 -> 管道: 直接从节点数据块写入管道, 不经过中转缓冲区 */
+static int ramfs_splice_out(struct ramfs_ctx *ctx, int slot, handle_t pipe_h, uint32_t offset,
+                            uint32_t size) {
+    struct ramfs_handle *h = get_handle(ctx, (uint32_t)slot);
+    if (!h) {
+        return -EBADF;
+    }
+
+    struct ramfs_node *node = h->node;
+    if (node->type == RAMFS_TYPE_DIR) {
+        return -EISDIR;
+    }
+    if (offset >= node->size) {
+        return 0;
+    }
+    if (size > node->size - offset) {
+        size = node->size - offset;
+    }
+
+    if (node->image) {
+        int n = sys_pipe_write_flags(pipe_h, node->image + offset, size, ABI_PIPE_NONBLOCK);
+        return n < 0 ? -errno : n;
+    }
+
+    /* 逐块写入管道, 管道写满即返回; 空块经中转缓冲区补零 */
+    uint32_t total = 0;
+    while (total < size) {
+        uint32_t pos = offset + total;
+        uint32_t in  = pos & (RAMFS_CHUNK_SIZE - 1);
+        uint32_t n   = RAMFS_CHUNK_SIZE - in;
+        if (n > size - total) {
+            n = size - total;
+        }
+
+        const char *src = node->chunks[pos >> RAMFS_CHUNK_SHIFT];
+        if (src) {
+            src += in;
+        } else {
+            if (n > RAMFS_FILE_EP_BUF_SIZE) n = RAMFS_FILE_EP_BUF_SIZE;
+            memset(g_ramfs_file_buf, 0, n);
+            src = g_ramfs_file_buf;
+        }
+
+        int w = sys_pipe_write_flags(pipe_h, src, n, ABI_PIPE_NONBLOCK);
+        if (w <= 0) {
+            if (total > 0) break;
+            return w < 0 ? -errno : 0;
+        }
+        total += (uint32_t)w;
+        if ((uint32_t)w < n) break;
+    }
+
+    return (int)total;
+}
+
+/* 管道 -> 文件: 按缓冲区大小分块搬运, 管道读空即返回 */
+static int ramfs_splice_in(struct ramfs_ctx *ctx, int slot, handle_t pipe_h, uint32_t offset,
+                           uint32_t size) {
+    uint32_t total = 0;
+
+    while (total < size) {
+        uint32_t chunk = size - total;
+        if (chunk > RAMFS_FILE_EP_BUF_SIZE) chunk = RAMFS_FILE_EP_BUF_SIZE;
+
+        int n = sys_pipe_read_flags(pipe_h, g_ramfs_file_buf, chunk, ABI_PIPE_NONBLOCK);
+        if (n <= 0) {
+            if (total > 0) break;
+            return n < 0 ? -errno : 0;
+        }
+
+        int w = ramfs_write(ctx, (uint32_t)slot, g_ramfs_file_buf, offset + total, (uint32_t)n);
+        if (w < 0) {
+            return total > 0 ? (int)total : w;
+        }
+        total += (uint32_t)w;
+        if (w < n) break;
+    }
+
+    return (int)total;
+}
+
+/* 为内核文件映射开一个缓页会话, 与 slot 共用节点, 缓页请求发到主 endpoint */
+static int ramfs_map(struct ramfs_ctx *ctx, int slot, const struct ipc_message *msg,
+                     struct ipc_message *reply) {
+    if (!(msg->flags & ABI_IPC_FLAG_KERNEL)) {
+        return -EPERM;
+    }
+    struct ramfs_handle *h = get_handle(ctx, (uint32_t)slot);
+    if (!h) {
+        return -EBADF;
+    }
+    if (h->node->type != RAMFS_TYPE_FILE || ctx->main_ep == HANDLE_INVALID) {
+        return -ENOSYS;
+    }
+
+    int p = alloc_handle(ctx, h->node, h->flags);
+    if (p < 0) {
+        return p;
+    }
+    ctx->handles[p].pager = true;
+    h->node->cached       = true;
+
+    reply->regs.data[1]       = (uint32_t)p;
+    reply->regs.data[2]       = (uint32_t)(uintptr_t)h->node;
+    reply->regs.data[3]       = h->node->size;
+    reply->regs.data[4]       = h->node->version;
+    reply->handles.handles[0] = ctx->main_ep;
+    reply->handles.count      = 1;
+    return 0;
+}
+
+/* 读一页: 镜像数据和整块数据直接作为回复缓冲区, 不复制 */
+static int ramfs_page_in(struct ramfs_node *node, uint32_t offset, uint32_t size,
+                         struct ipc_message *reply) {
+    if (offset >= node->size) {
+        return 0;
+    }
+    if (size > node->size - offset) {
+        size = node->size - offset;
+    }
+    if (size > RAMFS_FILE_EP_BUF_SIZE) {
+        size = RAMFS_FILE_EP_BUF_SIZE;
+    }
+
+    uint32_t    idx = offset >> RAMFS_CHUNK_SHIFT;
+    const char *src = NULL;
+    if (node->image) {
+        src = node->image + offset;
+    } else if ((offset & (RAMFS_CHUNK_SIZE - 1)) == 0 && size <= RAMFS_CHUNK_SIZE &&
+               idx < node->nchunks) {
+        src = node->chunks[idx];
+    }
+    if (!src) {
+        ramfs_copy_out(node, g_ramfs_file_buf, offset, size);
+        src = g_ramfs_file_buf;
+    }
+
+    reply->buffer.data = (uint64_t)(uintptr_t)src;
+    reply->buffer.size = size;
+    return (int)size;
+}
+
+int ramfs_pager_dispatch(struct ramfs_ctx *ctx, struct ipc_message *msg) {
+    uint32_t             op     = msg->regs.data[0];
+    uint32_t             slot   = msg->regs.data[1];
+    uint32_t             offset = msg->regs.data[2];
+    uint32_t             size   = msg->regs.data[3];
+    struct ramfs_handle *h      = get_handle(ctx, slot);
+    int                  result = -ENOSYS;
+    struct ipc_message   reply  = {0};
+
+    if (!(msg->flags & ABI_IPC_FLAG_KERNEL)) {
+        result = -EPERM;
+    } else if (!h || !h->pager) {
+        result = -EBADF;
+    } else if (op == IO_PAGE_IN) {
+        result = ramfs_page_in(h->node, offset, size, &reply);
+    } else if (op == IO_PAGE_OUT) {
+        /* 写回不改变文件大小, 也不改变内容版本 (缓存页本身就是最新内容) */
+        if (size > msg->buffer.size) {
+            size = msg->buffer.size;
+        }
+        if (offset >= h->node->size) {
+            size = 0;
+        } else if (size > h->node->size - offset) {
+            size = h->node->size - offset;
+        }
+        result = ramfs_node_write(h->node, (const void *)(uintptr_t)msg->buffer.data, offset,
+                                  size);
+    } else if (op == IO_CLOSE) {
+        free_handle(ctx, slot);
+        result = 0;
+    }
+
+    reply.regs.data[0] = (uint32_t)result;
+    sys_ipc_reply_to(msg->sender_tid, &reply);
+    return 0;
+}
+
 int ramfs_file_ep_dispatch(struct ramfs_ctx *ctx, int slot, struct ipc_message *msg) {
     uint32_t op = msg->regs.data[0];
     int      result = -ENOSYS;
@@ -555,6 +1203,37 @@ int ramfs_file_ep_dispatch(struct ramfs_ctx *ctx, int slot, struct ipc_message *
         }
         break;
     }
+    case IO_SPLICE_OUT:
+    case IO_SPLICE_IN: {
+        if (msg->handles.count < 1) {
+            result = -EBADF;
+            break;
+        }
+        handle_t pipe_h = msg->handles.handles[0];
+        uint32_t offset = msg->regs.data[2];
+        uint32_t size   = msg->regs.data[3];
+        if (op == IO_SPLICE_OUT) {
+            result = ramfs_splice_out(ctx, slot, pipe_h, offset, size);
+        } else {
+            result = ramfs_splice_in(ctx, slot, pipe_h, offset, size);
+        }
+        sys_handle_close(pipe_h);
+        break;
+    }
+    case IO_MAP:
+        result = ramfs_map(ctx, slot, msg, &reply);
+        break;
+    case IO_IOCTL: {
+        struct ramfs_handle *h = get_handle(ctx, (uint32_t)slot);
+        if (msg->regs.data[2] != VFS_IOCTL_GETSIZE) {
+            break;
+        }
+        result = h ? 0 : -EBADF;
+        if (h) {
+            reply.regs.data[1] = h->node->size;
+        }
+        break;
+    }
     case IO_CLOSE: {
         result = ramfs_close(ctx, slot);
         reply.regs.data[0] = (uint32_t)result;
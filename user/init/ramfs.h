@@ -11,26 +11,45 @@
 #include <vfs/vfs.h>
 
 #define RAMFS_NAME_MAX    255
-#define RAMFS_MAX_NODES   256
 #define RAMFS_MAX_HANDLES 64
 
+#define RAMFS_CHUNK_SHIFT 12
+#define RAMFS_CHUNK_SIZE  (1u << RAMFS_CHUNK_SHIFT) /* 文件数据分块大小 */
+#define RAMFS_HASH_MIN    64                        /* 目录项哈希表初始桶数 */
+
 /* 节点类型 */
 #define RAMFS_TYPE_FILE 0
 #define RAMFS_TYPE_DIR  1
 
-/* 文件/目录节点 */
+/*
+ * 文件/目录节点 (动态分配)
+ *
+ * 子节点既挂在父目录的双向链表上 (readdir 顺序), 也按 (父节点, 名字)
+ * 挂在全局哈希表上 (路径查找). 文件内容按 RAMFS_CHUNK_SIZE 分块,
+ * 追加只分配新块, 不搬动已有数据; 空块指针表示全零.
+ *
+ * 来自 initramfs 的文件不复制: image 直接指向启动模块中的数据,
+ * 第一次写入时才复制成分块 (写时复制), 截断则直接丢弃引用.
+ */
 struct ramfs_node {
-    char     name[RAMFS_NAME_MAX + 1];
-    uint32_t type;
-    uint32_t size;     /* 文件大小 */
-    char    *data;     /* 文件内容 */
-    uint32_t capacity; /* 已分配容量 */
+    char       *name;
+    uint32_t    name_len;
+    uint32_t    hash;
+    uint32_t    type;
+    uint32_t    size;    /* 文件大小 */
+    const char *image;   /* 只读镜像数据, 非 NULL 时 chunks 为空 */
+    char      **chunks;  /* 文件内容分块 */
+    uint32_t    nchunks; /* chunks 数组容量 */
+    uint32_t    nopen;   /* 打开的句柄数, 删除后最后一个句柄关闭时才释放 */
+    uint32_t    version; /* 内容版本, 全局递增, 文件映射据此判断缓存页是否过期 */
+    bool        cached;  /* 内核可能持有本版本的页缓存 (填充过或被映射过), 改写时才需通知内核 */
+    bool        unlinked;
 
     struct ramfs_node *parent;
-    struct ramfs_node *children; /* 目录的第一个子节点 */
-    struct ramfs_node *next;     /* 同级下一个节点 */
-
-    bool in_use;
+    struct ramfs_node *children;  /* 目录的第一个子节点 */
+    struct ramfs_node *next;      /* 同级下一个节点 */
+    struct ramfs_node *prev;      /* 同级上一个节点 */
+    struct ramfs_node *hash_next; /* 哈希桶链 */
 };
 
 /* 打开的文件句柄 */
@@ -39,13 +58,23 @@ struct ramfs_handle {
     uint32_t           flags;
     handle_t           file_ep; /* per-file endpoint (VFS 路径时有效) */
     bool               in_use;
+    bool               pager; /* 内核文件映射的缓页会话, 只接受内核发来的请求 */
+
+    /* 读目录游标: 第 dir_index 个子节点, 目录结构变化 (dir_gen 不同) 后作废 */
+    struct ramfs_node *dir_pos;
+    uint32_t           dir_index;
+    uint32_t           dir_gen;
 };
 
 /* 文件系统上下文 */
 struct ramfs_ctx {
-    struct ramfs_node   nodes[RAMFS_MAX_NODES];
     struct ramfs_handle handles[RAMFS_MAX_HANDLES];
     struct ramfs_node  *root;
+    struct ramfs_node **htab;    /* (父节点, 名字) -> 节点 */
+    uint32_t            hmask;   /* 桶数 - 1 */
+    uint32_t            nnodes;  /* 哈希表中的节点数 */
+    uint32_t            dir_gen; /* 每次增删改名加一 */
+    handle_t            main_ep; /* 服务主 endpoint, 缓页请求发到这里 */
 };
 
 /**
@@ -69,11 +98,29 @@ int ramfs_read(void *vctx, uint32_t handle, void *buf, uint32_t offset, uint32_t
 int ramfs_write(void *vctx, uint32_t handle, const void *buf, uint32_t offset, uint32_t size);
 int ramfs_finfo(void *vctx, uint32_t handle, struct vfs_info *info);
 
+/**
+ * 创建直接引用只读镜像数据的文件 (不复制, 写入时才复制)
+ * 调用者保证 data 在 ramfs 生命周期内一直有效.
+ * @return 0 成功，负数错误码
+ */
+int ramfs_add_image_file(void *vctx, const char *path, const void *data, uint32_t size);
+
+/**
+ * 取得文件内容的连续只读视图 (仅镜像文件), 用于免复制加载
+ * @return 数据指针, 文件内容不连续时返回 NULL
+ */
+const void *ramfs_file_data(void *vctx, uint32_t handle, uint32_t *size);
+
 /**
  * 处理 file_ep 上的 IO 消息
  */
 int ramfs_file_ep_dispatch(struct ramfs_ctx *ctx, int slot, struct ipc_message *msg);
 
+/**
+ * 处理主 endpoint 上内核发来的缓页请求 (IO_PAGE_IN/IO_PAGE_OUT/IO_CLOSE)
+ */
+int ramfs_pager_dispatch(struct ramfs_ctx *ctx, struct ipc_message *msg);
+
 /**
  * 获取指定 slot 的 file_ep handle
  */
@@ -51,7 +51,9 @@ static void ramfsd_main_loop(handle_t main_ep) {
 
         if (sys_ipc_receive(ready, &msg, 0) < 0) continue;
 
-        if (ready == main_ep) {
+        if (ready == main_ep && (msg.flags & ABI_IPC_FLAG_KERNEL)) {
+            ramfs_pager_dispatch(&g_service->ramfs, &msg);
+        } else if (ready == main_ep) {
             vfs_dispatch(ramfs_get_ops(), &g_service->ramfs, &msg);
         } else {
             int slot = find_slot_for_ep(ready);
@@ -94,6 +96,7 @@ int ramfsd_service_start(struct ramfsd_service *service) {
     }
 
     printf("[ramfsd] created endpoint: %u\n", service->endpoint);
+    service->ramfs.main_ep = service->endpoint;
 
     /* 创建服务线程 */
     service->running = true;
@@ -144,6 +144,18 @@ static int start_via_bootstrap(struct svc_manager *mgr, struct svc_config *cfg)
         return -ENOENT;
     }
 
+    /* initramfs 中的文件直接交给内核加载, 不复制 */
+    uint32_t    image_size;
+    const void *image = ramfs_file_data(ramfs, fd, &image_size);
+    if (image) {
+        struct proc_image_builder b;
+        proc_image_init(&b, cfg->name, image, image_size);
+        ramfs_close(ramfs, fd);
+
+        inject_svc_handles_image(&b, mgr, cfg);
+        return proc_image_spawn(&b);
+    }
+
     struct vfs_info info;
     if (ramfs_finfo(ramfs, fd, &info) < 0) {
         ramfs_close(ramfs, fd);
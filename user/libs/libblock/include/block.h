@@ -6,13 +6,22 @@
  *
  * 设备命名规范:
  *   - sda, sdb, sdc... 表示 SCSI/SATA/ATA 磁盘
+ *   - vda, vdb, vdc... 表示 VirtIO 磁盘
  *   - sda1, sda2... 表示分区
  *
+ * 注册的设备自动带一层扇区缓存 (见 block_read/block_write):
+ *   - 4KB 块为单位, 哈希索引 + LRU 淘汰
+ *   - 写回: 写入只标脏, 由淘汰/block_flush/后台线程周期写回
+ *   - 顺序读检测, 命中时预读后续块
+ *
+ * 缓存之下是请求队列 (见 block_submit): 每个设备一个派发线程, 按电梯顺序
+ * 取请求, 把相邻 LBA 同方向请求合并成一次驱动调用, 完成后回调.
+ *
  * 使用示例:
  *   struct block_device *dev = block_find("sda");
  *   if (dev) {
  *       char buf[512];
- *       dev->ops->read(dev->driver_ctx, 0, 1, buf);
+ *       block_read(dev, 0, 1, buf);
  *   }
  */
 
@@ -39,6 +48,7 @@ struct block_info {
     uint64_t sector_count;      /**< 扇区总数 */
     uint32_t sector_size;       /**< 扇区大小（字节） */
     uint32_t flags;             /**< 标志位 */
+    uint32_t max_sectors;       /**< 单次驱动调用最大扇区数 (0=BLOCK_QUEUE_MAX_SECTORS) */
     block_dev_type_t type;      /**< 设备类型 */
     char model[40];             /**< 设备型号 */
     char serial[20];            /**< 序列号 */
@@ -48,6 +58,61 @@ struct block_info {
 #define BLOCK_FLAG_REMOVABLE    (1 << 0)  /**< 可移动设备 */
 #define BLOCK_FLAG_READONLY     (1 << 1)  /**< 只读设备 */
 
+/* 缓存参数 */
+#define BLOCK_CACHE_BLOCK_SIZE  4096      /**< 缓存块大小（字节） */
+#define BLOCK_CACHE_DEFAULT     512       /**< 默认缓存块数 (2MB) */
+#define BLOCK_CACHE_DISABLED    0xFFFFFFFF /**< cache_blocks 取此值时不建缓存 */
+#define BLOCK_CACHE_RA_MAX      32        /**< 最大预读块数 */
+#define BLOCK_CACHE_FLUSH_MS    5000      /**< 后台写回周期 */
+
+/* 缓存统计 */
+struct block_cache_stats {
+    uint32_t hits;              /**< 命中块次数 */
+    uint32_t misses;            /**< 未命中块次数 */
+    uint32_t readahead;         /**< 预读块数 */
+    uint32_t writebacks;        /**< 写回块数 */
+    uint32_t cached;            /**< 当前缓存块数 */
+    uint32_t dirty;             /**< 当前脏块数 */
+    uint32_t capacity;          /**< 缓存容量（块） */
+};
+
+struct block_cache;
+struct block_queue;
+
+/* 请求队列参数 */
+#define BLOCK_QUEUE_MAX_SECTORS 256       /**< 默认合并上限 (128KB) */
+
+/* 请求方向 */
+#define BLOCK_OP_READ           0
+#define BLOCK_OP_WRITE          1
+
+struct block_request;
+
+/**
+ * 请求完成回调, 在设备派发线程中调用
+ * req->result 为 0 成功, 负数失败. 回调返回后 req 归还调用者.
+ */
+typedef void (*block_done_fn)(struct block_request *req);
+
+/* 块 IO 请求 (调用者分配, 完成回调前不得释放) */
+struct block_request {
+    uint64_t lba;               /**< 起始 LBA */
+    uint32_t count;             /**< 扇区数量 */
+    void *buffer;               /**< 数据缓冲区 */
+    uint32_t op;                /**< BLOCK_OP_READ / BLOCK_OP_WRITE */
+    int result;                 /**< 完成结果 */
+    block_done_fn done;         /**< 完成回调 */
+    void *priv;                 /**< 调用者私有数据 */
+    struct block_request *next; /**< 队列内部使用 */
+};
+
+/* 队列统计 */
+struct block_queue_stats {
+    uint32_t submitted;         /**< 提交的请求数 */
+    uint32_t dispatched;        /**< 实际的驱动调用数 */
+    uint32_t merged;            /**< 被合并进其他请求的请求数 */
+};
+
 /* 块设备操作 */
 struct block_ops {
     /**
@@ -93,6 +158,9 @@ struct block_device {
     struct block_ops *ops;      /**< 操作函数表 */
     void *driver_ctx;           /**< 驱动私有上下文 */
     struct block_info info;     /**< 设备信息缓存 */
+    uint32_t cache_blocks;      /**< 缓存块数 (0=默认, BLOCK_CACHE_DISABLED=不缓存) */
+    struct block_cache *cache;  /**< 扇区缓存 (注册时创建) */
+    struct block_queue *queue;  /**< 请求队列 (注册时创建) */
     bool valid;                 /**< 是否有效 */
 };
 
@@ -103,16 +171,66 @@ struct block_device {
  *
  * 设备名称会自动分配（如果冲突则使用下一个可用名称）
  * 例如：第一个 ATA 设备会命名为 sda
+ *
+ * 注册表保存 dev 的副本, 缓存挂在副本上: 读写请通过 block_find 返回的指针.
  */
 int block_register(struct block_device *dev);
 
 /**
- * 注销块设备
+ * 注销块设备 (先写回脏数据, 再释放缓存)
  * @param dev 设备实例
  * @return 0 成功，负数错误码
  */
 int block_unregister(struct block_device *dev);
 
+/**
+ * 经缓存读取扇区
+ * @param dev 设备（无缓存时直接调用 ops->read）
+ * @param lba 起始 LBA
+ * @param count 扇区数量
+ * @param buffer 输出缓冲区
+ * @return 0 成功，负数错误码
+ */
+int block_read(struct block_device *dev, uint64_t lba, uint32_t count, void *buffer);
+
+/**
+ * 经缓存写入扇区 (写回: 数据先留在缓存中)
+ * @return 0 成功，负数错误码
+ */
+int block_write(struct block_device *dev, uint64_t lba, uint32_t count, const void *buffer);
+
+/**
+ * 写回全部脏块并调用 ops->flush
+ * @return 0 成功，负数错误码
+ */
+int block_flush(struct block_device *dev);
+
+/**
+ * 异步提交请求
+ *
+ * 请求按 LBA 插入设备队列, 由派发线程按 C-LOOK 顺序处理: 与之相邻的
+ * 同方向请求合并成一次驱动调用 (不超过 info.max_sectors). 完成后调用
+ * req->done. 设备没有队列时同步执行并立即回调.
+ * 相互重叠的请求之间不保证顺序, 需要顺序的调用者应等前一个完成再提交.
+ *
+ * @param dev 设备
+ * @param req 请求
+ * @return 0 已受理，负数错误码 (此时不会回调)
+ */
+int block_submit(struct block_device *dev, struct block_request *req);
+
+/**
+ * 获取队列统计
+ * @return 0 成功，-1 设备无队列
+ */
+int block_queue_get_stats(struct block_device *dev, struct block_queue_stats *stats);
+
+/**
+ * 获取缓存统计
+ * @return 0 成功，-1 设备无缓存
+ */
+int block_cache_get_stats(struct block_device *dev, struct block_cache_stats *stats);
+
 /**
  * 查找块设备
  * @param name 设备名称 (sda, sdb, etc.)
@@ -1,6 +1,6 @@
 # libblock - 块设备抽象层
 #
-# 提供统一的块设备接口，支持 ATA、SCSI、VirtIO 等不同类型磁盘
+# 提供统一的块设备接口和扇区缓存，支持 ATA、SCSI、VirtIO 等不同类型磁盘
 
 set(LIB_NAME "block")
-set(LIB_DEPS "c")
+set(LIB_DEPS "c;pthread")
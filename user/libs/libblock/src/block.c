@@ -3,6 +3,8 @@
  * @brief 块设备抽象层实现
  */
 
+#include "block_internal.h"
+
 #include <block.h>
 #include <string.h>
 #include <stdio.h>
@@ -40,13 +42,13 @@ int block_alloc_name(block_dev_type_t type, char *name_out, int name_size) {
         }
     }
 
-    /* 生成名称: sda, sdb, sdc... */
+    /* 生成名称: sda, sdb, sdc... (VirtIO 为 vda, vdb...) */
     char suffix = 'a' + type_count;
     if (suffix > 'z') {
         return -1;  /* 超出范围 */
     }
 
-    snprintf(name_out, name_size, "sd%c", suffix);
+    snprintf(name_out, name_size, "%s%c", type == BLOCK_DEV_VIRTIO ? "vd" : "sd", suffix);
     return 0;
 }
 
@@ -89,9 +91,15 @@ int block_register(struct block_device *dev) {
     }
 
     dev->valid = true;
+    dev->cache = NULL;
+    dev->queue = NULL;
     block_devices[slot] = *dev;
     block_device_count++;
 
+    /* 队列和缓存挂在注册表中的副本上, 缓存经队列访问设备 */
+    block_queue_create(&block_devices[slot]);
+    block_cache_create(&block_devices[slot]);
+
     return 0;
 }
 
@@ -102,6 +110,8 @@ int block_unregister(struct block_device *dev) {
 
     for (int i = 0; i < BLOCK_MAX_DEVICES; i++) {
         if (block_devices[i].valid && &block_devices[i] == dev) {
+            block_cache_destroy(dev);
+            block_queue_destroy(dev);
             block_devices[i].valid = false;
             block_device_count--;
             return 0;
@@ -0,0 +1,590 @@
+/**
+ * @file block_cache.c
+ * @brief 块设备扇区缓存
+ *
+ * 以 BLOCK_CACHE_BLOCK_SIZE 为单位缓存扇区, 每块带扇区级 valid/dirty 位图,
+ * 所以整扇区写入无需先读. 块按哈希表索引, 用双向链表维护 LRU.
+ *
+ * 读未命中时把连续缺失的块合成一次设备读; 检测到顺序读时再向后预读,
+ * 预读窗口从 4 块开始逐次翻倍, 到 BLOCK_CACHE_RA_MAX 封顶, 随机读清零.
+ *
+ * 写入只标脏. 写回时机: 淘汰到脏块, block_flush, 以及后台线程每
+ * BLOCK_CACHE_FLUSH_MS 一次. 设备 IO 都经请求队列, 写回时所有脏块一起
+ * 提交, 由队列按 LBA 排序并合并相邻块.
+ */
+
+#include "block_internal.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <xnix/syscall.h>
+
+#define BC_RA_INIT 4
+
+struct bc_entry {
+    uint64_t         blk;
+    uint32_t         valid; /* 扇区有效位图 */
+    uint32_t         dirty; /* 扇区脏位图 */
+    bool             hashed;
+    struct bc_entry *hnext;
+    struct bc_entry *prev; /* LRU: prev 方向更新 */
+    struct bc_entry *next;
+    uint8_t         *data;
+    struct block_request wb; /* 异步写回请求 */
+};
+
+struct block_cache {
+    struct block_device *dev;
+    pthread_mutex_t      lock;
+
+    uint32_t ssize;     /* 扇区大小 */
+    uint32_t spb;       /* 每块扇区数 (2 的幂) */
+    uint32_t spb_shift;
+    uint32_t nentries;
+    uint32_t hash_mask;
+    uint32_t ndirty;
+
+    struct bc_entry  *entries;
+    struct bc_entry **hash;
+    struct bc_entry  *lru_head;
+    struct bc_entry  *lru_tail;
+    uint8_t          *pool;
+    uint8_t          *io_buf; /* BLOCK_CACHE_RA_MAX 块, 合并读用 */
+
+    uint64_t seq_next; /* 顺序读预期的下一块 */
+    uint32_t ra_blocks;
+
+    struct block_cache_stats stats;
+};
+
+/* ============== 索引与 LRU ============== */
+
+static inline uint32_t bc_hash(struct block_cache *c, uint64_t blk) {
+    return ((uint32_t)blk ^ (uint32_t)(blk >> 32)) & c->hash_mask;
+}
+
+static struct bc_entry *bc_lookup(struct block_cache *c, uint64_t blk) {
+    for (struct bc_entry *e = c->hash[bc_hash(c, blk)]; e; e = e->hnext) {
+        if (e->blk == blk) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+static void bc_unhash(struct block_cache *c, struct bc_entry *e) {
+    struct bc_entry **pp = &c->hash[bc_hash(c, e->blk)];
+    while (*pp && *pp != e) {
+        pp = &(*pp)->hnext;
+    }
+    if (*pp) {
+        *pp = e->hnext;
+    }
+    e->hnext  = NULL;
+    e->hashed = false;
+    c->stats.cached--;
+}
+
+static void bc_touch(struct block_cache *c, struct bc_entry *e) {
+    if (c->lru_head == e) {
+        return;
+    }
+
+    /* 摘下 */
+    if (e->prev) {
+        e->prev->next = e->next;
+    }
+    if (e->next) {
+        e->next->prev = e->prev;
+    }
+    if (c->lru_tail == e) {
+        c->lru_tail = e->prev;
+    }
+
+    /* 插到头部 */
+    e->prev = NULL;
+    e->next = c->lru_head;
+    if (c->lru_head) {
+        c->lru_head->prev = e;
+    }
+    c->lru_head = e;
+    if (!c->lru_tail) {
+        c->lru_tail = e;
+    }
+}
+
+/* 块 blk 在设备上实际包含的扇区数 (最后一块可能不满) */
+static uint32_t bc_block_sectors(struct block_cache *c, uint64_t blk) {
+    uint64_t total = c->dev->info.sector_count;
+    uint64_t start = blk * c->spb;
+    if (total == 0 || start + c->spb <= total) {
+        return c->spb;
+    }
+    return start < total ? (uint32_t)(total - start) : 0;
+}
+
+static inline uint32_t bc_mask(uint32_t s0, uint32_t s1) {
+    uint32_t hi = s1 >= 31 ? 0xFFFFFFFF : ((1u << (s1 + 1)) - 1);
+    return hi & ~((1u << s0) - 1);
+}
+
+/* ============== 写回 ============== */
+
+static void bc_clean(struct block_cache *c, struct bc_entry *e) {
+    e->dirty = 0;
+    c->ndirty--;
+    c->stats.writebacks++;
+}
+
+/* 单块写回: 逐段同步写出连续的脏扇区 */
+static int bc_writeback(struct block_cache *c, struct bc_entry *e) {
+    uint32_t s = 0;
+
+    while (s < c->spb) {
+        if (!(e->dirty & (1u << s))) {
+            s++;
+            continue;
+        }
+        uint32_t n = 1;
+        while (s + n < c->spb && (e->dirty & (1u << (s + n)))) {
+            n++;
+        }
+        if (block_rw_sync(c->dev, BLOCK_OP_WRITE, e->blk * c->spb + s, n,
+                          e->data + s * c->ssize) < 0) {
+            return -1;
+        }
+        s += n;
+    }
+
+    bc_clean(c, e);
+    return 0;
+}
+
+/**
+ * 写回全部脏块
+ *
+ * 脏扇区连续的块(通常是整块)一起挂到请求队列上, 由队列排序并合并相邻块;
+ * 脏扇区不连续的块逐段同步写.
+ */
+static int bc_sync_locked(struct block_cache *c) {
+    struct block_batch batch;
+    int                ret = 0;
+
+    if (c->ndirty == 0) {
+        return 0;
+    }
+    if (block_batch_init(&batch) < 0) {
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < c->nentries; i++) {
+        struct bc_entry *e = &c->entries[i];
+        if (!e->hashed || !e->dirty) {
+            continue;
+        }
+
+        uint32_t s0 = (uint32_t)__builtin_ctz(e->dirty);
+        uint32_t s1 = 31 - (uint32_t)__builtin_clz(e->dirty);
+        if (e->dirty != bc_mask(s0, s1)) {
+            if (bc_writeback(c, e) < 0) {
+                ret = -1;
+            }
+            continue;
+        }
+
+        e->wb.lba    = e->blk * c->spb + s0;
+        e->wb.count  = s1 - s0 + 1;
+        e->wb.buffer = e->data + s0 * c->ssize;
+        e->wb.op     = BLOCK_OP_WRITE;
+        e->wb.result = -1;
+        block_batch_add(c->dev, &batch, &e->wb);
+    }
+
+    if (block_batch_wait(&batch) < 0) {
+        ret = -1;
+    }
+
+    /* 按各请求结果清脏, 失败的块留待下次写回 */
+    for (uint32_t i = 0; i < c->nentries; i++) {
+        struct bc_entry *e = &c->entries[i];
+        if (e->hashed && e->dirty && e->wb.buffer) {
+            if (e->wb.result == 0) {
+                bc_clean(c, e);
+            }
+        }
+        e->wb.buffer = NULL;
+    }
+
+    return ret;
+}
+
+/**
+ * 为 blk 分配缓存块, 复用 LRU 尾部
+ *
+ * 淘汰到脏块时顺便写回全部脏块: 合并写比逐块写回便宜得多.
+ */
+static struct bc_entry *bc_alloc(struct block_cache *c, uint64_t blk) {
+    struct bc_entry *e = c->lru_tail;
+
+    if (e->dirty && (bc_sync_locked(c) < 0 || e->dirty)) {
+        return NULL;
+    }
+    if (e->hashed) {
+        bc_unhash(c, e);
+    }
+
+    e->blk    = blk;
+    e->valid  = 0;
+    e->dirty  = 0;
+    e->hashed = true;
+
+    uint32_t h  = bc_hash(c, blk);
+    e->hnext    = c->hash[h];
+    c->hash[h]  = e;
+    c->stats.cached++;
+
+    bc_touch(c, e);
+    return e;
+}
+
+/* ============== 创建与销毁 ============== */
+
+static pthread_t g_flusher;
+static bool      g_flusher_started;
+
+/* 后台写回线程: 周期写回所有设备的脏块 */
+static void *bc_flusher_entry(void *arg) {
+    (void)arg;
+
+    while (1) {
+        sys_sleep(BLOCK_CACHE_FLUSH_MS);
+        for (struct block_device *dev = block_first(); dev; dev = block_next(dev)) {
+            if (dev->cache && dev->cache->ndirty) {
+                block_flush(dev);
+            }
+        }
+    }
+    return NULL;
+}
+
+void block_cache_create(struct block_device *dev) {
+    uint32_t nentries = dev->cache_blocks ? dev->cache_blocks : BLOCK_CACHE_DEFAULT;
+    uint32_t ssize    = dev->info.sector_size;
+
+    dev->cache = NULL;
+    if (nentries == BLOCK_CACHE_DISABLED || ssize == 0 || BLOCK_CACHE_BLOCK_SIZE % ssize ||
+        (ssize & (ssize - 1)) || BLOCK_CACHE_BLOCK_SIZE / ssize > 32) {
+        return;
+    }
+    /* 一次填充最多 BLOCK_CACHE_RA_MAX 块, 容量至少两倍才不会在填充中淘汰刚读入的块 */
+    if (nentries < BLOCK_CACHE_RA_MAX * 2) {
+        nentries = BLOCK_CACHE_RA_MAX * 2;
+    }
+
+    struct block_cache *c = calloc(1, sizeof(*c));
+    if (!c) {
+        return;
+    }
+
+    uint32_t hsize = 1;
+    while (hsize < nentries) {
+        hsize <<= 1;
+    }
+
+    c->dev       = dev;
+    c->ssize     = ssize;
+    c->spb       = BLOCK_CACHE_BLOCK_SIZE / ssize;
+    while ((1u << c->spb_shift) < c->spb) {
+        c->spb_shift++;
+    }
+    c->nentries  = nentries;
+    c->hash_mask = hsize - 1;
+    c->entries   = calloc(nentries, sizeof(struct bc_entry));
+    c->hash      = calloc(hsize, sizeof(struct bc_entry *));
+    c->pool      = malloc(nentries * BLOCK_CACHE_BLOCK_SIZE);
+    c->io_buf    = malloc(BLOCK_CACHE_RA_MAX * BLOCK_CACHE_BLOCK_SIZE);
+
+    if (!c->entries || !c->hash || !c->pool || !c->io_buf) {
+        free(c->entries);
+        free(c->hash);
+        free(c->pool);
+        free(c->io_buf);
+        free(c);
+        return;
+    }
+
+    for (uint32_t i = 0; i < nentries; i++) {
+        struct bc_entry *e = &c->entries[i];
+        e->data            = c->pool + i * BLOCK_CACHE_BLOCK_SIZE;
+        e->prev            = i > 0 ? &c->entries[i - 1] : NULL;
+        e->next            = i + 1 < nentries ? &c->entries[i + 1] : NULL;
+    }
+    c->lru_head       = &c->entries[0];
+    c->lru_tail       = &c->entries[nentries - 1];
+    c->seq_next       = (uint64_t)-1;
+    c->stats.capacity = nentries;
+
+    pthread_mutex_init(&c->lock, NULL);
+    dev->cache = c;
+
+    if (!g_flusher_started) {
+        g_flusher_started = pthread_create(&g_flusher, NULL, bc_flusher_entry, NULL) == 0;
+        if (g_flusher_started) {
+            pthread_detach(g_flusher);
+        }
+    }
+}
+
+void block_cache_destroy(struct block_device *dev) {
+    struct block_cache *c = dev->cache;
+    if (!c) {
+        return;
+    }
+
+    block_cache_sync(dev);
+    dev->cache = NULL;
+
+    pthread_mutex_destroy(&c->lock);
+    free(c->entries);
+    free(c->hash);
+    free(c->pool);
+    free(c->io_buf);
+    free(c);
+}
+
+int block_cache_sync(struct block_device *dev) {
+    struct block_cache *c = dev->cache;
+    if (!c) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&c->lock);
+    int ret = bc_sync_locked(c);
+    pthread_mutex_unlock(&c->lock);
+    return ret;
+}
+
+/* ============== 读写 ============== */
+
+static bool bc_out_of_range(struct block_device *dev, uint64_t lba, uint32_t count) {
+    uint64_t total = dev->info.sector_count;
+    return total != 0 && (lba >= total || count > total - lba);
+}
+
+/**
+ * 读入 [blk, blk + nblk) 并填进缓存
+ *
+ * 已有的有效扇区(可能是脏数据)不被覆盖. 分配不到缓存块时数据只留在 io_buf.
+ */
+static int bc_fill(struct block_cache *c, uint64_t blk, uint32_t nblk) {
+    struct block_device *dev     = c->dev;
+    uint32_t             sectors = 0;
+
+    for (uint32_t k = 0; k < nblk; k++) {
+        sectors += bc_block_sectors(c, blk + k);
+    }
+    if (block_rw_sync(dev, BLOCK_OP_READ, blk * c->spb, sectors, c->io_buf) < 0) {
+        return -1;
+    }
+
+    for (uint32_t k = 0; k < nblk; k++) {
+        struct bc_entry *e = bc_lookup(c, blk + k);
+        if (e) {
+            bc_touch(c, e);
+        } else {
+            e = bc_alloc(c, blk + k);
+            if (!e) {
+                continue;
+            }
+        }
+
+        uint8_t *src  = c->io_buf + k * BLOCK_CACHE_BLOCK_SIZE;
+        uint32_t secs = bc_block_sectors(c, blk + k);
+        for (uint32_t s = 0; s < secs; s++) {
+            if (!(e->valid & (1u << s))) {
+                memcpy(e->data + s * c->ssize, src + s * c->ssize, c->ssize);
+            }
+        }
+        e->valid |= bc_mask(0, secs - 1);
+    }
+    return 0;
+}
+
+int block_read(struct block_device *dev, uint64_t lba, uint32_t count, void *buffer) {
+    if (!dev || !dev->ops || !buffer) {
+        return -1;
+    }
+
+    struct block_cache *c = dev->cache;
+    if (!c) {
+        return block_rw_sync(dev, BLOCK_OP_READ, lba, count, buffer);
+    }
+    if (count == 0) {
+        return 0;
+    }
+    if (bc_out_of_range(dev, lba, count)) {
+        return -1;
+    }
+
+    uint64_t first = lba >> c->spb_shift;
+    uint64_t last  = (lba + count - 1) >> c->spb_shift;
+    uint8_t *out   = buffer;
+
+    pthread_mutex_lock(&c->lock);
+
+    /* 顺序读检测: 紧接上次(或仍在上次最后一块内)则扩大预读窗口 */
+    if (first == c->seq_next || first + 1 == c->seq_next) {
+        c->ra_blocks = c->ra_blocks ? c->ra_blocks * 2 : BC_RA_INIT;
+        if (c->ra_blocks > BLOCK_CACHE_RA_MAX) {
+            c->ra_blocks = BLOCK_CACHE_RA_MAX;
+        }
+    } else {
+        c->ra_blocks = 0;
+    }
+    c->seq_next = last + 1;
+
+    uint64_t blk = first;
+    while (blk <= last) {
+        uint32_t         s0 = blk == first ? ((uint32_t)lba & (c->spb - 1)) : 0;
+        uint32_t         s1 = blk == last ? ((uint32_t)(lba + count - 1) & (c->spb - 1)) : c->spb - 1;
+        uint32_t         m  = bc_mask(s0, s1);
+        struct bc_entry *e  = bc_lookup(c, blk);
+
+        if (!e || (e->valid & m) != m) {
+            /* 连续缺失的块合并读, 读到请求末尾时按窗口追加预读 */
+            uint32_t nblk = 1;
+            while (blk + nblk <= last && nblk < BLOCK_CACHE_RA_MAX) {
+                struct bc_entry *n = bc_lookup(c, blk + nblk);
+                if (n && n->valid == bc_mask(0, bc_block_sectors(c, blk + nblk) - 1)) {
+                    break;
+                }
+                nblk++;
+            }
+            uint32_t ra = 0;
+            if (blk + nblk > last) {
+                while (ra < c->ra_blocks && nblk + ra < BLOCK_CACHE_RA_MAX &&
+                       bc_block_sectors(c, blk + nblk + ra) && !bc_lookup(c, blk + nblk + ra)) {
+                    ra++;
+                }
+            }
+
+            if (bc_fill(c, blk, nblk + ra) < 0) {
+                pthread_mutex_unlock(&c->lock);
+                return -1;
+            }
+            c->stats.readahead += ra;
+
+            /* 拷出本次读到的请求部分 */
+            for (uint32_t k = 0; k < nblk; k++, blk++) {
+                s0 = blk == first ? ((uint32_t)lba & (c->spb - 1)) : 0;
+                s1 = blk == last ? ((uint32_t)(lba + count - 1) & (c->spb - 1)) : c->spb - 1;
+                e  = bc_lookup(c, blk);
+
+                const uint8_t *src = e ? e->data : c->io_buf + k * BLOCK_CACHE_BLOCK_SIZE;
+                uint32_t       len = (s1 - s0 + 1) * c->ssize;
+                memcpy(out, src + s0 * c->ssize, len);
+                out += len;
+                c->stats.misses++;
+            }
+            continue;
+        }
+
+        uint32_t len = (s1 - s0 + 1) * c->ssize;
+        memcpy(out, e->data + s0 * c->ssize, len);
+        out += len;
+        bc_touch(c, e);
+        c->stats.hits++;
+        blk++;
+    }
+
+    pthread_mutex_unlock(&c->lock);
+    return 0;
+}
+
+int block_write(struct block_device *dev, uint64_t lba, uint32_t count, const void *buffer) {
+    if (!dev || !dev->ops || !buffer) {
+        return -1;
+    }
+    if (dev->info.flags & BLOCK_FLAG_READONLY) {
+        return -1;
+    }
+
+    struct block_cache *c = dev->cache;
+    if (!c) {
+        return block_rw_sync(dev, BLOCK_OP_WRITE, lba, count, (void *)buffer);
+    }
+    if (count == 0) {
+        return 0;
+    }
+    if (bc_out_of_range(dev, lba, count)) {
+        return -1;
+    }
+
+    uint64_t       first = lba >> c->spb_shift;
+    uint64_t       last  = (lba + count - 1) >> c->spb_shift;
+    const uint8_t *in    = buffer;
+    int            ret   = 0;
+
+    pthread_mutex_lock(&c->lock);
+
+    for (uint64_t blk = first; blk <= last; blk++) {
+        uint32_t         s0  = blk == first ? ((uint32_t)lba & (c->spb - 1)) : 0;
+        uint32_t         s1  = blk == last ? ((uint32_t)(lba + count - 1) & (c->spb - 1)) : c->spb - 1;
+        uint32_t         len = (s1 - s0 + 1) * c->ssize;
+        struct bc_entry *e   = bc_lookup(c, blk);
+
+        if (!e) {
+            e = bc_alloc(c, blk);
+        }
+        if (!e) {
+            /* 缓存块无法腾出(写回失败), 直写 */
+            if (block_rw_sync(dev, BLOCK_OP_WRITE, blk * c->spb + s0, s1 - s0 + 1, (void *)in) <
+                0) {
+                ret = -1;
+                break;
+            }
+            in += len;
+            continue;
+        }
+
+        memcpy(e->data + s0 * c->ssize, in, len);
+        in += len;
+
+        uint32_t m = bc_mask(s0, s1);
+        if (!e->dirty) {
+            c->ndirty++;
+        }
+        e->valid |= m;
+        e->dirty |= m;
+        bc_touch(c, e);
+    }
+
+    pthread_mutex_unlock(&c->lock);
+    return ret;
+}
+
+int block_flush(struct block_device *dev) {
+    if (!dev || !dev->ops) {
+        return -1;
+    }
+
+    int ret = block_cache_sync(dev);
+    if (dev->ops->flush && dev->ops->flush(dev->driver_ctx) < 0) {
+        ret = -1;
+    }
+    return ret;
+}
+
+int block_cache_get_stats(struct block_device *dev, struct block_cache_stats *stats) {
+    if (!dev || !dev->cache || !stats) {
+        return -1;
+    }
+
+    struct block_cache *c = dev->cache;
+    pthread_mutex_lock(&c->lock);
+    *stats       = c->stats;
+    stats->dirty = c->ndirty;
+    pthread_mutex_unlock(&c->lock);
+    return 0;
+}
@@ -0,0 +1,73 @@
+/**
+ * @file block_internal.h
+ * @brief libblock 内部接口
+ */
+
+#ifndef XNIX_LIBBLOCK_INTERNAL_H
+#define XNIX_LIBBLOCK_INTERNAL_H
+
+#include <block.h>
+
+/**
+ * 为已注册设备创建缓存 (按 dev->cache_blocks 决定大小)
+ * 失败时 dev->cache 保持 NULL, 设备退化为直通.
+ */
+void block_cache_create(struct block_device *dev);
+
+/**
+ * 写回并释放设备缓存
+ */
+void block_cache_destroy(struct block_device *dev);
+
+/**
+ * 写回全部脏块 (不调用 ops->flush)
+ * @return 0 成功，负数错误码
+ */
+int block_cache_sync(struct block_device *dev);
+
+/**
+ * 创建设备请求队列和派发线程
+ * 失败时 dev->queue 保持 NULL, 请求退化为同步直通.
+ */
+void block_queue_create(struct block_device *dev);
+
+/**
+ * 销毁设备请求队列 (等待已提交的请求完成)
+ */
+void block_queue_destroy(struct block_device *dev);
+
+/* 一组请求的完成计数, 用于同步等待 */
+struct block_batch {
+    uint32_t          submitted;
+    volatile uint32_t completed;
+    volatile int32_t  error;
+    uint32_t          event;
+};
+
+/**
+ * 初始化批次, 之后用 block_batch_add 提交请求, block_batch_wait 等待
+ * @return 0 成功，负数错误码
+ */
+int block_batch_init(struct block_batch *batch);
+
+/**
+ * 提交属于批次的请求 (占用 req->done/priv)
+ * @return 0 已受理，负数错误码
+ */
+int block_batch_add(struct block_device *dev, struct block_batch *batch,
+                    struct block_request *req);
+
+/**
+ * 等待批次内请求全部完成并释放批次
+ * @return 0 全部成功，负数错误码
+ */
+int block_batch_wait(struct block_batch *batch);
+
+/**
+ * 经队列同步读写 (提交后等待完成)
+ * @return 0 成功，负数错误码
+ */
+int block_rw_sync(struct block_device *dev, uint32_t op, uint64_t lba, uint32_t count,
+                  void *buffer);
+
+#endif /* XNIX_LIBBLOCK_INTERNAL_H */
@@ -0,0 +1,377 @@
+/**
+ * @file block_queue.c
+ * @brief 块设备请求队列
+ *
+ * 每个设备一个按 LBA 排序的单链表和一个派发线程. 派发线程按 C-LOOK
+ * 电梯顺序工作: 从磁头位置向高 LBA 扫描, 到头后绕回最低处.
+ *
+ * 取出一个请求后, 把紧随其后, 方向相同且 LBA 首尾相接的请求一起摘下,
+ * 总长不超过 info.max_sectors, 经合并缓冲区一次交给驱动, 再逐个回调.
+ * 提交者可以一次挂上很多请求 (如缓存写回), 由队列排序合并.
+ */
+
+#include "block_internal.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <xnix/syscall.h>
+
+#define BQ_KICK_BIT 1u
+
+struct block_queue {
+    struct block_device  *dev;
+    pthread_mutex_t       lock;
+    struct block_request *head; /* 按 lba 升序 */
+    uint64_t              pos;  /* 磁头位置: 上次派发的结束 LBA */
+    uint32_t              max_sectors;
+    uint32_t              kick; /* 唤醒派发线程的 event */
+    uint8_t              *merge_buf;
+    pthread_t             thread;
+    volatile bool         stop;
+
+    struct block_queue_stats stats;
+};
+
+/* ============== 派发 ============== */
+
+/**
+ * 按 C-LOOK 摘下下一批请求, 返回以 next 串起的链表
+ */
+static struct block_request *bq_pick(struct block_queue *q, uint32_t *out_sectors) {
+    struct block_request **pp = &q->head;
+
+    /* 第一个 lba >= pos 的请求, 没有则绕回队首 */
+    while (*pp && (*pp)->lba < q->pos) {
+        pp = &(*pp)->next;
+    }
+    if (!*pp) {
+        pp = &q->head;
+    }
+
+    struct block_request *first = *pp;
+    struct block_request *tail  = first;
+    uint32_t              total = first->count;
+    uint64_t              end   = first->lba + first->count;
+
+    /* 排序链表中相接的请求就在后面 */
+    while (tail->next && tail->next->op == first->op && tail->next->lba == end &&
+           total + tail->next->count <= q->max_sectors) {
+        tail = tail->next;
+        total += tail->count;
+        end += tail->count;
+        q->stats.merged++;
+    }
+
+    *pp        = tail->next;
+    tail->next = NULL;
+    q->pos     = end;
+
+    *out_sectors = total;
+    return first;
+}
+
+static void bq_complete(struct block_request *list, int result) {
+    while (list) {
+        struct block_request *next = list->next;
+        list->next                 = NULL;
+        list->result               = result;
+        if (list->done) {
+            list->done(list);
+        }
+        list = next;
+    }
+}
+
+static void bq_dispatch(struct block_queue *q, struct block_request *list, uint32_t sectors) {
+    struct block_device *dev   = q->dev;
+    uint32_t             ssize = dev->info.sector_size;
+    int                  ret;
+
+    if (!list->next) {
+        /* 单个请求直接用调用者缓冲区 */
+        if (list->op == BLOCK_OP_WRITE) {
+            ret = dev->ops->write(dev->driver_ctx, list->lba, list->count, list->buffer);
+        } else {
+            ret = dev->ops->read(dev->driver_ctx, list->lba, list->count, list->buffer);
+        }
+        bq_complete(list, ret < 0 ? -1 : 0);
+        return;
+    }
+
+    uint8_t *p = q->merge_buf;
+    if (list->op == BLOCK_OP_WRITE) {
+        for (struct block_request *r = list; r; r = r->next) {
+            memcpy(p, r->buffer, r->count * ssize);
+            p += r->count * ssize;
+        }
+        ret = dev->ops->write(dev->driver_ctx, list->lba, sectors, q->merge_buf);
+    } else {
+        ret = dev->ops->read(dev->driver_ctx, list->lba, sectors, q->merge_buf);
+        if (ret >= 0) {
+            for (struct block_request *r = list; r; r = r->next) {
+                memcpy(r->buffer, p, r->count * ssize);
+                p += r->count * ssize;
+            }
+        }
+    }
+    bq_complete(list, ret < 0 ? -1 : 0);
+}
+
+static void *bq_thread_entry(void *arg) {
+    struct block_queue *q = arg;
+
+    while (1) {
+        pthread_mutex_lock(&q->lock);
+        if (!q->head) {
+            pthread_mutex_unlock(&q->lock);
+            if (q->stop) {
+                break;
+            }
+            /* 提交者在检查后才 signal 也不会丢: pending 位保留到下次 wait */
+            sys_event_wait(q->kick);
+            continue;
+        }
+
+        uint32_t              sectors;
+        struct block_request *list = bq_pick(q, &sectors);
+        q->stats.dispatched++;
+        pthread_mutex_unlock(&q->lock);
+
+        bq_dispatch(q, list, sectors);
+    }
+    return NULL;
+}
+
+/* ============== 创建与销毁 ============== */
+
+void block_queue_create(struct block_device *dev) {
+    dev->queue = NULL;
+    if (dev->info.sector_size == 0) {
+        return;
+    }
+
+    struct block_queue *q = calloc(1, sizeof(*q));
+    if (!q) {
+        return;
+    }
+
+    q->dev         = dev;
+    q->max_sectors = dev->info.max_sectors ? dev->info.max_sectors : BLOCK_QUEUE_MAX_SECTORS;
+    q->merge_buf   = malloc(q->max_sectors * dev->info.sector_size);
+
+    int ev = sys_event_create();
+    if (!q->merge_buf || ev < 0) {
+        if (ev >= 0) {
+            sys_handle_close((uint32_t)ev);
+        }
+        free(q->merge_buf);
+        free(q);
+        return;
+    }
+    q->kick = (uint32_t)ev;
+    pthread_mutex_init(&q->lock, NULL);
+
+    if (pthread_create(&q->thread, NULL, bq_thread_entry, q) != 0) {
+        pthread_mutex_destroy(&q->lock);
+        sys_handle_close(q->kick);
+        free(q->merge_buf);
+        free(q);
+        return;
+    }
+    dev->queue = q;
+}
+
+void block_queue_destroy(struct block_device *dev) {
+    struct block_queue *q = dev->queue;
+    if (!q) {
+        return;
+    }
+
+    /* 派发线程处理完剩余请求后退出 */
+    q->stop = true;
+    sys_event_signal(q->kick, BQ_KICK_BIT);
+    pthread_join(q->thread, NULL);
+    dev->queue = NULL;
+
+    pthread_mutex_destroy(&q->lock);
+    sys_handle_close(q->kick);
+    free(q->merge_buf);
+    free(q);
+}
+
+/* ============== 提交 ============== */
+
+int block_submit(struct block_device *dev, struct block_request *req) {
+    if (!dev || !dev->ops || !req || !req->buffer || req->count == 0) {
+        return -1;
+    }
+    if (req->op != BLOCK_OP_READ && req->op != BLOCK_OP_WRITE) {
+        return -1;
+    }
+    if (req->op == BLOCK_OP_WRITE && (dev->info.flags & BLOCK_FLAG_READONLY)) {
+        return -1;
+    }
+
+    struct block_queue *q = dev->queue;
+    req->next             = NULL;
+
+    if (!q || q->stop) {
+        int ret = req->op == BLOCK_OP_WRITE
+                      ? dev->ops->write(dev->driver_ctx, req->lba, req->count, req->buffer)
+                      : dev->ops->read(dev->driver_ctx, req->lba, req->count, req->buffer);
+        bq_complete(req, ret < 0 ? -1 : 0);
+        return 0;
+    }
+
+    /* 超过合并上限的请求原样派发 (驱动自行拆分), 同样按 lba 排队 */
+    pthread_mutex_lock(&q->lock);
+    struct block_request **pp = &q->head;
+    while (*pp && (*pp)->lba <= req->lba) {
+        pp = &(*pp)->next;
+    }
+    req->next = *pp;
+    *pp       = req;
+    q->stats.submitted++;
+    pthread_mutex_unlock(&q->lock);
+
+    sys_event_signal(q->kick, BQ_KICK_BIT);
+    return 0;
+}
+
+int block_queue_get_stats(struct block_device *dev, struct block_queue_stats *stats) {
+    if (!dev || !dev->queue || !stats) {
+        return -1;
+    }
+
+    struct block_queue *q = dev->queue;
+    pthread_mutex_lock(&q->lock);
+    *stats = q->stats;
+    pthread_mutex_unlock(&q->lock);
+    return 0;
+}
+
+/* ============== 批次等待 ============== */
+
+/*
+ * 批次 event 池
+ *
+ * 派发线程先计数再 signal, 计满后等待者可能在 signal 之前就已返回.
+ * 所以 event 不随批次关闭 (关闭后 handle 号可能被别的对象复用), 而是
+ * 还回池中: 迟到的 signal 最多让下一个用到它的批次多醒一次, 它会重新
+ * 检查计数. 池的大小等于同时等待的批次数的峰值.
+ */
+static volatile uint32_t g_batch_ev_lock;
+static uint32_t         *g_batch_evs;
+static uint32_t          g_batch_ev_count;
+static uint32_t          g_batch_ev_cap;
+
+static void batch_ev_lock(void) {
+    while (__sync_lock_test_and_set(&g_batch_ev_lock, 1)) {
+        syscall0(SYS_THREAD_YIELD);
+    }
+}
+
+static void batch_ev_unlock(void) {
+    __sync_lock_release(&g_batch_ev_lock);
+}
+
+static int batch_ev_get(void) {
+    batch_ev_lock();
+    if (g_batch_ev_count > 0) {
+        uint32_t ev = g_batch_evs[--g_batch_ev_count];
+        batch_ev_unlock();
+        return (int)ev;
+    }
+    batch_ev_unlock();
+    return sys_event_create();
+}
+
+static void batch_ev_put(uint32_t ev) {
+    batch_ev_lock();
+    if (g_batch_ev_count == g_batch_ev_cap) {
+        uint32_t  cap = g_batch_ev_cap ? g_batch_ev_cap * 2 : 8;
+        uint32_t *evs = realloc(g_batch_evs, cap * sizeof(uint32_t));
+        if (!evs) {
+            /* 放不回池里宁可留着不关, 也不能让迟到的 signal 打到别的对象上 */
+            batch_ev_unlock();
+            return;
+        }
+        g_batch_evs    = evs;
+        g_batch_ev_cap = cap;
+    }
+    g_batch_evs[g_batch_ev_count++] = ev;
+    batch_ev_unlock();
+}
+
+/*
+ * 完成计数只由派发线程写 (无队列时回调在提交者线程内同步执行),
+ * 等待者只读, 不需要原子操作. 每次完成都 signal, 未在等待时 pending 位保留.
+ */
+static void batch_done(struct block_request *req) {
+    struct block_batch *batch = req->priv;
+    uint32_t            event = batch->event; /* 计满后 batch 可能已随等待者栈帧失效 */
+
+    if (req->result < 0) {
+        batch->error = req->result;
+    }
+    batch->completed++;
+    sys_event_signal(event, 1);
+}
+
+int block_batch_init(struct block_batch *batch) {
+    int ev = batch_ev_get();
+    if (ev < 0) {
+        return -1;
+    }
+
+    batch->submitted = 0;
+    batch->completed = 0;
+    batch->error     = 0;
+    batch->event     = (uint32_t)ev;
+    return 0;
+}
+
+int block_batch_add(struct block_device *dev, struct block_batch *batch,
+                    struct block_request *req) {
+    req->done = batch_done;
+    req->priv = batch;
+
+    if (block_submit(dev, req) < 0) {
+        batch->error = -1;
+        return -1;
+    }
+    batch->submitted++;
+    return 0;
+}
+
+int block_batch_wait(struct block_batch *batch) {
+    while (batch->completed != batch->submitted) {
+        sys_event_wait(batch->event);
+    }
+
+    batch_ev_put(batch->event);
+    return batch->error;
+}
+
+int block_rw_sync(struct block_device *dev, uint32_t op, uint64_t lba, uint32_t count,
+                  void *buffer) {
+    if (!dev->queue) {
+        return op == BLOCK_OP_WRITE ? dev->ops->write(dev->driver_ctx, lba, count, buffer)
+                                    : dev->ops->read(dev->driver_ctx, lba, count, buffer);
+    }
+
+    struct block_batch   batch;
+    struct block_request req = {
+        .lba    = lba,
+        .count  = count,
+        .buffer = buffer,
+        .op     = op,
+    };
+
+    if (block_batch_init(&batch) < 0) {
+        return -1;
+    }
+    block_batch_add(dev, &batch, &req);
+    return block_batch_wait(&batch);
+}
@@ -0,0 +1,40 @@
+/**
+ * @file mman.h
+ * @brief 文件内存映射
+ */
+
+#ifndef _SYS_MMAN_H
+#define _SYS_MMAN_H
+
+#include <stddef.h>
+#include <xnix/abi/mman.h>
+
+#define PROT_READ  ABI_PROT_READ
+#define PROT_WRITE ABI_PROT_WRITE
+
+#define MAP_SHARED  ABI_MAP_SHARED
+#define MAP_PRIVATE ABI_MAP_PRIVATE
+
+#define MAP_FAILED ((void *)-1)
+
+/**
+ * 映射 fd 对应的文件
+ *
+ * addr 只作提示, 由内核选择地址. offset 须页对齐, 映射不能超过文件末尾所在页.
+ * 映射建立后关闭 fd 不影响映射.
+ *
+ * @return 映射地址, 失败返回 MAP_FAILED (设置 errno)
+ */
+void *mmap(void *addr, size_t length, int prot, int flags, int fd, long offset);
+
+/**
+ * 取消映射, 可以只取消映射的一部分. MAP_SHARED 可写映射先写回脏页.
+ */
+int munmap(void *addr, size_t length);
+
+/**
+ * 写回 [addr, addr + length) 内 MAP_SHARED 映射的脏页
+ */
+int msync(void *addr, size_t length, int flags);
+
+#endif /* _SYS_MMAN_H */
@@ -52,4 +52,18 @@ int     dup(int oldfd);
 int     dup2(int oldfd, int newfd);
 int     pipe(int pipefd[2]);
 
+/*
+ * 零拷贝搬运
+ *
+ * 数据由文件服务端直接在文件和内核管道之间搬运, 不经过调用者地址空间.
+ * 服务端不支持时自动退回 read/write 中转 (结果按 fd 记住, 只探测一次);
+ * 服务端报告的其他错误 (EBADF/EINVAL 等) 照常返回.
+ *
+ * splice:   一次搬运最多 len 字节, fd_in/fd_out 至少一端是管道; 返回 0 表示 EOF
+ * sendfile: 从 in_fd 当前偏移拷贝最多 count 字节到 out_fd, 直到 EOF;
+ *           两端都是文件时经由临时管道中转
+ */
+ssize_t splice(int fd_in, int fd_out, size_t len);
+ssize_t sendfile(int out_fd, int in_fd, size_t count);
+
 #endif /* _UNISTD_H */
@@ -17,9 +17,16 @@ struct vfs_operations {
     int (*info)(void *ctx, const char *path, struct vfs_info *info);
     int (*opendir)(void *ctx, const char *path);
     int (*readdir)(void *ctx, uint32_t handle, uint32_t index, struct vfs_dirent *entry);
+    /* 可选: 从 index 起连续读取至多 max 项, 返回读到的项数 (0=结束); 缺省时逐项调用 readdir */
+    int (*getdents)(void *ctx, uint32_t handle, uint32_t index, struct vfs_dirent *entries,
+                    uint32_t max);
     int (*mkdir)(void *ctx, const char *path);
     int (*del)(void *ctx, const char *path);
     int (*rename)(void *ctx, const char *old_path, const char *new_path);
+    /* 可选: 读出文件开头至多 size 字节并填写 info, 返回读到的字节数; 缺省时 READFILE 回复 -38 */
+    int (*readfile)(void *ctx, const char *path, void *buf, uint32_t size, struct vfs_info *info);
+    /* 可选: 复制文件 (目标创建或截断), 返回复制的字节数; 缺省时 COPY 回复 -38, 由 vfsd 搬运 */
+    int (*copy)(void *ctx, const char *src_path, const char *dst_path);
 
     /* 文件 IO (read/write/finfo/truncate/sync) 已从接口移除,
        由各 backend 在各自 file_ep 的 event loop 中直接处理 IO_READ/IO_WRITE/IO_CLOSE */
@@ -27,4 +34,16 @@ struct vfs_operations {
 
 int vfs_dispatch(struct vfs_operations *ops, void *ctx, struct ipc_message *msg);
 
+/**
+ * 把目录项打包为 struct vfs_dirent_rec 追加到 buf + len
+ * @return 追加后的总长度, 放不下时返回 0
+ */
+uint32_t vfs_dirent_pack(void *buf, uint32_t len, uint32_t cap, const struct vfs_dirent *entry);
+
+/**
+ * 通知 vfsd 命名空间有变化 (创建, 删除, 重命名), vfsd 随之丢弃路径缓存
+ * vfs_dispatch 处理的操作已自动通知, 服务端自行增删节点时调用.
+ */
+void vfs_notify_change(void);
+
 #endif /* XNIX_VFS_DISPATCH_H */
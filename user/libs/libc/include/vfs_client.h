@@ -17,6 +17,7 @@ typedef int32_t ssize_t;
 
 /* Forward declarations */
 struct vfs_dirent;
+struct vfs_stat;
 
 /**
  * 初始化 VFS 客户端
@@ -39,6 +40,32 @@ int vfs_mount(const char *path, uint32_t fs_ep);
  */
 int vfs_open(const char *path, uint32_t flags);
 
+/**
+ * 打开文件并取得文件信息(省去单独一次 stat)
+ * @param path 文件路径
+ * @param flags 打开标志
+ * @param st 输出信息
+ * @return 文件描述符,负数失败
+ */
+int vfs_open_stat(const char *path, uint32_t flags, struct vfs_stat *st);
+
+/**
+ * 读取整个小文件(不超过 VFS_READFILE_MAX 时只需一次往返)
+ * @param path 文件路径
+ * @param buf 缓冲区
+ * @param size 缓冲区大小
+ * @return 实际读取字节数(文件更大时截断为 size),负数失败
+ */
+ssize_t vfs_read_file(const char *path, void *buf, size_t size);
+
+/**
+ * 复制文件(数据在文件系统服务端之间搬运,不经过调用者)
+ * @param src 源文件路径
+ * @param dst 目标文件路径(不存在则创建,已存在则截断)
+ * @return 复制的字节数,负数失败
+ */
+ssize_t vfs_copy(const char *src, const char *dst);
+
 /**
  * 关闭文件
  * @param fd 文件描述符
@@ -64,6 +91,23 @@ ssize_t vfs_read(int fd, void *buf, size_t size);
  */
 ssize_t vfs_write(int fd, const void *buf, size_t size);
 
+/**
+ * 为文件预分配连续空间 (文件系统不支持时返回 -ENOSYS)
+ * @param fd 文件描述符 (需可写)
+ * @param size 预计的最终文件大小
+ * @return 1 已预留连续空间 (不改变文件大小, 关闭时归还没用到的部分),
+ *         0 没有够长的连续区,负数失败
+ */
+int vfs_prealloc(int fd, uint32_t size);
+
+/**
+ * 查询打开文件的当前大小 (直接问文件系统服务端)
+ * @param fd   文件描述符
+ * @param size 输出文件大小
+ * @return 0 成功,负数失败 (服务端不支持时为 -ENOSYS)
+ */
+int vfs_file_size(int fd, uint32_t *size);
+
 /**
  * 创建目录
  * @param path 目录路径
@@ -94,6 +138,16 @@ struct vfs_stat {
  */
 int vfs_stat(const char *path, struct vfs_stat *st);
 
+/**
+ * 批量获取文件信息
+ * @param paths 路径数组
+ * @param count 路径个数
+ * @param st 输出信息数组
+ * @param results 输出各路径的结果,0 成功,负数错误码
+ * @return 0 成功(各路径结果见 results),负数失败
+ */
+int vfs_stat_many(const char *const paths[], int count, struct vfs_stat st[], int results[]);
+
 /**
  * 打开目录
  * @param path 目录路径
@@ -119,6 +173,16 @@ int vfs_readdir(int fd, char *name, size_t size);
  */
 int vfs_readdir_index(int fd, uint32_t index, struct vfs_dirent *dirent);
 
+/**
+ * 批量读取目录项
+ * @param fd 目录描述符
+ * @param cookie 输入起始位置(0 为开头),输出下次接着读的位置
+ * @param buf 输出缓冲区,存放紧排的 struct vfs_dirent_rec
+ * @param size 缓冲区大小
+ * @return 读到的项数,0 结束,负数失败
+ */
+int vfs_getdents(int fd, uint32_t *cookie, void *buf, uint32_t size);
+
 /**
  * 改变当前工作目录
  * @param path 目录路径
@@ -7,7 +7,7 @@
  * handle  = IPC endpoint (对端是谁)
  * session = 服务端 session ID (VFS/TTY/其他对象都可使用, 0 只是合法值)
  * offset  = 对象读写偏移
- * flags   = FD_FLAG_READ | WRITE | CLOEXEC | PIPE
+ * flags   = FD_FLAG_READ | WRITE | CLOEXEC | PIPE | DIR | WIN | NOWIN | NOCACHE | SPLICE | NOSPLICE
  *
  * 没有 type/proto 字段. write() 统一发 IO_WRITE, read() 统一发 IO_READ.
  * Pipe 是唯一例外: 使用 raw ipc_send/ipc_recv.
@@ -27,12 +27,21 @@
 #define FD_FLAG_CLOEXEC 0x04
 #define FD_FLAG_PIPE    0x08 /* pipe: 用 raw send/recv 而非 IO 协议 */
 #define FD_FLAG_DIR     0x10 /* 目录对象: after-open 控制面 */
+#define FD_FLAG_WIN     0x20 /* 会话已绑定本 fd 槽位的共享内存窗口 */
+#define FD_FLAG_NOWIN   0x40 /* 不走窗口 (服务端不支持或 dup 出的 fd) */
+#define FD_FLAG_NOCACHE 0x80 /* 会话未在内核文件页缓存登记, 不再查缓存 */
+#define FD_FLAG_SPLICE   0x100 /* 已探测: 服务端支持 IO_SPLICE_* */
+#define FD_FLAG_NOSPLICE 0x200 /* 已探测: 服务端不支持 IO_SPLICE_*, 直接 read/write */
+
+/* 每个 fd 槽位的共享内存窗口大小, 大于 FD_WIN_MIN 的读写经窗口一次搬运 */
+#define FD_WIN_SIZE (64 * 1024)
+#define FD_WIN_MIN  4096
 
 struct fd_entry {
     handle_t handle;     /* IPC endpoint */
     uint32_t session;    /* 服务端 session ID */
     uint32_t offset;     /* 对象读写偏移 */
-    uint8_t  flags;      /* FD_FLAG_* */
+    uint16_t flags;      /* FD_FLAG_* */
 };
 
 /**
@@ -78,6 +87,24 @@ handle_t fd_get_handle(int fd);
  * 安装 fd 条目
  */
 struct fd_entry *fd_install(int fd, handle_t handle, uint32_t session, uint32_t offset,
-                            uint8_t flags);
+                            uint16_t flags);
+
+/**
+ * 经共享内存窗口读 (IO_WIN_READ), 首次使用时创建窗口并借给服务端
+ * @return 读取字节数(0=EOF), -ENOSYS 表示该 fd 不走窗口, 其他负数为 errno
+ */
+int fd_win_read(int fd, struct fd_entry *ent, void *buf, uint32_t size);
+
+/**
+ * 经共享内存窗口写 (IO_WIN_WRITE)
+ * @return 写入字节数, -ENOSYS 表示该 fd 不走窗口, 其他负数为 errno
+ */
+int fd_win_write(int fd, struct fd_entry *ent, const void *buf, uint32_t size);
+
+/**
+ * 从内核文件页缓存读 (SYS_FCACHE_READ), 命中时不经过服务端
+ * @return 读取字节数, 0 表示未命中 (调用者继续走 IPC)
+ */
+int fd_cache_read(struct fd_entry *ent, void *buf, uint32_t size);
 
 #endif /* _XNIX_FD_H */
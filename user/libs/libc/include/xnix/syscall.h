@@ -11,8 +11,12 @@
 #include <stdint.h>
 #include <xnix/abi/handle.h>
 #include <xnix/abi/irq.h>
+#include <xnix/abi/mman.h>
 #include <xnix/abi/cap.h>
+#include <xnix/abi/fcache.h>
+#include <xnix/abi/pipe.h>
 #include <xnix/abi/process.h>
+#include <xnix/abi/ring.h>
 #include <xnix/abi/syscall.h>
 
 /*
@@ -210,6 +214,58 @@ static inline int sys_ioport_inw(uint16_t port) {
     return ret;
 }
 
+/**
+ * 从 I/O 端口连续读取 count 个字节(rep insb)
+ * @return 实际读取的字节数,-1 失败(设置 errno)
+ */
+static inline int sys_ioport_insb(uint16_t port, void *buf, uint32_t count) {
+    int ret = syscall3(SYS_IOPORT_INSB, (uint32_t)port, (uint32_t)(uintptr_t)buf, count);
+    if (ret < 0) {
+        errno = -ret;
+        return -1;
+    }
+    return ret;
+}
+
+/**
+ * 向 I/O 端口连续写入 count 个字节(rep outsb)
+ * @return 实际写入的字节数,-1 失败(设置 errno)
+ */
+static inline int sys_ioport_outsb(uint16_t port, const void *buf, uint32_t count) {
+    int ret = syscall3(SYS_IOPORT_OUTSB, (uint32_t)port, (uint32_t)(uintptr_t)buf, count);
+    if (ret < 0) {
+        errno = -ret;
+        return -1;
+    }
+    return ret;
+}
+
+/**
+ * 从 I/O 端口连续读取 count 个 16 位字(rep insw)
+ * @return 实际读取的字数,-1 失败(设置 errno)
+ */
+static inline int sys_ioport_insw(uint16_t port, void *buf, uint32_t count) {
+    int ret = syscall3(SYS_IOPORT_INSW, (uint32_t)port, (uint32_t)(uintptr_t)buf, count);
+    if (ret < 0) {
+        errno = -ret;
+        return -1;
+    }
+    return ret;
+}
+
+/**
+ * 向 I/O 端口连续写入 count 个 16 位字(rep outsw)
+ * @return 实际写入的字数,-1 失败(设置 errno)
+ */
+static inline int sys_ioport_outsw(uint16_t port, const void *buf, uint32_t count) {
+    int ret = syscall3(SYS_IOPORT_OUTSW, (uint32_t)port, (uint32_t)(uintptr_t)buf, count);
+    if (ret < 0) {
+        errno = -ret;
+        return -1;
+    }
+    return ret;
+}
+
 /**
  * 睡眠
  *
@@ -300,10 +356,11 @@ static inline int sys_pipe_create(handle_t *read_h, handle_t *write_h) {
 
 /**
  * 从管道读取
+ * @param flags ABI_PIPE_NONBLOCK: 无数据时失败, errno=EAGAIN
  * @return 读取字节数, 0=EOF, -1 失败
  */
-static inline int sys_pipe_read(handle_t h, void *buf, uint32_t size) {
-    int ret = syscall3(SYS_PIPE_READ, h, (uint32_t)(uintptr_t)buf, size);
+static inline int sys_pipe_read_flags(handle_t h, void *buf, uint32_t size, uint32_t flags) {
+    int ret = syscall4(SYS_PIPE_READ, h, (uint32_t)(uintptr_t)buf, size, flags);
     if (ret < 0) {
         errno = -ret;
         return -1;
@@ -311,12 +368,36 @@ static inline int sys_pipe_read(handle_t h, void *buf, uint32_t size) {
     return ret;
 }
 
+static inline int sys_pipe_read(handle_t h, void *buf, uint32_t size) {
+    return sys_pipe_read_flags(h, buf, size, 0);
+}
+
 /**
  * 向管道写入
+ * @param flags ABI_PIPE_NONBLOCK: 缓冲区满时返回已写字节数, 一字节未写则 errno=EAGAIN
  * @return 写入字节数, -1 失败
  */
+static inline int sys_pipe_write_flags(handle_t h, const void *buf, uint32_t size,
+                                       uint32_t flags) {
+    int ret = syscall4(SYS_PIPE_WRITE, h, (uint32_t)(uintptr_t)buf, size, flags);
+    if (ret < 0) {
+        errno = -ret;
+        return -1;
+    }
+    return ret;
+}
+
 static inline int sys_pipe_write(handle_t h, const void *buf, uint32_t size) {
-    int ret = syscall3(SYS_PIPE_WRITE, h, (uint32_t)(uintptr_t)buf, size);
+    return sys_pipe_write_flags(h, buf, size, 0);
+}
+
+/**
+ * 调整管道缓冲区容量
+ * @param size 新容量(按页取整并限制在内核上下限内), 0 仅查询
+ * @return 调整后的容量, -1 失败(EBUSY: 已缓冲数据超过新容量)
+ */
+static inline int sys_pipe_set_size(handle_t h, uint32_t size) {
+    int ret = syscall2(SYS_PIPE_SET_SIZE, h, size);
     if (ret < 0) {
         errno = -ret;
         return -1;
@@ -405,6 +486,34 @@ static inline int sys_ipc_reply_to(uint32_t sender_tid, struct ipc_message *repl
     return ret;
 }
 
+/**
+ * 接管延迟回复: 之后由当前线程回复 sender_tid, 对方捐出的优先级随之转来
+ * @return 0 成功,-1 失败(设置 errno)
+ */
+static inline int sys_ipc_reply_adopt(uint32_t sender_tid) {
+    int ret = syscall1(SYS_IPC_REPLY_ADOPT, sender_tid);
+    if (ret < 0) {
+        errno = -ret;
+        return -1;
+    }
+    return ret;
+}
+
+/**
+ * 设置/查询线程优先级 (小 = 高)
+ * @param tid  线程 TID, 0 表示当前线程
+ * @param prio 新的自身优先级, -1 表示只查询
+ * @return 含继承的有效优先级,-1 失败(设置 errno)
+ */
+static inline int sys_thread_prio(uint32_t tid, int prio) {
+    int ret = syscall2(SYS_THREAD_PRIO, tid, (uint32_t)prio);
+    if (ret < 0) {
+        errno = -ret;
+        return -1;
+    }
+    return ret;
+}
+
 /**
  * 等待多个 endpoint/notification 中任一就绪
  *
@@ -421,6 +530,21 @@ static inline handle_t sys_ipc_wait_any(void *set, uint32_t timeout_ms) {
     return (handle_t)ret;
 }
 
+/**
+ * 创建共享内存环形通道(SHM + SQ/CQ 门铃)
+ *
+ * @param args entries/entry_size 为输入, shm/sq_event/cq_event/size 为输出
+ * @return 0 成功,-1 失败(设置 errno)
+ */
+static inline int sys_ring_create(struct abi_ring_create_args *args) {
+    int ret = syscall1(SYS_RING_CREATE, (uint32_t)(uintptr_t)args);
+    if (ret < 0) {
+        errno = -ret;
+        return -1;
+    }
+    return 0;
+}
+
 /**
  * 等待子进程退出
  * @return 进程 PID,-1 失败(设置 errno)
@@ -523,6 +647,36 @@ static inline int sys_irq_read(uint8_t irq, void *buf, size_t size, uint32_t fla
     return ret;
 }
 
+/**
+ * @brief 解析 PCI 设备的 IRQ 并配置触发模式
+ * @param legacy 配置空间 Interrupt Line (0xFF 表示未分配)
+ * @return IRQ 号,-1 失败(设置 errno)
+ */
+static inline int sys_irq_route(uint8_t bus, uint8_t dev, uint8_t pin, uint8_t legacy) {
+    int ret = syscall4(SYS_IRQ_ROUTE, bus, dev, pin, legacy);
+    if (ret < 0) {
+        errno = -ret;
+        return -1;
+    }
+    return ret;
+}
+
+/**
+ * @brief 电平触发 IRQ 处理完毕, 重新使能
+ *
+ * 内核投递电平触发中断前会屏蔽该线, 驱动清除设备中断源后调用.
+ * 对边沿触发的 IRQ 是空操作.
+ * @return 0 成功,-1 失败(设置 errno)
+ */
+static inline int sys_irq_ack(uint8_t irq) {
+    int ret = syscall1(SYS_IRQ_ACK, (uint32_t)irq);
+    if (ret < 0) {
+        errno = -ret;
+        return -1;
+    }
+    return ret;
+}
+
 /*
  * 内存管理
  */
@@ -559,12 +713,87 @@ static inline void *sys_mmap_phys(handle_t handle, uint32_t offset, uint32_t siz
     return (void *)ret;
 }
 
+/**
+ * @brief 取消 sys_mmap_phys 建立的 SHM/DMA/MMIO 映射
+ *
+ * 物理页仍归 handle 所有, 释放的虚拟地址留给之后的映射复用.
+ *
+ * @param addr 映射起始地址
+ * @param size 映射大小
+ * @return 0 成功,-1 失败(设置 errno)
+ */
+static inline int sys_munmap(void *addr, uint32_t size) {
+    int ret = syscall2(SYS_MUNMAP, (uint32_t)(uintptr_t)addr, size);
+    if (ret < 0) {
+        errno = -ret;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 把已打开文件映射到用户空间
+ *
+ * 缺页时由内核向文件所在服务端取页. 映射用 sys_munmap 取消.
+ *
+ * @param args addr 为输出, 其余为输入
+ * @return 0 成功,-1 失败(设置 errno)
+ */
+static inline int sys_mmap_file(struct abi_mmap_file_args *args) {
+    int ret = syscall1(SYS_MMAP_FILE, (uint32_t)(uintptr_t)args);
+    if (ret < 0) {
+        errno = -ret;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 写回共享文件映射中的脏页
+ * @return 0 成功,-1 失败(设置 errno)
+ */
+static inline int sys_msync(void *addr, uint32_t size) {
+    int ret = syscall2(SYS_MSYNC, (uint32_t)(uintptr_t)addr, size);
+    if (ret < 0) {
+        errno = -ret;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 文件页缓存控制 (文件系统服务端使用)
+ * @return 0 成功,-1 失败(设置 errno)
+ */
+static inline int sys_fcache_ctl(struct abi_fcache_args *args) {
+    int ret = syscall1(SYS_FCACHE_CTL, (uint32_t)(uintptr_t)args);
+    if (ret < 0) {
+        errno = -ret;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 从文件页缓存读, 命中时不经过服务端
+ * @return 命中的字节数, 0 未命中,-1 失败(设置 errno, ENOENT 表示会话不走缓存)
+ */
+static inline int sys_fcache_read(handle_t handle, uint32_t session, uint32_t offset, void *buf,
+                                  uint32_t size) {
+    int ret = syscall5(SYS_FCACHE_READ, handle, session, offset, (uint32_t)(uintptr_t)buf, size);
+    if (ret < 0) {
+        errno = -ret;
+        return -1;
+    }
+    return ret;
+}
+
 /**
  * Physmem 信息结构(用于 sys_physmem_info)
  */
 struct physmem_info {
     uint32_t size;       /* 区域大小 */
-    uint32_t type;       /* 0=generic, 1=fb */
+    uint32_t type;       /* 0=generic, 1=fb, 2=shm, 3=dma, 4=mmio, 5=module */
     uint32_t width;      /* FB 宽度(仅 type=1) */
     uint32_t height;     /* FB 高度(仅 type=1) */
     uint32_t pitch;      /* FB pitch(仅 type=1) */
@@ -575,7 +804,8 @@ struct physmem_info {
     uint8_t  green_size; /* (仅 type=1) */
     uint8_t  blue_pos;   /* (仅 type=1) */
     uint8_t  blue_size;  /* (仅 type=1) */
-    uint8_t  _reserved[5];
+    uint8_t  _reserved[1];
+    uint32_t phys_addr;  /* 物理起始地址(仅 type=3/4) */
 };
 
 /**
@@ -609,6 +839,41 @@ static inline handle_t sys_shm_create(uint32_t size) {
     return (handle_t)ret;
 }
 
+/**
+ * 创建物理连续的 DMA 缓冲区
+ *
+ * 用 sys_mmap_phys 映射, 用 sys_physmem_info 取得物理地址.
+ *
+ * @param size 大小(字节,向上对齐到页)
+ * @return handle, HANDLE_INVALID 失败(设置 errno)
+ */
+static inline handle_t sys_dma_create(uint32_t size) {
+    int ret = syscall1(SYS_DMA_CREATE, size);
+    if (ret < 0) {
+        errno = -ret;
+        return (handle_t)-1;
+    }
+    return (handle_t)ret;
+}
+
+/**
+ * 包装设备 MMIO 区域(如 PCI 内存 BAR)
+ *
+ * 用 sys_mmap_phys 映射(禁用缓存). 地址不能与系统 RAM 重叠.
+ *
+ * @param phys 物理地址
+ * @param size 大小(字节)
+ * @return handle, HANDLE_INVALID 失败(设置 errno)
+ */
+static inline handle_t sys_mmio_create(uint32_t phys, uint32_t size) {
+    int ret = syscall2(SYS_MMIO_CREATE, phys, size);
+    if (ret < 0) {
+        errno = -ret;
+        return (handle_t)-1;
+    }
+    return (handle_t)ret;
+}
+
 /*
  * 进程列表
  */
@@ -723,6 +988,34 @@ static inline int sys_cap_revoke_from(pid_t pid, uint32_t cap_bits) {
     return ret;
 }
 
+/**
+ * 把自己拥有的端口区间授予目标进程
+ *
+ * @return 0 成功, -1 失败(设置 errno)
+ */
+static inline int sys_ioport_grant(pid_t pid, uint16_t start, uint16_t end) {
+    int ret = syscall3(SYS_IOPORT_GRANT, (uint32_t)pid, start, end);
+    if (ret < 0) {
+        errno = -ret;
+        return -1;
+    }
+    return ret;
+}
+
+/**
+ * 把自己拥有的 IRQ 授予目标进程
+ *
+ * @return 0 成功, -1 失败(设置 errno)
+ */
+static inline int sys_irq_grant(pid_t pid, uint8_t irq) {
+    int ret = syscall2(SYS_IRQ_GRANT, (uint32_t)pid, irq);
+    if (ret < 0) {
+        errno = -ret;
+        return -1;
+    }
+    return ret;
+}
+
 /**
  * 列出当前进程的所有 handle
  *
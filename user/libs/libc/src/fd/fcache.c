@@ -0,0 +1,29 @@
+/**
+ * @file fcache.c
+ * @brief fd 读先查内核文件页缓存
+ *
+ * 服务端打开文件时把会话登记到内核页缓存, 读过的整页交给内核.
+ * 之后的读先用 SYS_FCACHE_READ 从缓存拷贝, 命中部分不发 IPC;
+ * 未命中再走 IO_READ, 服务端顺带填充缓存.
+ * 会话未登记 (服务端不支持或不是文件) 时记 FD_FLAG_NOCACHE, 之后不再尝试.
+ */
+
+#include <errno.h>
+#include <xnix/fd.h>
+#include <xnix/syscall.h>
+
+int fd_cache_read(struct fd_entry *ent, void *buf, uint32_t size) {
+    if (ent->flags & (FD_FLAG_PIPE | FD_FLAG_DIR | FD_FLAG_NOCACHE)) {
+        return 0;
+    }
+
+    int n = sys_fcache_read(ent->handle, ent->session, ent->offset, buf, size);
+    if (n < 0) {
+        if (errno == ENOENT) {
+            ent->flags |= FD_FLAG_NOCACHE;
+        }
+        return 0;
+    }
+    ent->offset += (uint32_t)n;
+    return n;
+}
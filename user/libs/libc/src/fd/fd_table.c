@@ -108,7 +108,7 @@ handle_t fd_get_handle(int fd) {
 }
 
 struct fd_entry *fd_install(int fd, handle_t handle, uint32_t session, uint32_t offset,
-                            uint8_t flags) {
+                            uint16_t flags) {
     if (fd < 0 || fd >= FD_MAX) {
         return NULL;
     }
@@ -15,6 +15,7 @@
 #include <fcntl.h>
 #include <string.h>
 #include <unistd.h>
+#include <vfs_client.h>
 #include <xnix/abi/handle.h>
 #include <xnix/env.h>
 #include <xnix/fd.h>
@@ -24,15 +25,33 @@
 /* ---- write ---- */
 
 static ssize_t write_io(int fd, struct fd_entry *ent, const void *buf, size_t n) {
+    /* 大块写先走共享内存窗口 */
+    int w = fd_win_write(fd, ent, buf, (uint32_t)n);
+    if (w != -ENOSYS) {
+        if (w < 0) {
+            errno = -w;
+            return -1;
+        }
+        return (ssize_t)w;
+    }
+
     struct ipc_message msg   = {0};
     struct ipc_message reply = {0};
 
+    /*
+     * 数据作为单段 IOV 发出: 内核会合时直接从本进程拷进服务端的接收缓冲区,
+     * 省去系统调用入口的中转拷贝. 服务端收不下的部分被截断, 服务端只写
+     * 实际收到的部分并回复写入字节数 (见 abi/io.h IO_WRITE), 这里就是短写.
+     */
+    struct abi_ipc_iovec iov = {.data = (uint64_t)(uintptr_t)buf, .size = (uint32_t)n};
+
     msg.regs.data[0] = IO_WRITE;
     msg.regs.data[1] = ent->session;
     msg.regs.data[2] = ent->offset;
     msg.regs.data[3] = (uint32_t)n;
-    msg.buffer.data  = (uint64_t)(uintptr_t)buf;
-    msg.buffer.size  = (uint32_t)n;
+    msg.buffer.data  = (uint64_t)(uintptr_t)&iov;
+    msg.buffer.size  = 1;
+    msg.flags        = ABI_IPC_FLAG_IOV;
 
     int ret = sys_ipc_call(ent->handle, &msg, &reply, 5000);
     if (ret < 0) {
@@ -69,6 +88,20 @@ ssize_t write(int fd, const void *buf, size_t n) {
 /* ---- read ---- */
 
 static ssize_t read_io(int fd, struct fd_entry *ent, void *buf, size_t n) {
+    /* 先查内核文件页缓存, 再对大块读走共享内存窗口 */
+    int r = fd_cache_read(ent, buf, (uint32_t)n);
+    if (r > 0) {
+        return (ssize_t)r;
+    }
+    r = fd_win_read(fd, ent, buf, (uint32_t)n);
+    if (r != -ENOSYS) {
+        if (r < 0) {
+            errno = -r;
+            return -1;
+        }
+        return (ssize_t)r;
+    }
+
     struct ipc_message msg   = {0};
     struct ipc_message reply = {0};
 
@@ -163,7 +196,9 @@ int dup(int oldfd) {
         return -1;
     }
 
-    fd_install(newfd, (handle_t)new_handle, ent->session, ent->offset, ent->flags);
+    /* 会话上的窗口属于原 fd 槽位, 新 fd 不走窗口 */
+    fd_install(newfd, (handle_t)new_handle, ent->session, ent->offset,
+               (ent->flags & ~FD_FLAG_WIN) | FD_FLAG_NOWIN);
     return newfd;
 }
 
@@ -199,7 +234,9 @@ int dup2(int oldfd, int newfd) {
         return -1;
     }
 
-    fd_install(newfd, (handle_t)new_handle, ent->session, ent->offset, ent->flags);
+    /* 会话上的窗口属于原 fd 槽位, 新 fd 不走窗口 */
+    fd_install(newfd, (handle_t)new_handle, ent->session, ent->offset,
+               (ent->flags & ~FD_FLAG_WIN) | FD_FLAG_NOWIN);
     return newfd;
 }
 
@@ -235,6 +272,215 @@ int pipe(int fds[2]) {
     return 0;
 }
 
+/* ---- splice / sendfile ---- */
+
+#define SPLICE_CHUNK_MAX   (64 * 1024) /* 单次 IO_SPLICE_* 上限, 也是中转管道容量 */
+#define SPLICE_BOUNCE_SIZE 4096
+
+/* 请求文件服务端在文件与管道间搬运, 返回字节数或负 errno; pipe_h 无效时只探测 */
+static int splice_call(struct fd_entry *file, uint32_t op, handle_t pipe_h, uint32_t size) {
+    struct ipc_message msg   = {0};
+    struct ipc_message reply = {0};
+
+    msg.regs.data[0] = op;
+    msg.regs.data[1] = file->session;
+    msg.regs.data[2] = file->offset;
+    msg.regs.data[3] = size;
+    if (pipe_h != HANDLE_INVALID) {
+        msg.handles.handles[0] = pipe_h;
+        msg.handles.count      = 1;
+    }
+
+    int ret = sys_ipc_call(file->handle, &msg, &reply, 30000);
+    if (ret < 0) {
+        return -errno;
+    }
+    return (int32_t)reply.regs.data[0];
+}
+
+/*
+ * 每个 fd 首次搬运前不带 handle 探测一次: 支持的服务端回 -EBADF (缺管道 handle),
+ * 其余一律视为不支持并记在 fd 上. 不支持的服务端从此收不到管道 handle, 也就无从泄漏.
+ */
+static int splice_supported(struct fd_entry *file, uint32_t op) {
+    if (!(file->flags & (FD_FLAG_SPLICE | FD_FLAG_NOSPLICE))) {
+        int r = splice_call(file, op, HANDLE_INVALID, 0);
+        file->flags |= r == -EBADF ? FD_FLAG_SPLICE : FD_FLAG_NOSPLICE;
+    }
+    return (file->flags & FD_FLAG_SPLICE) != 0;
+}
+
+/* 服务端无法代劳时退回中转: ENOSYS=不支持该方向, EAGAIN=管道满/空需要阻塞等待 */
+static int splice_should_bounce(int err) {
+    return err == ENOSYS || err == EAGAIN;
+}
+
+static ssize_t splice_bounce(int fd_in, int fd_out, size_t len) {
+    char buf[SPLICE_BOUNCE_SIZE];
+
+    if (len > sizeof(buf)) len = sizeof(buf);
+
+    ssize_t n = read(fd_in, buf, len);
+    if (n <= 0) {
+        return n;
+    }
+
+    ssize_t done = 0;
+    while (done < n) {
+        ssize_t w = write(fd_out, buf + done, (size_t)(n - done));
+        if (w <= 0) {
+            return done > 0 ? done : -1;
+        }
+        done += w;
+    }
+    return done;
+}
+
+ssize_t splice(int fd_in, int fd_out, size_t len) {
+    struct fd_entry *in  = fd_get(fd_in);
+    struct fd_entry *out = fd_get(fd_out);
+    if (!in || !out) {
+        errno = EBADF;
+        return -1;
+    }
+
+    int in_pipe  = (in->flags & FD_FLAG_PIPE) != 0;
+    int out_pipe = (out->flags & FD_FLAG_PIPE) != 0;
+    if (!in_pipe && !out_pipe) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (len == 0) {
+        return 0;
+    }
+    if (len > SPLICE_CHUNK_MAX) len = SPLICE_CHUNK_MAX;
+
+    if (in_pipe != out_pipe) {
+        struct fd_entry *file   = in_pipe ? out : in;
+        handle_t         pipe_h = in_pipe ? in->handle : out->handle;
+        uint32_t         op     = in_pipe ? IO_SPLICE_IN : IO_SPLICE_OUT;
+
+        if (splice_supported(file, op)) {
+            int n = splice_call(file, op, pipe_h, (uint32_t)len);
+            if (n >= 0) {
+                file->offset += (uint32_t)n;
+                return n;
+            }
+            if (n == -ENOSYS) {
+                file->flags = (file->flags & ~FD_FLAG_SPLICE) | FD_FLAG_NOSPLICE;
+            }
+            if (!splice_should_bounce(-n)) {
+                errno = -n;
+                return -1;
+            }
+        }
+    }
+
+    return splice_bounce(fd_in, fd_out, len);
+}
+
+ssize_t sendfile(int out_fd, int in_fd, size_t count) {
+    struct fd_entry *in  = fd_get(in_fd);
+    struct fd_entry *out = fd_get(out_fd);
+    if (!in || !out) {
+        errno = EBADF;
+        return -1;
+    }
+
+    ssize_t total = 0;
+
+    if ((in->flags & FD_FLAG_PIPE) || (out->flags & FD_FLAG_PIPE)) {
+        while ((size_t)total < count) {
+            ssize_t n = splice(in_fd, out_fd, count - (size_t)total);
+            if (n < 0) {
+                return total > 0 ? total : -1;
+            }
+            if (n == 0) {
+                break;
+            }
+            total += n;
+        }
+        return total;
+    }
+
+    /*
+     * 目标是从头写的文件时按源文件剩余长度预分配连续空间. count 常是 SIZE_MAX
+     * (cat 这类 "读到 EOF" 的调用), 不能直接当大小; 问不到源长度就不预分配.
+     * 只对支持搬运的文件服务端发, 终端等不会收到.
+     */
+    uint32_t in_size;
+    if (out->offset == 0 && count > 0 && splice_supported(in, IO_SPLICE_OUT) &&
+        splice_supported(out, IO_SPLICE_IN) && vfs_file_size(in_fd, &in_size) == 0 &&
+        in_size > in->offset) {
+        size_t left = in_size - in->offset;
+        vfs_prealloc(out_fd, (uint32_t)(left < count ? left : count));
+    }
+
+    /* 任一端不支持搬运 (如终端) 就直接 read/write, 不必绕临时管道 */
+    if (!splice_supported(in, IO_SPLICE_OUT) || !splice_supported(out, IO_SPLICE_IN)) {
+        while ((size_t)total < count) {
+            ssize_t n = splice_bounce(in_fd, out_fd, count - (size_t)total);
+            if (n < 0) {
+                return total > 0 ? total : -1;
+            }
+            if (n == 0) {
+                break;
+            }
+            total += n;
+        }
+        return total;
+    }
+
+    /*
+     * 文件 -> 文件: 源服务端写入临时管道, 目标服务端从管道读出.
+     * 每轮搬运量不超过管道容量, 两侧都不会因管道满/空而阻塞.
+     */
+    int p[2];
+    if (pipe(p) < 0) {
+        return -1;
+    }
+
+    int cap = sys_pipe_set_size(fd_get_handle(p[0]), SPLICE_CHUNK_MAX);
+    if (cap <= 0) {
+        cap = sys_pipe_set_size(fd_get_handle(p[0]), 0);
+    }
+
+    int err = 0;
+    while ((size_t)total < count) {
+        size_t chunk = count - (size_t)total;
+        if (cap > 0 && chunk > (size_t)cap) chunk = (size_t)cap;
+
+        ssize_t n = splice(in_fd, p[1], chunk);
+        if (n <= 0) {
+            err = n < 0 ? errno : 0;
+            break;
+        }
+
+        ssize_t moved = 0;
+        while (moved < n) {
+            ssize_t m = splice(p[0], out_fd, (size_t)(n - moved));
+            if (m <= 0) {
+                err = m < 0 ? errno : EIO;
+                break;
+            }
+            moved += m;
+        }
+        total += moved;
+        if (moved < n) {
+            break;
+        }
+    }
+
+    close(p[0]);
+    close(p[1]);
+
+    if (err && total == 0) {
+        errno = err;
+        return -1;
+    }
+    return total;
+}
+
 /* ---- open ---- */
 
 static uint32_t g_io_vfsd_ep = HANDLE_INVALID;
@@ -0,0 +1,45 @@
+/**
+ * @file mman.c
+ * @brief 文件内存映射 (SYS_MMAP_FILE 封装)
+ */
+
+#include <errno.h>
+#include <sys/mman.h>
+#include <xnix/fd.h>
+#include <xnix/syscall.h>
+
+void *mmap(void *addr, size_t length, int prot, int flags, int fd, long offset) {
+    (void)addr;
+
+    struct fd_entry *ent = fd_get(fd);
+    if (!ent) {
+        errno = EBADF;
+        return MAP_FAILED;
+    }
+    if (offset < 0) {
+        errno = EINVAL;
+        return MAP_FAILED;
+    }
+
+    struct abi_mmap_file_args args = {
+        .handle  = ent->handle,
+        .session = ent->session,
+        .offset  = (uint32_t)offset,
+        .size    = (uint32_t)length,
+        .prot    = (uint32_t)prot,
+        .flags   = (uint32_t)flags,
+    };
+    if (sys_mmap_file(&args) < 0) {
+        return MAP_FAILED;
+    }
+    return (void *)(uintptr_t)args.addr;
+}
+
+int munmap(void *addr, size_t length) {
+    return sys_munmap(addr, (uint32_t)length);
+}
+
+int msync(void *addr, size_t length, int flags) {
+    (void)flags;
+    return sys_msync(addr, (uint32_t)length);
+}
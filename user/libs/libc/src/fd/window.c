@@ -0,0 +1,142 @@
+/**
+ * @file window.c
+ * @brief fd 共享内存窗口 (大块读写)
+ *
+ * 每个 fd 槽位在首次大块读写时创建一块 FD_WIN_SIZE 的 SHM 并映射, 之后
+ * 整个进程生命周期内复用. 槽位上打开的文件第一次走窗口时借给服务端
+ * (IO_WIN_ATTACH), 服务端把数据直接读写进窗口, IPC 只带偏移和字节数.
+ *
+ * 先发 IO_WIN_READ/IO_WIN_WRITE 探测: -ENOENT 说明服务端支持但尚未绑定,
+ * 绑定后重试; 其他错误一律退回 IO_READ/IO_WRITE, 不把 handle 交给不认识它的服务端.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <xnix/abi/io.h>
+#include <xnix/fd.h>
+#include <xnix/ipc.h>
+#include <xnix/syscall.h>
+
+static struct {
+    handle_t shm;
+    uint8_t *addr;
+} g_fd_win[FD_MAX];
+
+static int g_fd_win_disabled; /* 建不了 SHM (缺少能力等), 整个进程不再尝试 */
+
+/* 取得 fd 槽位的窗口映射, 需要时创建 */
+static uint8_t *fd_win_slot(int fd) {
+    if (g_fd_win[fd].addr) {
+        return g_fd_win[fd].addr;
+    }
+    if (g_fd_win_disabled) {
+        return NULL;
+    }
+
+    handle_t shm = sys_shm_create(FD_WIN_SIZE);
+    if (shm == (handle_t)-1) {
+        g_fd_win_disabled = 1;
+        return NULL;
+    }
+
+    void *addr = sys_mmap_phys(shm, 0, FD_WIN_SIZE, 0x03, NULL);
+    if (addr == (void *)-1) {
+        sys_handle_close(shm);
+        g_fd_win_disabled = 1;
+        return NULL;
+    }
+
+    g_fd_win[fd].shm  = shm;
+    g_fd_win[fd].addr = addr;
+    return addr;
+}
+
+static int fd_win_attach(int fd, struct fd_entry *ent) {
+    struct ipc_message msg   = {0};
+    struct ipc_message reply = {0};
+
+    msg.regs.data[0]       = IO_WIN_ATTACH;
+    msg.regs.data[1]       = ent->session;
+    msg.regs.data[2]       = FD_WIN_SIZE;
+    msg.handles.handles[0] = g_fd_win[fd].shm;
+    msg.handles.count      = 1;
+
+    if (sys_ipc_call(ent->handle, &msg, &reply, 5000) < 0) {
+        return -errno;
+    }
+    return (int32_t)reply.regs.data[0];
+}
+
+/* 发一次窗口读写, 会话未绑定窗口时绑定后重试 */
+static int fd_win_call(int fd, struct fd_entry *ent, uint32_t op, uint32_t size) {
+    for (int attempt = 0; attempt < 2; attempt++) {
+        struct ipc_message msg   = {0};
+        struct ipc_message reply = {0};
+
+        msg.regs.data[0] = op;
+        msg.regs.data[1] = ent->session;
+        msg.regs.data[2] = ent->offset;
+        msg.regs.data[3] = size;
+
+        if (sys_ipc_call(ent->handle, &msg, &reply, 30000) < 0) {
+            return -errno;
+        }
+
+        int32_t result = (int32_t)reply.regs.data[0];
+        if (result >= 0 || (ent->flags & FD_FLAG_WIN)) {
+            ent->flags |= FD_FLAG_WIN;
+            return result; /* 已绑定时的错误来自文件本身 */
+        }
+        if (result != -ENOENT || attempt > 0 || fd_win_attach(fd, ent) < 0) {
+            break;
+        }
+        ent->flags |= FD_FLAG_WIN;
+    }
+
+    ent->flags |= FD_FLAG_NOWIN;
+    return -ENOSYS;
+}
+
+static uint8_t *fd_win_prepare(int fd, struct fd_entry *ent, uint32_t size) {
+    if (fd < 0 || fd >= FD_MAX || size <= FD_WIN_MIN) {
+        return NULL;
+    }
+    if (ent->flags & (FD_FLAG_PIPE | FD_FLAG_DIR | FD_FLAG_NOWIN)) {
+        return NULL;
+    }
+    return fd_win_slot(fd);
+}
+
+int fd_win_read(int fd, struct fd_entry *ent, void *buf, uint32_t size) {
+    uint8_t *win = fd_win_prepare(fd, ent, size);
+    if (!win) {
+        return -ENOSYS;
+    }
+    if (size > FD_WIN_SIZE) {
+        size = FD_WIN_SIZE;
+    }
+
+    int n = fd_win_call(fd, ent, IO_WIN_READ, size);
+    if (n > 0) {
+        memcpy(buf, win, (uint32_t)n);
+        ent->offset += (uint32_t)n;
+    }
+    return n;
+}
+
+int fd_win_write(int fd, struct fd_entry *ent, const void *buf, uint32_t size) {
+    uint8_t *win = fd_win_prepare(fd, ent, size);
+    if (!win) {
+        return -ENOSYS;
+    }
+    if (size > FD_WIN_SIZE) {
+        size = FD_WIN_SIZE;
+    }
+
+    memcpy(win, buf, size);
+    int n = fd_win_call(fd, ent, IO_WIN_WRITE, size);
+    if (n > 0) {
+        ent->offset += (uint32_t)n;
+    }
+    return n;
+}
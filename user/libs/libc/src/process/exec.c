@@ -1,12 +1,14 @@
 #include <xnix/protocol/vfs.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <vfs_client.h>
 #include <xnix/abi/process.h>
 #include <xnix/errno.h>
+#include <xnix/fd.h>
 #include <xnix/syscall.h>
 
-#define EXEC_READ_CHUNK 4096
+#define EXEC_READ_CHUNK FD_WIN_SIZE /* 一次读满一个 fd 窗口 */
 
 static void derive_proc_name(char out[ABI_PROC_NAME_MAX], const char *path) {
     const char *base = path;
@@ -34,6 +36,35 @@ static void derive_proc_name(char out[ABI_PROC_NAME_MAX], const char *path) {
     out[len] = '\0';
 }
 
+/* 把内存中的 ELF 镜像交给内核创建进程 */
+static int exec_image(const struct abi_exec_args *args, const void *elf, uint32_t size) {
+    struct abi_exec_image_args img_args;
+    memset(&img_args, 0, sizeof(img_args));
+    derive_proc_name(img_args.name, args->path);
+    img_args.elf_ptr  = (uint32_t)(uintptr_t)elf;
+    img_args.elf_size = size;
+    img_args.flags    = args->flags;
+
+    int argc = args->argc;
+    if (argc < 0) {
+        argc = 0;
+    }
+    if (argc > ABI_EXEC_MAX_ARGS) {
+        argc = ABI_EXEC_MAX_ARGS;
+    }
+    img_args.argc = argc;
+    memcpy(img_args.argv, args->argv, sizeof(img_args.argv));
+
+    uint32_t handle_count = args->handle_count;
+    if (handle_count > ABI_EXEC_MAX_HANDLES) {
+        handle_count = ABI_EXEC_MAX_HANDLES;
+    }
+    img_args.handle_count = handle_count;
+    memcpy(img_args.handles, args->handles, handle_count * sizeof(args->handles[0]));
+
+    return syscall1(SYS_EXEC, (uint32_t)(uintptr_t)&img_args);
+}
+
 int sys_exec(struct abi_exec_args *args) {
     if (!args) {
         return -EINVAL;
@@ -43,21 +74,29 @@ int sys_exec(struct abi_exec_args *args) {
     }
 
     struct vfs_stat st;
-    int             ret = vfs_stat(args->path, &st);
-    if (ret < 0) {
-        return ret;
+    int             fd = vfs_open_stat(args->path, 0, &st);
+    if (fd < 0) {
+        return fd;
     }
 
     if (st.type != VFS_TYPE_FILE || st.size == 0) {
+        vfs_close(fd);
         return -EINVAL;
     }
 
-    int fd = vfs_open(args->path, 0);
-    if (fd < 0) {
-        return fd;
+    /*
+     * 能映射时直接把文件映射交给内核, 页来自内核页缓存, 再次执行同一程序不必经过服务端;
+     * 没有映射权限或服务端不支持映射时逐块读到堆上
+     */
+    void *elf = mmap(NULL, st.size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (elf != MAP_FAILED) {
+        vfs_close(fd);
+        int pid = exec_image(args, elf, st.size);
+        munmap(elf, st.size);
+        return pid;
     }
 
-    void *elf = malloc(st.size);
+    elf = malloc(st.size);
     if (!elf) {
         vfs_close(fd);
         return -ENOMEM;
@@ -84,31 +123,7 @@ int sys_exec(struct abi_exec_args *args) {
     }
     vfs_close(fd);
 
-    struct abi_exec_image_args img_args;
-    memset(&img_args, 0, sizeof(img_args));
-    derive_proc_name(img_args.name, args->path);
-    img_args.elf_ptr  = (uint32_t)(uintptr_t)elf;
-    img_args.elf_size = st.size;
-    img_args.flags    = args->flags;
-
-    int argc = args->argc;
-    if (argc < 0) {
-        argc = 0;
-    }
-    if (argc > ABI_EXEC_MAX_ARGS) {
-        argc = ABI_EXEC_MAX_ARGS;
-    }
-    img_args.argc = argc;
-    memcpy(img_args.argv, args->argv, sizeof(img_args.argv));
-
-    uint32_t handle_count = args->handle_count;
-    if (handle_count > ABI_EXEC_MAX_HANDLES) {
-        handle_count = ABI_EXEC_MAX_HANDLES;
-    }
-    img_args.handle_count = handle_count;
-    memcpy(img_args.handles, args->handles, handle_count * sizeof(args->handles[0]));
-
-    int pid = syscall1(SYS_EXEC, (uint32_t)(uintptr_t)&img_args);
+    int pid = exec_image(args, elf, st.size);
     free(elf);
     return pid;
 }
@@ -12,8 +12,58 @@
 #include <xnix/syscall.h>
 
 static char              g_path_buf[VFS_PATH_MAX];
+static char              g_path_buf2[VFS_PATH_MAX];
 static struct vfs_info   g_info_buf;
 static struct vfs_dirent g_dirent_buf;
+static uint8_t           g_file_buf[VFS_READFILE_MAX];
+
+/* GETDENTS: 一次最多 VFS_DENTS_MAX 项, 每项最长 VFS_DIRENT_REC_MAX, 全部装得下 */
+#define VFS_DENTS_BUF 4096
+#define VFS_DENTS_MAX (VFS_DENTS_BUF / VFS_DIRENT_REC_MAX)
+
+static struct vfs_dirent g_dents[VFS_DENTS_MAX];
+static uint8_t           g_dents_buf[VFS_DENTS_BUF];
+
+/* vfsd 登记的通知事件 */
+static handle_t g_watch_ev = HANDLE_INVALID;
+static uint32_t g_watch_bits;
+
+void vfs_notify_change(void) {
+    if (g_watch_ev != HANDLE_INVALID) {
+        sys_event_signal(g_watch_ev, g_watch_bits);
+    }
+}
+
+uint32_t vfs_dirent_pack(void *buf, uint32_t len, uint32_t cap, const struct vfs_dirent *entry) {
+    size_t   namelen = strnlen(entry->name, VFS_NAME_MAX - 1);
+    uint32_t reclen  = VFS_DIRENT_REC_LEN(namelen);
+    if (len + reclen > cap) {
+        return 0;
+    }
+
+    struct vfs_dirent_rec *rec = (struct vfs_dirent_rec *)((uint8_t *)buf + len);
+    memset(rec, 0, reclen);
+    rec->reclen  = (uint16_t)reclen;
+    rec->type    = (uint8_t)entry->type;
+    rec->namelen = (uint8_t)namelen;
+    rec->size    = entry->size;
+    memcpy(rec->name, entry->name, namelen);
+    return len + reclen;
+}
+
+/* 从 index 起读一批目录项; 没有 getdents 时逐项 readdir, 读失败即视为目录结束 */
+static int vfs_read_dents(struct vfs_operations *ops, void *ctx, uint32_t handle, uint32_t index,
+                          uint32_t max) {
+    if (ops->getdents) {
+        return ops->getdents(ctx, handle, index, g_dents, max);
+    }
+
+    uint32_t n = 0;
+    while (n < max && ops->readdir(ctx, handle, index + n, &g_dents[n]) == 0) {
+        n++;
+    }
+    return (int)n;
+}
 
 int vfs_dispatch(struct vfs_operations *ops, void *ctx, struct ipc_message *msg) {
     if (!ops || !msg) {
@@ -32,11 +82,20 @@ int vfs_dispatch(struct vfs_operations *ops, void *ctx, struct ipc_message *msg)
             memcpy(g_path_buf, (const void *)(uintptr_t)msg->buffer.data, msg->buffer.size);
             g_path_buf[msg->buffer.size] = '\0';
             handle_t file_ep = HANDLE_INVALID;
-            result = ops->open(ctx, g_path_buf, flags, &file_ep);
+            result = ops->open(ctx, g_path_buf, flags & ~VFS_O_STAT, &file_ep);
             if (result >= 0 && file_ep != HANDLE_INVALID) {
                 reply.handles.handles[0] = file_ep;
                 reply.handles.count      = 1;
             }
+            /* 顺带查询文件信息, 省去客户端单独一次 INFO */
+            if (result >= 0 && (flags & VFS_O_STAT) && ops->info &&
+                ops->info(ctx, g_path_buf, &g_info_buf) == 0) {
+                reply.regs.data[2] = g_info_buf.size;
+                reply.regs.data[3] = g_info_buf.type;
+            }
+            if (result >= 0 && (flags & VFS_O_CREAT)) {
+                vfs_notify_change();
+            }
         } else {
             result = -22;
         }
@@ -57,6 +116,27 @@ int vfs_dispatch(struct vfs_operations *ops, void *ctx, struct ipc_message *msg)
         }
         break;
     }
+    case UDM_VFS_READFILE: {
+        if (!ops->readfile) break;
+        uint32_t max = UDM_MSG_ARG(msg, 0);
+        if (max > sizeof(g_file_buf)) {
+            max = sizeof(g_file_buf);
+        }
+        if (msg->buffer.data && msg->buffer.size > 0 && msg->buffer.size < VFS_PATH_MAX) {
+            memcpy(g_path_buf, (const void *)(uintptr_t)msg->buffer.data, msg->buffer.size);
+            g_path_buf[msg->buffer.size] = '\0';
+            result = ops->readfile(ctx, g_path_buf, g_file_buf, max, &g_info_buf);
+            if (result >= 0) {
+                reply.buffer.data  = (uint64_t)(uintptr_t)g_file_buf;
+                reply.buffer.size  = (uint32_t)result;
+                reply.regs.data[2] = g_info_buf.size;
+                reply.regs.data[3] = g_info_buf.type;
+            }
+        } else {
+            result = -22;
+        }
+        break;
+    }
     case UDM_VFS_OPENDIR: {
         if (!ops->opendir) break;
         if (msg->buffer.data && msg->buffer.size > 0 && msg->buffer.size < VFS_PATH_MAX) {
@@ -83,6 +163,9 @@ int vfs_dispatch(struct vfs_operations *ops, void *ctx, struct ipc_message *msg)
             memcpy(g_path_buf, (const void *)(uintptr_t)msg->buffer.data, msg->buffer.size);
             g_path_buf[msg->buffer.size] = '\0';
             result = ops->mkdir(ctx, g_path_buf);
+            if (result == 0) {
+                vfs_notify_change();
+            }
         } else {
             result = -22;
         }
@@ -94,6 +177,9 @@ int vfs_dispatch(struct vfs_operations *ops, void *ctx, struct ipc_message *msg)
             memcpy(g_path_buf, (const void *)(uintptr_t)msg->buffer.data, msg->buffer.size);
             g_path_buf[msg->buffer.size] = '\0';
             result = ops->del(ctx, g_path_buf);
+            if (result == 0) {
+                vfs_notify_change();
+            }
         } else {
             result = -22;
         }
@@ -106,11 +192,48 @@ int vfs_dispatch(struct vfs_operations *ops, void *ctx, struct ipc_message *msg)
             const char *old_path = (const char *)(uintptr_t)msg->buffer.data;
             const char *new_path = old_path + old_len + 1;
             result = ops->rename(ctx, old_path, new_path);
+            if (result == 0) {
+                vfs_notify_change();
+            }
+        } else {
+            result = -22;
+        }
+        break;
+    }
+    case UDM_VFS_COPY: {
+        if (!ops->copy) break;
+        uint32_t    src_len = UDM_MSG_ARG(msg, 0);
+        uint32_t    size    = msg->buffer.size;
+        const char *buf     = (const char *)(uintptr_t)msg->buffer.data;
+        if (buf && src_len > 0 && src_len < VFS_PATH_MAX && size > src_len + 1 &&
+            size - src_len - 1 < VFS_PATH_MAX) {
+            memcpy(g_path_buf, buf, src_len);
+            g_path_buf[src_len] = '\0';
+            memcpy(g_path_buf2, buf + src_len + 1, size - src_len - 1);
+            g_path_buf2[size - src_len - 1] = '\0';
+            result = ops->copy(ctx, g_path_buf, g_path_buf2);
+            if (result >= 0) {
+                vfs_notify_change();
+            }
         } else {
             result = -22;
         }
         break;
     }
+    case UDM_VFS_WATCH: {
+        /* 同一个 vfsd 事件可能因多个挂载点多次登记, 位累加 */
+        if (msg->handles.count < 1) {
+            result = -22;
+            break;
+        }
+        if (g_watch_ev != HANDLE_INVALID) {
+            sys_handle_close(g_watch_ev);
+        }
+        g_watch_ev = msg->handles.handles[0];
+        g_watch_bits |= UDM_MSG_ARG(msg, 0);
+        result = 0;
+        break;
+    }
     case UDM_VFS_CLOSE: {
         if (!ops->close) break;
         result = ops->close(ctx, UDM_MSG_ARG(msg, 0));
@@ -140,6 +263,38 @@ int vfs_dispatch(struct vfs_operations *ops, void *ctx, struct ipc_message *msg)
             break;
         }
 
+        if (cmd == VFS_IOCTL_GETDENTS) {
+            if (!ops->readdir && !ops->getdents) {
+                result = -38;
+                break;
+            }
+
+            uint32_t index = msg->regs.data[3];
+            uint32_t cap   = msg->regs.data[4];
+            if (cap > sizeof(g_dents_buf)) {
+                cap = sizeof(g_dents_buf);
+            }
+            uint32_t max = cap / VFS_DIRENT_REC_MAX;
+            if (max == 0) {
+                result = -22;
+                break;
+            }
+
+            result = vfs_read_dents(ops, ctx, handle, index, max);
+            if (result < 0) {
+                break;
+            }
+
+            uint32_t len = 0;
+            for (int i = 0; i < result; i++) {
+                len = vfs_dirent_pack(g_dents_buf, len, cap, &g_dents[i]);
+            }
+            reply.buffer.data  = (uint64_t)(uintptr_t)g_dents_buf;
+            reply.buffer.size  = len;
+            reply.regs.data[1] = index + (uint32_t)result;
+            break;
+        }
+
         result = -38;
         break;
     }
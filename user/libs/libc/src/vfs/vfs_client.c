@@ -24,6 +24,29 @@
 /* VFS 服务器 endpoint */
 static uint32_t g_vfsd_ep = HANDLE_INVALID;
 
+/*
+ * 目录批量读取缓存: 按序号读目录项时一次 GETDENTS 取回一批, 之后逐项从缓存读出.
+ * 只支持从 0 开始顺序推进; 往回跳或服务端不支持时退回逐项 READDIR.
+ */
+#define VFS_DENTS_SLOTS 2
+#define VFS_DENTS_BUF   2048
+
+struct vfs_dents_cache {
+    int      fd;
+    uint32_t first;    /* 本批第一项的序号 */
+    uint32_t count;    /* 本批项数 */
+    uint32_t cookie;   /* 本批之后接着读的位置 */
+    uint32_t next_idx; /* 顺序游标: 序号及其记录偏移 */
+    uint32_t next_off;
+    uint8_t  used;
+    uint8_t  eof;
+    uint8_t  nosys; /* 服务端不支持 GETDENTS */
+    uint8_t  buf[VFS_DENTS_BUF];
+};
+
+static struct vfs_dents_cache g_dents[VFS_DENTS_SLOTS];
+static uint32_t               g_dents_next;
+
 static int vfs_ensure_vfsd(void) {
     if (g_vfsd_ep != HANDLE_INVALID) {
         return 0;
@@ -79,10 +102,8 @@ int vfs_mount(const char *path, uint32_t fs_ep) {
     return (int32_t)reply.regs.data[1];
 }
 
-/**
- * 打开文件(通过 vfsd) - 使用统一 fd 表
- */
-int vfs_open(const char *path, uint32_t flags) {
+/* 经 vfsd 打开文件并安装 fd, reply 留给调用者取附带信息 */
+static int vfs_open_reply(const char *path, uint32_t flags, struct ipc_message *reply) {
     if (!path) {
         return -EINVAL;
     }
@@ -97,8 +118,7 @@ int vfs_open(const char *path, uint32_t flags) {
     }
 
     /* 构造 IPC 消息 */
-    struct ipc_message msg   = {0};
-    struct ipc_message reply = {0};
+    struct ipc_message msg = {0};
 
     msg.regs.data[0] = UDM_VFS_OPEN;
     msg.regs.data[1] = (uint32_t)sys_getpid();
@@ -106,22 +126,22 @@ int vfs_open(const char *path, uint32_t flags) {
     msg.buffer.data  = (uint64_t)(uintptr_t)(void *)path;
     msg.buffer.size  = strlen(path);
 
-    int ret = sys_ipc_call(g_vfsd_ep, &msg, &reply, 5000);
+    int ret = sys_ipc_call(g_vfsd_ep, &msg, reply, 5000);
     if (ret < 0) {
         fd_free(fd);
         return -errno;
     }
 
     /* 后端结果: data[0] 为 0(成功)或 <0(错误码) */
-    int32_t result = (int32_t)reply.regs.data[0];
+    int32_t result = (int32_t)reply->regs.data[0];
     if (result < 0) {
         fd_free(fd);
         return result;
     }
 
     handle_t fs_ep = HANDLE_INVALID;
-    if (reply.handles.count > 0) {
-        fs_ep = reply.handles.handles[0];
+    if (reply->handles.count > 0) {
+        fs_ep = reply->handles.handles[0];
     }
 
     struct fd_entry *ent =
@@ -134,6 +154,144 @@ int vfs_open(const char *path, uint32_t flags) {
     return fd;
 }
 
+/**
+ * 打开文件(通过 vfsd) - 使用统一 fd 表
+ */
+int vfs_open(const char *path, uint32_t flags) {
+    struct ipc_message reply = {0};
+    return vfs_open_reply(path, flags, &reply);
+}
+
+/**
+ * 打开文件并取得文件信息(一次往返)
+ */
+int vfs_open_stat(const char *path, uint32_t flags, struct vfs_stat *st) {
+    if (!st) {
+        return -EINVAL;
+    }
+
+    struct ipc_message reply = {0};
+    int                fd    = vfs_open_reply(path, flags | VFS_O_STAT, &reply);
+    if (fd < 0) {
+        return fd;
+    }
+
+    /* 后端没有附带信息时补一次 stat */
+    if (reply.regs.data[3] == 0) {
+        int ret = vfs_stat(path, st);
+        if (ret < 0) {
+            vfs_close(fd);
+            return ret;
+        }
+        return fd;
+    }
+
+    st->size = reply.regs.data[2];
+    st->type = reply.regs.data[3];
+    return fd;
+}
+
+/**
+ * 读取整个小文件(通过 vfsd, 一次往返)
+ */
+ssize_t vfs_read_file(const char *path, void *buf, size_t size) {
+    if (!path || (!buf && size > 0)) {
+        return -EINVAL;
+    }
+    int init_ret = vfs_ensure_vfsd();
+    if (init_ret < 0) {
+        return init_ret;
+    }
+
+    uint32_t want = size > VFS_READFILE_MAX ? VFS_READFILE_MAX : (uint32_t)size;
+
+    struct ipc_message msg   = {0};
+    struct ipc_message reply = {0};
+
+    msg.regs.data[0] = UDM_VFS_READFILE;
+    msg.regs.data[1] = (uint32_t)sys_getpid();
+    msg.regs.data[2] = want;
+    msg.buffer.data  = (uint64_t)(uintptr_t)(void *)path;
+    msg.buffer.size  = strlen(path);
+
+    reply.buffer.data = (uint64_t)(uintptr_t)buf;
+    reply.buffer.size = want;
+
+    int ret = sys_ipc_call(g_vfsd_ep, &msg, &reply, 5000);
+    if (ret < 0) {
+        return -errno;
+    }
+
+    int32_t result = (int32_t)reply.regs.data[0];
+    if (result < 0 && result != -ENOSYS) {
+        return result;
+    }
+    if (result >= 0 && ((size_t)result == size || (uint32_t)result >= reply.regs.data[2])) {
+        return result; /* 缓冲区已满或已读到文件末尾 */
+    }
+
+    /* 后端不支持, 或文件超出一次能读的大小: 打开后接着读 */
+    uint32_t total = result > 0 ? (uint32_t)result : 0;
+    int      fd    = vfs_open(path, VFS_O_RDONLY);
+    if (fd < 0) {
+        return fd;
+    }
+    fd_get(fd)->offset = total;
+
+    while (total < size) {
+        ssize_t n = vfs_read(fd, (uint8_t *)buf + total, size - total);
+        if (n < 0) {
+            vfs_close(fd);
+            return n;
+        }
+        if (n == 0) {
+            break;
+        }
+        total += (uint32_t)n;
+    }
+    vfs_close(fd);
+    return (ssize_t)total;
+}
+
+/**
+ * 复制文件(通过 vfsd, 同一后端时由后端自己完成)
+ */
+ssize_t vfs_copy(const char *src, const char *dst) {
+    if (!src || !dst) {
+        return -EINVAL;
+    }
+    int init_ret = vfs_ensure_vfsd();
+    if (init_ret < 0) {
+        return init_ret;
+    }
+
+    size_t src_len = strlen(src);
+    size_t dst_len = strlen(dst);
+    if (src_len == 0 || dst_len == 0 || src_len >= VFS_PATH_MAX || dst_len >= VFS_PATH_MAX) {
+        return -EINVAL;
+    }
+
+    char paths[VFS_PATH_MAX * 2];
+    memcpy(paths, src, src_len + 1);
+    memcpy(paths + src_len + 1, dst, dst_len);
+
+    struct ipc_message msg   = {0};
+    struct ipc_message reply = {0};
+
+    msg.regs.data[0] = UDM_VFS_COPY;
+    msg.regs.data[1] = (uint32_t)sys_getpid();
+    msg.regs.data[2] = (uint32_t)src_len;
+    msg.buffer.data  = (uint64_t)(uintptr_t)paths;
+    msg.buffer.size  = (uint32_t)(src_len + 1 + dst_len);
+
+    /* 耗时随文件大小, 不设超时 */
+    int ret = sys_ipc_call(g_vfsd_ep, &msg, &reply, 0);
+    if (ret < 0) {
+        return -errno;
+    }
+    return (int32_t)reply.regs.data[0];
+}
+
 /**
  * 关闭文件(直接与 FS 驱动通信) - 使用统一 fd 表
  */
@@ -169,6 +327,16 @@ ssize_t vfs_read(int fd, void *buf, size_t size) {
         return 0;
     }
 
+    /* 先查内核文件页缓存, 再对大块读走共享内存窗口 */
+    int n = fd_cache_read(ent, buf, (uint32_t)size);
+    if (n > 0) {
+        return n;
+    }
+    n = fd_win_read(fd, ent, buf, (uint32_t)size);
+    if (n != -ENOSYS) {
+        return n;
+    }
+
     struct ipc_message msg   = {0};
     struct ipc_message reply = {0};
 
@@ -209,6 +377,12 @@ ssize_t vfs_write(int fd, const void *buf, size_t size) {
         return 0;
     }
 
+    /* 大块写先走共享内存窗口 */
+    int n = fd_win_write(fd, ent, buf, (uint32_t)size);
+    if (n != -ENOSYS) {
+        return n;
+    }
+
     struct ipc_message msg   = {0};
     struct ipc_message reply = {0};
 
@@ -232,6 +406,58 @@ ssize_t vfs_write(int fd, const void *buf, size_t size) {
     return result;
 }
 
+/**
+ * 预分配文件空间(直接与 FS 驱动通信)
+ */
+int vfs_prealloc(int fd, uint32_t size) {
+    struct fd_entry *ent = fd_get(fd);
+    if (!ent || (ent->flags & FD_FLAG_DIR)) {
+        return -EBADF;
+    }
+
+    struct ipc_message msg   = {0};
+    struct ipc_message reply = {0};
+
+    msg.regs.data[0] = IO_IOCTL;
+    msg.regs.data[1] = ent->session;
+    msg.regs.data[2] = VFS_IOCTL_PREALLOC;
+    msg.regs.data[3] = size;
+
+    int ret = sys_ipc_call(ent->handle, &msg, &reply, 30000);
+    if (ret < 0) {
+        return -errno;
+    }
+
+    return (int32_t)reply.regs.data[0];
+}
+
+/**
+ * 查询文件大小(直接与 FS 驱动通信)
+ */
+int vfs_file_size(int fd, uint32_t *size) {
+    struct fd_entry *ent = fd_get(fd);
+    if (!ent || (ent->flags & (FD_FLAG_DIR | FD_FLAG_PIPE)) || !size) {
+        return -EBADF;
+    }
+
+    struct ipc_message msg   = {0};
+    struct ipc_message reply = {0};
+
+    msg.regs.data[0] = IO_IOCTL;
+    msg.regs.data[1] = ent->session;
+    msg.regs.data[2] = VFS_IOCTL_GETSIZE;
+
+    if (sys_ipc_call(ent->handle, &msg, &reply, 1000) < 0) {
+        return -errno;
+    }
+
+    int32_t result = (int32_t)reply.regs.data[0];
+    if (result == 0) {
+        *size = reply.regs.data[1];
+    }
+    return result;
+}
+
 /**
  * 创建目录(通过 vfsd)
  */
@@ -324,6 +550,70 @@ int vfs_stat(const char *path, struct vfs_stat *st) {
     return 0;
 }
 
+/**
+ * 批量获取文件信息(通过 vfsd, 每 VFS_STATV_MAX 个路径一次往返)
+ */
+int vfs_stat_many(const char *const paths[], int count, struct vfs_stat st[], int results[]) {
+    static char g_statv_buf[VFS_STATV_MAX * VFS_PATH_MAX];
+
+    if (!paths || !st || !results || count < 0) {
+        return -EINVAL;
+    }
+    int init_ret = vfs_ensure_vfsd();
+    if (init_ret < 0) {
+        return init_ret;
+    }
+
+    for (int base = 0; base < count; base += VFS_STATV_MAX) {
+        int n = count - base < VFS_STATV_MAX ? count - base : VFS_STATV_MAX;
+
+        /* 路径首尾相接, 各自带 NUL; 过长的路径发空串, 由 vfsd 回 -EINVAL */
+        uint32_t len = 0;
+        for (int i = 0; i < n; i++) {
+            size_t plen = paths[base + i] ? strlen(paths[base + i]) : 0;
+            if (plen >= VFS_PATH_MAX) {
+                plen = 0;
+            }
+            if (plen > 0) {
+                memcpy(g_statv_buf + len, paths[base + i], plen);
+            }
+            g_statv_buf[len + plen] = '\0';
+            len += (uint32_t)plen + 1;
+        }
+
+        struct vfs_stat_rec recs[VFS_STATV_MAX];
+        struct ipc_message  msg   = {0};
+        struct ipc_message  reply = {0};
+
+        msg.regs.data[0] = UDM_VFS_STATV;
+        msg.regs.data[1] = (uint32_t)sys_getpid();
+        msg.regs.data[2] = (uint32_t)n;
+        msg.buffer.data  = (uint64_t)(uintptr_t)g_statv_buf;
+        msg.buffer.size  = len;
+
+        reply.buffer.data = (uint64_t)(uintptr_t)recs;
+        reply.buffer.size = sizeof(recs);
+
+        int ret = sys_ipc_call(g_vfsd_ep, &msg, &reply, 5000);
+        if (ret < 0) {
+            return -errno;
+        }
+
+        int32_t result = (int32_t)reply.regs.data[0];
+        if (result < 0) {
+            return result;
+        }
+
+        for (int i = 0; i < n; i++) {
+            results[base + i] = recs[i].result;
+            st[base + i].size = recs[i].size;
+            st[base + i].type = recs[i].type;
+        }
+    }
+
+    return 0;
+}
+
 /**
  * 打开目录(通过 vfsd) - 使用统一 fd 表
  */
@@ -364,6 +654,12 @@ int vfs_opendir(const char *path) {
         dir_ep = reply.handles.handles[0];
     }
 
+    for (int i = 0; i < VFS_DENTS_SLOTS; i++) {
+        if (g_dents[i].used && g_dents[i].fd == fd) {
+            g_dents[i].used = 0;
+        }
+    }
+
     struct fd_entry *ent =
         fd_install(fd, dir_ep, (uint32_t)result, 0, FD_FLAG_READ | FD_FLAG_DIR);
     if (!ent) {
@@ -386,33 +682,17 @@ int vfs_readdir(int fd, char *name, size_t size) {
         return -EINVAL;
     }
 
-    struct ipc_message msg   = {0};
-    struct ipc_message reply = {0};
-    char               tmp_name[256];
-
-    msg.regs.data[0] = IO_IOCTL;
-    msg.regs.data[1] = ent->session;
-    msg.regs.data[2] = VFS_IOCTL_READDIR;
-    msg.regs.data[3] = ent->offset;
-
-    reply.buffer.data = (uint64_t)(uintptr_t)tmp_name;
-    reply.buffer.size = sizeof(tmp_name);
-
-    int ret = sys_ipc_call(ent->handle, &msg, &reply, 5000);
+    struct vfs_dirent dirent;
+    int               ret = vfs_readdir_index(fd, ent->offset, &dirent);
     if (ret < 0) {
-        return -errno;
-    }
-
-    int32_t result = (int32_t)reply.regs.data[0];
-    if (result <= 0) {
-        return result;
+        return ret;
     }
 
-    size_t copy_size = strlen(tmp_name);
+    size_t copy_size = strlen(dirent.name);
     if (copy_size > size - 1) {
         copy_size = size - 1;
     }
-    memcpy(name, tmp_name, copy_size);
+    memcpy(name, dirent.name, copy_size);
     name[copy_size] = '\0';
     ent->offset++;
     return 1;
@@ -510,6 +790,111 @@ int vfs_copy_cwd_to_child(pid_t child_pid) {
     return (int32_t)reply.regs.data[1];
 }
 
+/**
+ * 批量读取目录项(直接与 FS 驱动或 vfsd 目录代理通信)
+ */
+int vfs_getdents(int fd, uint32_t *cookie, void *buf, uint32_t size) {
+    struct fd_entry *ent = fd_get(fd);
+    if (!ent || !(ent->flags & FD_FLAG_DIR)) {
+        return -EBADF;
+    }
+
+    if (!cookie || !buf || size < VFS_DIRENT_REC_MAX) {
+        return -EINVAL;
+    }
+
+    struct ipc_message msg   = {0};
+    struct ipc_message reply = {0};
+
+    msg.regs.data[0] = IO_IOCTL;
+    msg.regs.data[1] = ent->session;
+    msg.regs.data[2] = VFS_IOCTL_GETDENTS;
+    msg.regs.data[3] = *cookie;
+    msg.regs.data[4] = size;
+
+    reply.buffer.data = (uint64_t)(uintptr_t)buf;
+    reply.buffer.size = size;
+
+    int ret = sys_ipc_call(ent->handle, &msg, &reply, 5000);
+    if (ret < 0) {
+        return -errno;
+    }
+
+    int32_t result = (int32_t)reply.regs.data[0];
+    if (result > 0) {
+        *cookie = reply.regs.data[1];
+    }
+    return result;
+}
+
+static struct vfs_dents_cache *vfs_dents_slot(int fd) {
+    for (int i = 0; i < VFS_DENTS_SLOTS; i++) {
+        if (g_dents[i].used && g_dents[i].fd == fd) {
+            return &g_dents[i];
+        }
+    }
+
+    struct vfs_dents_cache *c = &g_dents[g_dents_next++ % VFS_DENTS_SLOTS];
+    c->fd                     = fd;
+    c->first                  = 0;
+    c->count                  = 0;
+    c->cookie                 = 0;
+    c->next_idx               = 0;
+    c->next_off               = 0;
+    c->used                   = 1;
+    c->eof                    = 0;
+    c->nosys                  = 0;
+    return c;
+}
+
+/* 从批量缓存取第 index 项, 缓存用不上时返回 -ENOSYS */
+static int vfs_dents_get(int fd, uint32_t index, struct vfs_dirent *dirent) {
+    struct vfs_dents_cache *c = vfs_dents_slot(fd);
+    if (c->nosys || index < c->first) {
+        return -ENOSYS;
+    }
+
+    uint32_t end = c->first + c->count;
+    if (index >= end) {
+        if (c->eof) {
+            return -ENOENT;
+        }
+        if (index != end) {
+            return -ENOSYS;
+        }
+
+        int n = vfs_getdents(fd, &c->cookie, c->buf, sizeof(c->buf));
+        if (n < 0) {
+            c->nosys = 1;
+            return -ENOSYS;
+        }
+        if (n == 0) {
+            c->eof = 1;
+            return -ENOENT;
+        }
+        c->first    = end;
+        c->count    = (uint32_t)n;
+        c->next_idx = c->first;
+        c->next_off = 0;
+    }
+
+    if (index < c->next_idx) {
+        c->next_idx = c->first;
+        c->next_off = 0;
+    }
+    while (c->next_idx < index) {
+        c->next_off += ((struct vfs_dirent_rec *)(c->buf + c->next_off))->reclen;
+        c->next_idx++;
+    }
+
+    const struct vfs_dirent_rec *rec = (const struct vfs_dirent_rec *)(c->buf + c->next_off);
+    memset(dirent, 0, sizeof(*dirent));
+    memcpy(dirent->name, rec->name, rec->namelen < VFS_NAME_MAX ? rec->namelen : VFS_NAME_MAX - 1);
+    dirent->type = rec->type;
+    dirent->size = rec->size;
+    return 0;
+}
+
 /**
  * 读取目录项(带索引) - 使用统一 fd 表
  */
@@ -523,6 +908,11 @@ int vfs_readdir_index(int fd, uint32_t index, struct vfs_dirent *dirent) {
         return -EINVAL;
     }
 
+    int cached = vfs_dents_get(fd, index, dirent);
+    if (cached != -ENOSYS) {
+        return cached;
+    }
+
     struct ipc_message msg   = {0};
     struct ipc_message reply = {0};
 
@@ -33,14 +33,34 @@ static int __posix_spawn_resolve_path(const char *file, char *out, size_t out_le
         return file_exists(out) ? 0 : -ENOENT;
     }
 
+    /* 全部候选 (3 个目录 × 有无 .elf) 一次批量 stat, 按搜索顺序取第一个普通文件 */
+    char            cands[6][VFS_PATH_MAX];
+    const char     *cand_ptrs[6];
+    struct vfs_stat st[6];
+    int             results[6];
+    int             n = 0;
+
     for (int i = 0; paths[i]; i++) {
-        int written = snprintf(out, out_len, "%s/%s", paths[i], file);
-        if (written > 0 && (size_t)written < out_len && file_exists(out)) {
-            return 0;
+        int written = snprintf(cands[n], sizeof(cands[n]), "%s/%s", paths[i], file);
+        if (written > 0 && (size_t)written < out_len && (size_t)written < sizeof(cands[n])) {
+            cand_ptrs[n] = cands[n];
+            n++;
+        }
+
+        written = snprintf(cands[n], sizeof(cands[n]), "%s/%s.elf", paths[i], file);
+        if (written > 0 && (size_t)written < out_len && (size_t)written < sizeof(cands[n])) {
+            cand_ptrs[n] = cands[n];
+            n++;
         }
+    }
+
+    if (n == 0 || vfs_stat_many(cand_ptrs, n, st, results) < 0) {
+        return -ENOENT;
+    }
 
-        written = snprintf(out, out_len, "%s/%s.elf", paths[i], file);
-        if (written > 0 && (size_t)written < out_len && file_exists(out)) {
+    for (int i = 0; i < n; i++) {
+        if (results[i] == 0 && st[i].type == VFS_TYPE_FILE) {
+            strcpy(out, cands[i]);
             return 0;
         }
     }
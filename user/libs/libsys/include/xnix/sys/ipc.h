@@ -27,6 +27,8 @@ struct sys_ipc_builder {
 void sys_ipc_builder_init(struct sys_ipc_builder *builder, uint32_t opcode);
 int  sys_ipc_builder_add_arg(struct sys_ipc_builder *builder, uint32_t arg);
 void sys_ipc_builder_set_buffer(struct sys_ipc_builder *builder, const void *data, uint32_t size);
+void sys_ipc_builder_set_iov(struct sys_ipc_builder *builder, const struct abi_ipc_iovec *iov,
+                             uint32_t count);
 int  sys_ipc_builder_call(struct sys_ipc_builder *builder, handle_t ep,
                           struct abi_ipc_message *reply, uint32_t timeout);
 int  sys_ipc_builder_send(struct sys_ipc_builder *builder, handle_t ep, uint32_t timeout);
@@ -42,6 +44,15 @@ struct sys_ipc_dispatch_entry {
 int sys_ipc_server_dispatch(const struct sys_ipc_dispatch_entry *table, uint32_t table_size,
                             void *ctx, const struct abi_ipc_message *msg,
                             struct abi_ipc_message *reply);
+/**
+ * 把消息 buffer 设置为分散/聚集段(发送或预置接收段均可)
+ *
+ * iov 数组在消息收发完成前必须保持有效.
+ */
+void sys_ipc_msg_set_iov(struct abi_ipc_message *msg, const struct abi_ipc_iovec *iov,
+                         uint32_t count);
+void sys_ipc_iov_set(struct abi_ipc_iovec *iov, const void *data, uint32_t size);
+
 int  sys_ipc_msg_get_buffer(const struct abi_ipc_message *msg, const void **data, uint32_t *size);
 void sys_ipc_reply_result(struct abi_ipc_message *reply, uint32_t result);
 void sys_ipc_reply_data(struct abi_ipc_message *reply, uint32_t result, const void *data,
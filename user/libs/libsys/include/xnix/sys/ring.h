@@ -0,0 +1,59 @@
+/**
+ * @file ring.h
+ * @brief libsys 共享内存环形通道 helper
+ *
+ * 客户端 submit 到 SQ / reap 自 CQ, 服务端 take 自 SQ / complete 到 CQ.
+ * 只有队列从空变为非空(唤醒消费者)或从满变为非满(唤醒生产者)时才敲门铃,
+ * 其余情况纯用户态读写共享内存.
+ */
+
+#ifndef XNIX_SYS_RING_H
+#define XNIX_SYS_RING_H
+
+#include <xnix/abi/handle.h>
+#include <xnix/abi/ring.h>
+
+struct sys_ring {
+    struct abi_ring_header *hdr;
+    uint8_t                *sq_slots;
+    uint8_t                *cq_slots;
+    handle_t                shm;
+    handle_t                sq_event;
+    handle_t                cq_event;
+    uint32_t                size;
+
+    /* 映射时校验过的几何参数副本, 不再读共享头部 */
+    uint32_t entries;
+    uint32_t mask;
+    uint32_t entry_size;
+};
+
+/**
+ * 创建通道并映射到本进程
+ *
+ * @return 0 成功,-1 失败(设置 errno)
+ */
+int sys_ring_create_chan(struct sys_ring *ring, uint32_t entries, uint32_t entry_size);
+
+/**
+ * 映射对端传来的通道(handle 通常随 IPC 消息到达)
+ *
+ * @return 0 成功,-1 失败(设置 errno)
+ */
+int sys_ring_attach(struct sys_ring *ring, handle_t shm, handle_t sq_event, handle_t cq_event);
+
+/* 客户端 */
+int sys_ring_submit(struct sys_ring *ring, const void *entry);
+int sys_ring_reap(struct sys_ring *ring, void *entry);
+int sys_ring_wait_complete(struct sys_ring *ring);
+
+/* 服务端 */
+int sys_ring_take(struct sys_ring *ring, void *entry);
+int sys_ring_complete(struct sys_ring *ring, const void *entry);
+int sys_ring_wait_submit(struct sys_ring *ring);
+
+/** 队列中待消费的条目数 */
+uint32_t sys_ring_sq_pending(const struct sys_ring *ring);
+uint32_t sys_ring_cq_pending(const struct sys_ring *ring);
+
+#endif /* XNIX_SYS_RING_H */
@@ -86,6 +86,36 @@ void sys_ipc_builder_set_buffer(struct sys_ipc_builder *builder, const void *dat
     builder->msg.buffer.size = size;
 }
 
+void sys_ipc_builder_set_iov(struct sys_ipc_builder *builder, const struct abi_ipc_iovec *iov,
+                             uint32_t count) {
+    if (!builder) {
+        return;
+    }
+
+    sys_ipc_msg_set_iov(&builder->msg, iov, count);
+}
+
+void sys_ipc_msg_set_iov(struct abi_ipc_message *msg, const struct abi_ipc_iovec *iov,
+                         uint32_t count) {
+    if (!msg) {
+        return;
+    }
+
+    msg->buffer.data = (uint64_t)(uintptr_t)iov;
+    msg->buffer.size = count;
+    msg->flags |= ABI_IPC_FLAG_IOV;
+}
+
+void sys_ipc_iov_set(struct abi_ipc_iovec *iov, const void *data, uint32_t size) {
+    if (!iov) {
+        return;
+    }
+
+    iov->data = (uint64_t)(uintptr_t)data;
+    iov->size = size;
+    iov->_pad = 0;
+}
+
 int sys_ipc_builder_call(struct sys_ipc_builder *builder, handle_t ep,
                          struct abi_ipc_message *reply, uint32_t timeout) {
     if (!builder || !reply || ep == HANDLE_INVALID) {
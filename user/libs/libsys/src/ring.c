@@ -0,0 +1,242 @@
+/**
+ * @file ring.c
+ * @brief libsys 共享内存环形通道 helper
+ *
+ * 单生产者/单消费者. 生产者写槽后 release 推进 tail,
+ * 消费者 acquire 读 tail 后取槽, 再 release 推进 head.
+ *
+ * 门铃规则:
+ *   - 入队前队列为空 -> 敲消费者门铃
+ *   - 出队前队列已满 -> 敲生产者门铃
+ * event 的 pending_bits 是粘滞的, 消费者"检查为空 -> event_wait"之间
+ * 到达的门铃不会丢失, 最多多醒一次.
+ *
+ * 推进自己的索引后要重读对端索引决定是否敲门铃, 这是 store -> load,
+ * release/acquire 不阻止两者重排 (x86 的 store buffer 就会这样做),
+ * 两端都把对方的旧值读进来就谁也不敲门铃, 双双睡死. 所以中间加全屏障.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <xnix/sys/ring.h>
+#include <xnix/syscall.h>
+
+#define RING_DOORBELL 1u
+
+static uint32_t ring_load(const volatile uint32_t *p) {
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static void ring_store(volatile uint32_t *p, uint32_t v) {
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+/* 本端索引的写入先于随后对对端索引的读取被对端看到 */
+static void ring_fence(void) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+/* 槽数组 [offset, offset + bytes) 落在头部之后且不越过 SHM 末尾 */
+static int ring_slots_fit(uint32_t offset, uint32_t bytes, uint32_t size) {
+    return offset >= ABI_RING_HDR_SIZE && (offset & 3) == 0 && offset <= size &&
+           bytes <= size - offset;
+}
+
+/*
+ * 头部在共享内存里, 对端随时可以改写. 几何参数只在映射时校验一次,
+ * 之后收发只用本地副本, 对端改头部最多弄乱自己的数据, 不会让本进程越界.
+ */
+static int ring_map(struct sys_ring *ring) {
+    uint32_t size = 0;
+    void    *addr = sys_mmap_phys(ring->shm, 0, 0, 0x03, &size);
+    if (addr == (void *)-1) {
+        return -1;
+    }
+
+    const volatile struct abi_ring_header *hdr = addr;
+    if (size < ABI_RING_HDR_SIZE) {
+        sys_munmap(addr, size);
+        errno = EINVAL;
+        return -1;
+    }
+
+    uint32_t entries    = hdr->entries;
+    uint32_t entry_size = hdr->entry_size;
+    uint32_t mask       = hdr->mask;
+    uint32_t sq_offset  = hdr->sq.offset;
+    uint32_t cq_offset  = hdr->cq.offset;
+
+    /* entries <= ENTRIES_MAX, entry_size <= ENTRY_MAX, 乘积不会溢出 */
+    if (hdr->magic != ABI_RING_MAGIC || entries == 0 ||
+        entries > ABI_RING_ENTRIES_MAX || (entries & (entries - 1)) != 0 ||
+        mask != entries - 1 || entry_size == 0 || entry_size > ABI_RING_ENTRY_MAX ||
+        (entry_size & 3) != 0 || !ring_slots_fit(sq_offset, entries * entry_size, size) ||
+        !ring_slots_fit(cq_offset, entries * entry_size, size)) {
+        sys_munmap(addr, size);
+        errno = EINVAL;
+        return -1;
+    }
+
+    ring->hdr        = (struct abi_ring_header *)addr;
+    ring->sq_slots   = (uint8_t *)addr + sq_offset;
+    ring->cq_slots   = (uint8_t *)addr + cq_offset;
+    ring->size       = size;
+    ring->entries    = entries;
+    ring->mask       = mask;
+    ring->entry_size = entry_size;
+    return 0;
+}
+
+int sys_ring_create_chan(struct sys_ring *ring, uint32_t entries, uint32_t entry_size) {
+    if (!ring) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    struct abi_ring_create_args args = {0};
+    args.entries    = entries;
+    args.entry_size = entry_size;
+    if (sys_ring_create(&args) < 0) {
+        return -1;
+    }
+
+    memset(ring, 0, sizeof(*ring));
+    ring->shm      = args.shm;
+    ring->sq_event = args.sq_event;
+    ring->cq_event = args.cq_event;
+
+    if (ring_map(ring) < 0) {
+        int err = errno;
+        sys_handle_close(args.cq_event);
+        sys_handle_close(args.sq_event);
+        sys_handle_close(args.shm);
+        errno = err;
+        return -1;
+    }
+    return 0;
+}
+
+int sys_ring_attach(struct sys_ring *ring, handle_t shm, handle_t sq_event, handle_t cq_event) {
+    if (!ring || shm == HANDLE_INVALID || sq_event == HANDLE_INVALID ||
+        cq_event == HANDLE_INVALID) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    memset(ring, 0, sizeof(*ring));
+    ring->shm      = shm;
+    ring->sq_event = sq_event;
+    ring->cq_event = cq_event;
+    return ring_map(ring);
+}
+
+static int ring_push(struct sys_ring *ring, struct abi_ring_queue *q, uint8_t *slots,
+                     const void *entry, handle_t consumer_bell) {
+    uint32_t tail = q->tail;
+    uint32_t head = ring_load(&q->head);
+    if (tail - head >= ring->entries) {
+        errno = EAGAIN;
+        return -1;
+    }
+
+    memcpy(slots + (tail & ring->mask) * ring->entry_size, entry, ring->entry_size);
+    ring_store(&q->tail, tail + 1);
+    ring_fence();
+
+    /* 发布后再看 head: 若消费者已经追平旧 tail, 说明它可能正要睡眠 */
+    if (ring_load(&q->head) == tail) {
+        sys_event_signal(consumer_bell, RING_DOORBELL);
+    }
+    return 0;
+}
+
+static int ring_pop(struct sys_ring *ring, struct abi_ring_queue *q, const uint8_t *slots,
+                    void *entry, handle_t producer_bell) {
+    uint32_t head = q->head;
+    uint32_t tail = ring_load(&q->tail);
+    if (head == tail) {
+        errno = EAGAIN;
+        return -1;
+    }
+
+    memcpy(entry, slots + (head & ring->mask) * ring->entry_size, ring->entry_size);
+    ring_store(&q->head, head + 1);
+    ring_fence();
+
+    if (ring_load(&q->tail) - head >= ring->entries) {
+        sys_event_signal(producer_bell, RING_DOORBELL);
+    }
+    return 0;
+}
+
+int sys_ring_submit(struct sys_ring *ring, const void *entry) {
+    if (!ring || !ring->hdr || !entry) {
+        errno = EINVAL;
+        return -1;
+    }
+    return ring_push(ring, &ring->hdr->sq, ring->sq_slots, entry, ring->sq_event);
+}
+
+int sys_ring_take(struct sys_ring *ring, void *entry) {
+    if (!ring || !ring->hdr || !entry) {
+        errno = EINVAL;
+        return -1;
+    }
+    return ring_pop(ring, &ring->hdr->sq, ring->sq_slots, entry, ring->cq_event);
+}
+
+int sys_ring_complete(struct sys_ring *ring, const void *entry) {
+    if (!ring || !ring->hdr || !entry) {
+        errno = EINVAL;
+        return -1;
+    }
+    return ring_push(ring, &ring->hdr->cq, ring->cq_slots, entry, ring->cq_event);
+}
+
+int sys_ring_reap(struct sys_ring *ring, void *entry) {
+    if (!ring || !ring->hdr || !entry) {
+        errno = EINVAL;
+        return -1;
+    }
+    return ring_pop(ring, &ring->hdr->cq, ring->cq_slots, entry, ring->sq_event);
+}
+
+uint32_t sys_ring_sq_pending(const struct sys_ring *ring) {
+    if (!ring || !ring->hdr) {
+        return 0;
+    }
+    return ring_load(&ring->hdr->sq.tail) - ring_load(&ring->hdr->sq.head);
+}
+
+uint32_t sys_ring_cq_pending(const struct sys_ring *ring) {
+    if (!ring || !ring->hdr) {
+        return 0;
+    }
+    return ring_load(&ring->hdr->cq.tail) - ring_load(&ring->hdr->cq.head);
+}
+
+int sys_ring_wait_submit(struct sys_ring *ring) {
+    if (!ring || !ring->hdr) {
+        errno = EINVAL;
+        return -1;
+    }
+    /* 上次 pop 推进的 head 先于这次检查对对端可见, 与对端 push 里的屏障配对 */
+    ring_fence();
+    if (sys_ring_sq_pending(ring) == 0) {
+        sys_event_wait(ring->sq_event);
+    }
+    return 0;
+}
+
+int sys_ring_wait_complete(struct sys_ring *ring) {
+    if (!ring || !ring->hdr) {
+        errno = EINVAL;
+        return -1;
+    }
+    /* 上次 pop 推进的 head 先于这次检查对对端可见, 与对端 push 里的屏障配对 */
+    ring_fence();
+    if (sys_ring_cq_pending(ring) == 0) {
+        sys_event_wait(ring->cq_event);
+    }
+    return 0;
+}
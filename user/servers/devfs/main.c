@@ -6,6 +6,7 @@
  *
  * 功能：
  *   - 接收块设备驱动的注册 (通过 BLK IPC 协议)
+ *   - 接收 TTY 与通用设备节点的注册 (IO 直接由注册方处理)
  *   - 解析 MBR 分区表, 暴露分区节点
  *   - 提供基础设备文件 (null, zero)
  *   - 代理块设备读写操作 (通过 BLK IPC 转发到驱动)
@@ -29,7 +30,7 @@
 #include <xnix/sys/server.h>
 #include <xnix/syscall.h>
 
-#define DEVFS_MAX_FILES 32
+#define DEVFS_MAX_FILES 64
 #define DEVFS_NAME_MAX  16
 
 /* MBR 分区表 */
@@ -52,6 +53,7 @@ typedef enum {
     DEV_TYPE_NULL,      /* /dev/null */
     DEV_TYPE_ZERO,      /* /dev/zero */
     DEV_TYPE_TTY,       /* TTY endpoint 设备 */
+    DEV_TYPE_SERVICE,   /* 服务端处理 IO 的通用设备 (minor 作为 session) */
 } dev_type_t;
 
 /* 设备文件条目 */
@@ -62,6 +64,7 @@ struct dev_entry {
     uint32_t sector_size;       /* 扇区大小 (字节) */
     uint64_t base_lba;          /* 分区起始 LBA (整盘=0) */
     uint64_t part_sectors;      /* 分区扇区数 */
+    uint32_t minor;             /* DEV_TYPE_SERVICE: 服务端设备号 */
     bool valid;
 };
 
@@ -241,6 +244,51 @@ static int devfs_handle_register_tty(struct ipc_message *msg) {
     return 0;
 }
 
+/* ============== 通用设备注册 ============== */
+
+static int devfs_handle_register_dev(struct ipc_message *msg) {
+    handle_t dev_ep = HANDLE_INVALID;
+    if (msg->handles.count >= 1) {
+        dev_ep = msg->handles.handles[0];
+    }
+    if (dev_ep == HANDLE_INVALID) {
+        return -22; /* EINVAL */
+    }
+
+    uint32_t name_len = msg->buffer.size;
+    if (!msg->buffer.data || name_len == 0 || name_len >= DEVFS_NAME_MAX) {
+        sys_handle_close(dev_ep);
+        return -22;
+    }
+
+    char dev_name[DEVFS_NAME_MAX] = {0};
+    memcpy(dev_name, (const char *)(uintptr_t)msg->buffer.data, name_len);
+    dev_name[name_len] = '\0';
+
+    if (devfs_find(dev_name)) {
+        sys_handle_close(dev_ep);
+        return -17; /* EEXIST */
+    }
+
+    int slot = devfs_alloc_slot();
+    if (slot < 0) {
+        sys_handle_close(dev_ep);
+        return -28; /* ENOSPC */
+    }
+
+    struct dev_entry *ent = &g_devfs.entries[slot];
+    strncpy(ent->name, dev_name, DEVFS_NAME_MAX - 1);
+    ent->name[DEVFS_NAME_MAX - 1] = '\0';
+    ent->type = DEV_TYPE_SERVICE;
+    ent->blk_ep = dev_ep; /* 复用: 存储服务 endpoint */
+    ent->minor = msg->regs.data[1];
+    ent->valid = true;
+    g_devfs.count++;
+
+    printf("[devfs] registered: /dev/%s (minor %u)\n", dev_name, ent->minor);
+    return 0;
+}
+
 /* ============== VFS 操作实现 ============== */
 
 static int devfs_open(void *ctx, const char *path, uint32_t flags, handle_t *out_ep) {
@@ -258,6 +306,11 @@ static int devfs_open(void *ctx, const char *path, uint32_t flags, handle_t *out
         *out_ep = ent->blk_ep;
     }
 
+    /* 通用设备: 返回值作为 session, 服务端据此区分节点 */
+    if (ent->type == DEV_TYPE_SERVICE) {
+        return (int)ent->minor;
+    }
+
     return 0;
 }
 
@@ -316,6 +369,28 @@ static int devfs_readdir(void *ctx, uint32_t handle, uint32_t index,
     return -1;
 }
 
+static int devfs_getdents(void *ctx, uint32_t handle, uint32_t index,
+                          struct vfs_dirent *entries, uint32_t max) {
+    (void)ctx;
+    (void)handle;
+
+    uint32_t count = 0;
+    uint32_t n     = 0;
+    for (int i = 0; i < DEVFS_MAX_FILES && n < max; i++) {
+        if (!g_devfs.entries[i].valid) {
+            continue;
+        }
+        if (count++ < index) {
+            continue;
+        }
+        memset(&entries[n], 0, sizeof(entries[n]));
+        strncpy(entries[n].name, g_devfs.entries[i].name, sizeof(entries[n].name) - 1);
+        entries[n].type = VFS_TYPE_FILE;
+        n++;
+    }
+    return (int)n;
+}
+
 static int devfs_mkdir(void *ctx, const char *path) {
     (void)ctx; (void)path;
     return -1;
@@ -334,14 +409,15 @@ static int devfs_rename(void *ctx, const char *old_path,
 
 /* VFS 操作表(命名空间 + 目录 close,文件 IO 通过 blk_ep 处理) */
 static struct vfs_operations devfs_ops = {
-    .open    = devfs_open,
-    .close   = devfs_close,
-    .info    = devfs_info,
-    .opendir = devfs_opendir,
-    .readdir = devfs_readdir,
-    .mkdir   = devfs_mkdir,
-    .del     = devfs_del,
-    .rename  = devfs_rename,
+    .open     = devfs_open,
+    .close    = devfs_close,
+    .info     = devfs_info,
+    .opendir  = devfs_opendir,
+    .readdir  = devfs_readdir,
+    .getdents = devfs_getdents,
+    .mkdir    = devfs_mkdir,
+    .del      = devfs_del,
+    .rename   = devfs_rename,
 };
 
 /* ============== 消息处理 ============== */
@@ -352,6 +428,9 @@ static int devfsd_handler(struct ipc_message *msg) {
 
     if (op == UDM_DEVFS_REGISTER_BLOCK) {
         int result = devfs_handle_register_block(msg);
+        if (result == 0) {
+            vfs_notify_change();
+        }
         msg->regs.data[0] = op;
         msg->regs.data[1] = (uint32_t)result;
         msg->buffer.data = 0;
@@ -362,6 +441,22 @@ static int devfsd_handler(struct ipc_message *msg) {
 
     if (op == UDM_DEVFS_REGISTER_TTY) {
         int result = devfs_handle_register_tty(msg);
+        if (result == 0) {
+            vfs_notify_change();
+        }
+        msg->regs.data[0] = op;
+        msg->regs.data[1] = (uint32_t)result;
+        msg->buffer.data = 0;
+        msg->buffer.size = 0;
+        msg->handles.count = 0;
+        return 0;
+    }
+
+    if (op == UDM_DEVFS_REGISTER_DEV) {
+        int result = devfs_handle_register_dev(msg);
+        if (result == 0) {
+            vfs_notify_change();
+        }
         msg->regs.data[0] = op;
         msg->regs.data[1] = (uint32_t)result;
         msg->buffer.data = 0;
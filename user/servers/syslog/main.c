@@ -114,7 +114,11 @@ static int syslogd_handler(struct ipc_message *msg) {
         uint32_t size = msg->regs.data[3];
         const char *data = (const char *)(uintptr_t)msg->buffer.data;
 
-        if (!data || size == 0 || msg->buffer.size < size) {
+        /* 超出接收缓冲区的部分已被截断, 只记录收到的部分 */
+        if (size > msg->buffer.size) {
+            size = msg->buffer.size;
+        }
+        if (!data || size == 0) {
             msg->regs.data[0] = (uint32_t)-22; /* -EINVAL */
             msg->buffer.data = 0;
             msg->buffer.size = 0;
@@ -153,6 +157,11 @@ static int syslogd_handler(struct ipc_message *msg) {
     }
 
     default:
+        /* 不支持的请求(如 IO_SPLICE_*)可能带有 handle, 释放掉避免泄漏 */
+        for (uint32_t i = 0; i < msg->handles.count; i++) {
+            sys_handle_close(msg->handles.handles[i]);
+        }
+        msg->handles.count = 0;
         msg->regs.data[0] = (uint32_t)-38; /* -ENOSYS */
         msg->buffer.data = 0;
         msg->buffer.size = 0;
@@ -873,9 +873,13 @@ static int term_handle_msg(struct terminal *t, struct ipc_message *msg,
     }
 
     case IO_WRITE: {
+        /* 只输出实际收到的部分, 回复输出的字节数 */
         uint32_t size = msg->regs.data[3];
         char    *data = (char *)(uintptr_t)msg->buffer.data;
-        if (data && size > 0) {
+        if (!data || size > msg->buffer.size) {
+            size = data ? msg->buffer.size : 0;
+        }
+        if (size > 0) {
             term_output_write(t, data, size);
         }
         msg->regs.data[0] = (uint32_t)size;
@@ -1002,6 +1006,16 @@ static int term_handle_msg(struct terminal *t, struct ipc_message *msg,
         return 0;
     }
 
+    case IO_SPLICE_OUT:
+    case IO_SPLICE_IN:
+        /* 终端不做零拷贝搬运, 释放随请求传来的管道 handle, 让客户端退回 read/write */
+        for (uint32_t i = 0; i < msg->handles.count; i++) {
+            sys_handle_close(msg->handles.handles[i]);
+        }
+        msg->handles.count = 0;
+        msg->regs.data[0]  = (uint32_t)-38; /* -ENOSYS */
+        return 0;
+
     default:
         msg->regs.data[0] = (uint32_t)-1;
         return 0;
@@ -13,6 +13,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <vfs_client.h>
 
 static struct passwd_entry g_users[PASSWD_MAX_USERS];
 static int                 g_user_count;
@@ -75,21 +76,13 @@ static int parse_line(const char *line, struct passwd_entry *ent) {
 }
 
 int passwd_load(const char *path) {
-    int fd = open(path, O_RDONLY);
-    if (fd < 0) {
-        printf("[userd] cannot open %s\n", path);
-        return -1;
-    }
-
     /* 读取整个文件 (passwd 文件很小) */
     char file_buf[2048];
-    int  total = 0;
-    int  n;
-    while (total < (int)sizeof(file_buf) - 1 &&
-           (n = read(fd, file_buf + total, sizeof(file_buf) - 1 - total)) > 0) {
-        total += n;
+    int  total = vfs_read_file(path, file_buf, sizeof(file_buf) - 1);
+    if (total < 0) {
+        printf("[userd] cannot open %s\n", path);
+        return -1;
     }
-    close(fd);
     file_buf[total] = '\0';
 
     /* 逐行解析 */
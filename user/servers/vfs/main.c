@@ -7,8 +7,10 @@
 #include <xnix/abi/io.h>
 #include <xnix/abi/ipc.h>
 #include <xnix/ipc.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <string.h>
+#include <vfs/vfs.h>
 #include <xnix/abi/handle.h>
 #include <xnix/abi/ipc.h>
 #include <xnix/env.h>
@@ -23,21 +25,88 @@ struct vfs_dir_state {
     uint32_t backend_handle;
     char     base_path[VFS_PATH_MAX];
     int      active;
+
+    /* 打开时的挂载子目录快照: 排在后端目录项之前, 同名的后端目录项被遮盖 */
+    uint32_t nchildren;
+    char     children[VFS_MAX_MOUNTS][VFS_NAME_MAX];
 };
 
 static struct vfs_dir_state dir_table[VFS_MAX_MOUNTS];
 
+/*
+ * 并发模型: 主线程收请求, 不碰后端的请求 (CWD, 命中缓存的 INFO 等) 当场处理;
+ * 要转发给后端的请求按目标挂载点排队, 由工作线程处理后用 sys_ipc_reply_to 延迟回复.
+ * 每个挂载点同时在途的请求数有上限, 慢的后端最多占住这么多工作线程,
+ * 其余挂载点的请求不会排在它后面.
+ *
+ * 全局状态由 g_vfs_lock 保护, 只在等待后端回复时放开 (vfsd_backend_call).
+ */
+#define VFSD_WORKERS        4
+#define VFSD_MOUNT_INFLIGHT 2
+#define VFSD_JOB_MAX        16
+#define VFSD_JOB_BUF        4096
+#define VFSD_WORKER_STACK   (16u * 1024u)
+
+struct vfsd_job {
+    struct ipc_message  msg; /* 请求, 处理时原地改写为回复 */
+    handle_t            from;
+    int                 mount;
+    struct vfs_dirent   dirent;               /* READDIR 回复缓冲区 */
+    struct vfs_stat_rec stats[VFS_STATV_MAX]; /* STATV 回复缓冲区 */
+    char                buf[VFSD_JOB_BUF];    /* 请求缓冲区, 也用作 READFILE/GETDENTS 回复和 COPY 中转 */
+    struct vfsd_job    *next;
+};
+
 struct vfs_mount {
     char     path[VFS_PATH_MAX];
     uint32_t path_len;
     uint32_t fs_ep;
     int      active;
+    int      watched; /* 后端已登记变化通知, 可以缓存 stat 结果 */
+
+    struct vfsd_job *queue_head; /* 等待工作线程的请求 */
+    struct vfsd_job *queue_tail;
+    uint32_t         inflight;
 };
 
 static struct vfs_mount  mount_table[VFS_MAX_MOUNTS];
-static struct vfs_dirent g_reply_dirent;
 static handle_t          g_vfs_ep = HANDLE_INVALID;
 static handle_t          g_vfs_dir_ep = HANDLE_INVALID;
+static handle_t          g_vfs_notify_ev = HANDLE_INVALID; /* 后端变化通知, bit i = mount_table[i] */
+
+/*
+ * 路径缓存 (dentry cache): 规范化绝对路径 -> 挂载点, 以及 INFO 的结果
+ *
+ * 挂载点随挂载表变化整体失效. stat 结果只缓存目录和不存在的路径 (负缓存),
+ * 文件大小随写入变化, 仍转发给后端. 后端增删改名后 signal 通知事件,
+ * vfsd 收下一条请求前先丢掉对应挂载点的全部缓存.
+ */
+#define VFSD_DCACHE_SIZE    128
+#define VFSD_DCACHE_BUCKETS 64
+
+struct vfs_dentry {
+    char     path[VFS_PATH_MAX];
+    uint32_t hash;
+    int16_t  next;  /* 哈希链, -1 结束 */
+    uint8_t  mount; /* mount_table 下标 */
+    uint8_t  has_info;
+    int32_t  result; /* 0 或 -ENOENT */
+    uint32_t type;
+    uint32_t size;
+    uint32_t stamp; /* LRU 时间戳 */
+    int      active;
+};
+
+static struct vfs_dentry dcache_table[VFSD_DCACHE_SIZE];
+static int16_t           dcache_bucket[VFSD_DCACHE_BUCKETS];
+static uint32_t          dcache_tick;
+static uint32_t          dcache_gen; /* 每次失效加一, 跨后端调用的结果据此判断能否缓存 */
+
+static pthread_mutex_t g_vfs_lock;
+static struct vfsd_job g_jobs[VFSD_JOB_MAX];
+static struct vfsd_job *g_job_free;
+static handle_t         g_job_ev  = HANDLE_INVALID; /* 有空闲 job */
+static handle_t         g_work_ev = HANDLE_INVALID; /* 有请求入队 */
 
 /* 进程工作目录映射表 */
 #define VFS_MAX_PROCESSES 64
@@ -77,14 +146,28 @@ static void vfsd_dir_free(uint32_t h) {
 }
 
 /**
- * 获取进程的当前工作目录
+ * 查找进程的 CWD 条目
+ * 以 pid 为起点线性探测, 条目从不释放, 遇到空位即可停止.
+ * 返回已有条目, 没有则返回可插入的空位, 表满返回 NULL.
  */
-static const char *vfsd_get_cwd(uint32_t pid) {
+static struct vfs_cwd_entry *vfsd_cwd_slot(uint32_t pid) {
     for (int i = 0; i < VFS_MAX_PROCESSES; i++) {
-        if (cwd_table[i].active && cwd_table[i].pid == pid) {
-            return cwd_table[i].cwd;
+        struct vfs_cwd_entry *e = &cwd_table[(pid + i) % VFS_MAX_PROCESSES];
+        if (!e->active || e->pid == pid) {
+            return e;
         }
     }
+    return NULL;
+}
+
+/**
+ * 获取进程的当前工作目录
+ */
+static const char *vfsd_get_cwd(uint32_t pid) {
+    struct vfs_cwd_entry *e = vfsd_cwd_slot(pid);
+    if (e && e->active) {
+        return e->cwd;
+    }
     return "/"; /* 默认返回根目录 */
 }
 
@@ -96,27 +179,16 @@ static int vfsd_set_cwd(uint32_t pid, const char *path) {
         return -22; /* EINVAL */
     }
 
-    /* 查找已有条目 */
-    for (int i = 0; i < VFS_MAX_PROCESSES; i++) {
-        if (cwd_table[i].active && cwd_table[i].pid == pid) {
-            strncpy(cwd_table[i].cwd, path, VFS_PATH_MAX - 1);
-            cwd_table[i].cwd[VFS_PATH_MAX - 1] = '\0';
-            return 0;
-        }
-    }
-
-    /* 分配新条目 */
-    for (int i = 0; i < VFS_MAX_PROCESSES; i++) {
-        if (!cwd_table[i].active) {
-            cwd_table[i].active = 1;
-            cwd_table[i].pid    = pid;
-            strncpy(cwd_table[i].cwd, path, VFS_PATH_MAX - 1);
-            cwd_table[i].cwd[VFS_PATH_MAX - 1] = '\0';
-            return 0;
-        }
+    struct vfs_cwd_entry *e = vfsd_cwd_slot(pid);
+    if (!e) {
+        return -12; /* ENOMEM */
     }
 
-    return -12; /* ENOMEM */
+    e->active = 1;
+    e->pid    = pid;
+    strncpy(e->cwd, path, VFS_PATH_MAX - 1);
+    e->cwd[VFS_PATH_MAX - 1] = '\0';
+    return 0;
 }
 
 /**
@@ -268,26 +340,129 @@ static int vfsd_needs_dir_proxy(const char *base) {
     return vfsd_mount_child_count(base) > 0;
 }
 
-static int vfsd_mount_child_at(const char *base, uint32_t index, char *name_out) {
-    char names[VFS_MAX_MOUNTS][VFS_NAME_MAX] = {{0}};
-    uint32_t count = vfsd_collect_mount_children(base, names);
-    if (index >= count) {
-        return -2;
+/* 名字是否被打开时快照的挂载子目录遮盖 */
+static int vfsd_dir_shadowed(const struct vfs_dir_state *st, const char *name) {
+    for (uint32_t i = 0; i < st->nchildren; i++) {
+        if (strcmp(st->children[i], name) == 0) {
+            return 1;
+        }
     }
-    strncpy(name_out, names[index], VFS_NAME_MAX - 1);
-    name_out[VFS_NAME_MAX - 1] = '\0';
     return 0;
 }
 
-static int vfsd_is_mount_shadowed(const char *base, const char *name) {
-    char names[VFS_MAX_MOUNTS][VFS_NAME_MAX] = {{0}};
-    uint32_t count = vfsd_collect_mount_children(base, names);
-    for (uint32_t i = 0; i < count; i++) {
-        if (strcmp(names[i], name) == 0) {
-            return 1;
+/**
+ * 调用后端, 等待回复期间放开全局锁
+ * 返回后之前取得的表项指针可能已失效, 需要重新查找.
+ */
+static int vfsd_backend_call(uint32_t ep, struct ipc_message *req, struct ipc_message *reply,
+                             uint32_t timeout_ms) {
+    pthread_mutex_unlock(&g_vfs_lock);
+    int ret = sys_ipc_call(ep, req, reply, timeout_ms);
+    pthread_mutex_lock(&g_vfs_lock);
+    return ret;
+}
+
+/* ============== 路径缓存 ============== */
+
+static uint32_t vfsd_dcache_hash(const char *path) {
+    uint32_t h = 2166136261u; /* FNV-1a */
+    while (*path) {
+        h ^= (uint8_t)*path++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static struct vfs_dentry *vfsd_dcache_find(const char *path, uint32_t hash) {
+    for (int i = dcache_bucket[hash % VFSD_DCACHE_BUCKETS]; i >= 0; i = dcache_table[i].next) {
+        struct vfs_dentry *d = &dcache_table[i];
+        if (d->hash == hash && strcmp(d->path, path) == 0) {
+            d->stamp = ++dcache_tick;
+            return d;
         }
     }
-    return 0;
+    return NULL;
+}
+
+static void vfsd_dcache_remove(int idx) {
+    struct vfs_dentry *d  = &dcache_table[idx];
+    int16_t           *pp = &dcache_bucket[d->hash % VFSD_DCACHE_BUCKETS];
+
+    while (*pp >= 0 && *pp != idx) {
+        pp = &dcache_table[*pp].next;
+    }
+    if (*pp == idx) {
+        *pp = d->next;
+    }
+    d->active = 0;
+}
+
+/* 新建条目, 表满时淘汰最久未用的 */
+static struct vfs_dentry *vfsd_dcache_insert(const char *path, uint32_t hash, int mount) {
+    int victim = 0;
+    for (int i = 0; i < VFSD_DCACHE_SIZE; i++) {
+        if (!dcache_table[i].active) {
+            victim = i;
+            break;
+        }
+        if (dcache_table[i].stamp < dcache_table[victim].stamp) {
+            victim = i;
+        }
+    }
+    if (dcache_table[victim].active) {
+        vfsd_dcache_remove(victim);
+    }
+
+    struct vfs_dentry *d = &dcache_table[victim];
+    memset(d, 0, sizeof(*d));
+    strcpy(d->path, path);
+    d->hash   = hash;
+    d->mount  = (uint8_t)mount;
+    d->stamp  = ++dcache_tick;
+    d->active = 1;
+
+    uint32_t b         = hash % VFSD_DCACHE_BUCKETS;
+    d->next            = dcache_bucket[b];
+    dcache_bucket[b]   = (int16_t)victim;
+    return d;
+}
+
+/**
+ * 丢弃属于 mounts 中挂载点 (bit i = mount_table[i]) 的缓存条目
+ */
+static void vfsd_dcache_flush(uint32_t mounts) {
+    dcache_gen++;
+    for (int i = 0; i < VFSD_DCACHE_SIZE; i++) {
+        if (dcache_table[i].active && (mounts & (1u << dcache_table[i].mount))) {
+            vfsd_dcache_remove(i);
+        }
+    }
+}
+
+/**
+ * 把通知事件交给挂载点的后端, 后端命名空间变化时 signal 对应位
+ * 后端不支持 (旧协议或超时) 时该挂载点不缓存 stat 结果.
+ */
+static void vfsd_mount_watch(int idx) {
+    struct vfs_mount *m = &mount_table[idx];
+
+    m->watched = 0;
+    if (g_vfs_notify_ev == HANDLE_INVALID) {
+        return;
+    }
+
+    struct ipc_message req   = {0};
+    struct ipc_message reply = {0};
+
+    req.regs.data[0]       = UDM_VFS_WATCH;
+    req.regs.data[1]       = 1u << idx;
+    req.handles.handles[0] = g_vfs_notify_ev;
+    req.handles.count      = 1;
+
+    int ret = vfsd_backend_call(m->fs_ep, &req, &reply, 1000);
+    if (ret == 0 && (int32_t)reply.regs.data[0] == 0) {
+        m->watched = 1;
+    }
 }
 
 /**
@@ -303,10 +478,14 @@ static int vfsd_mount(const char *path, uint32_t fs_ep) {
         return -22;
     }
 
+    /* 挂载表变化, 已缓存的挂载点解析全部作废 */
+    vfsd_dcache_flush(0xFFFFFFFFu);
+
     /* remount: 如果路径已挂载, 替换 fs_ep */
     for (int i = 0; i < VFS_MAX_MOUNTS; i++) {
         if (mount_table[i].active && strcmp(mount_table[i].path, path) == 0) {
             mount_table[i].fs_ep = fs_ep;
+            vfsd_mount_watch(i);
             return 0;
         }
     }
@@ -318,6 +497,7 @@ static int vfsd_mount(const char *path, uint32_t fs_ep) {
             mount_table[i].path_len = len;
             mount_table[i].fs_ep    = fs_ep;
             mount_table[i].active   = 1;
+            vfsd_mount_watch(i);
             return 0;
         }
     }
@@ -327,15 +507,11 @@ static int vfsd_mount(const char *path, uint32_t fs_ep) {
 
 /**
  * 查找挂载点 (最长前缀匹配)
- * 返回 fs_ep,并将相对路径写入 rel_path_out
+ * 返回 mount_table 下标
  */
-static int vfsd_lookup(const char *path, char *rel_path_out, size_t max_len) {
-    if (!path || path[0] != '/') {
-        return -22;
-    }
-
-    struct vfs_mount *best_match = NULL;
-    uint32_t          best_len   = 0;
+static int vfsd_mount_match(const char *path) {
+    int      best     = -2; /* ENOENT */
+    uint32_t best_len = 0;
 
     for (int i = 0; i < VFS_MAX_MOUNTS; i++) {
         if (!mount_table[i].active) {
@@ -354,44 +530,147 @@ static int vfsd_lookup(const char *path, char *rel_path_out, size_t max_len) {
 
             int is_root = (mlen == 1 && mount_table[i].path[0] == '/');
             if (match && (is_root || path[mlen] == '/' || path[mlen] == '\0')) {
-                best_match = &mount_table[i];
-                best_len   = mlen;
+                best     = i;
+                best_len = mlen;
             }
         }
     }
 
-    if (!best_match) {
-        return -2; /* ENOENT */
+    return best;
+}
+
+/**
+ * 取路径的缓存条目, 没有则解析挂载点后新建
+ * 没有匹配的挂载点时返回 NULL
+ */
+static struct vfs_dentry *vfsd_dentry_get(const char *path) {
+    uint32_t           hash = vfsd_dcache_hash(path);
+    struct vfs_dentry *d    = vfsd_dcache_find(path, hash);
+    if (d) {
+        return d;
+    }
+
+    int mount = vfsd_mount_match(path);
+    if (mount < 0) {
+        return NULL;
+    }
+    return vfsd_dcache_insert(path, hash, mount);
+}
+
+/**
+ * 计算路径在挂载点内的相对路径 (以 / 开头)
+ */
+static int vfsd_rel_path(const char *path, const struct vfs_mount *m, char *rel_path_out,
+                         size_t max_len) {
+    const char *rel = path + m->path_len;
+
+    if (*rel == '\0') {
+        /* 刚好是挂载点 -> / */
+        if (max_len < 2) {
+            return -36;
+        }
+        strcpy(rel_path_out, "/");
+    } else if (*rel == '/') {
+        /* 已经是 / 开头 -> 直接拷贝 */
+        size_t rel_len = strlen(rel);
+        if (rel_len >= max_len) {
+            return -36;
+        }
+        strcpy(rel_path_out, rel);
+    } else {
+        /* 挂载点为 / 且有后续路径的情况,需要补 / */
+        int needed = snprintf(rel_path_out, max_len, "/%s", rel);
+        if (needed < 0 || (size_t)needed >= max_len) {
+            return -36;
+        }
+    }
+    return 0;
+}
+
+/**
+ * 查找挂载点
+ * 返回 fs_ep,并将相对路径写入 rel_path_out
+ */
+static int vfsd_lookup(const char *path, char *rel_path_out, size_t max_len) {
+    if (!path || path[0] != '/' || strlen(path) >= VFS_PATH_MAX) {
+        return -22;
     }
 
-    /* 计算相对路径 */
-    const char *rel = path + best_len;
+    struct vfs_dentry *d = vfsd_dentry_get(path);
+    if (!d) {
+        return -2; /* ENOENT */
+    }
 
-    /* 构造以 / 开头的路径 */
+    struct vfs_mount *m = &mount_table[d->mount];
     if (rel_path_out) {
-        if (*rel == '\0') {
-            /* 刚好是挂载点 -> / */
-            if (max_len < 2) {
-                return -36;
-            }
-            strcpy(rel_path_out, "/");
-        } else if (*rel == '/') {
-            /* 已经是 / 开头 -> 直接拷贝 */
-            size_t rel_len = strlen(rel);
-            if (rel_len >= max_len) {
-                return -36;
-            }
-            strcpy(rel_path_out, rel);
-        } else {
-            /* 挂载点为 / 且有后续路径的情况,需要补 / */
-            int needed = snprintf(rel_path_out, max_len, "/%s", rel);
-            if (needed < 0 || (size_t)needed >= max_len) {
-                return -36;
-            }
+        int ret = vfsd_rel_path(path, m, rel_path_out, max_len);
+        if (ret < 0) {
+            return ret;
         }
     }
 
-    return (int)best_match->fs_ep;
+    return (int)m->fs_ep;
+}
+
+/**
+ * 获取路径信息, 优先使用缓存
+ * @return 0 成功，负数错误码
+ */
+static int vfsd_stat(const char *path, struct vfs_info *info) {
+    if (path[0] != '/') {
+        return -22;
+    }
+
+    struct vfs_dentry *d = vfsd_dentry_get(path);
+    if (!d) {
+        return -2; /* ENOENT */
+    }
+    if (d->has_info) {
+        info->type = d->type;
+        info->size = d->size;
+        return d->result;
+    }
+
+    int               mount = d->mount;
+    struct vfs_mount *m     = &mount_table[mount];
+    char              rel_path[VFS_PATH_MAX];
+    int               ret = vfsd_rel_path(path, m, rel_path, sizeof(rel_path));
+    if (ret < 0) {
+        return ret;
+    }
+
+    struct ipc_message req   = {0};
+    struct ipc_message reply = {0};
+
+    req.regs.data[0] = UDM_VFS_INFO;
+    req.buffer.data  = (uint64_t)(uintptr_t)rel_path;
+    req.buffer.size  = strlen(rel_path);
+
+    uint32_t gen = dcache_gen;
+    ret          = vfsd_backend_call(m->fs_ep, &req, &reply, 5000);
+    if (ret < 0) {
+        return ret;
+    }
+
+    int32_t result = (int32_t)reply.regs.data[0];
+    if (result == 0) {
+        info->size = reply.regs.data[2];
+        info->type = reply.regs.data[3];
+    }
+
+    /* 等待期间有过失效, 结果可能已过时, 不缓存 */
+    if (gen != dcache_gen || !m->watched) {
+        return result;
+    }
+    d = vfsd_dcache_find(path, vfsd_dcache_hash(path));
+    if (d && d->mount == mount &&
+        (result == -2 || (result == 0 && info->type == VFS_TYPE_DIR))) {
+        d->has_info = 1;
+        d->result   = result;
+        d->type     = result == 0 ? info->type : 0;
+        d->size     = result == 0 ? info->size : 0;
+    }
+    return result;
 }
 
 /**
@@ -427,7 +706,7 @@ static int vfsd_forward(struct ipc_message *msg, uint32_t pid, const char *path)
 
     /* 转发给 FS 驱动 */
     struct ipc_message reply = {0};
-    int                ret   = sys_ipc_call(fs_ep, msg, &reply, 5000);
+    int                ret   = vfsd_backend_call((uint32_t)fs_ep, msg, &reply, 5000);
     if (ret < 0) {
         return ret;
     }
@@ -451,6 +730,320 @@ static int vfsd_forward(struct ipc_message *msg, uint32_t pid, const char *path)
     return 0;
 }
 
+/**
+ * 读小文件: 后端把数据直接回复进 job->buf, 再由 vfsd 转给客户端
+ */
+static int vfsd_readfile(struct vfsd_job *job) {
+    struct ipc_message *msg = &job->msg;
+    char                path[VFS_PATH_MAX];
+    char                abs_path[VFS_PATH_MAX];
+    char                rel_path[VFS_PATH_MAX];
+
+    if (!msg->buffer.data || msg->buffer.size == 0 || msg->buffer.size >= VFS_PATH_MAX) {
+        return -22;
+    }
+    memcpy(path, (void *)(uintptr_t)msg->buffer.data, msg->buffer.size);
+    path[msg->buffer.size] = '\0';
+    vfsd_resolve_path(UDM_MSG_ARG(msg, 0), path, abs_path, sizeof(abs_path));
+
+    int fs_ep = vfsd_lookup(abs_path, rel_path, sizeof(rel_path));
+    if (fs_ep < 0) {
+        return fs_ep;
+    }
+
+    uint32_t max = UDM_MSG_ARG(msg, 1);
+    if (max > sizeof(job->buf)) {
+        max = sizeof(job->buf);
+    }
+
+    struct ipc_message req   = {0};
+    struct ipc_message reply = {0};
+
+    req.regs.data[0]  = UDM_VFS_READFILE;
+    req.regs.data[1]  = max;
+    req.buffer.data   = (uint64_t)(uintptr_t)rel_path;
+    req.buffer.size   = strlen(rel_path);
+    reply.buffer.data = (uint64_t)(uintptr_t)job->buf;
+    reply.buffer.size = max;
+
+    int ret = vfsd_backend_call((uint32_t)fs_ep, &req, &reply, 5000);
+    if (ret < 0) {
+        return ret;
+    }
+
+    int32_t result = (int32_t)reply.regs.data[0];
+    memcpy(msg->regs.data, reply.regs.data, sizeof(msg->regs.data));
+    msg->buffer.data   = (uint64_t)(uintptr_t)job->buf;
+    msg->buffer.size   = result > 0 && (uint32_t)result <= max ? (uint32_t)result : 0;
+    msg->handles.count = 0;
+    return 0;
+}
+
+/* 跨后端复制的共享窗口大小, 与客户端 fd 窗口一致 */
+#define VFSD_COPY_WIN (64u * 1024u)
+
+/* 在后端打开文件, 输出之后收发 IO 用的 endpoint (不等于 fs_ep 时由调用者关闭) 和会话 */
+static int vfsd_copy_open(uint32_t fs_ep, const char *rel_path, uint32_t flags, uint32_t *ep,
+                          uint32_t *session) {
+    struct ipc_message req   = {0};
+    struct ipc_message reply = {0};
+
+    req.regs.data[0] = UDM_VFS_OPEN;
+    req.regs.data[1] = flags;
+    req.buffer.data  = (uint64_t)(uintptr_t)rel_path;
+    req.buffer.size  = strlen(rel_path);
+
+    int ret = vfsd_backend_call(fs_ep, &req, &reply, 5000);
+    if (ret < 0) {
+        return ret;
+    }
+
+    int32_t result = (int32_t)reply.regs.data[0];
+    if (result < 0) {
+        return result;
+    }
+    *ep      = reply.handles.count > 0 ? reply.handles.handles[0] : fs_ep;
+    *session = (uint32_t)result;
+    return 0;
+}
+
+static void vfsd_copy_close(uint32_t fs_ep, uint32_t ep, uint32_t session) {
+    struct ipc_message req   = {0};
+    struct ipc_message reply = {0};
+
+    req.regs.data[0] = IO_CLOSE;
+    req.regs.data[1] = session;
+    vfsd_backend_call(ep, &req, &reply, 1000);
+
+    if (ep != fs_ep) {
+        sys_handle_close(ep);
+    }
+}
+
+/* 发一次文件 IO, buf 为 IO_READ 的接收区或 IO_WRITE 的数据, 窗口读写不带数据 */
+static int vfsd_copy_io(uint32_t ep, uint32_t op, uint32_t session, uint32_t offset,
+                        uint32_t size, void *buf) {
+    struct ipc_message req   = {0};
+    struct ipc_message reply = {0};
+
+    req.regs.data[0] = op;
+    req.regs.data[1] = session;
+    req.regs.data[2] = offset;
+    req.regs.data[3] = size;
+    if (op == IO_WRITE) {
+        req.buffer.data = (uint64_t)(uintptr_t)buf;
+        req.buffer.size = size;
+    } else if (op == IO_READ) {
+        reply.buffer.data = (uint64_t)(uintptr_t)buf;
+        reply.buffer.size = size;
+    }
+
+    int ret = vfsd_backend_call(ep, &req, &reply, 30000);
+    if (ret < 0) {
+        return ret;
+    }
+    return (int32_t)reply.regs.data[0];
+}
+
+/*
+ * 两端都支持共享内存窗口时, 把同一块 SHM 绑定到两个会话:
+ * 源后端读进窗口, 目标后端从窗口写出, 数据不经过 vfsd.
+ * 先用零长度窗口读写探测 (-ENOENT 表示支持但未绑定), 不把 handle 交给不认识它的后端.
+ * @return SHM handle (调用者关闭), 不能用窗口时返回 HANDLE_INVALID
+ */
+static handle_t vfsd_copy_win(uint32_t src_ep, uint32_t src_s, uint32_t dst_ep, uint32_t dst_s) {
+    if (vfsd_copy_io(src_ep, IO_WIN_READ, src_s, 0, 0, NULL) != -2 ||
+        vfsd_copy_io(dst_ep, IO_WIN_WRITE, dst_s, 0, 0, NULL) != -2) {
+        return HANDLE_INVALID;
+    }
+
+    handle_t shm = sys_shm_create(VFSD_COPY_WIN);
+    if (shm == (handle_t)-1) {
+        return HANDLE_INVALID;
+    }
+
+    uint32_t eps[2]      = {src_ep, dst_ep};
+    uint32_t sessions[2] = {src_s, dst_s};
+    for (int i = 0; i < 2; i++) {
+        struct ipc_message req   = {0};
+        struct ipc_message reply = {0};
+
+        req.regs.data[0]       = IO_WIN_ATTACH;
+        req.regs.data[1]       = sessions[i];
+        req.regs.data[2]       = VFSD_COPY_WIN;
+        req.handles.handles[0] = shm;
+        req.handles.count      = 1;
+
+        if (vfsd_backend_call(eps[i], &req, &reply, 5000) < 0 || reply.regs.data[0] != 0) {
+            sys_handle_close(shm);
+            return HANDLE_INVALID;
+        }
+    }
+    return shm;
+}
+
+/*
+ * 在两个后端之间搬运文件 (不同后端, 或后端不支持 COPY)
+ * 有共享窗口时每次搬 VFSD_COPY_WIN, 否则经 job->buf 用 IO_READ/IO_WRITE
+ */
+static int vfsd_copy_stream(struct vfsd_job *job, uint32_t src_fs, const char *src_rel,
+                            uint32_t dst_fs, const char *dst_rel) {
+    uint32_t src_ep, src_s, dst_ep, dst_s;
+
+    int ret = vfsd_copy_open(src_fs, src_rel, VFS_O_RDONLY, &src_ep, &src_s);
+    if (ret < 0) {
+        return ret;
+    }
+    ret = vfsd_copy_open(dst_fs, dst_rel, VFS_O_WRONLY | VFS_O_CREAT | VFS_O_TRUNC, &dst_ep,
+                         &dst_s);
+    if (ret < 0) {
+        vfsd_copy_close(src_fs, src_ep, src_s);
+        return ret;
+    }
+
+    handle_t shm   = vfsd_copy_win(src_ep, src_s, dst_ep, dst_s);
+    int      win   = shm != HANDLE_INVALID;
+    uint32_t chunk = win ? VFSD_COPY_WIN : sizeof(job->buf);
+    uint32_t off   = 0;
+
+    while (1) {
+        int n = vfsd_copy_io(src_ep, win ? IO_WIN_READ : IO_READ, src_s, off, chunk, job->buf);
+        if (n <= 0) {
+            ret = n;
+            break;
+        }
+        int w = vfsd_copy_io(dst_ep, win ? IO_WIN_WRITE : IO_WRITE, dst_s, off, (uint32_t)n,
+                             job->buf);
+        if (w != n) {
+            ret = w < 0 ? w : -28; /* ENOSPC */
+            break;
+        }
+        off += (uint32_t)n;
+    }
+
+    vfsd_copy_close(dst_fs, dst_ep, dst_s);
+    vfsd_copy_close(src_fs, src_ep, src_s);
+    if (win) {
+        sys_handle_close(shm);
+    }
+    return ret < 0 ? ret : (int)off;
+}
+
+/**
+ * 复制文件: 同一后端时整个交给后端, 否则 (或后端不支持) 由 vfsd 在两个后端间搬运
+ */
+static int vfsd_copy(struct vfsd_job *job) {
+    struct ipc_message *msg     = &job->msg;
+    uint32_t            pid     = UDM_MSG_ARG(msg, 0);
+    uint32_t            src_len = UDM_MSG_ARG(msg, 1);
+    const char         *buf     = (const char *)(uintptr_t)msg->buffer.data;
+    uint32_t            size    = msg->buffer.size;
+    char                path[VFS_PATH_MAX];
+    char                src_abs[VFS_PATH_MAX];
+    char                dst_abs[VFS_PATH_MAX];
+    char                src_rel[VFS_PATH_MAX];
+    char                dst_rel[VFS_PATH_MAX];
+
+    if (!buf || src_len == 0 || src_len >= VFS_PATH_MAX || size <= src_len + 1 ||
+        size - src_len - 1 >= VFS_PATH_MAX) {
+        return -22;
+    }
+
+    memcpy(path, buf, src_len);
+    path[src_len] = '\0';
+    vfsd_resolve_path(pid, path, src_abs, sizeof(src_abs));
+    memcpy(path, buf + src_len + 1, size - src_len - 1);
+    path[size - src_len - 1] = '\0';
+    vfsd_resolve_path(pid, path, dst_abs, sizeof(dst_abs));
+
+    if (strcmp(src_abs, dst_abs) == 0) {
+        return -22;
+    }
+    int src_fs = vfsd_lookup(src_abs, src_rel, sizeof(src_rel));
+    if (src_fs < 0) {
+        return src_fs;
+    }
+    int dst_fs = vfsd_lookup(dst_abs, dst_rel, sizeof(dst_rel));
+    if (dst_fs < 0) {
+        return dst_fs;
+    }
+
+    /* 拷贝耗时随文件大小, 不设超时; 请求路径已取出, job->buf 改放相对路径 */
+    int32_t result = -38;
+    if (src_fs == dst_fs) {
+        uint32_t rel_len = strlen(src_rel);
+        uint32_t len     = rel_len + 1 + strlen(dst_rel);
+
+        memcpy(job->buf, src_rel, rel_len + 1);
+        memcpy(job->buf + rel_len + 1, dst_rel, len - rel_len - 1);
+
+        struct ipc_message req   = {0};
+        struct ipc_message reply = {0};
+
+        req.regs.data[0] = UDM_VFS_COPY;
+        req.regs.data[1] = rel_len;
+        req.buffer.data  = (uint64_t)(uintptr_t)job->buf;
+        req.buffer.size  = len;
+
+        int ret = vfsd_backend_call((uint32_t)src_fs, &req, &reply, 0);
+        if (ret < 0) {
+            return ret;
+        }
+        result = (int32_t)reply.regs.data[0];
+    }
+    if (result == -38) {
+        result = vfsd_copy_stream(job, (uint32_t)src_fs, src_rel, (uint32_t)dst_fs, dst_rel);
+    }
+
+    msg->regs.data[0]  = (uint32_t)result;
+    msg->regs.data[1]  = (uint32_t)result;
+    msg->buffer.data   = 0;
+    msg->buffer.size   = 0;
+    msg->handles.count = 0;
+    return 0;
+}
+
+/**
+ * 批量 stat: 逐个路径经路径缓存查询, 结果写入 job->stats
+ */
+static int vfsd_statv(struct vfsd_job *job) {
+    struct ipc_message *msg   = &job->msg;
+    uint32_t            pid   = UDM_MSG_ARG(msg, 0);
+    uint32_t            count = UDM_MSG_ARG(msg, 1);
+    const char         *buf   = (const char *)(uintptr_t)msg->buffer.data;
+    uint32_t            size  = msg->buffer.size;
+    char                abs_path[VFS_PATH_MAX];
+
+    if (!buf || count == 0 || count > VFS_STATV_MAX || size > sizeof(job->buf)) {
+        return -22;
+    }
+
+    /* 请求里的路径在 job->buf 中, 处理期间不会被覆盖 */
+    uint32_t off = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        struct vfs_stat_rec *rec  = &job->stats[i];
+        struct vfs_info      info = {0};
+        size_t               len  = off < size ? strnlen(buf + off, size - off) : 0;
+
+        if (len == 0 || len >= VFS_PATH_MAX || off + len >= size) {
+            rec->result = -22;
+        } else {
+            vfsd_resolve_path(pid, buf + off, abs_path, sizeof(abs_path));
+            rec->result = vfsd_stat(abs_path, &info);
+        }
+        rec->type = rec->result == 0 ? info.type : 0;
+        rec->size = rec->result == 0 ? info.size : 0;
+        off += (uint32_t)len + 1;
+    }
+
+    msg->regs.data[0]  = count;
+    msg->regs.data[1]  = 0;
+    msg->buffer.data   = (uint64_t)(uintptr_t)job->stats;
+    msg->buffer.size   = count * sizeof(struct vfs_stat_rec);
+    msg->handles.count = 0;
+    return 0;
+}
+
 static int vfsd_opendir(struct ipc_message *msg, const char *abs_path) {
     char rel_path[VFS_PATH_MAX];
     int  backend_ep = vfsd_lookup(abs_path, rel_path, sizeof(rel_path));
@@ -465,7 +1058,7 @@ static int vfsd_opendir(struct ipc_message *msg, const char *abs_path) {
     req.buffer.data  = (uint64_t)(uintptr_t)rel_path;
     req.buffer.size  = (uint32_t)strlen(rel_path);
 
-    int ret = sys_ipc_call((uint32_t)backend_ep, &req, &reply, 5000);
+    int ret = vfsd_backend_call((uint32_t)backend_ep, &req, &reply, 5000);
     if (ret < 0) {
         return ret;
     }
@@ -495,6 +1088,7 @@ static int vfsd_opendir(struct ipc_message *msg, const char *abs_path) {
     st->backend_handle       = (uint32_t)result;
     strncpy(st->base_path, abs_path, sizeof(st->base_path) - 1);
     st->base_path[sizeof(st->base_path) - 1] = '\0';
+    st->nchildren = vfsd_collect_mount_children(abs_path, st->children);
 
     msg->regs.data[0]  = UDM_VFS_OPENDIR;
     msg->regs.data[1]  = (uint32_t)h;
@@ -504,26 +1098,28 @@ static int vfsd_opendir(struct ipc_message *msg, const char *abs_path) {
     return 0;
 }
 
-static int vfsd_readdir(struct ipc_message *msg, uint32_t h, uint32_t index) {
+static int vfsd_readdir(struct ipc_message *msg, uint32_t h, uint32_t index,
+                        struct vfs_dirent *dirent) {
     struct vfs_dir_state *st = vfsd_dir_get(h);
     if (!st) {
         return -22;
     }
 
-    uint32_t mount_count = vfsd_mount_child_count(st->base_path);
+    /* 调用后端期间表项可能被并发关闭, 用副本 */
+    struct vfs_dir_state dir = *st;
+
+    uint32_t mount_count = dir.nchildren;
 
     if (index < mount_count) {
-        memset(&g_reply_dirent, 0, sizeof(g_reply_dirent));
-        if (vfsd_mount_child_at(st->base_path, index, g_reply_dirent.name) < 0) {
-            return -2;
-        }
-        g_reply_dirent.type                   = VFS_TYPE_DIR;
-        g_reply_dirent.size                   = 0;
+        memset(dirent, 0, sizeof(*dirent));
+        strcpy(dirent->name, dir.children[index]);
+        dirent->type = VFS_TYPE_DIR;
+        dirent->size = 0;
 
         msg->regs.data[0] = UDM_VFS_READDIR;
         msg->regs.data[1] = 0;
-        msg->buffer.data  = (uint64_t)(uintptr_t)&g_reply_dirent;
-        msg->buffer.size  = sizeof(g_reply_dirent);
+        msg->buffer.data  = (uint64_t)(uintptr_t)dirent;
+        msg->buffer.size  = sizeof(*dirent);
         return 0;
     }
 
@@ -536,14 +1132,14 @@ static int vfsd_readdir(struct ipc_message *msg, uint32_t h, uint32_t index) {
         struct ipc_message reply = {0};
 
         req.regs.data[0] = IO_IOCTL;
-        req.regs.data[1] = st->backend_handle;
+        req.regs.data[1] = dir.backend_handle;
         req.regs.data[2] = VFS_IOCTL_READDIR;
         req.regs.data[3] = backend_index;
 
-        reply.buffer.data = (uint64_t)(uintptr_t)&g_reply_dirent;
-        reply.buffer.size = sizeof(g_reply_dirent);
+        reply.buffer.data = (uint64_t)(uintptr_t)dirent;
+        reply.buffer.size = sizeof(*dirent);
 
-        int ret = sys_ipc_call(st->backend_ep, &req, &reply, 5000);
+        int ret = vfsd_backend_call(dir.backend_ep, &req, &reply, 5000);
         if (ret < 0) {
             return ret;
         }
@@ -558,7 +1154,7 @@ static int vfsd_readdir(struct ipc_message *msg, uint32_t h, uint32_t index) {
         }
 
         /* 检查是否被挂载点遮盖 */
-        int shadowed = vfsd_is_mount_shadowed(st->base_path, g_reply_dirent.name);
+        int shadowed = vfsd_dir_shadowed(&dir, dirent->name);
 
         if (!shadowed) {
             if (visible_index == target_visible) {
@@ -572,8 +1168,95 @@ static int vfsd_readdir(struct ipc_message *msg, uint32_t h, uint32_t index) {
 
     msg->regs.data[0] = UDM_VFS_READDIR;
     msg->regs.data[1] = 0;
-    msg->buffer.data  = (uint64_t)(uintptr_t)&g_reply_dirent;
-    msg->buffer.size  = sizeof(g_reply_dirent);
+    msg->buffer.data  = (uint64_t)(uintptr_t)dirent;
+    msg->buffer.size  = sizeof(*dirent);
+    return 0;
+}
+
+/**
+ * 批量读取代理目录 (GETDENTS)
+ * cookie 小于快照中挂载子目录数时指向挂载子目录, 否则减去该数后是后端的 cookie.
+ * 后端的记录直接收进回复缓冲区, 原地剔除被遮盖的项.
+ */
+static int vfsd_getdents(struct vfsd_job *job, uint32_t h, uint32_t cookie, uint32_t cap) {
+    struct ipc_message   *msg = &job->msg;
+    struct vfs_dir_state *st  = vfsd_dir_get(h);
+    if (!st) {
+        return -22;
+    }
+
+    struct vfs_dir_state dir = *st;
+    uint8_t             *out = (uint8_t *)job->buf;
+    uint32_t             len = 0;
+    uint32_t             n   = 0;
+
+    if (cap > sizeof(job->buf)) {
+        cap = sizeof(job->buf);
+    }
+    if (cap < VFS_DIRENT_REC_MAX) {
+        return -22;
+    }
+
+    for (; cookie < dir.nchildren; cookie++, n++) {
+        struct vfs_dirent ent = {0};
+        strcpy(ent.name, dir.children[cookie]);
+        ent.type        = VFS_TYPE_DIR;
+        uint32_t newlen = vfs_dirent_pack(out, len, cap, &ent);
+        if (newlen == 0) {
+            break;
+        }
+        len = newlen;
+    }
+
+    /* 一批全被遮盖时继续读, 不能回 0 项让客户端以为到了末尾 */
+    while (n == 0 && cookie >= dir.nchildren && cap - len >= VFS_DIRENT_REC_MAX) {
+        struct ipc_message req   = {0};
+        struct ipc_message reply = {0};
+
+        req.regs.data[0] = IO_IOCTL;
+        req.regs.data[1] = dir.backend_handle;
+        req.regs.data[2] = VFS_IOCTL_GETDENTS;
+        req.regs.data[3] = cookie - dir.nchildren;
+        req.regs.data[4] = cap - len;
+
+        reply.buffer.data = (uint64_t)(uintptr_t)(out + len);
+        reply.buffer.size = cap - len;
+
+        int ret = vfsd_backend_call(dir.backend_ep, &req, &reply, 5000);
+        if (ret < 0) {
+            return ret;
+        }
+
+        int32_t result = (int32_t)reply.regs.data[0];
+        if (result <= 0) {
+            if (result < 0) {
+                return result;
+            }
+            break;
+        }
+        cookie = dir.nchildren + reply.regs.data[1];
+
+        uint32_t end = len + reply.buffer.size;
+        for (uint32_t pos = len; pos < end;) {
+            struct vfs_dirent_rec *rec    = (struct vfs_dirent_rec *)(out + pos);
+            uint32_t               reclen = rec->reclen;
+            if (reclen < sizeof(*rec) || pos + reclen > end) {
+                break;
+            }
+            if (!vfsd_dir_shadowed(&dir, rec->name)) {
+                memmove(out + len, rec, reclen);
+                len += reclen;
+                n++;
+            }
+            pos += reclen;
+        }
+    }
+
+    msg->regs.data[0]  = n;
+    msg->regs.data[1]  = cookie;
+    msg->buffer.data   = (uint64_t)(uintptr_t)out;
+    msg->buffer.size   = len;
+    msg->handles.count = 0;
     return 0;
 }
 
@@ -589,7 +1272,7 @@ static int vfsd_close_handle(struct ipc_message *msg, uint32_t h) {
     req.regs.data[0] = IO_CLOSE;
     req.regs.data[1] = st->backend_handle;
 
-    int ret = sys_ipc_call(st->backend_ep, &req, &reply, 5000);
+    int ret = vfsd_backend_call(st->backend_ep, &req, &reply, 5000);
     if (ret < 0) {
         return ret;
     }
@@ -605,8 +1288,24 @@ static int vfsd_close_handle(struct ipc_message *msg, uint32_t h) {
     return 0;
 }
 
-static int vfsd_path_handler(struct ipc_message *msg) {
-    uint32_t op = UDM_MSG_OPCODE(msg);
+static int vfsd_path_handler(struct vfsd_job *job) {
+    struct ipc_message *msg = &job->msg;
+    uint32_t            op  = UDM_MSG_OPCODE(msg);
+
+    /* 复合操作: 一次往返完成 open+read+close, 多次 stat 或整个文件复制 */
+    if (op == UDM_VFS_READFILE || op == UDM_VFS_STATV || op == UDM_VFS_COPY) {
+        int ret = op == UDM_VFS_READFILE ? vfsd_readfile(job)
+                  : op == UDM_VFS_STATV  ? vfsd_statv(job)
+                                         : vfsd_copy(job);
+        if (ret < 0) {
+            msg->regs.data[0]  = (uint32_t)ret;
+            msg->regs.data[1]  = (uint32_t)ret;
+            msg->buffer.data   = 0;
+            msg->buffer.size   = 0;
+            msg->handles.count = 0;
+        }
+        return 0;
+    }
 
     /* CHDIR: 改变当前工作目录 */
     if (op == UDM_VFS_CHDIR) {
@@ -621,31 +1320,16 @@ static int vfsd_path_handler(struct ipc_message *msg) {
             /* 解析为绝对路径 */
             vfsd_resolve_path(pid, path, abs_path, sizeof(abs_path));
 
-            /* 验证路径存在且是目录(通过 stat 转发给 FS 驱动)*/
-            char rel_path[VFS_PATH_MAX];
-            int  fs_ep = vfsd_lookup(abs_path, rel_path, sizeof(rel_path));
-            if (fs_ep < 0) {
-                msg->regs.data[0] = op;
-                msg->regs.data[1] = (uint32_t)fs_ep;
-                return 0;
-            }
-
-            /* 转发 INFO 操作验证是否是目录 */
-            struct ipc_message stat_req   = {0};
-            struct ipc_message stat_reply = {0};
-            stat_req.regs.data[0]         = UDM_VFS_INFO;
-            stat_req.buffer.data          = (uint64_t)(uintptr_t)rel_path;
-            stat_req.buffer.size          = strlen(rel_path);
-
-            int ret = sys_ipc_call(fs_ep, &stat_req, &stat_reply, 5000);
-            if (ret < 0 || (int32_t)stat_reply.regs.data[1] < 0) {
+            /* 验证路径存在且是目录 */
+            struct vfs_info info;
+            int             ret = vfsd_stat(abs_path, &info);
+            if (ret < 0) {
                 msg->regs.data[0] = op;
-                msg->regs.data[1] = ret < 0 ? (uint32_t)ret : stat_reply.regs.data[1];
+                msg->regs.data[1] = (uint32_t)ret;
                 return 0;
             }
 
-            uint32_t type = stat_reply.regs.data[3];
-            if (type != VFS_TYPE_DIR) {
+            if (info.type != VFS_TYPE_DIR) {
                 msg->regs.data[0] = op;
                 msg->regs.data[1] = (uint32_t)-20; /* ENOTDIR */
                 return 0;
@@ -663,6 +1347,31 @@ static int vfsd_path_handler(struct ipc_message *msg) {
         return 0;
     }
 
+    /* INFO: 查询路径信息 (经路径缓存) */
+    if (op == UDM_VFS_INFO) {
+        uint32_t pid = UDM_MSG_ARG(msg, 0);
+        char     path[VFS_PATH_MAX];
+        char     abs_path[VFS_PATH_MAX];
+        int      ret = -22; /* EINVAL */
+
+        struct vfs_info info = {0};
+        if (msg->buffer.data && msg->buffer.size > 0 && msg->buffer.size < VFS_PATH_MAX) {
+            memcpy(path, (void *)(uintptr_t)msg->buffer.data, msg->buffer.size);
+            path[msg->buffer.size] = '\0';
+
+            vfsd_resolve_path(pid, path, abs_path, sizeof(abs_path));
+            ret = vfsd_stat(abs_path, &info);
+        }
+
+        msg->regs.data[0] = (uint32_t)ret;
+        msg->regs.data[1] = (uint32_t)ret;
+        msg->regs.data[2] = info.size;
+        msg->regs.data[3] = info.type;
+        msg->buffer.data  = 0;
+        msg->buffer.size  = 0;
+        return 0;
+    }
+
     /* GETCWD: 获取当前工作目录 */
     if (op == UDM_VFS_GETCWD) {
         uint32_t    pid = UDM_MSG_ARG(msg, 0);
@@ -773,13 +1482,25 @@ static int vfsd_path_handler(struct ipc_message *msg) {
     return 0;
 }
 
-static int vfsd_dir_handler(struct ipc_message *msg) {
-    uint32_t op = UDM_MSG_OPCODE(msg);
+static int vfsd_dir_handler(struct vfsd_job *job) {
+    struct ipc_message *msg = &job->msg;
+    uint32_t            op  = UDM_MSG_OPCODE(msg);
 
     if (op == IO_IOCTL) {
         uint32_t h   = msg->regs.data[1];
         uint32_t cmd = msg->regs.data[2];
 
+        if (cmd == VFS_IOCTL_GETDENTS) {
+            int ret = vfsd_getdents(job, h, msg->regs.data[3], msg->regs.data[4]);
+            if (ret < 0) {
+                msg->regs.data[0]  = (uint32_t)ret;
+                msg->buffer.data   = 0;
+                msg->buffer.size   = 0;
+                msg->handles.count = 0;
+            }
+            return 0;
+        }
+
         if (cmd != VFS_IOCTL_READDIR) {
             msg->regs.data[0] = (uint32_t)-38; /* ENOSYS */
             msg->buffer.data  = 0;
@@ -789,7 +1510,7 @@ static int vfsd_dir_handler(struct ipc_message *msg) {
         }
 
         uint32_t index = msg->regs.data[3];
-        int      ret   = vfsd_readdir(msg, h, index);
+        int      ret   = vfsd_readdir(msg, h, index, &job->dirent);
         if (ret < 0) {
             msg->regs.data[0] = (uint32_t)ret;
             msg->buffer.data  = (uint64_t)(uintptr_t)0;
@@ -822,6 +1543,157 @@ static int vfsd_dir_handler(struct ipc_message *msg) {
     return 0;
 }
 
+/* ============== 请求调度 ============== */
+
+/* 取空闲 job, 全部在用时等工作线程归还 */
+static struct vfsd_job *vfsd_job_get(void) {
+    while (1) {
+        pthread_mutex_lock(&g_vfs_lock);
+        struct vfsd_job *job = g_job_free;
+        if (job) {
+            g_job_free = job->next;
+        }
+        pthread_mutex_unlock(&g_vfs_lock);
+
+        if (job) {
+            return job;
+        }
+        sys_event_wait(g_job_ev);
+    }
+}
+
+static void vfsd_job_put(struct vfsd_job *job) {
+    job->next  = g_job_free;
+    g_job_free = job;
+    sys_event_signal(g_job_ev, 1);
+}
+
+/**
+ * 请求要转发到哪个挂载点的后端
+ * 返回 mount_table 下标, -1 表示不需要等后端 (或参数无效), 可当场处理
+ */
+static int vfsd_job_mount(struct vfsd_job *job) {
+    struct ipc_message *msg = &job->msg;
+    uint32_t            op  = UDM_MSG_OPCODE(msg);
+
+    if (job->from == g_vfs_dir_ep) {
+        struct vfs_dir_state *st = vfsd_dir_get(msg->regs.data[1]);
+        if (!st) {
+            return -1;
+        }
+        for (int i = 0; i < VFS_MAX_MOUNTS; i++) {
+            if (mount_table[i].active && mount_table[i].fs_ep == st->backend_ep) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    if (op == UDM_VFS_GETCWD || op == UDM_VFS_COPY_CWD || op == 0x1000) {
+        return -1;
+    }
+    if (!msg->buffer.data || msg->buffer.size == 0) {
+        return -1;
+    }
+
+    /* STATV/COPY 可能涉及多个挂载点, 按第一个路径归类 */
+    uint32_t len = msg->buffer.size;
+    if (op == UDM_VFS_STATV || op == UDM_VFS_COPY) {
+        len = strnlen((const char *)(uintptr_t)msg->buffer.data, len);
+    }
+    if (len == 0 || len >= VFS_PATH_MAX) {
+        return -1;
+    }
+
+    char path[VFS_PATH_MAX];
+    char abs_path[VFS_PATH_MAX];
+    memcpy(path, (void *)(uintptr_t)msg->buffer.data, len);
+    path[len] = '\0';
+    vfsd_resolve_path(UDM_MSG_ARG(msg, 0), path, abs_path, sizeof(abs_path));
+
+    struct vfs_dentry *d = vfsd_dentry_get(abs_path);
+    if (!d || (op == UDM_VFS_INFO && d->has_info)) {
+        return -1;
+    }
+    return d->mount;
+}
+
+/* 处理请求并回复, 调用者持有 g_vfs_lock */
+static void vfsd_job_run(struct vfsd_job *job) {
+    struct ipc_message *msg = &job->msg;
+
+    /* 调用方捐给接收线程的优先级转到本工作线程, 回复时收回 */
+    if ((msg->flags & ABI_IPC_FLAG_NOREPLY) == 0) {
+        sys_ipc_reply_adopt(msg->sender_tid);
+    }
+
+    int ret = (job->from == g_vfs_dir_ep) ? vfsd_dir_handler(job) : vfsd_path_handler(job);
+    if (ret == 0 && (msg->flags & ABI_IPC_FLAG_NOREPLY) == 0) {
+        sys_ipc_reply_to(msg->sender_tid, msg);
+    }
+}
+
+/* 轮流从各挂载点队列取请求, 跳过在途数已满的挂载点 */
+static struct vfsd_job *vfsd_job_next(void) {
+    static int rr;
+
+    for (int n = 0; n < VFS_MAX_MOUNTS; n++) {
+        struct vfs_mount *m = &mount_table[(rr + n) % VFS_MAX_MOUNTS];
+        if (!m->queue_head || m->inflight >= VFSD_MOUNT_INFLIGHT) {
+            continue;
+        }
+
+        struct vfsd_job *job = m->queue_head;
+        m->queue_head        = job->next;
+        if (!m->queue_head) {
+            m->queue_tail = NULL;
+        }
+        m->inflight++;
+        rr = (rr + n + 1) % VFS_MAX_MOUNTS;
+        return job;
+    }
+    return NULL;
+}
+
+static void *vfsd_worker(void *arg) {
+    (void)arg;
+
+    pthread_mutex_lock(&g_vfs_lock);
+    while (1) {
+        struct vfsd_job *job = vfsd_job_next();
+        if (!job) {
+            /* 入队在放锁之后 signal, pending 位保留到下次 wait, 不会丢 */
+            pthread_mutex_unlock(&g_vfs_lock);
+            sys_event_wait(g_work_ev);
+            pthread_mutex_lock(&g_vfs_lock);
+            continue;
+        }
+
+        vfsd_job_run(job);
+
+        /* 在途数降下来后, 该挂载点排着的请求可能又能派发了 */
+        struct vfs_mount *m = &mount_table[job->mount];
+        m->inflight--;
+        if (m->queue_head) {
+            sys_event_signal(g_work_ev, 1);
+        }
+        vfsd_job_put(job);
+    }
+    return NULL;
+}
+
+static void vfsd_job_enqueue(struct vfsd_job *job) {
+    struct vfs_mount *m = &mount_table[job->mount];
+
+    job->next = NULL;
+    if (m->queue_tail) {
+        m->queue_tail->next = job;
+    } else {
+        m->queue_head = job;
+    }
+    m->queue_tail = job;
+}
+
 int main(void) {
     g_vfs_ep = env_require("vfs_ep");
     if (g_vfs_ep == HANDLE_INVALID) {
@@ -832,6 +1704,12 @@ int main(void) {
         return 1;
     }
 
+    /* 建不了通知事件时照常工作, 只是不缓存 stat 结果 */
+    int ev = sys_event_create();
+    if (ev >= 0) {
+        g_vfs_notify_ev = (handle_t)ev;
+    }
+
     /* 初始化挂载表 */
     for (int i = 0; i < VFS_MAX_MOUNTS; i++) {
         mount_table[i].active = 0;
@@ -842,34 +1720,89 @@ int main(void) {
     for (int i = 0; i < VFS_MAX_PROCESSES; i++) {
         cwd_table[i].active = 0;
     }
+    for (int i = 0; i < VFSD_DCACHE_BUCKETS; i++) {
+        dcache_bucket[i] = -1;
+    }
+
+    int job_ev  = sys_event_create();
+    int work_ev = sys_event_create();
+    if (job_ev < 0 || work_ev < 0) {
+        return 1;
+    }
+    g_job_ev  = (handle_t)job_ev;
+    g_work_ev = (handle_t)work_ev;
+
+    pthread_mutex_init(&g_vfs_lock, NULL);
+    for (int i = 0; i < VFSD_JOB_MAX; i++) {
+        g_jobs[i].next = g_job_free;
+        g_job_free     = &g_jobs[i];
+    }
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, VFSD_WORKER_STACK);
+    for (int i = 0; i < VFSD_WORKERS; i++) {
+        pthread_t tid;
+        if (pthread_create(&tid, &attr, vfsd_worker, NULL) != 0) {
+            ulog_tagf(stdout, TERM_COLOR_LIGHT_RED, "[vfsd]", " failed to start worker %d\n", i);
+            return 1;
+        }
+        pthread_detach(tid);
+    }
+    pthread_attr_destroy(&attr);
 
     svc_notify_ready("vfs");
 
+    struct vfsd_job *job = NULL;
+
     while (1) {
         struct abi_ipc_wait_set wait_set = {0};
-        struct ipc_message      msg      = {0};
-        char                    recv_buf[4096];
 
-        wait_set.handles[0] = g_vfs_ep;
-        wait_set.handles[1] = g_vfs_dir_ep;
-        wait_set.count      = 2;
+        if (!job) {
+            job = vfsd_job_get();
+        }
+
+        /* 通知事件排在最前: 后端先 signal 再回复, 收下一条请求前缓存已失效 */
+        if (g_vfs_notify_ev != HANDLE_INVALID) {
+            wait_set.handles[wait_set.count++] = g_vfs_notify_ev;
+        }
+        wait_set.handles[wait_set.count++] = g_vfs_ep;
+        wait_set.handles[wait_set.count++] = g_vfs_dir_ep;
 
         handle_t ready = sys_ipc_wait_any(&wait_set, 10000);
         if (ready == HANDLE_INVALID) {
             continue;
         }
 
-        msg.buffer.data = (uint64_t)(uintptr_t)recv_buf;
-        msg.buffer.size = sizeof(recv_buf);
+        if (ready == g_vfs_notify_ev) {
+            uint32_t bits = sys_event_wait(g_vfs_notify_ev);
+            pthread_mutex_lock(&g_vfs_lock);
+            vfsd_dcache_flush(bits);
+            pthread_mutex_unlock(&g_vfs_lock);
+            continue;
+        }
+
+        memset(&job->msg, 0, sizeof(job->msg));
+        job->msg.buffer.data = (uint64_t)(uintptr_t)job->buf;
+        job->msg.buffer.size = sizeof(job->buf);
+        job->from            = ready;
 
-        if (sys_ipc_receive(ready, &msg, 0) < 0) {
+        if (sys_ipc_receive(ready, &job->msg, 0) < 0) {
             continue;
         }
 
-        int ret = (ready == g_vfs_dir_ep) ? vfsd_dir_handler(&msg) : vfsd_path_handler(&msg);
-        if (ret == 0 && (msg.flags & ABI_IPC_FLAG_NOREPLY) == 0) {
-            sys_ipc_reply(&msg);
+        pthread_mutex_lock(&g_vfs_lock);
+        job->mount = vfsd_job_mount(job);
+        if (job->mount < 0) {
+            vfsd_job_run(job);
+            pthread_mutex_unlock(&g_vfs_lock);
+            continue;
         }
+        vfsd_job_enqueue(job);
+        pthread_mutex_unlock(&g_vfs_lock);
+
+        sys_event_signal(g_work_ev, 1);
+        job = NULL;
     }
 
     return 0;